@@ -0,0 +1,45 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "CoreBenchmark.h"
+
+/**
+ * Runs a CoreBenchmark on launch and reports its results.
+ *
+ * The benchmark is configured with launch arguments, e.g.
+ *
+ *   -samples 9 -minimumSampleMs 100 -tolerance 0.05
+ *
+ * Any argument that is left out uses the benchmark's default. The results are compared against
+ * the baselines in CoreBenchmarkBaselines.plist, printed to standard output as JSON and written
+ * to CoreBenchmarkResults.json in the app's Documents directory.
+ *
+ * With -recordBaselines YES the results are also written to CoreBenchmarkBaselines.plist in
+ * the Documents directory. Record baselines on the reference device and copy that file over
+ * the one in the project to update the stored baselines.
+ */
+@interface AppDelegate : NSObject <UIApplicationDelegate, CoreBenchmarkDelegate> {
+  UIWindow* _window;
+
+  CoreBenchmark* _benchmark;
+  BOOL _shouldRecordBaselines;
+}
+
+@property (nonatomic, readwrite, retain) UIWindow* window;
+
+@end
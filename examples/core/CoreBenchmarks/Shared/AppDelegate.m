@@ -0,0 +1,109 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "AppDelegate.h"
+
+static NSString* const kResultsFileName = @"CoreBenchmarkResults.json";
+static NSString* const kBaselinesFileName = @"CoreBenchmarkBaselines.plist";
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation AppDelegate
+
+@synthesize window = _window;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_window);
+  NI_RELEASE_SAFELY(_benchmark);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Application lifecycle
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)              application:(UIApplication *)application
+    didFinishLaunchingWithOptions:(NSDictionary *)launchOptions {
+  self.window = [[[UIWindow alloc] initWithFrame:[UIScreen mainScreen].bounds] autorelease];
+  [self.window makeKeyAndVisible];
+
+  _benchmark = [[CoreBenchmark alloc] init];
+  _benchmark.delegate = self;
+
+  NSString* baselinesPath = NIPathForBundleResource(nil, kBaselinesFileName);
+  _benchmark.baselines = [NSDictionary dictionaryWithContentsOfFile:baselinesPath];
+
+  // Launch arguments such as "-samples 9" are available through the user defaults.
+  NSUserDefaults* defaults = [NSUserDefaults standardUserDefaults];
+  if (nil != [defaults objectForKey:@"samples"]) {
+    _benchmark.numberOfSamples = MAX(1, [defaults integerForKey:@"samples"]);
+  }
+  if (nil != [defaults objectForKey:@"minimumSampleMs"]) {
+    _benchmark.minimumSampleDuration = MAX(1, [defaults integerForKey:@"minimumSampleMs"]) / 1000.0;
+  }
+  if (nil != [defaults objectForKey:@"tolerance"]) {
+    _benchmark.regressionTolerance = MAX(0, [defaults doubleForKey:@"tolerance"]);
+  }
+  _shouldRecordBaselines = [defaults boolForKey:@"recordBaselines"];
+
+  [_benchmark start];
+
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark CoreBenchmarkDelegate
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)coreBenchmark: (CoreBenchmark *)benchmark
+ didFinishWithResults: (NSDictionary *)results {
+  NSString* json = [CoreBenchmark JSONStringWithResults:results];
+
+  // Written with stdio rather than NSLog so that the output can be parsed without stripping
+  // log prefixes.
+  fputs([json UTF8String], stdout);
+  fflush(stdout);
+
+  NSString* resultsPath = NIPathForDocumentsResource(kResultsFileName);
+  NSError* error = nil;
+  if (![json writeToFile:resultsPath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+    NSLog(@"Failed to write the benchmark results to %@: %@", resultsPath, error);
+  }
+
+  if (_shouldRecordBaselines) {
+    NSString* baselinesPath = NIPathForDocumentsResource(kBaselinesFileName);
+    NSDictionary* baselines = [CoreBenchmark baselinesWithResults:results];
+    if (![baselines writeToFile:baselinesPath atomically:YES]) {
+      NSLog(@"Failed to write the benchmark baselines to %@", baselinesPath);
+    }
+  }
+}
+
+
+@end
@@ -0,0 +1,135 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+@protocol CoreBenchmarkDelegate;
+
+/**
+ * The version of the results and baselines formats. Bump this whenever a case is renamed or a
+ * metric's meaning changes so that stale baselines are ignored rather than compared.
+ */
+extern const NSInteger CoreBenchmarkResultsFormatVersion;
+
+/**
+ * Measures the hot helpers of Nimbus Core one case at a time.
+ *
+ * Each case is run in a loop. The number of iterations is doubled until a single sample takes
+ * at least minimumSampleDuration, and then numberOfSamples samples are taken. Every case
+ * reports:
+ *
+ * - ns_per_op: The wall time of one iteration in nanoseconds, from the median sample.
+ * - allocations_per_op: The number of malloc, calloc, valloc and realloc calls made through the
+ *   default malloc zone during one iteration, from the sample with the fewest. Allocations
+ *   made by other threads while a sample runs are counted as well.
+ * - ops_per_second: The number of iterations that run in one second.
+ * - mb_per_second: For cases that process a payload, the number of megabytes processed in one
+ *   second.
+ *
+ * When baselines are provided, every case that has a baseline also reports its baseline and
+ * the relative change in ns_per_op, and is flagged as regressed if it is slower than the
+ * baseline by more than regressionTolerance or makes more allocations than the baseline.
+ */
+@interface CoreBenchmark : NSObject {
+@private
+  // Configuration
+  NSInteger       _numberOfSamples;
+  NSTimeInterval  _minimumSampleDuration;
+  double          _regressionTolerance;
+  NSDictionary*   _baselines;
+
+  // Fixtures
+  NSData*         _payload;
+  NSString*       _stringPayload;
+  NSString*       _queryString;
+  NSString*       _URLString;
+  NSDictionary*   _queryDictionary;
+  NSString*       _whitespace;
+  NSString*       _paragraph;
+  UIFont*         _font;
+  NSArray*        _objects;
+
+  NSInteger             _caseIndex;
+  NSMutableDictionary*  _caseResults;
+
+  id<CoreBenchmarkDelegate> _delegate;
+}
+
+/**
+ * The number of samples taken of each case. Defaults to 5.
+ */
+@property (nonatomic, readwrite, assign) NSInteger numberOfSamples;
+
+/**
+ * The shortest duration of a single sample. Defaults to 0.05 seconds.
+ *
+ * Longer samples are less affected by timer resolution and scheduling noise.
+ */
+@property (nonatomic, readwrite, assign) NSTimeInterval minimumSampleDuration;
+
+/**
+ * How much slower than its baseline a case may be before it is flagged as regressed, as a
+ * fraction of the baseline. Defaults to 0.1.
+ */
+@property (nonatomic, readwrite, assign) double regressionTolerance;
+
+/**
+ * Baselines in the format returned by baselinesWithResults:.
+ *
+ * Baselines with a different format version are ignored.
+ */
+@property (nonatomic, readwrite, copy) NSDictionary* baselines;
+
+@property (nonatomic, readwrite, assign) id<CoreBenchmarkDelegate> delegate;
+
+/**
+ * Run every case. Cases run on successive passes of the main run loop so that the app stays
+ * responsive, and the delegate is notified once the last case has finished.
+ */
+- (void)start;
+
+/**
+ * Encode the results as JSON with the keys sorted, so that results from different runs can be
+ * compared with standard tools.
+ */
++ (NSString *)JSONStringWithResults:(NSDictionary *)results;
+
+/**
+ * The baselines that the given results would be compared against, as plist types.
+ *
+ * Write these to CoreBenchmarkBaselines.plist to make them the stored baselines.
+ */
++ (NSDictionary *)baselinesWithResults:(NSDictionary *)results;
+
+@end
+
+
+/**
+ * The delegate of a CoreBenchmark.
+ */
+@protocol CoreBenchmarkDelegate <NSObject>
+
+@required
+
+/**
+ * The benchmark has finished.
+ *
+ * @param results  The configuration, device and per-case metrics as plist types.
+ */
+- (void)coreBenchmark: (CoreBenchmark *)benchmark
+ didFinishWithResults: (NSDictionary *)results;
+
+@end
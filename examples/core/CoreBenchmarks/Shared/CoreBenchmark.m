@@ -0,0 +1,740 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "CoreBenchmark.h"
+
+#import "NIPointerSet.h"
+
+#import <libkern/OSAtomic.h>
+#import <mach/mach.h>
+#import <mach/mach_time.h>
+#import <malloc/malloc.h>
+
+const NSInteger CoreBenchmarkResultsFormatVersion = 1;
+
+static const NSInteger kDefaultNumberOfSamples = 5;
+static const NSTimeInterval kDefaultMinimumSampleDuration = 0.05;
+static const double kDefaultRegressionTolerance = 0.1;
+
+// Keeps a case with a very cheap operation from calibrating forever on a coarse clock.
+static const NSInteger kMaximumNumberOfIterations = 1 << 22;
+
+// Other threads can add a fraction of an allocation to a case between runs.
+static const double kAllocationTolerance = 0.05;
+
+// The number of objects that are added to each collection.
+static const NSInteger kNumberOfCollectionObjects = 16;
+
+/**
+ * A single benchmark case.
+ *
+ * The selector takes the number of iterations as an NSInteger. When the payload length is
+ * non-zero the payload fixtures are created with that many bytes before the case runs, and its
+ * throughput is reported.
+ */
+typedef struct {
+  const char* name;
+  const char* selectorName;
+  NSUInteger  payloadLength;
+} CoreBenchmarkCase;
+
+static const CoreBenchmarkCase kCases[] = {
+  { "md5_hash_16b",             "runMD5Hash:",                  16 },
+  { "md5_hash_1kb",             "runMD5Hash:",                  1024 },
+  { "md5_hash_64kb",            "runMD5Hash:",                  64 * 1024 },
+  { "md5_hash_1mb",             "runMD5Hash:",                  1024 * 1024 },
+  { "sha1_hash_16b",            "runSHA1Hash:",                 16 },
+  { "sha1_hash_1kb",            "runSHA1Hash:",                 1024 },
+  { "sha1_hash_64kb",           "runSHA1Hash:",                 64 * 1024 },
+  { "sha1_hash_1mb",            "runSHA1Hash:",                 1024 * 1024 },
+  { "string_md5_hash_1kb",      "runStringMD5Hash:",            1024 },
+  { "query_contents",           "runQueryContents:",            0 },
+  { "add_query_dictionary",     "runAddQueryDictionary:",       0 },
+  { "version_string_compare",   "runVersionStringCompare:",     0 },
+  { "is_whitespace_16b",        "runIsWhitespaceAndNewlines:",  16 },
+  { "is_whitespace_4kb",        "runIsWhitespaceAndNewlines:",  4 * 1024 },
+  { "height_with_font",         "runHeightWithFont:",           0 },
+  { "non_retaining_array",      "runNonRetainingArray:",        0 },
+  { "non_retaining_dictionary", "runNonRetainingDictionary:",   0 },
+  { "non_retaining_set",        "runNonRetainingSet:",          0 },
+  { "pointer_set",              "runPointerSet:",               0 },
+};
+
+static const NSInteger kNumberOfCases = sizeof(kCases) / sizeof(kCases[0]);
+
+typedef void (*CoreBenchmarkRunIMP)(id, SEL, NSInteger);
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Allocation Counting
+
+static malloc_zone_t  sOriginalZone;
+static BOOL           sIsCountingAllocations = NO;
+static volatile int32_t sNumberOfAllocations = 0;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void* CoreBenchmarkMalloc(malloc_zone_t* zone, size_t size) {
+  OSAtomicIncrement32(&sNumberOfAllocations);
+  return sOriginalZone.malloc(zone, size);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void* CoreBenchmarkCalloc(malloc_zone_t* zone, size_t count, size_t size) {
+  OSAtomicIncrement32(&sNumberOfAllocations);
+  return sOriginalZone.calloc(zone, count, size);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void* CoreBenchmarkValloc(malloc_zone_t* zone, size_t size) {
+  OSAtomicIncrement32(&sNumberOfAllocations);
+  return sOriginalZone.valloc(zone, size);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void* CoreBenchmarkRealloc(malloc_zone_t* zone, void* pointer, size_t size) {
+  OSAtomicIncrement32(&sNumberOfAllocations);
+  return sOriginalZone.realloc(zone, pointer, size);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Swap the functions of the default malloc zone, which serves malloc(), CoreFoundation and
+ * +alloc, for ones that count each allocation before forwarding it.
+ */
+static void CoreBenchmarkSetCountsAllocations(BOOL countsAllocations) {
+  if (countsAllocations == sIsCountingAllocations) {
+    return;
+  }
+
+  malloc_zone_t* zone = malloc_default_zone();
+
+  // Newer versions of the zone structure live in read-only memory.
+  vm_address_t page = trunc_page((vm_address_t)zone);
+  BOOL isProtected = (zone->version >= 8);
+  if (isProtected
+      && KERN_SUCCESS != vm_protect(mach_task_self(), page, vm_page_size, 0,
+                                    VM_PROT_READ | VM_PROT_WRITE)) {
+    NSLog(@"Unable to count allocations; the default malloc zone can't be made writable.");
+    return;
+  }
+
+  if (countsAllocations) {
+    sOriginalZone = *zone;
+    zone->malloc = CoreBenchmarkMalloc;
+    zone->calloc = CoreBenchmarkCalloc;
+    zone->valloc = CoreBenchmarkValloc;
+    zone->realloc = CoreBenchmarkRealloc;
+
+  } else {
+    zone->malloc = sOriginalZone.malloc;
+    zone->calloc = sOriginalZone.calloc;
+    zone->valloc = sOriginalZone.valloc;
+    zone->realloc = sOriginalZone.realloc;
+  }
+  sIsCountingAllocations = countsAllocations;
+
+  if (isProtected) {
+    vm_protect(mach_task_self(), page, vm_page_size, 0, VM_PROT_READ);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Reporting
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static double CoreBenchmarkNanosecondsFromTicks(uint64_t ticks) {
+  static mach_timebase_info_data_t sTimebase;
+  if (0 == sTimebase.denom) {
+    mach_timebase_info(&sTimebase);
+  }
+  return (double)ticks * sTimebase.numer / sTimebase.denom;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static int CoreBenchmarkCompareDoubles(const void* first, const void* second) {
+  double difference = *(const double *)first - *(const double *)second;
+  return (difference < 0) ? -1 : ((difference > 0) ? 1 : 0);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void CoreBenchmarkAppendIndent(NSMutableString* json, NSInteger depth) {
+  for (NSInteger ix = 0; ix < depth; ++ix) {
+    [json appendString:@"  "];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Append the JSON encoding of a dictionary, array, string or number to the given string.
+ */
+static void CoreBenchmarkAppendJSON(NSMutableString* json, id object, NSInteger depth) {
+  if ([object isKindOfClass:[NSDictionary class]]) {
+    NSArray* keys = [[object allKeys] sortedArrayUsingSelector:@selector(compare:)];
+
+    [json appendString:@"{"];
+    for (NSInteger ix = 0; ix < (NSInteger)[keys count]; ++ix) {
+      NSString* key = [keys objectAtIndex:ix];
+      [json appendString:(ix > 0) ? @",\n" : @"\n"];
+      CoreBenchmarkAppendIndent(json, depth + 1);
+      CoreBenchmarkAppendJSON(json, key, depth + 1);
+      [json appendString:@": "];
+      CoreBenchmarkAppendJSON(json, [object objectForKey:key], depth + 1);
+    }
+    if ([keys count] > 0) {
+      [json appendString:@"\n"];
+      CoreBenchmarkAppendIndent(json, depth);
+    }
+    [json appendString:@"}"];
+
+  } else if ([object isKindOfClass:[NSArray class]]) {
+    [json appendString:@"["];
+    for (NSInteger ix = 0; ix < (NSInteger)[object count]; ++ix) {
+      [json appendString:(ix > 0) ? @", " : @""];
+      CoreBenchmarkAppendJSON(json, [object objectAtIndex:ix], depth + 1);
+    }
+    [json appendString:@"]"];
+
+  } else if ([object isKindOfClass:[NSString class]]) {
+    [json appendString:@"\""];
+    for (NSUInteger ix = 0; ix < [object length]; ++ix) {
+      unichar character = [object characterAtIndex:ix];
+      if ('"' == character || '\\' == character) {
+        [json appendFormat:@"\\%C", character];
+
+      } else if (character < 0x20) {
+        [json appendFormat:@"\\u%04x", character];
+
+      } else {
+        [json appendFormat:@"%C", character];
+      }
+    }
+    [json appendString:@"\""];
+
+  } else if ([object isKindOfClass:[NSNumber class]]) {
+    const char* type = [object objCType];
+    if (0 == strcmp(type, @encode(double)) || 0 == strcmp(type, @encode(float))) {
+      [json appendFormat:@"%.3f", [object doubleValue]];
+
+    } else if (0 == strcmp(type, @encode(BOOL))) {
+      [json appendString:[object boolValue] ? @"true" : @"false"];
+
+    } else {
+      [json appendString:[object stringValue]];
+    }
+
+  } else {
+    // Only plist types that JSON can represent are used in the results.
+    NIDASSERT(NO);
+    [json appendString:@"null"];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface CoreBenchmark()
+
+- (void)runNextCase;
+- (void)finish;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation CoreBenchmark
+
+@synthesize numberOfSamples       = _numberOfSamples;
+@synthesize minimumSampleDuration = _minimumSampleDuration;
+@synthesize regressionTolerance   = _regressionTolerance;
+@synthesize baselines             = _baselines;
+@synthesize delegate              = _delegate;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_baselines);
+  NI_RELEASE_SAFELY(_payload);
+  NI_RELEASE_SAFELY(_stringPayload);
+  NI_RELEASE_SAFELY(_queryString);
+  NI_RELEASE_SAFELY(_URLString);
+  NI_RELEASE_SAFELY(_queryDictionary);
+  NI_RELEASE_SAFELY(_whitespace);
+  NI_RELEASE_SAFELY(_paragraph);
+  NI_RELEASE_SAFELY(_font);
+  NI_RELEASE_SAFELY(_objects);
+  NI_RELEASE_SAFELY(_caseResults);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _numberOfSamples = kDefaultNumberOfSamples;
+    _minimumSampleDuration = kDefaultMinimumSampleDuration;
+    _regressionTolerance = kDefaultRegressionTolerance;
+
+    _queryString = [@"q=nimbus&page=2&count=50&sort=relevance&lang=en"
+                    @"&title=The%20Nimbus%20Framework&tag=ios&tag=objc" copy];
+    _URLString = [@"http://example.com/search?q=nimbus" copy];
+    _queryDictionary = [[NSDictionary alloc] initWithObjectsAndKeys:
+                        @"2", @"page",
+                        @"50", @"count",
+                        @"relevance", @"sort",
+                        @"en", @"lang",
+                        nil];
+    _paragraph = [@"Nimbus is an iOS framework whose feature set grows only as fast as its "
+                  @"documentation. Every component is tested, documented and built to be dropped "
+                  @"into an existing application without having to adopt the rest." copy];
+    _font = [[UIFont systemFontOfSize:14] retain];
+
+    NSMutableArray* objects = [NSMutableArray arrayWithCapacity:kNumberOfCollectionObjects];
+    for (NSInteger ix = 0; ix < kNumberOfCollectionObjects; ++ix) {
+      [objects addObject:[NSNumber numberWithInteger:ix * 7919]];
+    }
+    _objects = [objects copy];
+
+    _caseResults = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Fixtures
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)createFixturesWithPayloadLength:(NSUInteger)payloadLength {
+  NI_RELEASE_SAFELY(_payload);
+  NI_RELEASE_SAFELY(_stringPayload);
+  NI_RELEASE_SAFELY(_whitespace);
+
+  if (0 == payloadLength) {
+    return;
+  }
+
+  // A fixed seed keeps the payloads identical between runs.
+  NSMutableData* payload = [NSMutableData dataWithLength:payloadLength];
+  unsigned char* bytes = [payload mutableBytes];
+  uint32_t seed = 2166136261u;
+  for (NSUInteger ix = 0; ix < payloadLength; ++ix) {
+    seed = seed * 1664525u + 1013904223u;
+    bytes[ix] = (unsigned char)(seed >> 24);
+  }
+  _payload = [payload copy];
+
+  static const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789 ";
+  static const char kWhitespace[] = " \t\n ";
+  NSMutableData* text = [NSMutableData dataWithLength:payloadLength];
+  NSMutableData* whitespace = [NSMutableData dataWithLength:payloadLength];
+  char* textBytes = [text mutableBytes];
+  char* whitespaceBytes = [whitespace mutableBytes];
+  for (NSUInteger ix = 0; ix < payloadLength; ++ix) {
+    textBytes[ix] = kAlphabet[bytes[ix] % (sizeof(kAlphabet) - 1)];
+    whitespaceBytes[ix] = kWhitespace[ix % (sizeof(kWhitespace) - 1)];
+  }
+  _stringPayload = [[NSString alloc] initWithData:text encoding:NSASCIIStringEncoding];
+  _whitespace = [[NSString alloc] initWithData:whitespace encoding:NSASCIIStringEncoding];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Cases
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runMD5Hash:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [_payload md5Hash];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runSHA1Hash:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [_payload sha1Hash];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runStringMD5Hash:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [_stringPayload md5Hash];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runQueryContents:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [_queryString queryContentsUsingEncoding:NSUTF8StringEncoding];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runAddQueryDictionary:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [_URLString stringByAddingQueryDictionary:_queryDictionary];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runVersionStringCompare:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [@"4.3.1" versionStringCompare:@"4.3.2b1"];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runIsWhitespaceAndNewlines:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [_whitespace isWhitespaceAndNewlines];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runHeightWithFont:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    [_paragraph heightWithFont: _font
+            constrainedToWidth: 280
+                 lineBreakMode: UILineBreakModeWordWrap];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runNonRetainingArray:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    NSMutableArray* array = NICreateNonRetainingArray();
+    for (id object in _objects) {
+      [array addObject:object];
+    }
+    for (id object in _objects) {
+      [array indexOfObjectIdenticalTo:object];
+    }
+    [array release];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runNonRetainingDictionary:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    NSMutableDictionary* dictionary = NICreateNonRetainingDictionary();
+    for (id object in _objects) {
+      [dictionary setObject:object forKey:object];
+    }
+    for (id object in _objects) {
+      [dictionary objectForKey:object];
+    }
+    [dictionary release];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runNonRetainingSet:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    NSMutableSet* set = NICreateNonRetainingSet();
+    for (id object in _objects) {
+      [set addObject:object];
+    }
+    for (id object in _objects) {
+      [set member:object];
+    }
+    [set release];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runPointerSet:(NSInteger)iterations {
+  for (NSInteger ix = 0; ix < iterations; ++ix) {
+    NIPointerSet* set = [[NIPointerSet alloc] init];
+    for (id object in _objects) {
+      [set addPointer:object];
+    }
+    for (id object in _objects) {
+      [set containsPointer:object];
+    }
+    [set release];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Measurement
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Run the case's selector once with the given number of iterations.
+ *
+ * @param nanoseconds  The wall time of the run.
+ * @param allocations  The number of allocations made during the run.
+ */
+- (void)sampleSelector: (SEL)selector
+            iterations: (NSInteger)iterations
+           nanoseconds: (double *)nanoseconds
+           allocations: (int32_t *)allocations {
+  CoreBenchmarkRunIMP run = (CoreBenchmarkRunIMP)[self methodForSelector:selector];
+
+  // Autoreleased results are freed after the run so that only their allocation is measured.
+  NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+  sNumberOfAllocations = 0;
+  OSMemoryBarrier();
+  uint64_t startTime = mach_absolute_time();
+  run(self, selector, iterations);
+  uint64_t endTime = mach_absolute_time();
+  OSMemoryBarrier();
+  *allocations = sNumberOfAllocations;
+
+  [pool release];
+
+  *nanoseconds = CoreBenchmarkNanosecondsFromTicks(endTime - startTime);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSDictionary *)resultsForCase:(const CoreBenchmarkCase *)benchmarkCase {
+  SEL selector = NSSelectorFromString([NSString stringWithUTF8String:benchmarkCase->selectorName]);
+  NIDASSERT([self respondsToSelector:selector]);
+
+  [self createFixturesWithPayloadLength:benchmarkCase->payloadLength];
+
+  double nanoseconds = 0;
+  int32_t allocations = 0;
+
+  // Calibrating also warms up the caches and any lazily created state.
+  NSInteger iterations = 1;
+  double minimumNanoseconds = _minimumSampleDuration * NSEC_PER_SEC;
+  while (YES) {
+    [self sampleSelector: selector
+              iterations: iterations
+             nanoseconds: &nanoseconds
+             allocations: &allocations];
+    if (nanoseconds >= minimumNanoseconds || iterations >= kMaximumNumberOfIterations) {
+      break;
+    }
+    iterations *= 2;
+  }
+
+  NSInteger numberOfSamples = MAX(1, _numberOfSamples);
+  double* nanosecondsPerOperation = malloc(numberOfSamples * sizeof(double));
+  double allocationsPerOperation = DBL_MAX;
+
+  for (NSInteger ixSample = 0; ixSample < numberOfSamples; ++ixSample) {
+    [self sampleSelector: selector
+              iterations: iterations
+             nanoseconds: &nanoseconds
+             allocations: &allocations];
+    nanosecondsPerOperation[ixSample] = nanoseconds / iterations;
+
+    // Other threads can only add allocations to a sample, so the fewest is the most accurate.
+    allocationsPerOperation = MIN(allocationsPerOperation, (double)allocations / iterations);
+  }
+
+  qsort(nanosecondsPerOperation, numberOfSamples, sizeof(double), CoreBenchmarkCompareDoubles);
+  double median = nanosecondsPerOperation[numberOfSamples / 2];
+  if (numberOfSamples % 2 == 0) {
+    median = (median + nanosecondsPerOperation[numberOfSamples / 2 - 1]) / 2;
+  }
+  free(nanosecondsPerOperation);
+
+  NSMutableDictionary* results = [NSMutableDictionary dictionary];
+  [results setObject:[NSNumber numberWithDouble:median] forKey:@"ns_per_op"];
+  [results setObject:[NSNumber numberWithDouble:allocationsPerOperation]
+              forKey:@"allocations_per_op"];
+  [results setObject:[NSNumber numberWithInteger:iterations] forKey:@"iterations"];
+  if (median > 0) {
+    [results setObject:[NSNumber numberWithDouble:NSEC_PER_SEC / median]
+                forKey:@"ops_per_second"];
+    if (benchmarkCase->payloadLength > 0) {
+      double bytesPerSecond = benchmarkCase->payloadLength * (NSEC_PER_SEC / median);
+      [results setObject:[NSNumber numberWithDouble:bytesPerSecond / (1024 * 1024)]
+                  forKey:@"mb_per_second"];
+    }
+  }
+
+  return results;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Compare a case's results against its baseline and record the comparison in the results.
+ *
+ * @returns YES if the case regressed.
+ */
+- (BOOL)compareResults:(NSMutableDictionary *)results withBaseline:(NSDictionary *)baseline {
+  double nanosecondsPerOperation = [[results objectForKey:@"ns_per_op"] doubleValue];
+  double allocationsPerOperation = [[results objectForKey:@"allocations_per_op"] doubleValue];
+  double baselineNanoseconds = [[baseline objectForKey:@"ns_per_op"] doubleValue];
+  double baselineAllocations = [[baseline objectForKey:@"allocations_per_op"] doubleValue];
+
+  BOOL isRegressed = (allocationsPerOperation > baselineAllocations + kAllocationTolerance);
+  if (baselineNanoseconds > 0) {
+    double change = (nanosecondsPerOperation - baselineNanoseconds) / baselineNanoseconds;
+    [results setObject:[NSNumber numberWithDouble:change] forKey:@"ns_per_op_change"];
+    isRegressed = isRegressed || (change > _regressionTolerance);
+  }
+
+  [results setObject:[NSNumber numberWithDouble:baselineNanoseconds]
+              forKey:@"baseline_ns_per_op"];
+  [results setObject:[NSNumber numberWithDouble:baselineAllocations]
+              forKey:@"baseline_allocations_per_op"];
+  [results setObject:[NSNumber numberWithBool:isRegressed] forKey:@"regressed"];
+
+  return isRegressed;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)start {
+  [_caseResults removeAllObjects];
+  _caseIndex = 0;
+
+  CoreBenchmarkSetCountsAllocations(YES);
+
+  [self performSelector:@selector(runNextCase) withObject:nil afterDelay:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runNextCase {
+  if (_caseIndex >= kNumberOfCases) {
+    [self finish];
+    return;
+  }
+
+  const CoreBenchmarkCase* benchmarkCase = &kCases[_caseIndex];
+  ++_caseIndex;
+
+  NSDictionary* results = [self resultsForCase:benchmarkCase];
+  [_caseResults setObject:results forKey:[NSString stringWithUTF8String:benchmarkCase->name]];
+
+  // Let the run loop turn over between cases so that the app doesn't appear to hang.
+  [self performSelector:@selector(runNextCase) withObject:nil afterDelay:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)finish {
+  CoreBenchmarkSetCountsAllocations(NO);
+
+  NSDictionary* baselineCases = nil;
+  if ([[_baselines objectForKey:@"format_version"] integerValue]
+      == CoreBenchmarkResultsFormatVersion) {
+    baselineCases = [_baselines objectForKey:@"cases"];
+  }
+
+  NSMutableDictionary* cases = [NSMutableDictionary dictionaryWithCapacity:[_caseResults count]];
+  NSMutableArray* regressedCases = [NSMutableArray array];
+  NSArray* names = [[_caseResults allKeys] sortedArrayUsingSelector:@selector(compare:)];
+  for (NSString* name in names) {
+    NSMutableDictionary* results = [[[_caseResults objectForKey:name] mutableCopy] autorelease];
+    NSDictionary* baseline = [baselineCases objectForKey:name];
+    if (nil != baseline && [self compareResults:results withBaseline:baseline]) {
+      [regressedCases addObject:name];
+    }
+    [cases setObject:results forKey:name];
+  }
+
+  UIDevice* device = [UIDevice currentDevice];
+  NSDictionary* results =
+  [NSDictionary dictionaryWithObjectsAndKeys:
+   [NSNumber numberWithInteger:CoreBenchmarkResultsFormatVersion], @"format_version",
+   [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithInteger:_numberOfSamples], @"samples",
+    [NSNumber numberWithDouble:_minimumSampleDuration * 1000], @"minimum_sample_ms",
+    [NSNumber numberWithDouble:_regressionTolerance], @"regression_tolerance",
+    [NSNumber numberWithBool:(nil != baselineCases)], @"has_baselines",
+    nil], @"configuration",
+   [NSDictionary dictionaryWithObjectsAndKeys:
+    [device model], @"model",
+    [device systemName], @"system_name",
+    [device systemVersion], @"system_version",
+    nil], @"device",
+   cases, @"cases",
+   regressedCases, @"regressed_cases",
+   nil];
+
+  [_delegate coreBenchmark:self didFinishWithResults:results];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSString *)JSONStringWithResults:(NSDictionary *)results {
+  NSMutableString* json = [NSMutableString string];
+  CoreBenchmarkAppendJSON(json, results, 0);
+  [json appendString:@"\n"];
+  return json;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSDictionary *)baselinesWithResults:(NSDictionary *)results {
+  NSDictionary* cases = [results objectForKey:@"cases"];
+  NSMutableDictionary* baselineCases = [NSMutableDictionary dictionaryWithCapacity:[cases count]];
+  for (NSString* name in cases) {
+    NSDictionary* caseResults = [cases objectForKey:name];
+    [baselineCases setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+                               [caseResults objectForKey:@"ns_per_op"], @"ns_per_op",
+                               [caseResults objectForKey:@"allocations_per_op"],
+                               @"allocations_per_op",
+                               nil]
+                      forKey: name];
+  }
+
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+          [results objectForKey:@"format_version"], @"format_version",
+          [results objectForKey:@"device"], @"device",
+          baselineCases, @"cases",
+          nil];
+}
+
+
+@end
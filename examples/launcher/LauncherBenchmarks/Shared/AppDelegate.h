@@ -0,0 +1,40 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "LauncherBenchmark.h"
+
+/**
+ * Runs a LauncherBenchmark on launch and reports its results.
+ *
+ * The benchmark is configured with launch arguments, e.g.
+ *
+ *   -pages 40 -itemsPerPage 20 -icons 16 -iterations 10
+ *
+ * Any argument that is left out uses the benchmark's default. The results are printed to
+ * standard output as JSON and written to LauncherBenchmarkResults.json in the app's Documents
+ * directory.
+ */
+@interface AppDelegate : NSObject <UIApplicationDelegate, LauncherBenchmarkDelegate> {
+  UIWindow* _window;
+
+  LauncherBenchmark* _benchmark;
+}
+
+@property (nonatomic, readwrite, retain) UIWindow* window;
+
+@end
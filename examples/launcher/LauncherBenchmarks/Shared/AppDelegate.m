@@ -0,0 +1,99 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "AppDelegate.h"
+
+static NSString* const kResultsFileName = @"LauncherBenchmarkResults.json";
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation AppDelegate
+
+@synthesize window = _window;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_window);
+  NI_RELEASE_SAFELY(_benchmark);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Application lifecycle
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)              application:(UIApplication *)application
+    didFinishLaunchingWithOptions:(NSDictionary *)launchOptions {
+  self.window = [[[UIWindow alloc] initWithFrame:[UIScreen mainScreen].bounds] autorelease];
+  [self.window makeKeyAndVisible];
+
+  _benchmark = [[LauncherBenchmark alloc] initWithWindow:self.window];
+  _benchmark.delegate = self;
+
+  // Launch arguments such as "-pages 40" are available through the user defaults.
+  NSUserDefaults* defaults = [NSUserDefaults standardUserDefaults];
+  if (nil != [defaults objectForKey:@"pages"]) {
+    _benchmark.numberOfPages = MAX(1, [defaults integerForKey:@"pages"]);
+  }
+  if (nil != [defaults objectForKey:@"itemsPerPage"]) {
+    _benchmark.numberOfItemsPerPage = MAX(0, [defaults integerForKey:@"itemsPerPage"]);
+  }
+  if (nil != [defaults objectForKey:@"icons"]) {
+    _benchmark.numberOfIcons = MAX(0, [defaults integerForKey:@"icons"]);
+  }
+  if (nil != [defaults objectForKey:@"iterations"]) {
+    _benchmark.numberOfIterations = MAX(1, [defaults integerForKey:@"iterations"]);
+  }
+
+  [_benchmark start];
+
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark LauncherBenchmarkDelegate
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)launcherBenchmark: (LauncherBenchmark *)benchmark
+     didFinishWithResults: (NSDictionary *)results {
+  NSString* json = [LauncherBenchmark JSONStringWithResults:results];
+
+  // Written with stdio rather than NSLog so that the output can be parsed without stripping
+  // log prefixes.
+  fputs([json UTF8String], stdout);
+  fflush(stdout);
+
+  NSString* resultsPath = NIPathForDocumentsResource(kResultsFileName);
+  NSError* error = nil;
+  if (![json writeToFile:resultsPath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+    NSLog(@"Failed to write the benchmark results to %@: %@", resultsPath, error);
+  }
+}
+
+
+@end
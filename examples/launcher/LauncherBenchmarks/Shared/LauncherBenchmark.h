@@ -0,0 +1,140 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+@protocol LauncherBenchmarkDelegate;
+
+/**
+ * The version of the results format. Bump this whenever a metric is renamed or its meaning
+ * changes so that results from different releases aren't compared by mistake.
+ */
+extern const NSInteger LauncherBenchmarkResultsFormatVersion;
+
+/**
+ * Builds a launcher of a configurable size in a window and measures it.
+ *
+ * The benchmark runs the following phases in order:
+ *
+ * - first_frame_latency_ms: The time from adding the launcher to the window, which loads its
+ *   view and data, until the first display refresh after that.
+ * - reload_data_ms: The duration of NILauncherView's reloadData.
+ * - layout_pages_ms: The duration of resizing the launcher view between portrait and landscape
+ *   dimensions, which recalculates the layout metrics and lays out the pages.
+ * - paging: Every page is scrolled to in turn using an animated setCurrentPage:animated:.
+ *   Display refreshes are timed with a CADisplayLink, and any refresh that took longer than
+ *   the display's frame duration counts the frames that were missed.
+ *
+ * The process's resident memory is sampled on every display refresh and after every phase;
+ * the highest sample is reported as the high-water mark.
+ *
+ * Timed phases are repeated numberOfIterations times and reported as the minimum, median and
+ * maximum in milliseconds.
+ */
+@interface LauncherBenchmark : NSObject {
+@private
+  // Configuration
+  NSInteger _numberOfPages;
+  NSInteger _numberOfItemsPerPage;
+  NSInteger _numberOfIcons;
+  NSInteger _numberOfIterations;
+
+  UIWindow*                 _window;
+  NILauncherViewController* _launcherController;
+
+  // Frame Timing
+  CADisplayLink*  _displayLink;
+  CFTimeInterval  _lastFrameTimestamp;
+  CFTimeInterval  _launcherAddedTime;
+  BOOL            _isWaitingForFirstFrame;
+  BOOL            _isTimingFrames;
+  NSInteger       _numberOfFrames;
+  NSInteger       _numberOfDroppedFrames;
+
+  // Paging
+  NSTimer*        _pagingTimer;
+  NSInteger       _pagingTargetPage;
+
+  // Memory
+  unsigned long long _baselineResidentBytes;
+  unsigned long long _peakResidentBytes;
+
+  NSMutableDictionary* _metrics;
+
+  id<LauncherBenchmarkDelegate> _delegate;
+}
+
+/**
+ * Designated initializer.
+ *
+ * @param window  The window that the launcher is shown in while the benchmark runs.
+ */
+- (id)initWithWindow:(UIWindow *)window;
+
+/**
+ * The number of pages in the launcher. Defaults to 10.
+ */
+@property (nonatomic, readwrite, assign) NSInteger numberOfPages;
+
+/**
+ * The number of items on each page. Defaults to 16.
+ */
+@property (nonatomic, readwrite, assign) NSInteger numberOfItemsPerPage;
+
+/**
+ * The number of distinct icon images shared by the items. Defaults to 8.
+ *
+ * The icons are generated when the benchmark starts. With no icons the items have no images.
+ */
+@property (nonatomic, readwrite, assign) NSInteger numberOfIcons;
+
+/**
+ * The number of times each timed phase is repeated. Defaults to 5.
+ */
+@property (nonatomic, readwrite, assign) NSInteger numberOfIterations;
+
+@property (nonatomic, readwrite, assign) id<LauncherBenchmarkDelegate> delegate;
+
+/**
+ * Run the benchmark. The delegate is notified once every phase has finished.
+ */
+- (void)start;
+
+/**
+ * Encode the results as JSON with the keys sorted, so that results from different runs can be
+ * compared with standard tools.
+ */
++ (NSString *)JSONStringWithResults:(NSDictionary *)results;
+
+@end
+
+
+/**
+ * The delegate of a LauncherBenchmark.
+ */
+@protocol LauncherBenchmarkDelegate <NSObject>
+
+@required
+
+/**
+ * The benchmark has finished.
+ *
+ * @param results  The configuration, device and measured metrics as plist types.
+ */
+- (void)launcherBenchmark: (LauncherBenchmark *)benchmark
+     didFinishWithResults: (NSDictionary *)results;
+
+@end
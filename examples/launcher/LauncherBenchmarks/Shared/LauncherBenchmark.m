@@ -0,0 +1,470 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "LauncherBenchmark.h"
+
+#import <mach/mach.h>
+
+const NSInteger LauncherBenchmarkResultsFormatVersion = 1;
+
+static const NSInteger kDefaultNumberOfPages = 10;
+static const NSInteger kDefaultNumberOfItemsPerPage = 16;
+static const NSInteger kDefaultNumberOfIcons = 8;
+static const NSInteger kDefaultNumberOfIterations = 5;
+
+static const CGFloat kIconDimensions = 57;
+
+// Long enough for each animated page change to finish before the next one begins.
+static const NSTimeInterval kPagingInterval = 0.5;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static unsigned long long LauncherBenchmarkResidentBytes(void) {
+  struct task_basic_info info;
+  mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+  if (KERN_SUCCESS != task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count)) {
+    return 0;
+  }
+  return info.resident_size;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * The minimum, median and maximum of the given durations in milliseconds.
+ *
+ * @param samples  An array of NSNumber durations in seconds.
+ */
+static NSDictionary* LauncherBenchmarkSummary(NSArray* samples) {
+  if ([samples count] == 0) {
+    return [NSDictionary dictionary];
+  }
+
+  NSArray* sortedSamples = [samples sortedArrayUsingSelector:@selector(compare:)];
+  NSInteger count = [sortedSamples count];
+
+  double median = [[sortedSamples objectAtIndex:count / 2] doubleValue];
+  if (count % 2 == 0) {
+    median = (median + [[sortedSamples objectAtIndex:count / 2 - 1] doubleValue]) / 2;
+  }
+
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+          [NSNumber numberWithDouble:[[sortedSamples objectAtIndex:0] doubleValue] * 1000], @"min",
+          [NSNumber numberWithDouble:median * 1000], @"median",
+          [NSNumber numberWithDouble:[[sortedSamples lastObject] doubleValue] * 1000], @"max",
+          nil];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void LauncherBenchmarkAppendIndent(NSMutableString* json, NSInteger depth) {
+  for (NSInteger ix = 0; ix < depth; ++ix) {
+    [json appendString:@"  "];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Append the JSON encoding of a dictionary, string or number to the given string.
+ */
+static void LauncherBenchmarkAppendJSON(NSMutableString* json, id object, NSInteger depth) {
+  if ([object isKindOfClass:[NSDictionary class]]) {
+    NSArray* keys = [[object allKeys] sortedArrayUsingSelector:@selector(compare:)];
+
+    [json appendString:@"{"];
+    for (NSInteger ix = 0; ix < (NSInteger)[keys count]; ++ix) {
+      NSString* key = [keys objectAtIndex:ix];
+      [json appendString:(ix > 0) ? @",\n" : @"\n"];
+      LauncherBenchmarkAppendIndent(json, depth + 1);
+      LauncherBenchmarkAppendJSON(json, key, depth + 1);
+      [json appendString:@": "];
+      LauncherBenchmarkAppendJSON(json, [object objectForKey:key], depth + 1);
+    }
+    if ([keys count] > 0) {
+      [json appendString:@"\n"];
+      LauncherBenchmarkAppendIndent(json, depth);
+    }
+    [json appendString:@"}"];
+
+  } else if ([object isKindOfClass:[NSString class]]) {
+    [json appendString:@"\""];
+    for (NSUInteger ix = 0; ix < [object length]; ++ix) {
+      unichar character = [object characterAtIndex:ix];
+      if ('"' == character || '\\' == character) {
+        [json appendFormat:@"\\%C", character];
+
+      } else if (character < 0x20) {
+        [json appendFormat:@"\\u%04x", character];
+
+      } else {
+        [json appendFormat:@"%C", character];
+      }
+    }
+    [json appendString:@"\""];
+
+  } else if ([object isKindOfClass:[NSNumber class]]) {
+    const char* type = [object objCType];
+    if (0 == strcmp(type, @encode(double)) || 0 == strcmp(type, @encode(float))) {
+      [json appendFormat:@"%.3f", [object doubleValue]];
+
+    } else {
+      [json appendString:[object stringValue]];
+    }
+
+  } else {
+    // Only plist types that JSON can represent are used in the results.
+    NIDASSERT(NO);
+    [json appendString:@"null"];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface LauncherBenchmark()
+
+- (void)runReloadDataPhase;
+- (void)runLayoutPhase;
+- (void)runPagingPhase;
+- (void)finish;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation LauncherBenchmark
+
+@synthesize numberOfPages         = _numberOfPages;
+@synthesize numberOfItemsPerPage  = _numberOfItemsPerPage;
+@synthesize numberOfIcons         = _numberOfIcons;
+@synthesize numberOfIterations    = _numberOfIterations;
+@synthesize delegate              = _delegate;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [_displayLink invalidate];
+  [_pagingTimer invalidate];
+
+  NI_RELEASE_SAFELY(_window);
+  NI_RELEASE_SAFELY(_launcherController);
+  NI_RELEASE_SAFELY(_displayLink);
+  NI_RELEASE_SAFELY(_pagingTimer);
+  NI_RELEASE_SAFELY(_metrics);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithWindow:(UIWindow *)window {
+  if ((self = [super init])) {
+    _window = [window retain];
+
+    _numberOfPages = kDefaultNumberOfPages;
+    _numberOfItemsPerPage = kDefaultNumberOfItemsPerPage;
+    _numberOfIcons = kDefaultNumberOfIcons;
+    _numberOfIterations = kDefaultNumberOfIterations;
+
+    _metrics = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Launcher Data
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Write numberOfIcons solid-colored icons to a temporary directory.
+ *
+ * @returns The paths of the icons.
+ */
+- (NSArray *)createIcons {
+  NSString* directory =
+  [NSTemporaryDirectory() stringByAppendingPathComponent:@"LauncherBenchmarkIcons"];
+  [[NSFileManager defaultManager] createDirectoryAtPath: directory
+                            withIntermediateDirectories: YES
+                                             attributes: nil
+                                                  error: nil];
+
+  NSMutableArray* iconPaths = [NSMutableArray arrayWithCapacity:_numberOfIcons];
+  CGRect iconRect = CGRectMake(0, 0, kIconDimensions, kIconDimensions);
+
+  for (NSInteger ixIcon = 0; ixIcon < _numberOfIcons; ++ixIcon) {
+    UIGraphicsBeginImageContext(iconRect.size);
+    [[UIColor colorWithHue: (CGFloat)ixIcon / (CGFloat)_numberOfIcons
+                saturation: 0.7
+                brightness: 0.9
+                     alpha: 1] setFill];
+    UIRectFill(iconRect);
+    UIImage* icon = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    NSString* iconPath = [directory stringByAppendingPathComponent:
+                          [NSString stringWithFormat:@"icon%d.png", ixIcon]];
+    [UIImagePNGRepresentation(icon) writeToFile:iconPath atomically:YES];
+    [iconPaths addObject:iconPath];
+  }
+
+  return iconPaths;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)pagesWithIconPaths:(NSArray *)iconPaths {
+  NSMutableArray* pages = [NSMutableArray arrayWithCapacity:_numberOfPages];
+  NSInteger ixIcon = 0;
+
+  for (NSInteger ixPage = 0; ixPage < _numberOfPages; ++ixPage) {
+    NSMutableArray* items = [NSMutableArray arrayWithCapacity:_numberOfItemsPerPage];
+
+    for (NSInteger ixItem = 0; ixItem < _numberOfItemsPerPage; ++ixItem) {
+      NSString* iconPath = nil;
+      if ([iconPaths count] > 0) {
+        iconPath = [iconPaths objectAtIndex:ixIcon];
+        ixIcon = (ixIcon + 1) % [iconPaths count];
+      }
+
+      NSString* title = [NSString stringWithFormat:@"Item %d", ixPage * _numberOfItemsPerPage
+                         + ixItem + 1];
+      [items addObject:[NILauncherItemDetails itemDetailsWithTitle: title
+                                                         imagePath: iconPath]];
+    }
+
+    [pages addObject:items];
+  }
+
+  return pages;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Measurement
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)sampleMemory {
+  _peakResidentBytes = MAX(_peakResidentBytes, LauncherBenchmarkResidentBytes());
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink {
+  [self sampleMemory];
+
+  if (_isWaitingForFirstFrame) {
+    // The launcher's first frame was committed at the end of the run loop pass that added it
+    // to the window and is on screen by this refresh.
+    _isWaitingForFirstFrame = NO;
+    [_metrics setObject: [NSNumber numberWithDouble:
+                          (CACurrentMediaTime() - _launcherAddedTime) * 1000]
+                 forKey: @"first_frame_latency_ms"];
+
+    [self performSelector:@selector(runReloadDataPhase) withObject:nil afterDelay:0];
+  }
+
+  if (_isTimingFrames) {
+    CFTimeInterval timestamp = displayLink.timestamp;
+    CFTimeInterval frameDuration = displayLink.duration;
+
+    if (_lastFrameTimestamp > 0 && frameDuration > 0) {
+      NSInteger elapsedFrames = lround((timestamp - _lastFrameTimestamp) / frameDuration);
+      _numberOfFrames += 1;
+      _numberOfDroppedFrames += MAX(0, elapsedFrames - 1);
+    }
+    _lastFrameTimestamp = timestamp;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)start {
+  NSArray* iconPaths = [self createIcons];
+
+  [_metrics removeAllObjects];
+  _baselineResidentBytes = LauncherBenchmarkResidentBytes();
+  _peakResidentBytes = _baselineResidentBytes;
+
+  [_launcherController.view removeFromSuperview];
+  NI_RELEASE_SAFELY(_launcherController);
+  _launcherController = [[NILauncherViewController alloc] initWithNibName:nil bundle:nil];
+  _launcherController.pages = [self pagesWithIconPaths:iconPaths];
+
+  [_displayLink invalidate];
+  NI_RELEASE_SAFELY(_displayLink);
+  _displayLink = [[CADisplayLink displayLinkWithTarget: self
+                                              selector: @selector(displayLinkDidFire:)] retain];
+  [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+
+  // Accessing the view loads it, which reloads the launcher's data.
+  _isWaitingForFirstFrame = YES;
+  _launcherAddedTime = CACurrentMediaTime();
+  _launcherController.view.frame = [UIScreen mainScreen].applicationFrame;
+  [_window addSubview:_launcherController.view];
+
+  [self sampleMemory];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runReloadDataPhase {
+  NILauncherView* launcherView = _launcherController.launcherView;
+  NSMutableArray* samples = [NSMutableArray arrayWithCapacity:_numberOfIterations];
+
+  for (NSInteger ixIteration = 0; ixIteration < _numberOfIterations; ++ixIteration) {
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+    CFTimeInterval startTime = CACurrentMediaTime();
+    [launcherView reloadData];
+    CFTimeInterval duration = CACurrentMediaTime() - startTime;
+
+    [self sampleMemory];
+    [pool release];
+
+    [samples addObject:[NSNumber numberWithDouble:duration]];
+  }
+
+  [_metrics setObject:LauncherBenchmarkSummary(samples) forKey:@"reload_data_ms"];
+
+  [self performSelector:@selector(runLayoutPhase) withObject:nil afterDelay:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runLayoutPhase {
+  NILauncherView* launcherView = _launcherController.launcherView;
+  NSMutableArray* samples = [NSMutableArray arrayWithCapacity:_numberOfIterations];
+
+  CGRect portraitFrame = launcherView.frame;
+  CGRect landscapeFrame = CGRectMake(portraitFrame.origin.x, portraitFrame.origin.y,
+                                     portraitFrame.size.height, portraitFrame.size.width);
+
+  for (NSInteger ixIteration = 0; ixIteration < _numberOfIterations; ++ixIteration) {
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+    CFTimeInterval startTime = CACurrentMediaTime();
+    launcherView.frame = (ixIteration % 2 == 0) ? landscapeFrame : portraitFrame;
+    CFTimeInterval duration = CACurrentMediaTime() - startTime;
+
+    [self sampleMemory];
+    [pool release];
+
+    [samples addObject:[NSNumber numberWithDouble:duration]];
+  }
+
+  launcherView.frame = portraitFrame;
+
+  [_metrics setObject:LauncherBenchmarkSummary(samples) forKey:@"layout_pages_ms"];
+
+  // Give any layout that was deferred to idle run loop passes a chance to finish so that it
+  // isn't counted against the paging phase.
+  [self performSelector:@selector(runPagingPhase) withObject:nil afterDelay:kPagingInterval];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)pageToNextPage {
+  ++_pagingTargetPage;
+
+  if (_pagingTargetPage >= _numberOfPages) {
+    [_pagingTimer invalidate];
+    NI_RELEASE_SAFELY(_pagingTimer);
+    _isTimingFrames = NO;
+
+    [_metrics setObject: [NSNumber numberWithInteger:_numberOfFrames]
+                 forKey: @"paging_frames"];
+    [_metrics setObject: [NSNumber numberWithInteger:_numberOfDroppedFrames]
+                 forKey: @"paging_dropped_frames"];
+
+    [self finish];
+    return;
+  }
+
+  [_launcherController.launcherView setCurrentPage:_pagingTargetPage animated:YES];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)runPagingPhase {
+  [_launcherController.launcherView setCurrentPage:0 animated:NO];
+
+  _pagingTargetPage = 0;
+  _numberOfFrames = 0;
+  _numberOfDroppedFrames = 0;
+  _lastFrameTimestamp = 0;
+  _isTimingFrames = YES;
+
+  _pagingTimer = [[NSTimer scheduledTimerWithTimeInterval: kPagingInterval
+                                                   target: self
+                                                 selector: @selector(pageToNextPage)
+                                                 userInfo: nil
+                                                  repeats: YES] retain];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)finish {
+  // The display link retains its target, so it must be invalidated to release the benchmark.
+  [_displayLink invalidate];
+  NI_RELEASE_SAFELY(_displayLink);
+
+  [self sampleMemory];
+  [_metrics setObject: [NSNumber numberWithUnsignedLongLong:_baselineResidentBytes]
+               forKey: @"baseline_resident_bytes"];
+  [_metrics setObject: [NSNumber numberWithUnsignedLongLong:_peakResidentBytes]
+               forKey: @"peak_resident_bytes"];
+
+  UIDevice* device = [UIDevice currentDevice];
+  NSDictionary* results =
+  [NSDictionary dictionaryWithObjectsAndKeys:
+   [NSNumber numberWithInteger:LauncherBenchmarkResultsFormatVersion], @"format_version",
+   [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithInteger:_numberOfPages], @"pages",
+    [NSNumber numberWithInteger:_numberOfItemsPerPage], @"items_per_page",
+    [NSNumber numberWithInteger:_numberOfIcons], @"icons",
+    [NSNumber numberWithInteger:_numberOfIterations], @"iterations",
+    nil], @"configuration",
+   [NSDictionary dictionaryWithObjectsAndKeys:
+    [device model], @"model",
+    [device systemName], @"system_name",
+    [device systemVersion], @"system_version",
+    nil], @"device",
+   [NSDictionary dictionaryWithDictionary:_metrics], @"metrics",
+   nil];
+
+  [_delegate launcherBenchmark:self didFinishWithResults:results];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSString *)JSONStringWithResults:(NSDictionary *)results {
+  NSMutableString* json = [NSMutableString string];
+  LauncherBenchmarkAppendJSON(json, results, 0);
+  [json appendString:@"\n"];
+  return json;
+}
+
+
+@end
@@ -10,13 +10,19 @@ This script provides a couple basic features for parsing pbxproj files:
 * Getting a dependency list
 * Adding one pbxproj to another pbxproj as a dependency
 
-Version 1.2.
+The project file is parsed once into an index of its objects. Parsed projects are cached on disk
+and edits are held in memory until save() writes them all at once.
+
+Version 1.3.
 
 History:
 1.0 - October 20, 2010: Initial hacked-together version finished. It is alive!
 1.1 - January 11, 2011: Add configuration settings to all configurations by default.
 1.2 - June 7, 2011: Rewrote the pbxproj family of code as an ios module and made the class
                     more generic (no assumptions made about the project layout).
+1.3 - October 14, 2026: Parse the object graph once instead of searching the project text for
+                        every query, cache parsed projects on disk, and batch edits into a
+                        single write.
 
 Branched from Three20's ttmodule script 2011-06-07.
 Created by Jeff Verkoeyen on 2010-10-18.
@@ -38,6 +44,7 @@ limitations under the License.
 
 import hashlib
 import logging
+import marshal
 import os
 import re
 import sys
@@ -45,256 +52,428 @@ from relpath import relpath
 
 pbxproj_cache = {}
 
+# Parsed projects are kept here between runs, keyed by the project's path. A cached project is
+# only used if the project file's contents hash to the same value. The file's size is checked
+# first so that most changes are caught without hashing.
+pbxproj_disk_cache_dir = os.path.join(os.path.expanduser('~'), '.nimbus', 'pbxproj-cache')
+
+# Bump this whenever the parsed format changes to ignore previously cached projects.
+pbxproj_disk_cache_version = 1
+
+# The objects that Xcode writes on a single line.
+single_line_isas = ('PBXBuildFile', 'PBXFileReference')
+
+# Tokens of the ASCII property list format that Xcode writes project files in. The groups are
+# numbered so that a match's lastindex is its kind.
+token_re = re.compile(r'''\s*(?:
+	(/\*.*?\*/|//[^\n]*)                # 1: comment
+	|("(?:[^"\\]|\\.)*")                # 2: quoted string
+	|((?:[^\s=;,(){}"/]|/(?![*/]))+)    # 3: bare string
+	|([=;,(){}])                        # 4: punctuation
+	)''', re.S | re.X)
+
+COMMENT_TOKEN = 1
+PUNCTUATION_TOKEN = 4
+
+section_marker_re = re.compile(r'/\* (Begin|End) (\w+) section \*/')
+
+# Strings made up of only these characters are written without quotes.
+unquoted_string_re = re.compile(r'^[A-Za-z0-9_./]+$')
+
+
+class PbxprojParseError(Exception):
+	pass
+
+
+# A string value that is written with a comment after it. GUIDs are commented with the name of
+# the object they refer to.
+class PbxString(str):
+	comment = None
+
+	def __new__(cls, value, comment = None):
+		string = str.__new__(cls, value)
+		string.comment = comment
+		return string
+
+
+def unquote(text):
+	if text[0] != '"':
+		return text
+	text = text[1:-1]
+	if '\\' not in text:
+		return text
+	escapes = {'n': '\n', 't': '\t', '"': '"', '\\': '\\'}
+	return re.sub(r'\\(.)', lambda match: escapes.get(match.group(1), match.group(1)), text)
+
+
+def quote(text):
+	if unquoted_string_re.match(text):
+		return text
+	text = text.replace('\\', '\\\\').replace('"', '\\"').replace('\n', '\\n')
+	return '"'+text+'"'
+
+
+# Formats a value the way that Xcode writes it.
+#
+# indent is the indentation level of the line that the value starts on.
+def format_value(value, indent, single_line = False):
+	if isinstance(value, dict):
+		keys = sorted(value.keys(), key = lambda key: (key != 'isa', key))
+		if single_line:
+			return '{'+''.join([key+' = '+format_value(value[key], 0, True)+'; ' for key in keys])+'}'
+		text = '{\n'
+		for key in keys:
+			text += '\t' * (indent + 1) + key + ' = ' + format_value(value[key], indent + 1) + ';\n'
+		return text + '\t' * indent + '}'
+
+	if isinstance(value, list):
+		if single_line:
+			return '('+''.join([format_value(item, 0, True)+', ' for item in value])+')'
+		text = '(\n'
+		for item in value:
+			text += '\t' * (indent + 1) + format_value(item, indent + 1) + ',\n'
+		return text + '\t' * indent + ')'
+
+	text = quote(value)
+	comment = getattr(value, 'comment', None)
+	if comment:
+		text += ' /* '+comment+' */'
+	return text
+
+
+# Reads the object graph out of a project file in a single pass.
+#
+# The values are plain dicts, lists and strings so that they can be cached cheaply. Alongside
+# them, the parser records where the entries of every multi-line dictionary sit in the file so
+# that edits can be made by inserting text without disturbing the rest of the file. Xcode writes
+# everything that can be edited this way on multiple lines.
+class PbxprojParser(object):
+	def __init__(self, data):
+		self._data = data
+
+		# Section name -> {'begin': offset after the Begin marker, 'end': offset after the End marker}.
+		self.sections = {}
+
+		# Key path from the root -> (indent, close offset, {key: (line start, value start, value end)})
+		#
+		# The indent is the indentation level of the dictionary's entries and the close offset is
+		# where the line with the closing brace begins.
+		self.layouts = {}
+
+		# The GUIDs of the objects in the order that they appear in the file.
+		self.object_order = []
+
+		self._texts = []
+		self._starts = []
+		self._index = 0
+
+	def parse(self):
+		self._tokenize()
+		try:
+			root = self._read_value(())
+		except IndexError:
+			self._fail("Unexpected end of file")
+		if self._index != len(self._texts):
+			self._fail("Unexpected data after the root object")
+		return root
+
+	def _fail(self, message):
+		offset = len(self._data)
+		if self._index < len(self._starts):
+			offset = self._starts[self._index]
+		line = self._data.count('\n', 0, offset) + 1
+		raise PbxprojParseError(message+" on line "+str(line))
+
+	def _tokenize(self):
+		data = self._data
+		texts = self._texts
+		starts = self._starts
+		offset = 0
+
+		for match in token_re.finditer(data):
+			if match.start() != offset:
+				break
+			offset = match.end()
+
+			kind = match.lastindex
+			if kind == COMMENT_TOKEN:
+				marker = section_marker_re.match(match.group(kind))
+				if marker:
+					(begin_or_end, name) = marker.groups()
+					section = self.sections.setdefault(name, {})
+					section[begin_or_end.lower()] = self._offset_after_newline(offset)
+			else:
+				texts.append(match.group(kind))
+				starts.append(match.start(kind))
+
+		if data[offset:].strip():
+			line = data.count('\n', 0, offset) + 1
+			raise PbxprojParseError("Unexpected character on line "+str(line))
+
+	def _offset_after_newline(self, offset):
+		if self._data.startswith('\n', offset):
+			return offset + 1
+		return offset
+
+	# Where the line that contains the offset begins, or the offset itself if there is anything
+	# other than indentation before it on the line.
+	def _line_start(self, offset):
+		line_start = self._data.rfind('\n', 0, offset) + 1
+		if self._data[line_start:offset].strip('\t '):
+			return offset
+		return line_start
+
+	# path is the key path to the value, or None if its layout doesn't need to be recorded.
+	def _read_value(self, path):
+		text = self._texts[self._index]
+		if text == '{':
+			return self._read_dict(path)
+		if text == '(':
+			return self._read_list()
+		if len(text) == 1 and text in '=;,)}':
+			self._fail("Unexpected '"+text+"'")
+
+		self._index += 1
+		return unquote(text)
+
+	def _read_dict(self, path):
+		data = self._data
+		texts = self._texts
+		starts = self._starts
+
+		open_offset = starts[self._index]
+		self._index += 1
+
+		result = {}
+
+		entries = None
+		if path is not None and data.startswith('\n', open_offset + 1):
+			entries = {}
+			line_start = data.rfind('\n', 0, open_offset) + 1
+			indent = len(data[line_start:open_offset]) - len(data[line_start:open_offset].lstrip('\t')) + 1
+		is_objects = (path == ('objects',))
+
+		while True:
+			text = texts[self._index]
+			if text == '}':
+				if entries is not None:
+					close_offset = self._line_start(starts[self._index])
+					self.layouts[path] = (indent, close_offset, entries)
+				self._index += 1
+				return result
+
+			key = unquote(text)
+			key_start = starts[self._index]
+			if texts[self._index + 1] != '=':
+				self._index += 1
+				self._fail("Expected '='")
+			self._index += 2
+
+			value_start = starts[self._index]
+			if entries is not None:
+				value = self._read_value(path + (key,))
+			else:
+				value = self._read_value(None)
+
+			if texts[self._index] != ';':
+				self._fail("Expected ';'")
+			if entries is not None:
+				entries[key] = (self._line_start(key_start), value_start, starts[self._index])
+			self._index += 1
+
+			result[key] = value
+			if is_objects:
+				self.object_order.append(key)
+
+	def _read_list(self):
+		texts = self._texts
+		self._index += 1
+
+		result = []
+		while True:
+			if texts[self._index] == ')':
+				self._index += 1
+				return result
+
+			result.append(self._read_value(None))
+
+			if texts[self._index] == ',':
+				self._index += 1
+
+
 class PbxprojTarget(object):
 	def __init__(self, name, project, guid = None):
 		self._name = name
 		self._project = project
-		
-		# This target's GUID.
-		self._guid = guid
-		
-		# The configuration list GUID points to the list of configurations for a given target.
-		self._configuration_list_guid = None
-		
-		# The list of configuration GUIDs for this target.
-		self._configuration_guids = None
-		
+
+		# This target's GUID, without the comment it may have been parsed with.
+		self._guid = guid and str(guid)
+
 		# The GUID for the resources build phase.
 		self._resources_build_phase_guid = None
-		
+
 		# The GUID for the frameworks builds phase.
 		self._frameworks_build_phase_guid = None
-		
-		# An array of dependency GUIDs.
-		self._dependency_guids = None
-		
-		# An array of dependency names in the same order as the dependency guids array.
-		self._dependency_names = None
-		
-		# An array of path:target strings.
-		self._dependency_paths = None
-		
-		# This target's product GUID.
-		self._product_guid = None
-		
-		# This target's product name.
-		self._product_name = None
 
 
 	def name(self):
 		return self._name
 
 
-	def configuration_list_guid(self):
-		if self._configuration_list_guid is None:
-			project_data = project.get_project_data()
+	def _object(self):
+		return self._project.object_for_guid(self.guid())
 
-			result = re.search('[A-Z0-9]+ \/\* '+re.escape(self._name)+' \*\/ = {\n[ \t]+isa = PBXNativeTarget;(?:.|\n)+?buildConfigurationList = ([A-Z0-9]+) \/\* Build configuration list for PBXNativeTarget "'+re.escape(self._name)+'" \*\/;',
-			                   project_data)
 
-			if result:
-				(self._configuration_list_guid, ) = result.groups()
-			else:
-				# False indicates that we could not find a configuration list GUID.
-				self._configuration_list_guid = False
-		
-		return self._configuration_list_guid
+	def configuration_list_guid(self):
+		target = self._object()
+		if target is None or 'buildConfigurationList' not in target:
+			# False indicates that we could not find a configuration list GUID.
+			return False
 
+		return target['buildConfigurationList']
 
+
+	# Returns a list of (guid, name) tuples.
 	def configuration_guids(self):
-		if not self._configuration_guids and self.configuration_list_guid():
-			project_data = project.get_project_data()
+		configuration_list = self._project.object_for_guid(self.configuration_list_guid())
+		if configuration_list is None:
+			logging.error("Couldn't find the configuration list for the project.")
+			return False
 
-			match = re.search(re.escape(self.configuration_list_guid())+' \/\* Build configuration list for PBXNativeTarget "'+re.escape(self._name)+'" \*\/ = \{\n[ \t]+isa = XCConfigurationList;\n[ \t]+buildConfigurations = \(\n((?:.|\n)+?)\);', project_data)
-			if not match:
-				logging.error("Couldn't find the configuration list for the project.")
-				return False
+		configuration_guids = []
+		for guid in configuration_list.get('buildConfigurations', []):
+			configuration = self._project.object_for_guid(guid)
+			if configuration is not None:
+				configuration_guids.append((guid, configuration.get('name')))
 
-			(configuration_list,) = match.groups()
-			self._configuration_guids = re.findall('[ \t]+([A-Z0-9]+) \/\* (.+) \*\/,\n', configuration_list)
-		
-		return self._configuration_guids
+		return configuration_guids
 
 
 	def guid(self):
 		if not self._guid:
-			project_data = self._project.get_project_data()
-			result = re.search('([A-Z0-9]+) \/\* '+re.escape(self._name)+' \*\/ = {\n[ \t]+isa = PBXNativeTarget;(?:.|\n)+?buildPhases =',
-			                   project_data)
-	
-			if not result:
+			guid = self._project.target_guid_for_name(self._name)
+			self._guid = guid and str(guid)
+
+			if not self._guid:
 				logging.error("Can't recover: Unable to find the GUID for the target named \""+self._name+"\" from the project loaded from: "+self._project.path())
 				return False
 
-			(self._guid, ) = result.groups()
-		
 		return self._guid
 
 
-	def _gather_build_phases(self):	
-		project_data = self._project.get_project_data()
-		
-		result = re.search('[A-Z0-9]+ \/\* '+re.escape(self._name)+' \*\/ = {\n[ \t]+isa = PBXNativeTarget;(?:.|\n)+?buildPhases = \(\n((?:.|\n)+?)\);',
-		                   project_data)
-	
-		if not result:
+	def _gather_build_phases(self):
+		target = self._object()
+		if target is None:
 			logging.error("Can't recover: Unable to find the build phases for the target named \""+self._name+"\" from the project loaded from: "+self._project.path())
 			return False
 
-		(build_phases, ) = result.groups()
-
 		# Get the build phases we care about.
 
-		match = re.search('([A-Z0-9]+) \/\* Resources \*\/', build_phases)
-		if match:
-			(self._resources_build_phase_guid, ) = match.groups()
-		else:
-			self._resources_build_phase_guid = False
-		
-		match = re.search('([A-Z0-9]+) \/\* Frameworks \*\/', build_phases)
-		if not match:
+		self._resources_build_phase_guid = False
+		for guid in target.get('buildPhases', []):
+			phase = self._project.object_for_guid(guid)
+			if phase is None:
+				continue
+			if phase['isa'] == 'PBXResourcesBuildPhase':
+				self._resources_build_phase_guid = guid
+			elif phase['isa'] == 'PBXFrameworksBuildPhase':
+				self._frameworks_build_phase_guid = guid
+
+		if not self._frameworks_build_phase_guid:
 			logging.error("Couldn't find the Frameworks phase for the target named \""+self._name+"\" from the project loaded from: "+self._project.path())
 			logging.error("Please add a New Link Binary With Libraries Build Phase to your target")
 			logging.error("Right click your target in the project, then click Add, then New Build Phase,")
 			logging.error("  \"New Link Binary With Libraries Build Phase\"")
 			return False
 
-		(self._frameworks_build_phase_guid, ) = match.groups()
-
 
 	def resources_build_phase_guid(self):
 		if not self._resources_build_phase_guid:
 			self._gather_build_phases()
-		
+
 		return self._resources_build_phase_guid
 
 
 	def frameworks_build_phase_guid(self):
 		if not self._frameworks_build_phase_guid:
 			self._gather_build_phases()
-		
+
 		return self._frameworks_build_phase_guid
 
 
 	def dependency_guids(self):
-		if not self._dependency_guids:
-			project_data = self._project.get_project_data()
-
-			result = re.search(re.escape(self.guid())+' \/\* '+re.escape(self._name)+' \*\/ = {\n[ \t]+isa = PBXNativeTarget;(?:.|\n)+?dependencies = \(\n((?:[ \t]+[A-Z0-9]+ \/\* PBXTargetDependency \*\/,\n)*)[ \t]*\);\n',
-			                   project_data)
-	
-			if not result:
-				logging.error("Unable to get dependencies from: "+self._project.path())
-				return False
-	
-			(dependency_set, ) = result.groups()
-			self._dependency_guids = re.findall('[ \t]+([A-Z0-9]+) \/\* PBXTargetDependency \*\/,\n', dependency_set)
-		
-		return self._dependency_guids
+		target = self._object()
+		if target is None or 'dependencies' not in target:
+			logging.error("Unable to get dependencies from: "+self._project.path())
+			return False
+
+		return list(target['dependencies'])
 
 
 	def dependency_names(self):
-		if not self._dependency_names:
-			project_data = self._project.get_project_data()
-			dependency_names = []
+		dependency_names = []
 
-			for guid in self.dependency_guids():
-				result = re.search(guid+' \/\* PBXTargetDependency \*\/ = \{\n[ \t]+isa = PBXTargetDependency;\n[ \t]*name = (["a-zA-Z0-9\.\-]+);',
-				                   project_data)
+		for guid in self.dependency_guids() or []:
+			dependency = self._project.object_for_guid(guid)
+			if dependency is None:
+				continue
 
-				if result:
-					(dependency_name, ) = result.groups()
-					dependency_names.append(dependency_name)
+			if 'name' in dependency:
+				dependency_names.append(dependency['name'])
+			else:
+				target = self._project.object_for_guid(dependency.get('target'))
+				if target is not None and 'name' in target:
+					dependency_names.append(target['name'])
 
-			self._dependency_names = dependency_names
-		
-		return self._dependency_names
+		return dependency_names
 
-	def dependency_paths(self):
-		if self._dependency_paths:
-			return self._dependency_paths
 
+	# Returns a list of path:target strings.
+	def dependency_paths(self):
 		dependency_guids = self.dependency_guids()
-		if dependency_guids:
-			project_data = self._project.get_project_data()
-			
-			target_proxy_guids = []
-			
-			for guid in dependency_guids:
-				result = re.search(guid+' \/\* PBXTargetDependency \*\/ = \{\n(?:.|\n)+?targetProxy = ([A-Z0-9]+) \/\* PBXContainerItemProxy \*\/;',
-				                   project_data)
-				
-				if result:
-					(target_proxy_guid, ) = result.groups()
-					target_proxy_guids.append(target_proxy_guid)
-
-			container_portal_guids = []
-			remote_guids = []
-			
-			for guid in target_proxy_guids:
-				result = re.search(guid+' \/\* PBXContainerItemProxy \*\/ = \{\n(?:.|\n)+?containerPortal = ([A-Z0-9]+) \/\* .+? \*\/;(?:.|\n)+?remoteGlobalIDString = ([A-Z0-9]+)',
-				                   project_data)
-				
-				if result:
-					(container_portal_guid, remote_guid, ) = result.groups()
-					container_portal_guids.append(container_portal_guid)
-					remote_guids.append(remote_guid)
-
-			dependency_paths = []
-
-			index = 0
-			for guid in container_portal_guids:
-				result = re.search(guid+' \/\* .+? \*\/ = {isa = PBXFileReference; lastKnownFileType = "wrapper.pb-project"; name = .+?; path = (.+?); sourceTree = .+?; };',
-				                   project_data)
-				
-				if result:
-					(dependency_path, ) = result.groups()
-					dependency_path = dependency_path + ":" + remote_guids[index]
-					dependency_paths.append(dependency_path)
-				else:
-					logging.error("Unable to find the path for GUID: "+guid)
-				
-				index += 1
-
-			if len(dependency_paths) != len(container_portal_guids):
-				logging.error("Unable to load all dependency information from the project.")
-				return False
-
-			self._dependency_paths = dependency_paths
-			
-		elif dependency_guids is not None and dependency_guids is not False and len(dependency_guids) == 0:
-			self._dependency_paths = []
+		if dependency_guids is False:
+			return None
 
-		return self._dependency_paths
+		project = self._project
+		dependency_paths = []
 
+		for guid in dependency_guids:
+			dependency = project.object_for_guid(guid)
+			proxy = project.object_for_guid(dependency and dependency.get('targetProxy'))
+			if proxy is None:
+				continue
 
-	def _gather_product_details(self):
-		project_data = self._project.get_project_data()
+			container_portal_guid = proxy.get('containerPortal')
+			container_portal = project.object_for_guid(container_portal_guid)
 
-		result = re.search(re.escape(self.guid())+' \/\* '+re.escape(self._name)+' \*\/ = {\n[ \t]+isa = PBXNativeTarget;(?:.|\n)+?productReference = ([A-Z0-9]+) \/\* (.+?) \*\/;',
-		                   project_data)
+			if (container_portal is None
+			    or container_portal.get('lastKnownFileType') != 'wrapper.pb-project'
+			    or 'path' not in container_portal):
+				logging.error("Unable to find the path for GUID: "+str(container_portal_guid))
+				logging.error("Unable to load all dependency information from the project.")
+				return False
 
-		if not result:
-			logging.error("Unable to get product guid from: "+self.path())
-			return False
+			dependency_paths.append(container_portal['path'] + ":" + proxy.get('remoteGlobalIDString', ''))
 
-		(self._product_guid, self._product_name, ) = result.groups()
-		
-		return True
+		return dependency_paths
 
 
 	def product_guid(self):
-		if not self._product_guid:
-			self._gather_product_details()
+		target = self._object()
+		if target is None or 'productReference' not in target:
+			logging.error("Unable to get product guid from: "+self._project.path())
+			return None
 
-		return self._product_guid
+		return target['productReference']
 
 
 	def product_name(self):
-		if not self._product_name:
-			self._gather_product_details()
+		product_guid = self.product_guid()
+		if product_guid is None:
+			return None
 
-		return self._product_name
+		product = self._project.object_for_guid(product_guid)
+		return product and product.get('path')
 
 
 class pbxproj(object):
@@ -307,11 +486,27 @@ class pbxproj(object):
 		return pbxproj_cache[path]
 
 	def __init__(self, path, xcode_version = None):
-		# The contents of the pbxproj file loaded into memory.
+		# The contents of the pbxproj file as it was loaded from disk.
 		self._project_data = None
-		
+
+		# The parsed contents of the pbxproj file.
+		self._root = None
+
+		# Offsets of the Begin and End markers of each section in the project data.
+		self._sections = None
+
+		# Edits waiting to be written by save(). Each edit replaces a range of the loaded
+		# project data with text that is only rendered once the project is saved.
+		self._edits = []
+
+		# Objects added since the project was loaded, grouped by section.
+		self._new_objects_by_section = {}
+
+		# The (dictionary id, key) pairs of values that will be rendered by an edit.
+		self._pending_values = set()
+
 		self._active_target = None
-		
+
 		self._project_name = os.path.basename(os.path.dirname(path)).replace('.xcodeproj', '')
 
 		# The path to the pbxproj file.
@@ -319,15 +514,12 @@ class pbxproj(object):
 
 		# Mapping of target names to PbxprojTarget objects.
 		self._targets_by_name = {}
-		
+
 		# Mapping of target guids to PbxprojTarget objects.
 		self._targets_by_guid = {}
-		
+
 		# ???
 		self._xcode_version = xcode_version
-		
-		# The file format version for this project.
-		self._file_format_version = None
 
 		self._is_loaded = self._load_from_disk()
 
@@ -352,7 +544,7 @@ class pbxproj(object):
 	def active_target(self):
 		if self._active_target is None:
 			return None
-		
+
 		return self.target_by_name(self._active_target)
 
 	def set_active_target(self, target_name):
@@ -364,89 +556,330 @@ class pbxproj(object):
 		return os.path.dirname(self.path())
 
 	def version(self):
-		if not self._file_format_version:
-			result = re.search('\tobjectVersion = ([0-9]+);', project_data)
-
-			if not result:
-				logging.error("Can't recover: unable to find the project version for your target at: "+self.path())
-				return False
-	
-			(self._file_format_version,) = result.groups()
-			self._file_format_version = int(self._file_format_version)
+		if self._root is None or 'objectVersion' not in self._root:
+			logging.error("Can't recover: unable to find the project version for your target at: "+self.path())
+			return False
 
-		return self._file_format_version
+		return int(self._root['objectVersion'])
 
 	# Fetch a specific target by its name.
 	def target_by_name(self, name):
 		if name in self._targets_by_guid:
-			target = self._targets_by_guid[name]
-			target._guid = name
-			return target
+			return self._targets_by_guid[name]
 
 		if name not in self._targets_by_name:
 			target = PbxprojTarget(name, self)
 			self._targets_by_name[name] = target
-			self._targets_by_guid[target.guid()] = target
-		
+			if target.guid():
+				self._targets_by_guid[target.guid()] = target
+
 		return self._targets_by_name[name]
 
-	# Load the project data from disk.
+	def target_guid_for_name(self, name):
+		for guid in self._project_object().get('targets', []):
+			target = self.object_for_guid(guid)
+			if target is not None and target.get('name') == name:
+				return guid
+		return None
+
+	def object_for_guid(self, guid):
+		if not guid or self._root is None:
+			return None
+		return self._objects.get(guid)
+
+	# The project data with any unsaved edits applied.
 	def get_project_data(self):
-		if self._project_data is None:
-			if not os.path.exists(self.path()):
-				logging.info("Couldn't find the project at this path:")
-				logging.info(self.path())
-				return None
+		if self._project_data is None or not self._edits:
+			return self._project_data
 
-			project_file = open(self.path(), 'r')
-			self._project_data = project_file.read()
+		project_data = self._project_data
+		pieces = []
+		offset = 0
+		for (start, end, sequence, render) in sorted(self._edits):
+			pieces.append(project_data[offset:start])
+			pieces.append(render())
+			offset = max(offset, end)
+		pieces.append(project_data[offset:])
 
-		return self._project_data
+		return ''.join(pieces)
 
-	# Write the project data to disk.
+	# Replace the project data, discarding any unsaved edits.
 	def set_project_data(self, project_data, flush=False):
-		if self._project_data != project_data or flush:
-			self._project_data = project_data
+		if self._project_data != project_data or self._edits or flush:
+			self._load_from_data(project_data)
 			if flush:
-				project_file = open(self.path(), 'w')
-				project_file.write(self._project_data)
+				self.save(force = True)
+
+	# Whether there are edits that haven't been written to disk yet.
+	def has_unsaved_changes(self):
+		return len(self._edits) > 0
+
+	# Write every edit made since the project was loaded to disk at once.
+	def save(self, force = False):
+		if not self._edits and not force:
+			return True
 
-	def _load_from_disk(self):
 		project_data = self.get_project_data()
+		project_file = open(self.path(), 'w')
+		project_file.write(project_data)
+		project_file.close()
+
+		return self._load_from_data(project_data)
 
-		if project_data is None:
+	def _load_from_disk(self):
+		if not os.path.exists(self.path()):
+			logging.info("Couldn't find the project at this path:")
+			logging.info(self.path())
 			logging.error("Can't recover: unable to load the project data from disk, check the path:\n    path: \""+self.path()+"\"")
 			return False
 
-		self._gather_all_targets()
+		project_file = open(self.path(), 'r')
+		project_data = project_file.read()
+		project_file.close()
 
-		return True
+		return self._load_from_data(project_data)
 
-	def _gather_all_targets(self):
-		project_data = self.get_project_data()
-		
-		result = re.search('targets = \(\n((?:.|\n)+?)\);',
-		                   project_data)
-		
-		if not result:
-			logging.error("Couldn't find any targets.")
+	def _load_from_data(self, project_data):
+		self._project_data = project_data
+		self._edits = []
+		self._new_objects_by_section = {}
+		self._pending_values = set()
+		self._targets_by_name = {}
+		self._targets_by_guid = {}
+
+		parsed = self._load_from_disk_cache(project_data)
+		if parsed is None:
+			try:
+				parser = PbxprojParser(project_data)
+				root = parser.parse()
+			except PbxprojParseError, e:
+				logging.error("Can't recover: unable to parse the project at: "+self.path())
+				logging.error(str(e))
+				self._root = None
+				return False
+			parsed = (root, parser.sections, parser.layouts, parser.object_order)
+			self._store_in_disk_cache(project_data, parsed)
+
+		(self._root, self._sections, layouts, self._object_order) = parsed
+		if not isinstance(self._root, dict) or not isinstance(self._root.get('objects'), dict):
+			logging.error("Can't recover: the project has no objects: "+self.path())
+			self._root = None
+			return False
+
+		self._objects = self._root['objects']
+
+		# The layouts of the parsed dictionaries, looked up by the dictionaries themselves.
+		self._layouts_by_id = {}
+		for (path, layout) in layouts.items():
+			dictionary = self._root
+			for key in path:
+				dictionary = dictionary[key]
+			self._layouts_by_id[id(dictionary)] = layout
+
+		self._index_objects()
+
+		return self._gather_all_targets() is not None
+
+	def _disk_cache_path(self):
+		key = hashlib.sha1(os.path.abspath(self.path())).hexdigest()
+		return os.path.join(pbxproj_disk_cache_dir, key)
+
+	# Returns the parsed project if the given project data has been parsed before.
+	def _load_from_disk_cache(self, project_data):
+		try:
+			cache_file = open(self._disk_cache_path(), 'rb')
+			try:
+				entry = marshal.load(cache_file)
+			finally:
+				cache_file.close()
+			(version, mtime, size, digest, parsed) = entry
+		except Exception:
+			return None
+
+		if version != pbxproj_disk_cache_version:
 			return None
-		
-		(target_list, ) = result.groups()
 
-		targets = re.findall('([A-Z0-9]+) \/\* (.+?) \*\/', target_list)
+		# A change in size is a cheap way to tell that the file has changed, but an unchanged size
+		# and modification time don't mean that it hasn't, so the contents are always compared.
+		if size != len(project_data):
+			return None
+		if digest != hashlib.sha1(project_data).hexdigest():
+			return None
+
+		if mtime != os.stat(self.path()).st_mtime:
+			# The file was touched without being changed.
+			self._store_in_disk_cache(project_data, parsed)
+
+		logging.info("Loaded the parsed project from the cache: "+self.path())
+		return parsed
+
+	def _store_in_disk_cache(self, project_data, parsed):
+		entry = (pbxproj_disk_cache_version,
+		         os.stat(self.path()).st_mtime,
+		         len(project_data),
+		         hashlib.sha1(project_data).hexdigest(),
+		         parsed)
+
+		try:
+			if not os.path.isdir(pbxproj_disk_cache_dir):
+				os.makedirs(pbxproj_disk_cache_dir)
+			cache_file = open(self._disk_cache_path(), 'wb')
+			try:
+				marshal.dump(entry, cache_file)
+			finally:
+				cache_file.close()
+		except (IOError, OSError, ValueError), e:
+			logging.info("Unable to cache the parsed project: "+str(e))
+
+	# Build the lookup tables that the queries and edits use.
+	def _index_objects(self):
+		self._buildfile_guids_by_fileref = {}
+		self._fileref_guids_by_type_and_path = {}
+		self._group_guids_by_name = {}
+		self._target_dependency_guids_by_name = {}
+		self._configuration_guids_by_name = {}
+
+		for guid in self._object_order:
+			self._index_object(guid, self._objects[guid])
+
+	def _index_object(self, guid, obj):
+		isa = obj.get('isa')
+		if isa == 'PBXBuildFile':
+			self._buildfile_guids_by_fileref.setdefault(obj.get('fileRef'), guid)
+
+		elif isa == 'PBXFileReference':
+			key = (obj.get('lastKnownFileType'), obj.get('name'), obj.get('path'))
+			self._fileref_guids_by_type_and_path.setdefault(key, guid)
+
+		elif isa == 'PBXGroup':
+			# Xcode names groups by their path when they don't have a name.
+			name = obj.get('name', obj.get('path'))
+			if name is not None:
+				self._group_guids_by_name.setdefault(name, guid)
+
+		elif isa == 'PBXTargetDependency':
+			if 'name' in obj:
+				self._target_dependency_guids_by_name.setdefault(obj['name'], guid)
+
+		elif isa == 'XCBuildConfiguration':
+			self._configuration_guids_by_name.setdefault(obj.get('name'), []).append(guid)
+
+	def _project_object(self):
+		if self._root is None:
+			return {}
+		return self.object_for_guid(self._root.get('rootObject')) or {}
+
+	def _gather_all_targets(self):
+		targets = self._project_object().get('targets')
+
 		if not targets:
-			logging.error("Unable to read the targets.")
+			logging.error("Couldn't find any targets.")
 			return None
-		
-		for target in targets:
-			name = target[1]
-			target = PbxprojTarget(name, project = self, guid = target[0])
+
+		for guid in targets:
+			target = self.object_for_guid(guid)
+			if target is None or 'name' not in target:
+				logging.error("Unable to read the targets.")
+				return None
+
+			name = target['name']
+			target = PbxprojTarget(name, project = self, guid = guid)
 			self._targets_by_name[name] = target
-			self._targets_by_guid[target.guid()] = target
+			self._targets_by_guid[guid] = target
 
 		return True
 
+	def _add_edit(self, start, end, render):
+		self._edits.append((start, end, len(self._edits), render))
+
+	# Add a new object to the project. It is written at the top of its section.
+	def _add_object(self, guid, obj, comment):
+		isa = obj['isa']
+
+		self._objects[guid] = obj
+		self._object_order.append(guid)
+		self._index_object(guid, obj)
+
+		if isa not in self._new_objects_by_section:
+			self._new_objects_by_section[isa] = []
+
+			section = self._sections.get(isa)
+			if section is not None and 'begin' in section:
+				self._add_edit(section['begin'], section['begin'],
+				               lambda: self._render_objects_in_section(isa))
+			else:
+				offset = self._offset_for_new_section(isa)
+				self._add_edit(offset, offset,
+				               lambda: ("\n/* Begin "+isa+" section */\n"
+				                        + self._render_objects_in_section(isa)
+				                        + "/* End "+isa+" section */\n"))
+
+		self._new_objects_by_section[isa].append((guid, comment))
+
+	def _render_objects_in_section(self, isa):
+		text = ''
+		for (guid, comment) in self._new_objects_by_section[isa]:
+			obj = self._objects[guid]
+			text += '\t\t'+format_value(PbxString(guid, comment), 2)+' = '
+			text += format_value(obj, 2, isa in single_line_isas)+';\n'
+		return text
+
+	# Xcode orders the sections by name.
+	def _offset_for_new_section(self, isa):
+		preceding_names = [name for name in self._sections if name < isa and 'end' in self._sections[name]]
+		if preceding_names:
+			return self._sections[max(preceding_names)]['end']
+
+		# Place the section at the top of the objects.
+		(indent, close_offset, entries) = self._layouts_by_id[id(self._objects)]
+		if entries:
+			return min([line_start for (line_start, value_start, value_end) in entries.values()])
+		return close_offset
+
+	# Add an item to a list in a dictionary that is either part of the loaded project or new.
+	def _append_to_list(self, dictionary, key, item):
+		dictionary[key].append(item)
+
+		layout = self._layouts_by_id.get(id(dictionary))
+		if layout is None or (id(dictionary), key) in self._pending_values:
+			# The list is rendered when the project is saved.
+			return
+
+		(indent, close_offset, entries) = layout
+		(line_start, value_start, value_end) = entries[key]
+
+		# The items are written on the lines after the opening parenthesis.
+		offset = value_start + 1
+		if self._project_data.startswith('\n', offset):
+			offset += 1
+		indent += 1
+		self._add_edit(offset, offset, lambda: '\t' * indent + format_value(item, indent) + ',\n')
+
+	# Set a value in a dictionary that is either part of the loaded project or new.
+	def _set_value(self, dictionary, key, value):
+		had_key = key in dictionary
+		dictionary[key] = value
+
+		layout = self._layouts_by_id.get(id(dictionary))
+		if layout is None or (id(dictionary), key) in self._pending_values:
+			# The value is rendered when the project is saved.
+			return
+		self._pending_values.add((id(dictionary), key))
+
+		(indent, close_offset, entries) = layout
+		if had_key:
+			(line_start, value_start, value_end) = entries[key]
+			self._add_edit(value_start, value_end, lambda: format_value(dictionary[key], indent))
+			return
+
+		# Keep the keys in the same order that Xcode writes them.
+		following_keys = [other for other in entries if other != 'isa' and other > key]
+		if following_keys:
+			offset = entries[min(following_keys)][0]
+		else:
+			offset = close_offset
+		self._add_edit(offset, offset,
+		               lambda: '\t' * indent + key + ' = ' + format_value(dictionary[key], indent) + ';\n')
 
 	def dependency_names_for_target_name(self, target_name):
 		target = self.target_by_name(target_name)
@@ -465,33 +898,18 @@ class pbxproj(object):
 	# Returns: <default_guid> if a line was added.
 	#          Otherwise, the existing guid is returned.
 	def add_buildfile(self, name, file_ref_hash, default_guid):
-		project_data = self.get_project_data()
-
-		match = re.search('\/\* Begin PBXBuildFile section \*\/\n((?:.|\n)+?)\/\* End PBXBuildFile section \*\/', project_data)
-
-		if not match:
-			logging.error("Couldn't find PBXBuildFile section.")
-			return None
-
-		(subtext, ) = match.groups()
+		buildfile_hash = self._buildfile_guids_by_fileref.get(file_ref_hash)
 
-		buildfile_hash = None
-		
-		match = re.search('([A-Z0-9]+).+?fileRef = '+re.escape(file_ref_hash), subtext)
-		if match:
-			(buildfile_hash, ) = match.groups()
+		if buildfile_hash is not None:
 			logging.info("This build file already exists: "+buildfile_hash)
-		
-		if buildfile_hash is None:
-			match = re.search('\/\* Begin PBXBuildFile section \*\/\n', project_data)
-
+		else:
 			buildfile_hash = default_guid
-		
-			libfiletext = "\t\t"+buildfile_hash+" /* "+name+" in Frameworks */ = {isa = PBXBuildFile; fileRef = "+file_ref_hash+" /* "+name+" */; };\n"
-			project_data = project_data[:match.end()] + libfiletext + project_data[match.end():]
-		
-		self.set_project_data(project_data)
-		
+
+			buildfile = {}
+			buildfile['isa'] = 'PBXBuildFile'
+			buildfile['fileRef'] = PbxString(file_ref_hash, name)
+			self._add_object(buildfile_hash, buildfile, name+" in Frameworks")
+
 		return buildfile_hash
 
 	# Add a line to the PBXFileReference section.
@@ -501,36 +919,24 @@ class pbxproj(object):
 	# Returns: <default_guid> if a line was added.
 	#          Otherwise, the existing guid is returned.
 	def add_filereference(self, name, file_type, default_guid, rel_path, source_tree):
-		project_data = self.get_project_data()
-
-		quoted_rel_path = '"'+rel_path.strip('"')+'"'
-
-		fileref_hash = None
-
-		match = re.search('([A-Z0-9]+) \/\* '+re.escape(name)+' \*\/ = \{isa = PBXFileReference; lastKnownFileType = "wrapper.'+file_type+'"; name = '+re.escape(name)+'; path = '+re.escape(rel_path)+';', project_data)
+		rel_path = rel_path.strip('"')
 
-		if not match:
-			# Check again for quoted versions, just to be sure.
-			match = re.search('([A-Z0-9]+) \/\* '+re.escape(name)+' \*\/ = \{isa = PBXFileReference; lastKnownFileType = "wrapper.'+file_type+'"; name = '+re.escape(name)+'; path = '+re.escape(quoted_rel_path)+';', project_data)
+		key = ('wrapper.'+file_type, name, rel_path)
+		fileref_hash = self._fileref_guids_by_type_and_path.get(key)
 
-		if match:
+		if fileref_hash is not None:
 			logging.info("This file has already been added.")
-			(fileref_hash, ) = match.groups()
-			
-		else:
-			match = re.search('\/\* Begin PBXFileReference section \*\/\n', project_data)
-
-			if not match:
-				logging.error("Couldn't find the PBXFileReference section.")
-				return False
 
+		else:
 			fileref_hash = default_guid
-			
-			pbxfileref = "\t\t"+fileref_hash+" /* "+name+" */ = {isa = PBXFileReference; lastKnownFileType = \"wrapper."+file_type+"\"; name = "+name+"; path = "+quoted_rel_path+"; sourceTree = "+source_tree+"; };\n"
 
-			project_data = project_data[:match.end()] + pbxfileref + project_data[match.end():]
-
-		self.set_project_data(project_data)
+			fileref = {}
+			fileref['isa'] = 'PBXFileReference'
+			fileref['lastKnownFileType'] = 'wrapper.'+file_type
+			fileref['name'] = name
+			fileref['path'] = rel_path
+			fileref['sourceTree'] = source_tree
+			self._add_object(fileref_hash, fileref, name)
 
 		return fileref_hash
 
@@ -538,28 +944,15 @@ class pbxproj(object):
 	#
 	# <guid> /* <name> */,
 	def add_file_to_group(self, name, guid, group):
-		project_data = self.get_project_data()
-
-		match = re.search('\/\* '+re.escape(group)+' \*\/ = \{\n[ \t]+isa = PBXGroup;\n[ \t]+children = \(\n((?:.|\n)+?)\);', project_data)
-		if not match:
+		pbxgroup = self.object_for_guid(self._group_guids_by_name.get(group))
+		if pbxgroup is None or 'children' not in pbxgroup:
 			logging.error("Couldn't find the "+group+" children.")
 			return False
 
-		(children,) = match.groups()
-		match = re.search(re.escape(guid), children)
-		if match:
+		if guid in pbxgroup['children']:
 			logging.info("This file is already a member of the "+name+" group.")
 		else:
-			match = re.search('\/\* '+re.escape(group)+' \*\/ = \{\n[ \t]+isa = PBXGroup;\n[ \t]+children = \(\n', project_data)
-
-			if not match:
-				logging.error("Couldn't find the "+group+" group.")
-				return False
-
-			pbxgroup = "\t\t\t\t"+guid+" /* "+name+" */,\n"
-			project_data = project_data[:match.end()] + pbxgroup + project_data[match.end():]
-
-		self.set_project_data(project_data)
+			self._append_to_list(pbxgroup, 'children', PbxString(guid, name))
 
 		return True
 
@@ -573,36 +966,22 @@ class pbxproj(object):
 	#
 	# <guid> /* <name> */,
 	def add_file_to_resources(self, name, guid):
-		match = re.search('\/\* '+re.escape('Resources')+' \*\/ = \{\n[ \t]+isa = PBXGroup;\n[ \t]+children = \(\n((?:.|\n)+?)\);', self.get_project_data())
-		if not match:
+		if 'Resources' not in self._group_guids_by_name:
 			return self.add_file_to_group(name, guid, 'Supporting Files')
 
 		return self.add_file_to_group(name, guid, 'Resources')
 
 	def add_file_to_phase(self, name, guid, phase_guid, phase):
-		project_data = self.get_project_data()
-
-		match = re.search(re.escape(phase_guid)+" \/\* "+re.escape(phase)+" \*\/ = {(?:.|\n)+?files = \(((?:.|\n)+?)\);", project_data)
+		build_phase = self.object_for_guid(phase_guid)
 
-		if not match:
+		if build_phase is None or 'files' not in build_phase:
 			logging.error("Couldn't find the "+phase+" phase.")
 			return False
 
-		(files, ) = match.groups()
-
-		match = re.search(re.escape(guid), files)
-		if match:
+		if guid in build_phase['files']:
 			logging.info("The file has already been added.")
 		else:
-			match = re.search(re.escape(phase_guid)+" \/\* "+phase+" \*\/ = {(?:.|\n)+?files = \(\n", project_data)
-			if not match:
-				logging.error("Couldn't find the "+phase+" files")
-				return False
-
-			frameworktext = "\t\t\t\t"+guid+" /* "+name+" in "+phase+" */,\n"
-			project_data = project_data[:match.end()] + frameworktext + project_data[match.end():]
-
-		self.set_project_data(project_data)
+			self._append_to_list(build_phase, 'files', PbxString(guid, name+" in "+phase))
 
 		return True
 
@@ -616,14 +995,16 @@ class pbxproj(object):
 		return self.add_file_to_phase(name, guid, target.frameworks_build_phase_guid(), 'Frameworks')
 
 	def add_file_to_resources_phase(self, name, guid):
-		if self._resources_guid is None:
+		target = self.active_target()
+		resources_guid = target and target.resources_build_phase_guid()
+		if not resources_guid:
 			logging.error("No resources build phase found in the destination project")
 			logging.error("Please add a New Copy Bundle Resources Build Phase to your target")
 			logging.error("Right click your target in the project, Add, New Build Phase,")
 			logging.error("  \"New Copy Bundle Resources Build Phase\"")
 			return False
 
-		return self.add_file_to_phase(name, guid, self._resources_guid, 'Resources')
+		return self.add_file_to_phase(name, guid, resources_guid, 'Resources')
 
 	def add_header_search_path(self, configuration):
 		project_path = os.path.dirname(os.path.abspath(self.xcodeprojpath()))
@@ -633,13 +1014,13 @@ class pbxproj(object):
 		did_add_build_setting = self.add_build_setting(configuration, 'HEADER_SEARCH_PATHS', '"'+rel_path+'"')
 		if not did_add_build_setting:
 			return did_add_build_setting
-		
+
 		# Version 46 is Xcode 4's file format.
 		try:
 			primary_version = int(self._xcode_version.split('.')[0])
-		except ValueError, e:
+		except (ValueError, AttributeError), e:
 			primary_version = 0
-		if self._file_format_version >= 46 or primary_version >= 4:
+		if self.version() >= 46 or primary_version >= 4:
 			did_add_build_setting = self.add_build_setting(configuration, 'HEADER_SEARCH_PATHS', '"$(BUILT_PRODUCTS_DIR)/../../three20"')
 			if not did_add_build_setting:
 				return did_add_build_setting
@@ -649,52 +1030,46 @@ class pbxproj(object):
 				return did_add_build_setting
 
 		return did_add_build_setting
-	
-	def add_build_setting(self, configuration, setting_name, value):
-		project_data = self.get_project_data()
 
-		match = re.search('\/\* '+configuration+' \*\/ = {\n[ \t]+isa = XCBuildConfiguration;\n[ \t]+buildSettings = \{\n((?:.|\n)+?)\};', project_data)
-		if not match:
-			logging.error("Couldn't find this configuration.")
-			return False
+	# Find the named configuration, preferring the active target's configuration.
+	def _configuration_by_name(self, configuration):
+		guids = self._configuration_guids_by_name.get(configuration)
+		if not guids:
+			return None
 
-		settings_start = match.start(1)
-		settings_end = match.end(1)
+		target = self.active_target()
+		if target is not None and target.configuration_list_guid():
+			for (guid, name) in target.configuration_guids() or []:
+				if name == configuration:
+					return self.object_for_guid(guid)
 
-		(build_settings, ) = match.groups()
+		return self.object_for_guid(guids[0])
+
+	def add_build_setting(self, configuration, setting_name, value):
+		build_configuration = self._configuration_by_name(configuration)
+		if build_configuration is None or 'buildSettings' not in build_configuration:
+			logging.error("Couldn't find this configuration.")
+			return False
 
-		match = re.search(re.escape(setting_name)+' = ((?:.|\n)+?);', build_settings)
+		build_settings = build_configuration['buildSettings']
+		value = value.strip('"')
 
-		if not match:
+		if setting_name not in build_settings:
 			# Add a brand new build setting. No checking for existing settings necessary.
-			settingtext = '\t\t\t\t'+setting_name+' = '+value+';\n'
+			self._set_value(build_settings, setting_name, value)
 
-			project_data = project_data[:settings_start] + settingtext + project_data[settings_start:]
 		else:
 			# Build settings already exist. Is there one or many?
-			(search_paths,) = match.groups()
-			if re.search('\(\n', search_paths):
+			existing = build_settings[setting_name]
+			if isinstance(existing, list):
 				# Many
-				match = re.search(re.escape(value), search_paths)
-				if not match:
-					# If value has any spaces in it, Xcode will split it up into
-					# multiple entries.
-					escaped_value = re.escape(value).replace(' ', '",\n[ \t]+"')
-					match = re.search(escaped_value, search_paths)
-					if not match and not re.search(re.escape(value.strip('"')), search_paths):
-						match = re.search(re.escape(setting_name)+' = \(\n', build_settings)
-
-						build_settings = build_settings[:match.end()] + '\t\t\t\t\t'+value+',\n' + build_settings[match.end():]
-						project_data = project_data[:settings_start] + build_settings + project_data[settings_end:]
+				# If value has any spaces in it, Xcode will split it up into multiple entries.
+				if value not in existing and value not in ' '.join(existing):
+					self._append_to_list(build_settings, setting_name, value)
 			else:
 				# One
-				if search_paths.strip('"') != value.strip('"'):
-					existing_path = search_paths
-					path_set = '(\n\t\t\t\t\t'+value+',\n\t\t\t\t\t'+existing_path+'\n\t\t\t\t)'
-					build_settings = build_settings[:match.start(1)] + path_set + build_settings[match.end(1):]
-					project_data = project_data[:settings_start] + build_settings + project_data[settings_end:]
-
-		self.set_project_data(project_data)
+				if existing != value:
+					self._set_value(build_settings, setting_name, [value, existing])
 
 		return True
 
@@ -706,15 +1081,15 @@ class pbxproj(object):
 
 	def add_framework(self, framework):
 		tthash_base = self.get_hash_base(framework)
-		
+
 		fileref_hash = self.add_filereference(framework, 'frameworks', tthash_base+'0', 'System/Library/Frameworks/'+framework, 'SDKROOT')
 		libfile_hash = self.add_buildfile(framework, fileref_hash, tthash_base+'1')
 		if not self.add_file_to_frameworks(framework, fileref_hash):
 			return False
-		
+
 		if not self.add_file_to_frameworks_phase(framework, libfile_hash):
 			return False
-		
+
 		return True
 
 	def add_bundle(self):
@@ -723,7 +1098,7 @@ class pbxproj(object):
 		project_path = os.path.dirname(os.path.abspath(self.xcodeprojpath()))
 		build_path = os.path.join(Paths.src_dir, 'Three20.bundle')
 		rel_path = relpath(project_path, build_path)
-		
+
 		fileref_hash = self.add_filereference('Three20.bundle', 'plug-in', tthash_base+'0', rel_path, 'SOURCE_ROOT')
 
 		libfile_hash = self.add_buildfile('Three20.bundle', fileref_hash, tthash_base+'1')
@@ -738,399 +1113,243 @@ class pbxproj(object):
 
 	# Get the PBXFileReference from the given PBXBuildFile guid.
 	def get_filerefguid_from_buildfileguid(self, buildfileguid):
-		project_data = self.get_project_data()
-		match = re.search(buildfileguid+' \/\* .+ \*\/ = {isa = PBXBuildFile; fileRef = ([A-Z0-9]+) \/\* .+ \*\/;', project_data)
+		buildfile = self.object_for_guid(buildfileguid)
 
-		if not match:
+		if buildfile is None or 'fileRef' not in buildfile:
 			logging.error("Couldn't find PBXBuildFile row.")
 			return None
 
-		(filerefguid, ) = match.groups()
-		
-		return filerefguid
+		return buildfile['fileRef']
 
 	def get_filepath_from_filerefguid(self, filerefguid):
-		project_data = self.get_project_data()
-		match = re.search(filerefguid+' \/\* .+ \*\/ = {isa = PBXFileReference; .+ path = (.+); .+ };', project_data)
+		fileref = self.object_for_guid(filerefguid)
 
-		if not match:
+		if fileref is None or 'path' not in fileref:
 			logging.error("Couldn't find PBXFileReference row.")
 			return None
 
-		(path, ) = match.groups()
-		
-		return path
-
-
-	# Get all source files that are "built" in this project. This includes files built for
-	# libraries, executables, and unit testing.
-	def get_built_sources(self):
-		project_data = self.get_project_data()
-		match = re.search('\/\* Begin PBXSourcesBuildPhase section \*\/\n((?:.|\n)+?)\/\* End PBXSourcesBuildPhase section \*\/', project_data)
+		return fileref['path']
 
-		if not match:
-			logging.error("Couldn't find PBXSourcesBuildPhase section.")
-			return None
-		
-		(buildphasedata, ) = match.groups()
-		
-		buildfileguids = re.findall('[ \t]+([A-Z0-9]+) \/\* .+ \*\/,\n', buildphasedata)
-		
+	# Get the paths of the files built by every build phase of the given kind.
+	def _get_built_files(self, isa):
 		project_path = os.path.dirname(os.path.abspath(self.xcodeprojpath()))
-		
+
 		filenames = []
-		
-		for buildfileguid in buildfileguids:
-			filerefguid = self.get_filerefguid_from_buildfileguid(buildfileguid)
-			filepath = self.get_filepath_from_filerefguid(filerefguid)
 
-			filenames.append(os.path.join(project_path, filepath.strip('"')))
+		for guid in self._object_order:
+			build_phase = self._objects[guid]
+			if build_phase.get('isa') != isa:
+				continue
+
+			for buildfileguid in build_phase.get('files', []):
+				filerefguid = self.get_filerefguid_from_buildfileguid(buildfileguid)
+				filepath = self.get_filepath_from_filerefguid(filerefguid)
+				if filepath is not None:
+					filenames.append(os.path.join(project_path, filepath))
 
 		return filenames
 
 
-	# Get all header files that are "built" in this project. This includes files built for
+	# Get all source files that are "built" in this project. This includes files built for
 	# libraries, executables, and unit testing.
-	def get_built_headers(self):
-		project_data = self.get_project_data()
-		match = re.search('\/\* Begin PBXHeadersBuildPhase section \*\/\n((?:.|\n)+?)\/\* End PBXHeadersBuildPhase section \*\/', project_data)
+	def get_built_sources(self):
+		return self._get_built_files('PBXSourcesBuildPhase')
 
-		if not match:
-			logging.error("Couldn't find PBXHeadersBuildPhase section.")
-			return None
-		
-		(buildphasedata, ) = match.groups()
 
-		buildfileguids = re.findall('[ \t]+([A-Z0-9]+) \/\* .+ \*\/,\n', buildphasedata)
-		
-		project_path = os.path.dirname(os.path.abspath(self.xcodeprojpath()))
-		
-		filenames = []
-		
-		for buildfileguid in buildfileguids:
-			filerefguid = self.get_filerefguid_from_buildfileguid(buildfileguid)
-			filepath = self.get_filepath_from_filerefguid(filerefguid)
-			
-			filenames.append(os.path.join(project_path, filepath.strip('"')))
-
-		return filenames
+	# Get all header files that are "built" in this project. This includes files built for
+	# libraries, executables, and unit testing.
+	def get_built_headers(self):
+		return self._get_built_files('PBXHeadersBuildPhase')
 
 
+	# Add the dependency to this project's active target.
+	#
+	# The edits are only made in memory. Call save() once every dependency has been added to
+	# write the project.
 	def add_dependency(self, dep):
-		project_data = self.get_project_data()
-		dep_data = dep.get_project_data()
 		project_target = self.active_target()
 		dep_target = dep.active_target()
-		
-		if project_data is None or dep_data is None:
+
+		if not self.is_loaded() or not dep.is_loaded():
 			return False
 
 		logging.info("\nAdding "+str(dep)+"\nto\n"+str(self))
-		
+
 		project_path = os.path.dirname(os.path.abspath(self.xcodeprojpath()))
 		dep_path = os.path.abspath(dep.xcodeprojpath())
 		rel_path = relpath(project_path, dep_path)
-		
+
 		logging.info("")
 		logging.info("Project path:    "+project_path)
 		logging.info("Dependency path: "+dep_path)
 		logging.info("Relative path:   "+rel_path)
-		
+
 		tthash_base = self.get_hash_base(dep.uniqueid_for_target(dep._active_target))
-	
+
+		dep_project_filename = dep._project_name+'.xcodeproj'
+
 		###############################################
 		logging.info("")
 		logging.info("Step 1: Add file reference to the dependency...")
-		
-		pbxfileref_hash = self.add_filereference(dep._project_name+'.xcodeproj', 'pb-project', tthash_base+'0', rel_path, 'SOURCE_ROOT')
-		project_data = self.get_project_data()
+
+		pbxfileref_hash = self.add_filereference(dep_project_filename, 'pb-project', tthash_base+'0', rel_path, 'SOURCE_ROOT')
 
 		logging.info("Done: Added file reference: "+pbxfileref_hash)
-		self.set_project_data(project_data)
-		
+
 		###############################################
 		logging.info("")
 		logging.info("Step 2: Add file to Frameworks group...")
-		
-		if not self.add_file_to_frameworks(dep._project_name+".xcodeproj", pbxfileref_hash):
+
+		if not self.add_file_to_frameworks(dep_project_filename, pbxfileref_hash):
 			return False
-		project_data = self.get_project_data()
 
 		logging.info("Done: Added file to Frameworks group.")
-		self.set_project_data(project_data)
-		
+
 		###############################################
 		logging.info("")
 		logging.info("Step 3: Add dependencies...")
-		
-		pbxtargetdependency_hash = None
+
+		pbxtargetdependency_hash = self._target_dependency_guids_by_name.get(dep._project_name)
 		pbxcontaineritemproxy_hash = None
-		
-		match = re.search('\/\* Begin PBXTargetDependency section \*\/\n((?:.|\n)+?)\/\* End PBXTargetDependency section \*\/', project_data)
-		if not match:
-			logging.info("\tAdding a PBXTargetDependency section...")
-			match = re.search('\/\* End PBXSourcesBuildPhase section \*\/\n', project_data)
-			
-			if not match:
-				logging.error("Couldn't find the PBXSourcesBuildPhase section.")
-				return False
-			
-			project_data = project_data[:match.end()] + "\n/* Begin PBXTargetDependency section */\n\n/* End PBXTargetDependency section */\n" + project_data[match.end():]
-		else:
-			(subtext, ) = match.groups()
-			match = re.search('([A-Z0-9]+) \/\* PBXTargetDependency \*\/ = {\n[ \t]+isa = PBXTargetDependency;\n[ \t]+name = '+re.escape(dep._project_name)+';\n[ \t]+targetProxy = ([A-Z0-9]+) \/\* PBXContainerItemProxy \*\/;', project_data)
-			if match:
-				(pbxtargetdependency_hash, pbxcontaineritemproxy_hash,) = match.groups()
-				logging.info("This dependency already exists.")
 
-		self.set_project_data(project_data)
+		if pbxtargetdependency_hash is not None:
+			pbxcontaineritemproxy_hash = self._objects[pbxtargetdependency_hash].get('targetProxy')
 
 		if pbxtargetdependency_hash is None or pbxcontaineritemproxy_hash is None:
-			match = re.search('\/\* Begin PBXTargetDependency section \*\/\n', project_data)
-		
 			pbxtargetdependency_hash = tthash_base+'1'
 			pbxcontaineritemproxy_hash = tthash_base+'2'
-		
-			pbxtargetdependency = "\t\t"+pbxtargetdependency_hash+" /* PBXTargetDependency */ = {\n\t\t\tisa = PBXTargetDependency;\n\t\t\tname = "+dep._project_name+";\n\t\t\ttargetProxy = "+pbxcontaineritemproxy_hash+" /* PBXContainerItemProxy */;\n\t\t};\n"
-			project_data = project_data[:match.end()] + pbxtargetdependency + project_data[match.end():]
+
+			pbxtargetdependency = {}
+			pbxtargetdependency['isa'] = 'PBXTargetDependency'
+			pbxtargetdependency['name'] = dep._project_name
+			pbxtargetdependency['targetProxy'] = PbxString(pbxcontaineritemproxy_hash, 'PBXContainerItemProxy')
+			self._add_object(pbxtargetdependency_hash, pbxtargetdependency, 'PBXTargetDependency')
+		else:
+			logging.info("This dependency already exists.")
 
 		logging.info("Done: Added dependency.")
-		self.set_project_data(project_data)
 
 
 		###############################################
 		logging.info("")
 		logging.info("Step 3.1: Add container proxy for dependencies...")
 
-		containerExists = False
-
-		match = re.search('\/\* Begin PBXContainerItemProxy section \*\/\n((?:.|\n)+?)\/\* End PBXContainerItemProxy section \*\/', project_data)
-		if not match:
-			logging.info("\tAdding a PBXContainerItemProxy section...")
-			match = re.search('\/\* End PBXBuildFile section \*\/\n', project_data)
-			
-			if not match:
-				logging.error("Couldn't find the PBXBuildFile section.")
-				return False
-			
-			project_data = project_data[:match.end()] + "\n/* Begin PBXContainerItemProxy section */\n\n/* End PBXContainerItemProxy section */\n" + project_data[match.end():]
+		if pbxcontaineritemproxy_hash in self._objects:
+			logging.info("This container proxy already exists.")
 		else:
-			(subtext, ) = match.groups()
-			match = re.search(re.escape(pbxcontaineritemproxy_hash), subtext)
-			if match:
-				logging.info("This container proxy already exists.")
-				containerExists = True
-
-		self.set_project_data(project_data)
-
-		if not containerExists:
-			match = re.search('\/\* Begin PBXContainerItemProxy section \*\/\n', project_data)
-
-			pbxcontaineritemproxy = "\t\t"+pbxcontaineritemproxy_hash+" /* PBXContainerItemProxy */ = {\n\t\t\tisa = PBXContainerItemProxy;\n\t\t\tcontainerPortal = "+pbxfileref_hash+" /* "+dep._project_name+".xcodeproj */;\n\t\t\tproxyType = 1;\n\t\t\tremoteGlobalIDString = "+dep_target.guid()+";\n\t\t\tremoteInfo = "+dep._project_name+";\n\t\t};\n"
-			project_data = project_data[:match.end()] + pbxcontaineritemproxy + project_data[match.end():]
+			pbxcontaineritemproxy = {}
+			pbxcontaineritemproxy['isa'] = 'PBXContainerItemProxy'
+			pbxcontaineritemproxy['containerPortal'] = PbxString(pbxfileref_hash, dep_project_filename)
+			pbxcontaineritemproxy['proxyType'] = '1'
+			pbxcontaineritemproxy['remoteGlobalIDString'] = dep_target.guid()
+			pbxcontaineritemproxy['remoteInfo'] = dep._project_name
+			self._add_object(pbxcontaineritemproxy_hash, pbxcontaineritemproxy, 'PBXContainerItemProxy')
 
 		logging.info("Done: Added container proxy.")
-		self.set_project_data(project_data)
 
 
 		###############################################
 		logging.info("")
 		logging.info("Step 3.2: Add module to the dependency list...")
 
-		match = re.search(project_target.guid()+' \/\* .+? \*\/ = {\n[ \t]+(?:.|\n)+?[ \t]+dependencies = \(\n((?:.|\n)+?)\);', project_data)
-		
-		dependency_exists = False
-		
-		if not match:
+		target = self.object_for_guid(project_target.guid())
+		if target is None or 'dependencies' not in target:
 			logging.error("Couldn't find the dependency list.")
 			return False
-		else:
-			(dependencylist, ) = match.groups()
-			match = re.search(re.escape(pbxtargetdependency_hash), dependencylist)
-			if match:
-				logging.info("This dependency has already been added.")
-				dependency_exists = True
-		
-		if not dependency_exists:
-			match = re.search(project_target.guid()+' \/\* .+? \*\/ = {\n[ \t]+(?:.|\n)+?[ \t]+dependencies = \(\n', project_data)
-
-			if not match:
-				logging.error("Couldn't find the dependency list.")
-				return False
 
-			dependency_item = '\t\t\t\t'+pbxtargetdependency_hash+' /* PBXTargetDependency */,\n'
-			project_data = project_data[:match.end()] + dependency_item + project_data[match.end():]
+		if pbxtargetdependency_hash in target['dependencies']:
+			logging.info("This dependency has already been added.")
+		else:
+			self._append_to_list(target, 'dependencies', PbxString(pbxtargetdependency_hash, 'PBXTargetDependency'))
 
 		logging.info("Done: Added module to the dependency list.")
-		self.set_project_data(project_data)
 
 
 		###############################################
 		logging.info("")
 		logging.info("Step 4: Create project references...")
 
-		match = re.search('\/\* Begin PBXProject section \*\/\n((?:.|\n)+?)\/\* End PBXProject section \*\/', project_data)
-		if not match:
-			logging.error("Couldn't find the project section.")
-			return False
-
-		project_start = match.start(1)
-		project_end = match.end(1)
+		project_object = self._project_object()
 
-		(project_section, ) = match.groups()
-		
-		reference_exists = False
-		did_change = False
-		
-		productgroup_hash = None
-		
-		match = re.search('projectReferences = \(\n((?:.|\n)+?)\n[ \t]+\);', project_section)
-		if not match:
+		if 'projectReferences' not in project_object:
 			logging.info("Creating project references...")
-			match = re.search('projectDirPath = ".*?";\n', project_section)
-			if not match:
-				logging.error("Couldn't find project references anchor.")
-				return False
-			
-			did_change = True
-			project_section = project_section[:match.end()] + '\t\t\tprojectReferences = (\n\t\t\t);\n' + project_section[match.end():]
+			self._set_value(project_object, 'projectReferences', [])
 
-		else:
-			(refs, ) = match.groups()
+		productgroup_hash = None
 
-			match = re.search('\{\n[ \t]+ProductGroup = ([A-Z0-9]+) \/\* Products \*\/;\n[ \t]+ProjectRef = '+re.escape(pbxfileref_hash), refs)
-			if match:
-				(productgroup_hash, ) = match.groups()
+		for reference in project_object['projectReferences']:
+			if reference.get('ProjectRef') == pbxfileref_hash:
+				productgroup_hash = reference.get('ProductGroup')
 				logging.info("This product group already exists: "+productgroup_hash)
-				reference_exists = True
+				break
 
-
-		if not reference_exists:
-			match = re.search('projectReferences = \(\n', project_section)
-			
-			if not match:
-				logging.error("Missing the project references item.")
-				return False
-			
+		if productgroup_hash is None:
 			productgroup_hash = tthash_base+'3'
 
-			reference_text = '\t\t\t\t{\n\t\t\t\t\tProductGroup = '+productgroup_hash+' /* Products */;\n\t\t\t\t\tProjectRef = '+pbxfileref_hash+' /* '+dep._project_name+'.xcodeproj */;\n\t\t\t\t},\n'
-			project_section = project_section[:match.end()] + reference_text + project_section[match.end():]
-			did_change = True
-			
-		if did_change:
-			project_data = project_data[:project_start] + project_section + project_data[project_end:]
+			reference = {}
+			reference['ProductGroup'] = PbxString(productgroup_hash, 'Products')
+			reference['ProjectRef'] = PbxString(pbxfileref_hash, dep_project_filename)
+			self._append_to_list(project_object, 'projectReferences', reference)
 
 		logging.info("Done: Created project reference.")
-		self.set_project_data(project_data)
 
 		###############################################
 		logging.info("")
 		logging.info("Step 4.1: Create product group...")
 
-		match = re.search('\/\* Begin PBXGroup section \*\/\n', project_data)
-		if not match:
-			logging.error("Couldn't find the group section.")
-			return False
-		
-		group_start = match.end()
-
 		lib_hash = None
 
-		match = re.search(re.escape(productgroup_hash)+" \/\* Products \*\/ = \{\n[ \t]+isa = PBXGroup;\n[ \t]+children = \(\n((?:.|\n)+?)\);", project_data)
-		if match:
+		product_group = self.object_for_guid(productgroup_hash)
+		if product_group is not None:
 			logging.info("This product group already exists.")
-			(children, ) = match.groups()
-			match = re.search('([A-Z0-9]+) \/\* '+re.escape(dep_target.product_name())+' \*\/', children)
-			if not match:
+			for child in product_group.get('children', []):
+				# The products added by this script don't have a reference proxy, so they can only
+				# be recognized by their GUID.
+				product = self.object_for_guid(child)
+				if child == tthash_base+'4' or (product is not None and product.get('path') == dep_target.product_name()):
+					lib_hash = child
+					break
+
+			if lib_hash is None:
 				logging.error("No product found")
 				return False
 				# TODO: Add this product.
-			else:
-				(lib_hash, ) = match.groups()
-			
+
 		else:
 			lib_hash = tthash_base+'4'
 
-			productgrouptext = "\t\t"+productgroup_hash+" /* Products */ = {\n\t\t\tisa = PBXGroup;\n\t\t\tchildren = (\n\t\t\t\t"+lib_hash+" /* "+dep_target.product_name()+" */,\n\t\t\t);\n\t\t\tname = Products;\n\t\t\tsourceTree = \"<group>\";\n\t\t};\n"
-			project_data = project_data[:group_start] + productgrouptext + project_data[group_start:]
+			product_group = {}
+			product_group['isa'] = 'PBXGroup'
+			product_group['children'] = [PbxString(lib_hash, dep_target.product_name())]
+			product_group['name'] = 'Products'
+			product_group['sourceTree'] = '<group>'
+			self._add_object(productgroup_hash, product_group, 'Products')
 
 		logging.info("Done: Created product group: "+lib_hash)
-		self.set_project_data(project_data)
-		
+
 		###############################################
 		logging.info("")
 		logging.info("Step 4.2: Add container proxy for target product...")
 
-		containerExists = False
-		
 		targetproduct_hash = tthash_base+'6'
 
-		match = re.search('\/\* Begin PBXContainerItemProxy section \*\/\n((?:.|\n)+?)\/\* End PBXContainerItemProxy section \*\/', project_data)
-		if not match:
-			logging.info("\tAdding a PBXContainerItemProxy section...")
-			match = re.search('\/\* End PBXBuildFile section \*\/\n', project_data)
-			
-			if not match:
-				logging.error("Couldn't find the PBXBuildFile section.")
-				return False
-			
-			project_data = project_data[:match.end()] + "\n/* Begin PBXContainerItemProxy section */\n\n/* End PBXContainerItemProxy section */\n" + project_data[match.end():]
+		if targetproduct_hash in self._objects:
+			logging.info("This container proxy already exists.")
 		else:
-			(subtext, ) = match.groups()
-			match = re.search(re.escape(targetproduct_hash), subtext)
-			if match:
-				logging.info("This container proxy already exists.")
-				containerExists = True
-
-		self.set_project_data(project_data)
-		
-		if not containerExists:
-			match = re.search('\/\* Begin PBXContainerItemProxy section \*\/\n', project_data)
-
-			pbxcontaineritemproxy = "\t\t"+targetproduct_hash+" /* PBXContainerItemProxy */ = {\n\t\t\tisa = PBXContainerItemProxy;\n\t\t\tcontainerPortal = "+pbxfileref_hash+" /* "+dep._project_name+".xcodeproj */;\n\t\t\tproxyType = 2;\n\t\t\tremoteGlobalIDString = "+dep_target.guid()+";\n\t\t\tremoteInfo = "+dep._project_name+";\n\t\t};\n"
-			project_data = project_data[:match.end()] + pbxcontaineritemproxy + project_data[match.end():]
+			pbxcontaineritemproxy = {}
+			pbxcontaineritemproxy['isa'] = 'PBXContainerItemProxy'
+			pbxcontaineritemproxy['containerPortal'] = PbxString(pbxfileref_hash, dep_project_filename)
+			pbxcontaineritemproxy['proxyType'] = '2'
+			pbxcontaineritemproxy['remoteGlobalIDString'] = dep_target.guid()
+			pbxcontaineritemproxy['remoteInfo'] = dep._project_name
+			self._add_object(targetproduct_hash, pbxcontaineritemproxy, 'PBXContainerItemProxy')
 
 		logging.info("Done: Added target container proxy.")
-		self.set_project_data(project_data)
 
 
 		###############################################
-		# This code seems to break the xcode project but doesn't seem completely crucial.
-		# Gr.
-
-		# logging.info("")
-		# logging.info("Step 4.3: Create reference proxy...")
-		# 
-		# referenceExists = False
-		# 
-		# match = re.search('\/\* Begin PBXReferenceProxy section \*\/\n((?:.|\n)+?)\/\* End PBXReferenceProxy section \*\/', project_data)
-		# if not match:
-		# 	logging.info("\tAdding a PBXReferenceProxy section...")
-		# 	match = re.search('\/\* End PBXProject section \*\/\n', project_data)
-		# 	
-		# 	if not match:
-		# 		logging.error("Couldn't find the PBXProject section.")
-		# 		return False
-		# 	
-		# 	project_data = project_data[:match.end()] + "\n/* Begin PBXReferenceProxy section */\n\n/* End PBXReferenceProxy section */\n" + project_data[match.end():]
-		# else:
-		# 	(subtext, ) = match.groups()
-		# 	match = re.search(re.escape(lib_hash), subtext)
-		# 	if match:
-		# 		logging.info("This reference proxy already exists.")
-		# 		referenceExists = True
-		# 
-		# self.set_project_data(project_data)
-		# 
-		# if not referenceExists:
-		# 	match = re.search('\/\* Begin PBXReferenceProxy section \*\/\n', project_data)
-		# 
-		# 	referenceproxytext = "\t\t"+lib_hash+" /* "+dep_target.product_name()+" */ = {\n\t\t\tisa = PBXReferenceProxy;\n\t\t\tfileType = archive.ar;\n\t\t\tpath = \""+dep_target.product_name()+"\";\n\t\t\tremoteRef = "+targetproduct_hash+" /* PBXContainerItemProxy */;\n\t\t\tsourceTree = BUILT_PRODUCTS_DIR;\n\t\t};\n"
-		# 	project_data = project_data[:match.end()] + referenceproxytext + project_data[match.end():]
-		# 
-		# logging.info("Done: Created reference proxy.")
-		# self.set_project_data(project_data)
+		# Creating the PBXReferenceProxy for the product seems to break the xcode project but
+		# doesn't seem completely crucial, so it's skipped.
 
 
 		###############################################
@@ -1138,20 +1357,16 @@ class pbxproj(object):
 		logging.info("Step 5: Add target file...")
 
 		libfile_hash = self.add_buildfile(dep_target.product_name(), lib_hash, tthash_base+'5')
-		project_data = self.get_project_data()
 
 		logging.info("Done: Added target file.")
-		
+
 
 		###############################################
 		logging.info("")
 		logging.info("Step 6: Add frameworks...")
 
 		self.add_file_to_frameworks_phase(dep_target.product_name(), libfile_hash)
-		project_data = self.get_project_data()
 
 		logging.info("Done: Adding module.")
 
-		self.set_project_data(project_data, flush = True)
-
 		return True
@@ -0,0 +1,201 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/**
+ * @ingroup NimbusCore
+ * @{
+ */
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import <CommonCrypto/CommonDigest.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NimbusCore.h"
+#else
+#import "NimbusCore.h"
+#endif
+
+/**
+ * @brief The hash algorithms supported by NIHasher.
+ */
+typedef enum {
+  NIHashAlgorithmMD5,
+  NIHashAlgorithmSHA1,
+  NIHashAlgorithmSHA256,
+} NIHashAlgorithm;
+
+/**
+ * @brief The length in bytes of the longest digest that NIHasher can produce.
+ */
+#define NI_MAX_DIGEST_LENGTH CC_SHA256_DIGEST_LENGTH
+
+/**
+ * @brief Encode bytes as a string of lowercase hexadecimal digits.
+ *
+ * Each byte becomes two characters, so the string is twice as long as the data.
+ */
+NSString* NIHexStringFromBytes(const void* bytes, NSUInteger length);
+
+/**
+ * @brief Calculates a hash from data that is provided a piece at a time.
+ *
+ * Use a hasher to hash data that is too large to hold in memory at once, or that arrives in
+ * pieces, such as a download. Feed it the data in order with the update methods and then call
+ * one of the finish methods once to get the digest.
+ *
+ * @code
+ * NSError* error = nil;
+ * NSString* hash = [NIHasher hexDigestOfFileAtPath: path
+ *                                        algorithm: NIHashAlgorithmSHA1
+ *                                            error: &error];
+ * @endcode
+ *
+ * Files are read in fixed-size chunks, so hashing a file uses the same amount of memory no
+ * matter how large the file is.
+ */
+@interface NIHasher : NSObject {
+@private
+  NIHashAlgorithm _algorithm;
+  union {
+    CC_MD5_CTX    md5;
+    CC_SHA1_CTX   sha1;
+    CC_SHA256_CTX sha256;
+  } _context;
+  BOOL            _isFinished;
+
+  // Kept once the hasher is finished so that finishing it again returns the same digest.
+  unsigned char   _digest[NI_MAX_DIGEST_LENGTH];
+}
+
+/**
+ * @brief Designated initializer.
+ */
+- (id)initWithAlgorithm:(NIHashAlgorithm)algorithm;
+
+/**
+ * @brief An autoreleased hasher using the given algorithm.
+ */
++ (id)hasherWithAlgorithm:(NIHashAlgorithm)algorithm;
+
+/**
+ * @brief The algorithm used to calculate the hash.
+ */
+@property (nonatomic, readonly, assign) NIHashAlgorithm algorithm;
+
+/**
+ * @brief The length in bytes of the digest for this hasher's algorithm.
+ */
+@property (nonatomic, readonly, assign) NSUInteger digestLength;
+
+
+/**
+ * @name Adding Data
+ * @{
+ */
+#pragma mark Adding Data
+
+/**
+ * @brief Add the given bytes to the hash.
+ */
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length;
+
+/**
+ * @brief Add the given data to the hash.
+ */
+- (void)updateWithData:(NSData *)data;
+
+/**
+ * @brief Add the UTF-8 encoding of the given string to the hash.
+ *
+ * The string is encoded through a small buffer rather than being copied into an NSData object.
+ */
+- (void)updateWithString:(NSString *)string;
+
+/**
+ * @brief Add the contents of the file at the given path to the hash.
+ *
+ * If the file can't be read then some of its contents may already have been added.
+ *
+ * @returns YES if the whole file was read.
+ */
+- (BOOL)updateWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+/**@}*/
+
+
+/**
+ * @name Finishing
+ * @{
+ *
+ * No more data can be added once a hasher is finished. Finishing a hasher again returns the
+ * same digest.
+ */
+#pragma mark Finishing
+
+/**
+ * @brief Finish the hash and write the digest into the given buffer.
+ *
+ * This creates no objects, for when only the bytes of the digest are needed.
+ *
+ * @param digest  A buffer of at least digestLength bytes.
+ */
+- (void)finishWithDigest:(unsigned char *)digest;
+
+/**
+ * @brief Finish the hash and return the digest.
+ */
+- (NSData *)finishDigest;
+
+/**
+ * @brief Finish the hash and return the digest as a string of hexadecimal digits.
+ */
+- (NSString *)finishHexDigest;
+
+/**@}*/
+
+
+/**
+ * @name Hashing Files
+ * @{
+ */
+#pragma mark Hashing Files
+
+/**
+ * @brief The digest of the contents of the file at the given path.
+ *
+ * @returns The digest, or nil if the file could not be read.
+ */
++ (NSData *)digestOfFileAtPath: (NSString *)path
+                     algorithm: (NIHashAlgorithm)algorithm
+                         error: (NSError **)error;
+
+/**
+ * @brief The digest of the contents of the file at the given path as a string of hexadecimal
+ *        digits.
+ *
+ * @returns The digest, or nil if the file could not be read.
+ */
++ (NSString *)hexDigestOfFileAtPath: (NSString *)path
+                          algorithm: (NIHashAlgorithm)algorithm
+                              error: (NSError **)error;
+
+/**@}*/
+
+@end
+
+/**@}*/
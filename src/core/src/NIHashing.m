@@ -0,0 +1,299 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIHashing.h"
+
+#import <errno.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+// Large enough to keep the number of reads low, small enough to not matter on the heap.
+static const size_t kFileReadChunkSize = 64 * 1024;
+
+// The CommonCrypto functions take 32-bit lengths.
+static const NSUInteger kMaxUpdateLength = 0x40000000;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSString* NIHexStringFromBytes(const void* bytes, NSUInteger length) {
+  static const char kHexDigits[] = "0123456789abcdef";
+
+  if (0 == length) {
+    return @"";
+  }
+
+  NSUInteger hexLength = length * 2;
+  char* hex = malloc(hexLength);
+  if (NULL == hex) {
+    return nil;
+  }
+
+  const unsigned char* byte = (const unsigned char *)bytes;
+  for (NSUInteger ix = 0; ix < length; ++ix) {
+    hex[ix * 2]     = kHexDigits[byte[ix] >> 4];
+    hex[ix * 2 + 1] = kHexDigits[byte[ix] & 0x0F];
+  }
+
+  // The string takes ownership of the buffer rather than copying it.
+  return [[[NSString alloc] initWithBytesNoCopy: hex
+                                         length: hexLength
+                                       encoding: NSASCIIStringEncoding
+                                   freeWhenDone: YES] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIHasher
+
+@synthesize algorithm = _algorithm;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithAlgorithm:(NIHashAlgorithm)algorithm {
+  if ((self = [super init])) {
+    _algorithm = algorithm;
+
+    switch (_algorithm) {
+      case NIHashAlgorithmMD5:
+        CC_MD5_Init(&_context.md5);
+        break;
+      case NIHashAlgorithmSHA1:
+        CC_SHA1_Init(&_context.sha1);
+        break;
+      case NIHashAlgorithmSHA256:
+        CC_SHA256_Init(&_context.sha256);
+        break;
+    }
+  }
+
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithAlgorithm:NIHashAlgorithmMD5];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (id)hasherWithAlgorithm:(NIHashAlgorithm)algorithm {
+  return [[[self alloc] initWithAlgorithm:algorithm] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)digestLength {
+  switch (_algorithm) {
+    case NIHashAlgorithmMD5:
+      return CC_MD5_DIGEST_LENGTH;
+    case NIHashAlgorithmSHA1:
+      return CC_SHA1_DIGEST_LENGTH;
+    case NIHashAlgorithmSHA256:
+      return CC_SHA256_DIGEST_LENGTH;
+  }
+  return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Adding Data
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length {
+  NIDASSERT(!_isFinished);
+  if (_isFinished) {
+    return;
+  }
+
+  const unsigned char* chunk = (const unsigned char *)bytes;
+  while (length > 0) {
+    CC_LONG chunkLength = (CC_LONG)MIN(length, kMaxUpdateLength);
+
+    switch (_algorithm) {
+      case NIHashAlgorithmMD5:
+        CC_MD5_Update(&_context.md5, chunk, chunkLength);
+        break;
+      case NIHashAlgorithmSHA1:
+        CC_SHA1_Update(&_context.sha1, chunk, chunkLength);
+        break;
+      case NIHashAlgorithmSHA256:
+        CC_SHA256_Update(&_context.sha256, chunk, chunkLength);
+        break;
+    }
+
+    chunk += chunkLength;
+    length -= chunkLength;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)updateWithData:(NSData *)data {
+  [self updateWithBytes:[data bytes] length:[data length]];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)updateWithString:(NSString *)string {
+  unsigned char buffer[1024];
+  NSRange remainingRange = NSMakeRange(0, [string length]);
+
+  while (remainingRange.length > 0) {
+    NSUInteger usedLength = 0;
+    if (![string getBytes: buffer
+                maxLength: sizeof(buffer)
+               usedLength: &usedLength
+                 encoding: NSUTF8StringEncoding
+                  options: 0
+                    range: remainingRange
+           remainingRange: &remainingRange]) {
+      break;
+    }
+    [self updateWithBytes:buffer length:usedLength];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)updateWithContentsOfFile:(NSString *)path error:(NSError **)error {
+  int fileDescriptor = open([path fileSystemRepresentation], O_RDONLY);
+  if (fileDescriptor < 0) {
+    if (nil != error) {
+      *error = [NSError errorWithDomain: NSPOSIXErrorDomain
+                                   code: errno
+                               userInfo: [NSDictionary dictionaryWithObject: path
+                                                                     forKey: NSFilePathErrorKey]];
+    }
+    return NO;
+  }
+
+  unsigned char* buffer = malloc(kFileReadChunkSize);
+  BOOL didReadFile = (NULL != buffer);
+  if (!didReadFile && nil != error) {
+    *error = [NSError errorWithDomain: NSPOSIXErrorDomain
+                                 code: ENOMEM
+                             userInfo: [NSDictionary dictionaryWithObject: path
+                                                                   forKey: NSFilePathErrorKey]];
+  }
+
+  while (didReadFile) {
+    ssize_t numberOfBytesRead = read(fileDescriptor, buffer, kFileReadChunkSize);
+    if (numberOfBytesRead > 0) {
+      [self updateWithBytes:buffer length:(NSUInteger)numberOfBytesRead];
+
+    } else if (0 == numberOfBytesRead) {
+      // End of file.
+      break;
+
+    } else if (EINTR != errno) {
+      didReadFile = NO;
+      if (nil != error) {
+        *error = [NSError errorWithDomain: NSPOSIXErrorDomain
+                                     code: errno
+                                 userInfo: [NSDictionary dictionaryWithObject: path
+                                                                       forKey: NSFilePathErrorKey]];
+      }
+    }
+  }
+
+  free(buffer);
+  close(fileDescriptor);
+
+  return didReadFile;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Finishing
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)finishWithDigest:(unsigned char *)digest {
+  if (!_isFinished) {
+    _isFinished = YES;
+
+    switch (_algorithm) {
+      case NIHashAlgorithmMD5:
+        CC_MD5_Final(_digest, &_context.md5);
+        break;
+      case NIHashAlgorithmSHA1:
+        CC_SHA1_Final(_digest, &_context.sha1);
+        break;
+      case NIHashAlgorithmSHA256:
+        CC_SHA256_Final(_digest, &_context.sha256);
+        break;
+    }
+  }
+
+  memcpy(digest, _digest, self.digestLength);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSData *)finishDigest {
+  unsigned char digest[NI_MAX_DIGEST_LENGTH];
+  [self finishWithDigest:digest];
+  return [NSData dataWithBytes:digest length:self.digestLength];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)finishHexDigest {
+  unsigned char digest[NI_MAX_DIGEST_LENGTH];
+  [self finishWithDigest:digest];
+  return NIHexStringFromBytes(digest, self.digestLength);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Hashing Files
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSData *)digestOfFileAtPath: (NSString *)path
+                     algorithm: (NIHashAlgorithm)algorithm
+                         error: (NSError **)error {
+  NIHasher* hasher = [self hasherWithAlgorithm:algorithm];
+  if (![hasher updateWithContentsOfFile:path error:error]) {
+    return nil;
+  }
+  return [hasher finishDigest];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSString *)hexDigestOfFileAtPath: (NSString *)path
+                          algorithm: (NIHashAlgorithm)algorithm
+                              error: (NSError **)error {
+  NIHasher* hasher = [self hasherWithAlgorithm:algorithm];
+  if (![hasher updateWithContentsOfFile:path error:error]) {
+    return nil;
+  }
+  return [hasher finishHexDigest];
+}
+
+
+@end
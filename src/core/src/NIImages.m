@@ -0,0 +1,186 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NimbusCore.h"
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Draw the given image into a bitmap context, forcing it to be decompressed.
+ *
+ * The returned image uses the same pixel format as the screen so that Core Animation can use
+ * it without any further conversion.
+ *
+ * @returns A CGImageRef that must be released, or NULL if the image could not be decoded.
+ */
+static CGImageRef NICreateDecodedCGImage(CGImageRef image) {
+  if (NULL == image) {
+    return NULL;
+  }
+
+  size_t width = CGImageGetWidth(image);
+  size_t height = CGImageGetHeight(image);
+  if (0 == width || 0 == height) {
+    return NULL;
+  }
+
+  CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(image);
+  BOOL hasAlpha = !(kCGImageAlphaNone == alphaInfo
+                    || kCGImageAlphaNoneSkipFirst == alphaInfo
+                    || kCGImageAlphaNoneSkipLast == alphaInfo);
+  CGBitmapInfo bitmapInfo = (kCGBitmapByteOrder32Little
+                             | (hasAlpha
+                                ? kCGImageAlphaPremultipliedFirst
+                                : kCGImageAlphaNoneSkipFirst));
+
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, bitmapInfo);
+  CGColorSpaceRelease(colorSpace);
+  if (NULL == context) {
+    return NULL;
+  }
+
+  CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+  CGImageRef decodedImage = CGBitmapContextCreateImage(context);
+  CGContextRelease(context);
+
+  return decodedImage;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Wrap a CGImage in a UIImage, using the given scale when the OS supports it.
+ */
+static UIImage* NIImageWithCGImage(CGImageRef image,
+                                   CGFloat scale,
+                                   UIImageOrientation orientation) {
+  if ([UIImage respondsToSelector:@selector(imageWithCGImage:scale:orientation:)]) {
+    return [UIImage imageWithCGImage:image scale:scale orientation:orientation];
+
+  } else {
+    return [UIImage imageWithCGImage:image];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+UIImage* NIDecodedImage(UIImage* image) {
+  if (nil == image) {
+    return nil;
+  }
+
+  CGImageRef decodedImage = NICreateDecodedCGImage(image.CGImage);
+  if (NULL == decodedImage) {
+    return nil;
+  }
+
+  CGFloat scale = [image respondsToSelector:@selector(scale)] ? image.scale : 1;
+  UIImage* result = NIImageWithCGImage(decodedImage, scale, image.imageOrientation);
+  CGImageRelease(decodedImage);
+
+  return result;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+UIImage* NIDecodedImageWithData(NSData* data, CGFloat scale) {
+  if ([data length] < 4) {
+    return nil;
+  }
+
+  NI_TRACE_BEGIN("NIDecodedImageWithData");
+
+  CGDataProviderRef provider = CGDataProviderCreateWithCFData((CFDataRef)data);
+  if (NULL == provider) {
+    NI_TRACE_END("NIDecodedImageWithData");
+    return nil;
+  }
+
+  // Core Graphics is safe to use from any thread, so we only fall back to UIImage for formats
+  // that Core Graphics can't read directly. The JPEG provider doesn't read the data until the
+  // image is drawn, so the data's format has to be checked up front.
+  static const unsigned char kPNGSignature[4] = { 0x89, 'P', 'N', 'G' };
+  static const unsigned char kJPEGStartOfImage[2] = { 0xFF, 0xD8 };
+  CGImageRef image = NULL;
+  if (0 == memcmp([data bytes], kPNGSignature, sizeof(kPNGSignature))) {
+    image = CGImageCreateWithPNGDataProvider(provider, NULL, NO, kCGRenderingIntentDefault);
+
+  } else if (0 == memcmp([data bytes], kJPEGStartOfImage, sizeof(kJPEGStartOfImage))) {
+    image = CGImageCreateWithJPEGDataProvider(provider, NULL, NO, kCGRenderingIntentDefault);
+  }
+  CGDataProviderRelease(provider);
+
+  // UIImage can only be used on the main thread before iOS 4.
+  if (NULL == image && [NSThread isMainThread]) {
+    UIImage* fallbackImage = [[UIImage alloc] initWithData:data];
+    image = CGImageRetain(fallbackImage.CGImage);
+    [fallbackImage release];
+  }
+
+  CGImageRef decodedImage = NICreateDecodedCGImage(image);
+  CGImageRelease(image);
+
+  UIImage* result = nil;
+  if (NULL != decodedImage) {
+    result = NIImageWithCGImage(decodedImage, scale, UIImageOrientationUp);
+    CGImageRelease(decodedImage);
+  }
+
+  NI_TRACE_END("NIDecodedImageWithData");
+
+  return result;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+UIImage* NIDecodedImageWithContentsOfFile(NSString* path) {
+  if (nil == path) {
+    return nil;
+  }
+
+  NSString* pathWithoutExtension = [path stringByDeletingPathExtension];
+  CGFloat scale = [pathWithoutExtension hasSuffix:@"@2x"] ? 2 : 1;
+  NSData* data = nil;
+
+  // Prefer the high resolution version of the image on high resolution screens, as
+  // imageWithContentsOfFile: does.
+  UIScreen* screen = [UIScreen mainScreen];
+  if (1 == scale && [screen respondsToSelector:@selector(scale)] && screen.scale > 1) {
+    NSString* extension = [path pathExtension];
+    NSString* highResolutionPath = [pathWithoutExtension stringByAppendingString:@"@2x"];
+    if ([extension length] > 0) {
+      highResolutionPath = [highResolutionPath stringByAppendingPathExtension:extension];
+    }
+
+    data = [[NSData alloc] initWithContentsOfFile:highResolutionPath];
+    if (nil != data) {
+      scale = 2;
+    }
+  }
+
+  if (nil == data) {
+    data = [[NSData alloc] initWithContentsOfFile:path];
+  }
+  if (nil == data) {
+    return nil;
+  }
+
+  UIImage* image = NIDecodedImageWithData(data, scale);
+  [data release];
+
+  return image;
+}
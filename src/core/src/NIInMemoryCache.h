@@ -0,0 +1,178 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/**
+ * @ingroup NimbusCore
+ * @{
+ */
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NimbusCore.h"
+#else
+#import "NimbusCore.h"
+#endif
+
+@class NIMemoryCacheEntry;
+
+/**
+ * @brief An in-memory cache that evicts the least recently used objects once it grows too large.
+ *
+ * Each object is stored with a cost. Once the total cost of the objects in the cache exceeds
+ * maxTotalCost, the least recently used objects are removed until it no longer does. Fetching
+ * an object with objectForKey: marks it as the most recently used.
+ *
+ * All objects are removed from the cache when the application receives a memory warning.
+ *
+ * The hit, miss, and eviction counters can be used to tune maxTotalCost for a given device.
+ *
+ * This class is not thread-safe and should only be used from the main thread.
+ */
+@interface NIMemoryCache : NSObject {
+@private
+  NSMutableDictionary*  _entries; // NSDictionary< id<NSCopying>, NIMemoryCacheEntry >
+
+  // The most recently used entry is at the head of the list.
+  NIMemoryCacheEntry*   _headEntry;
+  NIMemoryCacheEntry*   _tailEntry;
+
+  NSUInteger            _maxTotalCost;
+  NSUInteger            _totalCost;
+
+  // Statistics
+  NSUInteger            _numberOfHits;
+  NSUInteger            _numberOfMisses;
+  NSUInteger            _numberOfEvictions;
+}
+
+/**
+ * @brief Designated initializer.
+ *
+ * @param maxTotalCost  The total cost at which objects start being evicted. Zero means that
+ *                      objects are only evicted when a memory warning is received.
+ */
+- (id)initWithMaxTotalCost:(NSUInteger)maxTotalCost;
+
+/**
+ * @brief Fetch the object stored with the given key and mark it as the most recently used.
+ *
+ * @returns The object, or nil if there is no object for the given key.
+ */
+- (id)objectForKey:(id)key;
+
+/**
+ * @brief Store an object in the cache with the given cost.
+ *
+ * Any object already stored with this key is replaced. If the new total cost exceeds
+ * maxTotalCost then the least recently used objects are evicted, which may include this object
+ * if its cost alone exceeds maxTotalCost.
+ */
+- (void)setObject:(id)object forKey:(id)key cost:(NSUInteger)cost;
+
+/**
+ * @brief Remove the object stored with the given key.
+ *
+ * Removing an object explicitly does not count as an eviction.
+ */
+- (void)removeObjectForKey:(id)key;
+
+/**
+ * @brief Remove every object from the cache.
+ *
+ * Removing objects explicitly does not count as eviction.
+ */
+- (void)removeAllObjects;
+
+/**
+ * @brief Evict every object from the cache.
+ *
+ * Called automatically when the application receives a memory warning.
+ */
+- (void)reduceMemoryUsage;
+
+/**
+ * @brief The total cost at which objects start being evicted.
+ *
+ * Lowering this value evicts objects immediately. Zero means no limit.
+ */
+@property (nonatomic, readwrite, assign) NSUInteger maxTotalCost;
+
+/**
+ * @brief The sum of the costs of every object in the cache.
+ */
+@property (nonatomic, readonly, assign) NSUInteger totalCost;
+
+/**
+ * @brief The number of objects in the cache.
+ */
+@property (nonatomic, readonly, assign) NSUInteger count;
+
+
+/**
+ * @name Statistics
+ * @{
+ */
+#pragma mark Statistics
+
+/**
+ * @brief The number of times objectForKey: has found an object.
+ */
+@property (nonatomic, readonly, assign) NSUInteger numberOfHits;
+
+/**
+ * @brief The number of times objectForKey: has not found an object.
+ */
+@property (nonatomic, readonly, assign) NSUInteger numberOfMisses;
+
+/**
+ * @brief The number of objects removed to stay within maxTotalCost or due to a memory warning.
+ */
+@property (nonatomic, readonly, assign) NSUInteger numberOfEvictions;
+
+/**
+ * @brief Reset the hit, miss, and eviction counters to zero.
+ */
+- (void)resetStatistics;
+
+/**@}*/
+
+@end
+
+
+/**
+ * @brief A memory cache for decompressed images.
+ *
+ * The cost of each image is the number of bytes used by its decompressed bitmap, so
+ * maxTotalCost is a limit on bytes of pixel data.
+ */
+@interface NIImageMemoryCache : NIMemoryCache {
+}
+
+/**
+ * @brief Store an image in the cache, using its decompressed size as its cost.
+ */
+- (void)storeImage:(UIImage *)image forKey:(id)key;
+
+/**
+ * @brief The number of bytes used by the bitmap backing the given image.
+ */
++ (NSUInteger)costForImage:(UIImage *)image;
+
+@end
+
+/**@}*/
@@ -0,0 +1,318 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIInMemoryCache.h"
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief A single object in the cache and its position in the least recently used list.
+ *
+ * The list pointers are not retained; each entry is retained only by the cache's dictionary.
+ */
+@interface NIMemoryCacheEntry : NSObject {
+@private
+  id                  _key;
+  id                  _object;
+  NSUInteger          _cost;
+  NIMemoryCacheEntry* _previousEntry;
+  NIMemoryCacheEntry* _nextEntry;
+}
+
+@property (nonatomic, readwrite, copy)    id                  key;
+@property (nonatomic, readwrite, retain)  id                  object;
+@property (nonatomic, readwrite, assign)  NSUInteger          cost;
+@property (nonatomic, readwrite, assign)  NIMemoryCacheEntry* previousEntry;
+@property (nonatomic, readwrite, assign)  NIMemoryCacheEntry* nextEntry;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIMemoryCacheEntry
+
+@synthesize key           = _key;
+@synthesize object        = _object;
+@synthesize cost          = _cost;
+@synthesize previousEntry = _previousEntry;
+@synthesize nextEntry     = _nextEntry;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_key);
+  NI_RELEASE_SAFELY(_object);
+
+  [super dealloc];
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIMemoryCache
+
+@synthesize maxTotalCost      = _maxTotalCost;
+@synthesize totalCost         = _totalCost;
+@synthesize numberOfHits      = _numberOfHits;
+@synthesize numberOfMisses    = _numberOfMisses;
+@synthesize numberOfEvictions = _numberOfEvictions;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+  NI_RELEASE_SAFELY(_entries);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithMaxTotalCost:(NSUInteger)maxTotalCost {
+  if ((self = [super init])) {
+    _entries = [[NSMutableDictionary alloc] init];
+    _maxTotalCost = maxTotalCost;
+
+    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+    [nc addObserver: self
+           selector: @selector(didReceiveMemoryWarning:)
+               name: UIApplicationDidReceiveMemoryWarningNotification
+             object: nil];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithMaxTotalCost:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Least Recently Used List
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)unlinkEntry:(NIMemoryCacheEntry *)entry {
+  if (nil != entry.previousEntry) {
+    entry.previousEntry.nextEntry = entry.nextEntry;
+
+  } else {
+    _headEntry = entry.nextEntry;
+  }
+
+  if (nil != entry.nextEntry) {
+    entry.nextEntry.previousEntry = entry.previousEntry;
+
+  } else {
+    _tailEntry = entry.previousEntry;
+  }
+
+  entry.previousEntry = nil;
+  entry.nextEntry = nil;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)linkEntryAtHead:(NIMemoryCacheEntry *)entry {
+  entry.previousEntry = nil;
+  entry.nextEntry = _headEntry;
+  _headEntry.previousEntry = entry;
+  _headEntry = entry;
+
+  if (nil == _tailEntry) {
+    _tailEntry = entry;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeEntry:(NIMemoryCacheEntry *)entry {
+  [self unlinkEntry:entry];
+  _totalCost -= entry.cost;
+
+  // The dictionary holds the only reference to the entry, so the key must outlive the removal.
+  [_entries removeObjectForKey:[[entry.key retain] autorelease]];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)evictEntriesToFitMaxTotalCost {
+  if (0 == _maxTotalCost) {
+    return;
+  }
+
+  while (_totalCost > _maxTotalCost && nil != _tailEntry) {
+    [self removeEntry:_tailEntry];
+    ++_numberOfEvictions;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Notifications
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+  [self reduceMemoryUsage];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Public Methods
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)objectForKey:(id)key {
+  NIMemoryCacheEntry* entry = (nil == key) ? nil : [_entries objectForKey:key];
+  if (nil == entry) {
+    ++_numberOfMisses;
+    return nil;
+  }
+
+  ++_numberOfHits;
+  if (_headEntry != entry) {
+    [self unlinkEntry:entry];
+    [self linkEntryAtHead:entry];
+  }
+
+  return [[entry.object retain] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setObject:(id)object forKey:(id)key cost:(NSUInteger)cost {
+  NIDASSERT(nil != key);
+  if (nil == key) {
+    return;
+  }
+
+  if (nil == object) {
+    [self removeObjectForKey:key];
+    return;
+  }
+
+  NIMemoryCacheEntry* entry = [_entries objectForKey:key];
+  if (nil != entry) {
+    _totalCost -= entry.cost;
+    [self unlinkEntry:entry];
+
+  } else {
+    entry = [[[NIMemoryCacheEntry alloc] init] autorelease];
+    entry.key = key;
+    [_entries setObject:entry forKey:key];
+  }
+
+  entry.object = object;
+  entry.cost = cost;
+  _totalCost += cost;
+  [self linkEntryAtHead:entry];
+
+  [self evictEntriesToFitMaxTotalCost];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObjectForKey:(id)key {
+  NIMemoryCacheEntry* entry = (nil == key) ? nil : [_entries objectForKey:key];
+  if (nil != entry) {
+    [self removeEntry:entry];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllObjects {
+  _headEntry = nil;
+  _tailEntry = nil;
+  _totalCost = 0;
+  [_entries removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryUsage {
+  _numberOfEvictions += [_entries count];
+  [self removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)resetStatistics {
+  _numberOfHits = 0;
+  _numberOfMisses = 0;
+  _numberOfEvictions = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)count {
+  return [_entries count];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setMaxTotalCost:(NSUInteger)maxTotalCost {
+  _maxTotalCost = maxTotalCost;
+  [self evictEntriesToFitMaxTotalCost];
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIImageMemoryCache
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSUInteger)costForImage:(UIImage *)image {
+  CGImageRef imageRef = image.CGImage;
+  if (NULL == imageRef) {
+    return 0;
+  }
+  return CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)storeImage:(UIImage *)image forKey:(id)key {
+  [self setObject: image
+           forKey: key
+             cost: [[self class] costForImage:image]];
+}
+
+
+@end
@@ -0,0 +1,128 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/**
+ * @ingroup NimbusCore
+ * @{
+ */
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NimbusCore.h"
+#else
+#import "NimbusCore.h"
+#endif
+
+/**
+ * @brief A single log message and where it was logged from.
+ *
+ * The strings are not retained by the record; a sink that keeps a record after
+ * writeLogRecord: returns must retain the message itself.
+ */
+typedef struct {
+  NSInteger         level;      // 0 for messages logged with NIDPRINT.
+  const char*       module;     // May be NULL.
+  const char*       function;
+  NSInteger         line;
+  CFAbsoluteTime    timestamp;
+  uint32_t          thread;     // The mach port of the thread that logged the message.
+  NSString*         message;
+} NILogRecord;
+
+/**
+ * @brief A destination for log messages.
+ *
+ * Sinks may be called from any thread, though never from more than one thread at a time when
+ * they are the destination of an NIBufferedLogSink.
+ */
+@protocol NILogSink <NSObject>
+
+@required
+
+/**
+ * Write a single log message.
+ */
+- (void)writeLogRecord:(const NILogRecord *)record;
+
+@optional
+
+/**
+ * Write any messages that have not been written yet before returning.
+ */
+- (void)flush;
+
+@end
+
+
+/**
+ * @brief Writes log messages to the console with NSLog, prefixed with the function and line
+ *        that they were logged from.
+ */
+@interface NIConsoleLogSink : NSObject <NILogSink> {
+}
+
+@end
+
+
+struct NILogBuffer;
+
+/**
+ * @brief Collects log messages in a lock-free ring buffer and writes them to another sink on a
+ *        background thread.
+ *
+ * Writing a record to this sink only retains its message and adds it to the buffer, so logging
+ * from a busy thread no longer waits on the destination. The destination receives the records
+ * in the order that they were logged, always from one thread at a time.
+ *
+ * If the buffer fills up faster than the background thread can empty it, the logging thread
+ * writes the buffered records to the destination itself rather than dropping any.
+ */
+@interface NIBufferedLogSink : NSObject <NILogSink> {
+@private
+  id<NILogSink>       _destination;
+  struct NILogBuffer* _buffer;
+}
+
+/**
+ * @brief Designated initializer.
+ *
+ * @param destination  The sink that the buffered records are written to.
+ * @param capacity     The number of records that the buffer can hold. Rounded up to the next
+ *                     power of two.
+ */
+- (id)initWithDestination:(id<NILogSink>)destination capacity:(NSUInteger)capacity;
+
+/**
+ * @brief Buffer up to 1024 records for the given sink.
+ */
+- (id)initWithDestination:(id<NILogSink>)destination;
+
+/**
+ * @brief The sink that the buffered records are written to.
+ */
+@property (nonatomic, readonly, retain) id<NILogSink> destination;
+
+/**
+ * @brief Write every buffered record to the destination on the calling thread and then flush
+ *        the destination.
+ */
+- (void)flush;
+
+@end
+
+/**@}*/
@@ -0,0 +1,497 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NILogging.h"
+
+#import <libkern/OSAtomic.h>
+#import <mach/mach.h>
+#import <pthread.h>
+#import <signal.h>
+
+static const NSUInteger kDefaultLogBufferCapacity = 1024;
+
+#define NI_MAX_NUMBER_OF_LOG_MODULES 32
+
+typedef struct {
+  char*               name;
+  volatile NSInteger  maxLogLevel;
+} NILogModule;
+
+// Modules are only ever appended, and each one is fully written before the count is
+// incremented, so the table can be read without a lock.
+static NILogModule      sLogModules[NI_MAX_NUMBER_OF_LOG_MODULES];
+static volatile int32_t sNumberOfLogModules = 0;
+static pthread_mutex_t  sLogModulesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static id<NILogSink>    sLogSink = nil;
+static id<NILogSink>    sDefaultLogSink = nil;
+static pthread_once_t   sDefaultLogSinkOnce = PTHREAD_ONCE_INIT;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Module Log Levels
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static NILogModule* NILogModuleNamed(const char* module) {
+  int32_t numberOfLogModules = sNumberOfLogModules;
+  OSMemoryBarrier();
+
+  for (int32_t ix = 0; ix < numberOfLogModules; ++ix) {
+    if (0 == strcmp(sLogModules[ix].name, module)) {
+      return &sLogModules[ix];
+    }
+  }
+  return NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NISetMaxLogLevelForModule(NSInteger maxLogLevel, const char* module) {
+  if (NULL == module) {
+    NIMaxLogLevel = maxLogLevel;
+    return;
+  }
+
+  pthread_mutex_lock(&sLogModulesLock);
+
+  NILogModule* logModule = NILogModuleNamed(module);
+  if (NULL != logModule) {
+    logModule->maxLogLevel = maxLogLevel;
+
+  } else if (sNumberOfLogModules < NI_MAX_NUMBER_OF_LOG_MODULES) {
+    logModule = &sLogModules[sNumberOfLogModules];
+    logModule->name = strdup(module);
+    logModule->maxLogLevel = maxLogLevel;
+    OSMemoryBarrier();
+    OSAtomicIncrement32Barrier(&sNumberOfLogModules);
+  }
+
+  pthread_mutex_unlock(&sLogModulesLock);
+
+  NIDASSERT(NULL != logModule);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSInteger NIMaxLogLevelForModule(const char* module) {
+  if (NULL == module || 0 == sNumberOfLogModules) {
+    return NIMaxLogLevel;
+  }
+
+  NILogModule* logModule = NILogModuleNamed(module);
+  return (NULL != logModule) ? logModule->maxLogLevel : NIMaxLogLevel;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Log Sinks
+
+
+static NSUncaughtExceptionHandler* sPreviousUncaughtExceptionHandler = NULL;
+
+static const int kCrashSignals[] = { SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV, SIGTRAP };
+#define NI_NUMBER_OF_CRASH_SIGNALS (sizeof(kCrashSignals) / sizeof(kCrashSignals[0]))
+static struct sigaction sPreviousCrashSignalActions[NI_NUMBER_OF_CRASH_SIGNALS];
+static volatile sig_atomic_t sIsHandlingCrashSignal = 0;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface NIBufferedLogSink()
+
+/**
+ * Like flush, but gives up rather than waiting if the buffer is being drained.
+ */
+- (void)flushIfNotDraining;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NILogUncaughtExceptionHandler(NSException* exception) {
+  NIFlushLog();
+
+  if (NULL != sPreviousUncaughtExceptionHandler) {
+    sPreviousUncaughtExceptionHandler(exception);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NILogCrashSignalHandler(int signalNumber) {
+  // Writing the log isn't async-signal-safe, but the process is about to die anyway and the
+  // last few messages are usually the ones that explain why. A crash while flushing skips
+  // straight to the previous handler.
+  if (0 == sIsHandlingCrashSignal) {
+    sIsHandlingCrashSignal = 1;
+
+    id<NILogSink> sink = (nil != sLogSink) ? sLogSink : sDefaultLogSink;
+    if ([sink isKindOfClass:[NIBufferedLogSink class]]) {
+      // Waiting on the drain lock could hang the app rather than letting it crash.
+      [(NIBufferedLogSink *)sink flushIfNotDraining];
+
+    } else if ([sink respondsToSelector:@selector(flush)]) {
+      [sink flush];
+    }
+  }
+
+  // Hand the signal to whoever was handling it before us so the crash is reported as usual.
+  for (NSUInteger ix = 0; ix < NI_NUMBER_OF_CRASH_SIGNALS; ++ix) {
+    if (kCrashSignals[ix] == signalNumber) {
+      sigaction(signalNumber, &sPreviousCrashSignalActions[ix], NULL);
+      break;
+    }
+  }
+  raise(signalNumber);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NICreateDefaultLogSink(void) {
+  NIConsoleLogSink* consoleSink = [[NIConsoleLogSink alloc] init];
+  sDefaultLogSink = [[NIBufferedLogSink alloc] initWithDestination:consoleSink];
+  [consoleSink release];
+
+  // Flush the buffered messages when the app crashes.
+  sPreviousUncaughtExceptionHandler = NSGetUncaughtExceptionHandler();
+  NSSetUncaughtExceptionHandler(&NILogUncaughtExceptionHandler);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = &NILogCrashSignalHandler;
+  sigemptyset(&action.sa_mask);
+  for (NSUInteger ix = 0; ix < NI_NUMBER_OF_CRASH_SIGNALS; ++ix) {
+    sigaction(kCrashSignals[ix], &action, &sPreviousCrashSignalActions[ix]);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NISetLogSink(id<NILogSink> sink) {
+  id<NILogSink> previousSink = sLogSink;
+  if (previousSink == sink) {
+    return;
+  }
+
+  sLogSink = [sink retain];
+  if ([previousSink respondsToSelector:@selector(flush)]) {
+    [previousSink flush];
+  }
+  [previousSink release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+id<NILogSink> NICurrentLogSink(void) {
+  if (nil != sLogSink) {
+    return sLogSink;
+  }
+
+  pthread_once(&sDefaultLogSinkOnce, &NICreateDefaultLogSink);
+  return sDefaultLogSink;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NIFlushLog(void) {
+  id<NILogSink> sink = NICurrentLogSink();
+  if ([sink respondsToSelector:@selector(flush)]) {
+    [sink flush];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NILogMessage(NSInteger level, const char* module, const char* function, NSInteger line,
+                  NSString* format, ...) {
+  va_list arguments;
+  va_start(arguments, format);
+  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  va_end(arguments);
+
+  NILogRecord record;
+  record.level = level;
+  record.module = module;
+  record.function = function;
+  record.line = line;
+  record.timestamp = CFAbsoluteTimeGetCurrent();
+  record.thread = pthread_mach_thread_np(pthread_self());
+  record.message = message;
+
+  [NICurrentLogSink() writeLogRecord:&record];
+
+  [message release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIConsoleLogSink
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)writeLogRecord:(const NILogRecord *)record {
+  NSLog(@"%s(%ld): %@", record->function, (long)record->line, record->message);
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Log Buffer
+
+// A bounded multiple-producer queue. Each cell's sequence number says whose turn it is: a
+// producer may fill the cell at position p once its sequence is p, and the consumer may empty it
+// once its sequence is p + 1. Producers claim positions with a compare-and-swap, so logging never
+// takes a lock; only draining the queue does.
+typedef struct {
+  volatile int64_t  sequence;
+  NILogRecord       record;
+} NILogBufferCell;
+
+struct NILogBuffer {
+  NILogBufferCell*  cells;
+  int64_t           mask;
+  volatile int64_t  enqueuePosition;
+
+  // Draining
+  int64_t           dequeuePosition;
+  pthread_mutex_t   drainLock;
+  NSInteger         drainDepth; // Only accessed with the drain lock held.
+  id<NILogSink>     destination;
+
+  // Background Thread
+  pthread_t         thread;
+  semaphore_t       semaphore;
+  volatile BOOL     isStopping;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static BOOL NILogBufferEnqueue(struct NILogBuffer* buffer, const NILogRecord* record) {
+  int64_t position = buffer->enqueuePosition;
+  for (;;) {
+    NILogBufferCell* cell = &buffer->cells[position & buffer->mask];
+    int64_t difference = cell->sequence - position;
+
+    if (0 == difference) {
+      if (OSAtomicCompareAndSwap64Barrier(position, position + 1, &buffer->enqueuePosition)) {
+        cell->record = *record;
+        OSMemoryBarrier();
+        cell->sequence = position + 1;
+        return YES;
+      }
+
+    } else if (difference < 0) {
+      // The consumer hasn't emptied this cell yet.
+      return NO;
+    }
+
+    position = buffer->enqueuePosition;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Write every ready record to the destination. The caller must hold the drain lock.
+ */
+static void NILogBufferDrain(struct NILogBuffer* buffer) {
+  ++buffer->drainDepth;
+
+  for (;;) {
+    int64_t position = buffer->dequeuePosition;
+    NILogBufferCell* cell = &buffer->cells[position & buffer->mask];
+
+    OSMemoryBarrier();
+    if (cell->sequence != position + 1) {
+      // Either the buffer is empty or the next record is still being written.
+      break;
+    }
+
+    NILogRecord record = cell->record;
+    OSMemoryBarrier();
+    cell->sequence = position + buffer->mask + 1;
+    buffer->dequeuePosition = position + 1;
+
+    [buffer->destination writeLogRecord:&record];
+    [record.message release];
+  }
+
+  --buffer->drainDepth;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void* NILogBufferThreadMain(void* context) {
+  struct NILogBuffer* buffer = (struct NILogBuffer *)context;
+
+  while (!buffer->isStopping) {
+    semaphore_wait(buffer->semaphore);
+
+    NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+    pthread_mutex_lock(&buffer->drainLock);
+    NILogBufferDrain(buffer);
+    pthread_mutex_unlock(&buffer->drainLock);
+    [pool release];
+  }
+
+  return NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIBufferedLogSink
+
+@synthesize destination = _destination;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  if (NULL != _buffer) {
+    _buffer->isStopping = YES;
+    semaphore_signal(_buffer->semaphore);
+    pthread_join(_buffer->thread, NULL);
+
+    [self flush];
+
+    semaphore_destroy(mach_task_self(), _buffer->semaphore);
+    pthread_mutex_destroy(&_buffer->drainLock);
+    free(_buffer->cells);
+    free(_buffer);
+    _buffer = NULL;
+  }
+
+  NI_RELEASE_SAFELY(_destination);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithDestination:(id<NILogSink>)destination capacity:(NSUInteger)capacity {
+  NIDASSERT(nil != destination);
+
+  if ((self = [super init])) {
+    _destination = [destination retain];
+
+    NSUInteger numberOfCells = 2;
+    while (numberOfCells < capacity) {
+      numberOfCells <<= 1;
+    }
+
+    _buffer = calloc(1, sizeof(struct NILogBuffer));
+    _buffer->cells = calloc(numberOfCells, sizeof(NILogBufferCell));
+    _buffer->mask = numberOfCells - 1;
+    for (NSUInteger ix = 0; ix < numberOfCells; ++ix) {
+      _buffer->cells[ix].sequence = ix;
+    }
+
+    // A destination that logs while writing would otherwise deadlock on the drain lock.
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&_buffer->drainLock, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+
+    _buffer->destination = _destination;
+
+    semaphore_create(mach_task_self(), &_buffer->semaphore, SYNC_POLICY_FIFO, 0);
+
+    // Cocoa has to be told that the app is multithreaded before it is used from a POSIX thread,
+    // and detaching an NSThread is the only way to do that.
+    if (![NSThread isMultiThreaded]) {
+      [NSThread detachNewThreadSelector: @selector(class)
+                               toTarget: [NSObject class]
+                             withObject: nil];
+    }
+    pthread_create(&_buffer->thread, NULL, &NILogBufferThreadMain, _buffer);
+  }
+
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithDestination:(id<NILogSink>)destination {
+  return [self initWithDestination:destination capacity:kDefaultLogBufferCapacity];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)writeLogRecord:(const NILogRecord *)record {
+  NILogRecord bufferedRecord = *record;
+  bufferedRecord.message = [record->message retain];
+
+  while (!NILogBufferEnqueue(_buffer, &bufferedRecord)) {
+    // The background thread has fallen behind, so make room by writing the buffered records
+    // from this thread.
+    pthread_mutex_lock(&_buffer->drainLock);
+    NILogBufferDrain(_buffer);
+    pthread_mutex_unlock(&_buffer->drainLock);
+  }
+
+  semaphore_signal(_buffer->semaphore);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)flush {
+  pthread_mutex_lock(&_buffer->drainLock);
+  NILogBufferDrain(_buffer);
+  pthread_mutex_unlock(&_buffer->drainLock);
+
+  if ([_destination respondsToSelector:@selector(flush)]) {
+    [_destination flush];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)flushIfNotDraining {
+  if (0 != pthread_mutex_trylock(&_buffer->drainLock)) {
+    // Another thread is draining.
+    return;
+  }
+
+  // The drain lock is recursive, so this thread may hold it already if it was interrupted
+  // while draining.
+  if (0 == _buffer->drainDepth) {
+    NILogBufferDrain(_buffer);
+
+    if ([_destination respondsToSelector:@selector(flush)]) {
+      [_destination flush];
+    }
+  }
+
+  pthread_mutex_unlock(&_buffer->drainLock);
+}
+
+
+@end
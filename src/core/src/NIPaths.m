@@ -18,6 +18,108 @@
 
 #import "NimbusCore.h"
 
+#import <pthread.h>
+#import <sys/syslimits.h>
+
+/**
+ * @brief A system directory, looked up once.
+ */
+typedef struct {
+  NSString*   path;
+  char*       fileSystemPath;
+  size_t      fileSystemPathLength;
+} NISearchPath;
+
+static NISearchPath   sDocumentsPath;
+static pthread_once_t sDocumentsPathOnce = PTHREAD_ONCE_INIT;
+static NISearchPath   sCachesPath;
+static pthread_once_t sCachesPathOnce = PTHREAD_ONCE_INIT;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIInitSearchPath(NISearchPath* searchPath, NSSearchPathDirectory directory) {
+  // This may be the first thing to run on a background thread without a pool of its own.
+  NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+  NSArray* dirs = NSSearchPathForDirectoriesInDomains(directory, NSUserDomainMask, YES);
+  searchPath->path = [[dirs objectAtIndex:0] copy];
+  searchPath->fileSystemPath = strdup([searchPath->path fileSystemRepresentation]);
+  searchPath->fileSystemPathLength = strlen(searchPath->fileSystemPath);
+
+  [pool release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIInitDocumentsPath(void) {
+  NIInitSearchPath(&sDocumentsPath, NSDocumentDirectory);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIInitCachesPath(void) {
+  NIInitSearchPath(&sCachesPath, NSCachesDirectory);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static const NISearchPath* NIDocumentsPath(void) {
+  pthread_once(&sDocumentsPathOnce, &NIInitDocumentsPath);
+  return &sDocumentsPath;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static const NISearchPath* NICachesPath(void) {
+  pthread_once(&sCachesPathOnce, &NIInitCachesPath);
+  return &sCachesPath;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static BOOL NIGetPathForSearchPathResource(const NISearchPath* searchPath,
+                                           char* buffer, size_t bufferSize,
+                                           const char* relativePath) {
+  if (NULL == relativePath) {
+    relativePath = "";
+  }
+  while ('/' == *relativePath) {
+    ++relativePath;
+  }
+
+  size_t baseLength = searchPath->fileSystemPathLength;
+  size_t relativeLength = strlen(relativePath);
+  size_t length = baseLength + ((relativeLength > 0) ? 1 + relativeLength : 0);
+  if (NULL == buffer || length + 1 > bufferSize) {
+    return NO;
+  }
+
+  memcpy(buffer, searchPath->fileSystemPath, baseLength);
+  if (relativeLength > 0) {
+    buffer[baseLength] = '/';
+    memcpy(buffer + baseLength + 1, relativePath, relativeLength);
+  }
+  buffer[length] = '\0';
+
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static NSURL* NIURLForSearchPathResource(const NISearchPath* searchPath, NSString* relativePath) {
+  BOOL isDirectory = (0 == [relativePath length]);
+  const char* fileSystemRelativePath = isDirectory ? NULL : [relativePath fileSystemRepresentation];
+
+  char path[PATH_MAX];
+  if (!NIGetPathForSearchPathResource(searchPath, path, sizeof(path), fileSystemRelativePath)) {
+    return nil;
+  }
+
+  CFURLRef url = CFURLCreateFromFileSystemRepresentation(NULL, (const UInt8 *)path, strlen(path),
+                                                         isDirectory);
+  return [(NSURL *)url autorelease];
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 NSString* NIPathForBundleResource(NSBundle* bundle, NSString* relativePath) {
@@ -28,12 +130,35 @@ NSString* NIPathForBundleResource(NSBundle* bundle, NSString* relativePath) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 NSString* NIPathForDocumentsResource(NSString* relativePath) {
-  static NSString* documentsPath = nil;
-  if (nil == documentsPath) {
-    NSArray* dirs = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory,
-                                                        NSUserDomainMask,
-                                                        YES);
-    documentsPath = [[dirs objectAtIndex:0] retain];
-  }
-  return [documentsPath stringByAppendingPathComponent:relativePath];
+  return [NIDocumentsPath()->path stringByAppendingPathComponent:relativePath];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSString* NIPathForCachesResource(NSString* relativePath) {
+  return [NICachesPath()->path stringByAppendingPathComponent:relativePath];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL NIGetPathForDocumentsResource(char* buffer, size_t bufferSize, const char* relativePath) {
+  return NIGetPathForSearchPathResource(NIDocumentsPath(), buffer, bufferSize, relativePath);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL NIGetPathForCachesResource(char* buffer, size_t bufferSize, const char* relativePath) {
+  return NIGetPathForSearchPathResource(NICachesPath(), buffer, bufferSize, relativePath);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSURL* NIURLForDocumentsResource(NSString* relativePath) {
+  return NIURLForSearchPathResource(NIDocumentsPath(), relativePath);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSURL* NIURLForCachesResource(NSString* relativePath) {
+  return NIURLForSearchPathResource(NICachesPath(), relativePath);
 }
@@ -0,0 +1,132 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/**
+ * @ingroup NimbusCore
+ * @{
+ */
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NimbusCore.h"
+#else
+#import "NimbusCore.h"
+#endif
+
+/**
+ * @brief A set of pointers that are compared by identity and never retained.
+ *
+ * The pointers are stored in a single open-addressed table, so adding, removing, and finding a
+ * pointer hashes the pointer and probes neighbouring slots without calling out to any retain,
+ * release, hash, or equality callbacks. This makes it a good fit for hot registries of observers
+ * or delegates and for maps from views to their location.
+ *
+ * Each pointer can carry an integer value, so the set doubles as a map from pointers to indices:
+ *
+ * @code
+ * [buttonIndices addPointer:button withValue:index];
+ *
+ * NSInteger index = 0;
+ * if ([buttonIndices getValue:&index forPointer:button]) {
+ *   ...
+ * }
+ * @endcode
+ *
+ * The set is enumerated in no particular order. Pointers may be removed while the set is being
+ * enumerated; a pointer that is removed before the enumeration reaches it is enumerated as nil.
+ * Adding a pointer during enumeration throws an exception, as it does with the Foundation
+ * collections.
+ *
+ * Like the non-retaining collections, the set does not know when an object is deallocated. Use
+ * NIZeroingWeakSet to have objects removed automatically.
+ *
+ * This class is not thread-safe.
+ */
+@interface NIPointerSet : NSObject <NSFastEnumeration> {
+@private
+  // All three arrays share a single allocation of _capacity slots.
+  const void**  _pointers;
+  NSInteger*    _values;
+  BOOL*         _tombstones;
+
+  NSUInteger    _capacity;
+  NSUInteger    _count;
+  NSUInteger    _numberOfTombstones;
+
+  unsigned long _mutations;
+}
+
+/**
+ * @brief Designated initializer.
+ *
+ * @param capacity  The number of pointers the set can hold before it has to grow.
+ */
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ * @brief An autoreleased, empty pointer set.
+ */
++ (id)pointerSet;
+
+/**
+ * @brief The number of pointers in the set.
+ */
+@property (nonatomic, readonly, assign) NSUInteger count;
+
+/**
+ * @brief Whether the given pointer is in the set.
+ */
+- (BOOL)containsPointer:(const void *)pointer;
+
+/**
+ * @brief Add the given pointer to the set with a value of zero.
+ *
+ * The value of a pointer that is already in the set is left alone.
+ */
+- (void)addPointer:(const void *)pointer;
+
+/**
+ * @brief Add the given pointer to the set, or replace its value if it is already in the set.
+ *
+ * @param pointer  Must not be NULL.
+ */
+- (void)addPointer:(const void *)pointer withValue:(NSInteger)value;
+
+/**
+ * @brief Fetch the value stored with the given pointer.
+ *
+ * @returns NO if the pointer is not in the set, in which case value is left alone.
+ */
+- (BOOL)getValue:(NSInteger *)value forPointer:(const void *)pointer;
+
+/**
+ * @brief Remove the given pointer from the set.
+ *
+ * The pointer's slot is marked as deleted rather than refilled, so removal never moves other
+ * pointers. Deleted slots are reclaimed the next time the set grows.
+ */
+- (void)removePointer:(const void *)pointer;
+
+/**
+ * @brief Remove every pointer from the set while keeping its capacity.
+ */
+- (void)removeAllPointers;
+
+@end
+
+/**@}*/
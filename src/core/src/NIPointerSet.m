@@ -0,0 +1,318 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIPointerSet.h"
+
+// Must be a power of two so that hashes can be masked into the table.
+static const NSUInteger kMinimumCapacity = 8;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static NSUInteger NIHashPointer(const void* pointer) {
+  // Allocations are aligned, so the low bits of a pointer carry little information. Fold the
+  // higher bits down and multiply to spread consecutive allocations across the table.
+  uintptr_t hash = (uintptr_t)pointer;
+  hash ^= hash >> 4;
+  hash *= 2654435761u;
+  return (NSUInteger)(hash ^ (hash >> 16));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIPointerSet
+
+@synthesize count = _count;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  free(_pointers);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)allocateSlots:(NSUInteger)capacity {
+  // The arrays are ordered from the largest element to the smallest to keep them aligned.
+  size_t slotSize = sizeof(const void *) + sizeof(NSInteger) + sizeof(BOOL);
+  void* slots = calloc(capacity, slotSize);
+  if (NULL == slots) {
+    return NO;
+  }
+
+  _pointers = (const void **)slots;
+  _values = (NSInteger *)(_pointers + capacity);
+  _tombstones = (BOOL *)(_values + capacity);
+  _capacity = capacity;
+  _numberOfTombstones = 0;
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithCapacity:(NSUInteger)capacity {
+  if ((self = [super init])) {
+    // Keep the table at most half full so that probe sequences stay short.
+    NSUInteger tableCapacity = kMinimumCapacity;
+    while (tableCapacity < capacity * 2) {
+      tableCapacity *= 2;
+    }
+
+    if (![self allocateSlots:tableCapacity]) {
+      [self release];
+      return nil;
+    }
+  }
+
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithCapacity:0];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (id)pointerSet {
+  return [[[self alloc] init] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Probing
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The slot holding the given pointer, or NSNotFound.
+ */
+- (NSUInteger)slotForPointer:(const void *)pointer {
+  NSUInteger mask = _capacity - 1;
+  NSUInteger ixSlot = NIHashPointer(pointer) & mask;
+
+  // The table always has empty slots, so every probe sequence ends.
+  while (NULL != _pointers[ixSlot] || _tombstones[ixSlot]) {
+    if (_pointers[ixSlot] == pointer) {
+      return ixSlot;
+    }
+    ixSlot = (ixSlot + 1) & mask;
+  }
+
+  return NSNotFound;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The slot that a pointer known not to be in the set should be stored in.
+ *
+ * Deleted slots are reused before the probe reaches an empty slot.
+ */
+- (NSUInteger)freeSlotForPointer:(const void *)pointer {
+  NSUInteger mask = _capacity - 1;
+  NSUInteger ixSlot = NIHashPointer(pointer) & mask;
+
+  while (NULL != _pointers[ixSlot]) {
+    ixSlot = (ixSlot + 1) & mask;
+  }
+
+  return ixSlot;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Rebuild the table so that it can take at least one more pointer.
+ *
+ * Deleted slots are dropped along the way and the new table is sized to be at most half full,
+ * so a set that has mostly filled up with deleted slots may well shrink.
+ */
+- (BOOL)growToFitAnotherPointer {
+  const void** oldPointers = _pointers;
+  NSInteger* oldValues = _values;
+  NSUInteger oldCapacity = _capacity;
+
+  NSUInteger capacity = kMinimumCapacity;
+  while (capacity < (_count + 1) * 2) {
+    capacity *= 2;
+  }
+
+  if (![self allocateSlots:capacity]) {
+    return NO;
+  }
+
+  for (NSUInteger ixSlot = 0; ixSlot < oldCapacity; ++ixSlot) {
+    if (NULL != oldPointers[ixSlot]) {
+      NSUInteger ixNewSlot = [self freeSlotForPointer:oldPointers[ixSlot]];
+      _pointers[ixNewSlot] = oldPointers[ixSlot];
+      _values[ixNewSlot] = oldValues[ixSlot];
+    }
+  }
+
+  free(oldPointers);
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Public Methods
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)containsPointer:(const void *)pointer {
+  return NULL != pointer && NSNotFound != [self slotForPointer:pointer];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)addPointer:(const void *)pointer {
+  if (![self containsPointer:pointer]) {
+    [self addPointer:pointer withValue:0];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)addPointer:(const void *)pointer withValue:(NSInteger)value {
+  NIDASSERT(NULL != pointer);
+  if (NULL == pointer) {
+    return;
+  }
+
+  NSUInteger ixSlot = [self slotForPointer:pointer];
+  if (NSNotFound != ixSlot) {
+    // Replacing a value doesn't change the table, so it is safe during enumeration.
+    _values[ixSlot] = value;
+    return;
+  }
+
+  // Keep at least a quarter of the table empty, counting deleted slots as used.
+  if ((_count + _numberOfTombstones + 1) * 4 > _capacity * 3
+      && ![self growToFitAnotherPointer]) {
+    return;
+  }
+
+  ixSlot = [self freeSlotForPointer:pointer];
+  if (_tombstones[ixSlot]) {
+    _tombstones[ixSlot] = NO;
+    --_numberOfTombstones;
+  }
+  _pointers[ixSlot] = pointer;
+  _values[ixSlot] = value;
+  ++_count;
+  ++_mutations;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)getValue:(NSInteger *)value forPointer:(const void *)pointer {
+  if (NULL == pointer) {
+    return NO;
+  }
+
+  NSUInteger ixSlot = [self slotForPointer:pointer];
+  if (NSNotFound == ixSlot) {
+    return NO;
+  }
+
+  if (NULL != value) {
+    *value = _values[ixSlot];
+  }
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removePointer:(const void *)pointer {
+  if (NULL == pointer) {
+    return;
+  }
+
+  NSUInteger ixSlot = [self slotForPointer:pointer];
+  if (NSNotFound == ixSlot) {
+    return;
+  }
+
+  // Removal doesn't count as a mutation because no other pointer moves. An enumeration that has
+  // yet to reach this slot will see NULL.
+  _pointers[ixSlot] = NULL;
+  _values[ixSlot] = 0;
+  _tombstones[ixSlot] = YES;
+  ++_numberOfTombstones;
+  --_count;
+
+  if (0 == _count) {
+    // Nothing is left to probe past, so every deleted slot can be reclaimed in place.
+    memset(_tombstones, 0, _capacity * sizeof(BOOL));
+    _numberOfTombstones = 0;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllPointers {
+  memset(_pointers, 0, _capacity * (sizeof(const void *) + sizeof(NSInteger) + sizeof(BOOL)));
+  _count = 0;
+  _numberOfTombstones = 0;
+  ++_mutations;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark NSFastEnumeration
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)countByEnumeratingWithState: (NSFastEnumerationState *)state
+                                  objects: (id *)stackbuf
+                                    count: (NSUInteger)len {
+  if (0 == state->state) {
+    state->state = 1;
+    state->mutationsPtr = &_mutations;
+    state->extra[0] = 0;
+  }
+
+  // Rather than copying the pointers out, hand out each run of occupied slots in place. This is
+  // also what lets pointers be removed during enumeration: the enumeration reads each slot as it
+  // reaches it.
+  NSUInteger ixSlot = state->extra[0];
+  while (ixSlot < _capacity && NULL == _pointers[ixSlot]) {
+    ++ixSlot;
+  }
+
+  NSUInteger ixFirstSlot = ixSlot;
+  while (ixSlot < _capacity && NULL != _pointers[ixSlot]) {
+    ++ixSlot;
+  }
+
+  state->extra[0] = ixSlot;
+  state->itemsPtr = (id *)(void *)(_pointers + ixFirstSlot);
+  return ixSlot - ixFirstSlot;
+}
+
+
+@end
@@ -18,21 +18,36 @@
 
 #import "NimbusCore.h"
 
+#import <pthread.h>
+
+static BOOL           sIsPad = NO;
+static pthread_once_t sIsPadOnce = PTHREAD_ONCE_INIT;
+
+static Class          sPopoverControllerClass = nil;
+static pthread_once_t sPopoverControllerClassOnce = PTHREAD_ONCE_INIT;
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-BOOL NIIsPad() {
+static void NIInitIsPad(void) {
 #ifdef UI_USER_INTERFACE_IDIOM
-  static NSInteger isPad = -1;
-  if (isPad < 0) {
-    isPad = (UI_USER_INTERFACE_IDIOM() == UIUserInterfaceIdiomPad);
-  }
-  return isPad > 0;
-#else
-  return NO;
+  sIsPad = (UI_USER_INTERFACE_IDIOM() == UIUserInterfaceIdiomPad);
 #endif
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIInitPopoverControllerClass(void) {
+  sPopoverControllerClass = NSClassFromString(@"UIPopoverController");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL NIIsPad() {
+  pthread_once(&sIsPadOnce, &NIInitIsPad);
+  return sIsPad;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 BOOL NIDeviceOSVersionIsAtLeast(double versionNumber) {
   return kCFCoreFoundationVersionNumber >= versionNumber;
@@ -41,9 +56,6 @@ BOOL NIDeviceOSVersionIsAtLeast(double versionNumber) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 Class NIUIPopoverControllerClass() {
-  static Class sClass = nil;
-  if (nil == sClass) {
-    sClass = NSClassFromString(@"UIPopoverController");
-  }
-  return sClass;
+  pthread_once(&sPopoverControllerClassOnce, &NIInitPopoverControllerClass);
+  return sPopoverControllerClass;
 }
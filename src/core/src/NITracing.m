@@ -0,0 +1,151 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NimbusCore.h"
+
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
+
+BOOL NITracingEnabled = NO;
+
+// The buffer is zero-filled memory that the system only backs with pages once events have been
+// written to them, so it costs nothing while tracing is disabled.
+static NITraceEvent sTraceEvents[NI_TRACE_BUFFER_CAPACITY];
+
+// The total number of events recorded since the last reset, including those that have since
+// been overwritten.
+static volatile int64_t sNumberOfRecordedEvents = 0;
+
+static mach_timebase_info_data_t  sTimebase = { 0, 0 };
+static pthread_once_t             sTimebaseOnce = PTHREAD_ONCE_INIT;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIInitTimebase(void) {
+  mach_timebase_info(&sTimebase);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NITraceRecordEvent(NITraceEventType type, const char* name, int64_t value) {
+  int64_t ixEvent = OSAtomicIncrement64Barrier(&sNumberOfRecordedEvents) - 1;
+  NITraceEvent* event = &sTraceEvents[ixEvent % NI_TRACE_BUFFER_CAPACITY];
+
+  event->type = type;
+  event->name = name;
+  event->timestamp = mach_absolute_time();
+  event->thread = pthread_mach_thread_np(pthread_self());
+  event->value = value;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSUInteger NITraceCopyEvents(NITraceEvent* events, NSUInteger maxCount) {
+  if (NULL == events) {
+    return 0;
+  }
+
+  OSMemoryBarrier();
+  int64_t numberOfRecordedEvents = sNumberOfRecordedEvents;
+
+  NSUInteger count = (NSUInteger)MIN(numberOfRecordedEvents, NI_TRACE_BUFFER_CAPACITY);
+  count = MIN(count, maxCount);
+
+  int64_t ixFirstEvent = numberOfRecordedEvents - count;
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    events[ix] = sTraceEvents[(ixFirstEvent + ix) % NI_TRACE_BUFFER_CAPACITY];
+  }
+
+  return count;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void NITraceReset(void) {
+  sNumberOfRecordedEvents = 0;
+  OSMemoryBarrier();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSTimeInterval NITraceTimeIntervalFromTimestamp(uint64_t timestamp, uint64_t startTimestamp) {
+  pthread_once(&sTimebaseOnce, &NIInitTimebase);
+
+  if (timestamp < startTimestamp) {
+    return 0;
+  }
+
+  uint64_t nanoseconds = (timestamp - startTimestamp) * sTimebase.numer / sTimebase.denom;
+  return (NSTimeInterval)nanoseconds / NSEC_PER_SEC;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NITraceAppendEscapedName(NSMutableString* json, const char* name) {
+  [json appendString:@"\""];
+  for (const char* character = name; NULL != character && '\0' != *character; ++character) {
+    if ('"' == *character || '\\' == *character) {
+      [json appendFormat:@"\\%c", *character];
+
+    } else if ((unsigned char)*character < 0x20) {
+      [json appendFormat:@"\\u%04x", (unsigned char)*character];
+
+    } else {
+      [json appendFormat:@"%c", *character];
+    }
+  }
+  [json appendString:@"\""];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL NITraceWriteToFile(NSString* path, NSError** error) {
+  NITraceEvent* events = malloc(sizeof(NITraceEvent) * NI_TRACE_BUFFER_CAPACITY);
+  if (NULL == events) {
+    return NO;
+  }
+
+  NSUInteger count = NITraceCopyEvents(events, NI_TRACE_BUFFER_CAPACITY);
+  uint64_t startTimestamp = (count > 0) ? events[0].timestamp : 0;
+
+  NSMutableString* json = [NSMutableString stringWithString:@"{\"traceEvents\":["];
+  for (NSUInteger ix = 0; ix < count; ++ix) {
+    const NITraceEvent* event = &events[ix];
+
+    static const char* kPhases[] = { "B", "E", "C", "i" };
+    [json appendString:(ix > 0) ? @",\n" : @"\n"];
+    [json appendString:@"{\"name\":"];
+    NITraceAppendEscapedName(json, event->name);
+    [json appendFormat:@",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+     kPhases[event->type],
+     NITraceTimeIntervalFromTimestamp(event->timestamp, startTimestamp) * 1000000,
+     event->thread];
+
+    if (NITraceEventTypeCounter == event->type) {
+      [json appendFormat:@",\"args\":{\"value\":%lld}", event->value];
+
+    } else if (NITraceEventTypeMarker == event->type) {
+      [json appendString:@",\"s\":\"t\""];
+    }
+    [json appendString:@"}"];
+  }
+  [json appendString:@"\n]}\n"];
+
+  free(events);
+
+  return [json writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:error];
+}
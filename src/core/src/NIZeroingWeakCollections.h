@@ -0,0 +1,169 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/**
+ * @ingroup Non-Retaining-Collections
+ * @{
+ *
+ * Zeroing weak collections don't retain their objects, but unlike the collections made by
+ * NICreateNonRetainingArray and friends they notice when one of their objects is deallocated
+ * and stop containing it. A delegate that forgets to remove itself no longer leaves a dangling
+ * pointer behind.
+ *
+ * Each object is watched by attaching a small sentinel object to it with
+ * objc_setAssociatedObject. The sentinel is released when the object is deallocated and tells
+ * the collection that the object is gone. The dead entry's slot is cleared right away, but the
+ * collection isn't compacted until it is next mutated, so an object that is deallocated while
+ * the collection is being enumerated is enumerated as nil rather than throwing off the
+ * enumeration.
+ *
+ * An object is only removed once it has finished deallocating, so an object that is in the
+ * middle of its dealloc method may still be enumerated.
+ *
+ * Associated objects were added in iOS 3.1. On iOS 3.0 these collections don't notice
+ * deallocated objects and behave like the non-retaining collections.
+ *
+ * These collections are not thread-safe, and their objects must be deallocated on the same
+ * thread that uses the collection.
+ */
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NimbusCore.h"
+#else
+#import "NimbusCore.h"
+#endif
+
+@class NIPointerSet;
+
+/**
+ * @brief Whether zeroing weak collections can notice deallocated objects on this device.
+ */
+BOOL NIIsZeroingWeakReferenceSupported();
+
+/**
+ * @brief An ordered array that holds zeroing weak references to its objects.
+ *
+ * Objects are compared by identity. The same object may be added more than once.
+ */
+@interface NIZeroingWeakArray : NSObject <NSFastEnumeration> {
+@private
+  // Deallocated objects leave nil behind until the array is compacted.
+  id*           _objects;
+  NSUInteger    _numberOfSlots;
+  NSUInteger    _capacity;
+  NSUInteger    _numberOfDeadObjects;
+
+  // Every distinct object in the array, mapped to the number of times it appears.
+  NIPointerSet* _watchedObjects;
+
+  unsigned long _mutations;
+}
+
+/**
+ * @brief An autoreleased, empty array.
+ */
++ (id)array;
+
+/**
+ * @brief The number of live objects in the array.
+ */
+@property (nonatomic, readonly, assign) NSUInteger count;
+
+/**
+ * @brief Whether the given object is in the array.
+ *
+ * This is a hash lookup rather than a search.
+ */
+- (BOOL)containsObject:(id)object;
+
+/**
+ * @brief Add the given object to the end of the array.
+ */
+- (void)addObject:(id)object;
+
+/**
+ * @brief Remove every occurrence of the given object from the array.
+ */
+- (void)removeObject:(id)object;
+
+/**
+ * @brief Remove every object from the array.
+ */
+- (void)removeAllObjects;
+
+/**
+ * @brief The array's live objects, in order, in an array that retains them.
+ *
+ * Use this rather than enumerating the array directly when the objects may add or remove
+ * objects while they are being notified.
+ */
+- (NSArray *)allObjects;
+
+@end
+
+
+/**
+ * @brief An unordered set that holds zeroing weak references to its objects.
+ *
+ * Objects are compared by identity and stored in an NIPointerSet, so adding, removing, and
+ * finding an object involve no hash or isEqual: messages.
+ */
+@interface NIZeroingWeakSet : NSObject <NSFastEnumeration> {
+@private
+  NIPointerSet* _objects;
+}
+
+/**
+ * @brief An autoreleased, empty set.
+ */
++ (id)set;
+
+/**
+ * @brief The number of live objects in the set.
+ */
+@property (nonatomic, readonly, assign) NSUInteger count;
+
+/**
+ * @brief Whether the given object is in the set.
+ */
+- (BOOL)containsObject:(id)object;
+
+/**
+ * @brief Add the given object to the set if it isn't already in it.
+ */
+- (void)addObject:(id)object;
+
+/**
+ * @brief Remove the given object from the set.
+ */
+- (void)removeObject:(id)object;
+
+/**
+ * @brief Remove every object from the set.
+ */
+- (void)removeAllObjects;
+
+/**
+ * @brief The set's live objects in an array that retains them.
+ */
+- (NSArray *)allObjects;
+
+@end
+
+/**@}*/
@@ -0,0 +1,438 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NIZeroingWeakCollections.h"
+
+#import "NIPointerSet.h"
+
+#import <objc/runtime.h>
+
+static const NSUInteger kMinimumArrayCapacity = 4;
+
+/**
+ * Implemented by the collections so that a sentinel can report its object's death.
+ */
+@protocol NIZeroingWeakOwner <NSObject>
+@required
+- (void)weakObjectDidDeallocate:(id)object;
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL NIIsZeroingWeakReferenceSupported() {
+  // The associated object functions are weakly linked when targeting iOS 3.0.
+  return NULL != &objc_setAssociatedObject;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Attached to a watched object and released along with it.
+ *
+ * Neither the owner nor the object is retained.
+ */
+@interface NIZeroingWeakSentinel : NSObject {
+@private
+  id<NIZeroingWeakOwner>  _owner;
+  id                      _object;
+}
+
+- (id)initWithOwner:(id<NIZeroingWeakOwner>)owner object:(id)object;
+
+// Called when the owner stops watching the object, so that releasing the sentinel is silent.
+- (void)detach;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIZeroingWeakSentinel
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  // The object's memory is still allocated while its associated objects are released, so the
+  // owner can safely use the pointer to find its entry. It must not message the object.
+  [_owner weakObjectDidDeallocate:_object];
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithOwner:(id<NIZeroingWeakOwner>)owner object:(id)object {
+  if ((self = [super init])) {
+    _owner = owner;
+    _object = object;
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)detach {
+  _owner = nil;
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Attach a sentinel to the object that reports back to the owner.
+ *
+ * The owner is used as the association key so that an object can be in several collections.
+ */
+static void NIWatchObject(id object, id<NIZeroingWeakOwner> owner) {
+  if (!NIIsZeroingWeakReferenceSupported()) {
+    return;
+  }
+
+  NIZeroingWeakSentinel* sentinel = [[NIZeroingWeakSentinel alloc] initWithOwner: owner
+                                                                          object: object];
+  objc_setAssociatedObject(object, owner, sentinel, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+  [sentinel release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIUnwatchObject(id object, id<NIZeroingWeakOwner> owner) {
+  if (!NIIsZeroingWeakReferenceSupported()) {
+    return;
+  }
+
+  NIZeroingWeakSentinel* sentinel = objc_getAssociatedObject(object, owner);
+  [sentinel detach];
+  objc_setAssociatedObject(object, owner, nil, OBJC_ASSOCIATION_ASSIGN);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface NIZeroingWeakArray() <NIZeroingWeakOwner>
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIZeroingWeakArray
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  for (id object in _watchedObjects) {
+    NIUnwatchObject(object, self);
+  }
+  NI_RELEASE_SAFELY(_watchedObjects);
+  free(_objects);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _watchedObjects = [[NIPointerSet alloc] init];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (id)array {
+  return [[[self alloc] init] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Close the gaps left by deallocated objects.
+ *
+ * Only called from methods that mutate the array, which invalidate enumerations anyway.
+ */
+- (void)compactIfNeeded {
+  if (0 == _numberOfDeadObjects) {
+    return;
+  }
+
+  NSUInteger ixLiveSlot = 0;
+  for (NSUInteger ixSlot = 0; ixSlot < _numberOfSlots; ++ixSlot) {
+    if (nil != _objects[ixSlot]) {
+      _objects[ixLiveSlot++] = _objects[ixSlot];
+    }
+  }
+  _numberOfSlots = ixLiveSlot;
+  _numberOfDeadObjects = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)weakObjectDidDeallocate:(id)object {
+  NSInteger numberOfOccurrences = 0;
+  if (![_watchedObjects getValue:&numberOfOccurrences forPointer:object]) {
+    return;
+  }
+  [_watchedObjects removePointer:object];
+
+  // Clearing the slots is not a mutation, so enumerations can carry on past them.
+  for (NSUInteger ixSlot = 0; ixSlot < _numberOfSlots; ++ixSlot) {
+    if (_objects[ixSlot] == object) {
+      _objects[ixSlot] = nil;
+    }
+  }
+  _numberOfDeadObjects += numberOfOccurrences;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)count {
+  return _numberOfSlots - _numberOfDeadObjects;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)containsObject:(id)object {
+  return [_watchedObjects containsPointer:object];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)addObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object) {
+    return;
+  }
+
+  [self compactIfNeeded];
+
+  if (_numberOfSlots == _capacity) {
+    NSUInteger capacity = MAX(kMinimumArrayCapacity, _capacity * 2);
+    id* objects = realloc(_objects, capacity * sizeof(id));
+    if (NULL == objects) {
+      return;
+    }
+    _objects = objects;
+    _capacity = capacity;
+  }
+
+  _objects[_numberOfSlots++] = object;
+  ++_mutations;
+
+  NSInteger numberOfOccurrences = 0;
+  if ([_watchedObjects getValue:&numberOfOccurrences forPointer:object]) {
+    [_watchedObjects addPointer:object withValue:numberOfOccurrences + 1];
+
+  } else {
+    [_watchedObjects addPointer:object withValue:1];
+    NIWatchObject(object, self);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObject:(id)object {
+  if (![_watchedObjects containsPointer:object]) {
+    return;
+  }
+
+  [self compactIfNeeded];
+
+  NSUInteger ixKeptSlot = 0;
+  for (NSUInteger ixSlot = 0; ixSlot < _numberOfSlots; ++ixSlot) {
+    if (_objects[ixSlot] != object) {
+      _objects[ixKeptSlot++] = _objects[ixSlot];
+    }
+  }
+  _numberOfSlots = ixKeptSlot;
+  ++_mutations;
+
+  [_watchedObjects removePointer:object];
+  NIUnwatchObject(object, self);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllObjects {
+  for (id object in _watchedObjects) {
+    NIUnwatchObject(object, self);
+  }
+  [_watchedObjects removeAllPointers];
+
+  _numberOfSlots = 0;
+  _numberOfDeadObjects = 0;
+  ++_mutations;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)allObjects {
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:self.count];
+  for (NSUInteger ixSlot = 0; ixSlot < _numberOfSlots; ++ixSlot) {
+    if (nil != _objects[ixSlot]) {
+      [objects addObject:_objects[ixSlot]];
+    }
+  }
+  return objects;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)countByEnumeratingWithState: (NSFastEnumerationState *)state
+                                  objects: (id *)stackbuf
+                                    count: (NSUInteger)len {
+  if (0 == state->state) {
+    state->state = 1;
+    state->mutationsPtr = &_mutations;
+    state->extra[0] = 0;
+  }
+
+  // Hand out each run of live objects in place, skipping the gaps left by dead ones.
+  NSUInteger ixSlot = state->extra[0];
+  while (ixSlot < _numberOfSlots && nil == _objects[ixSlot]) {
+    ++ixSlot;
+  }
+
+  NSUInteger ixFirstSlot = ixSlot;
+  while (ixSlot < _numberOfSlots && nil != _objects[ixSlot]) {
+    ++ixSlot;
+  }
+
+  state->extra[0] = ixSlot;
+  state->itemsPtr = _objects + ixFirstSlot;
+  return ixSlot - ixFirstSlot;
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface NIZeroingWeakSet() <NIZeroingWeakOwner>
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIZeroingWeakSet
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  for (id object in _objects) {
+    NIUnwatchObject(object, self);
+  }
+  NI_RELEASE_SAFELY(_objects);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _objects = [[NIPointerSet alloc] init];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (id)set {
+  return [[[self alloc] init] autorelease];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)weakObjectDidDeallocate:(id)object {
+  // The pointer set leaves a deleted slot behind that is reclaimed when the set next grows.
+  [_objects removePointer:object];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)count {
+  return _objects.count;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)containsObject:(id)object {
+  return [_objects containsPointer:object];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)addObject:(id)object {
+  NIDASSERT(nil != object);
+  if (nil == object || [_objects containsPointer:object]) {
+    return;
+  }
+
+  [_objects addPointer:object];
+  NIWatchObject(object, self);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeObject:(id)object {
+  if (![_objects containsPointer:object]) {
+    return;
+  }
+
+  [_objects removePointer:object];
+  NIUnwatchObject(object, self);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllObjects {
+  for (id object in _objects) {
+    NIUnwatchObject(object, self);
+  }
+  [_objects removeAllPointers];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)allObjects {
+  NSMutableArray* objects = [NSMutableArray arrayWithCapacity:_objects.count];
+  for (id object in _objects) {
+    [objects addObject:object];
+  }
+  return objects;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)countByEnumeratingWithState: (NSFastEnumerationState *)state
+                                  objects: (id *)stackbuf
+                                    count: (NSUInteger)len {
+  return [_objects countByEnumeratingWithState:state objects:stackbuf count:len];
+}
+
+
+@end
@@ -18,6 +18,8 @@
 
 #import "NimbusCore+Additions.h"
 
+#import "NIHashing.h"
+
 #import <CommonCrypto/CommonDigest.h>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -43,12 +45,7 @@ NI_FIX_CATEGORY_BUG(NSDataNimbusCore)
   unsigned char result[CC_MD5_DIGEST_LENGTH];
   CC_MD5([self bytes], [self length], result);
 
-  return [NSString stringWithFormat:
-          @"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-          result[0], result[1], result[2], result[3], result[4], result[5], result[6], result[7],
-          result[8], result[9], result[10], result[11], result[12], result[13], result[14],
-          result[15]
-          ];
+  return NIHexStringFromBytes(result, CC_MD5_DIGEST_LENGTH);
 }
 
 
@@ -62,15 +59,50 @@ NI_FIX_CATEGORY_BUG(NSDataNimbusCore)
   unsigned char result[CC_SHA1_DIGEST_LENGTH];
   CC_SHA1([self bytes], [self length], result);
 
-  return [NSString stringWithFormat:
-          @"%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-          result[0], result[1], result[2], result[3], result[4], result[5], result[6], result[7],
-          result[8], result[9], result[10], result[11], result[12], result[13], result[14],
-          result[15], result[16], result[17], result[18], result[19]
-          ];
+  return NIHexStringFromBytes(result, CC_SHA1_DIGEST_LENGTH);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Calculate the raw md5 digest using CC_MD5.
+ *
+ * Use this instead of md5Hash when the bytes of the digest are needed rather than its text.
+ *
+ * @returns The 16 bytes of the md5 digest of this data.
+ */
+- (NSData *)md5Digest {
+  unsigned char result[CC_MD5_DIGEST_LENGTH];
+  CC_MD5([self bytes], [self length], result);
+
+  return [NSData dataWithBytes:result length:CC_MD5_DIGEST_LENGTH];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Calculate the raw SHA1 digest using CC_SHA1.
+ *
+ * Use this instead of sha1Hash when the bytes of the digest are needed rather than its text.
+ *
+ * @returns The 20 bytes of the SHA1 digest of this data.
+ */
+- (NSData *)sha1Digest {
+  unsigned char result[CC_SHA1_DIGEST_LENGTH];
+  CC_SHA1([self bytes], [self length], result);
+
+  return [NSData dataWithBytes:result length:CC_SHA1_DIGEST_LENGTH];
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The bytes of this data as a string of lowercase hexadecimal digits.
+ */
+- (NSString *)hexString {
+  return NIHexStringFromBytes([self bytes], [self length]);
+}
+
 @end
 
 /**@}*/
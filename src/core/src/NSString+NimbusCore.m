@@ -18,6 +18,380 @@
 
 #import "NimbusCore+Additions.h"
 
+#import "NIHashing.h"
+#import "NIInMemoryCache.h"
+
+// The maximum number of text measurements kept in the shared measurement cache.
+static const NSUInteger kMaxNumberOfCachedMeasurements = 1024;
+
+// The kinds of measurement stored in the shared measurement cache.
+static NSString* const kSingleLineMeasurement = @"w";
+static NSString* const kConstrainedMeasurement = @"h";
+
+// Queries and query components shorter than this are parsed without allocating a buffer.
+#define NI_QUERY_STACK_BUFFER_LENGTH 256
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The process-wide cache of text measurements.
+ *
+ * Every entry has a cost of one, so the cache holds at most kMaxNumberOfCachedMeasurements
+ * measurements and evicts the least recently used one beyond that. The cache is emptied when
+ * the app receives a memory warning.
+ *
+ * Like the UIKit string drawing methods being cached, this must only be used from the main
+ * thread.
+ */
+static NIMemoryCache* NITextMeasurementCache() {
+  static NIMemoryCache* sMeasurementCache = nil;
+  if (nil == sMeasurementCache) {
+    sMeasurementCache = [[NIMemoryCache alloc]
+                         initWithMaxTotalCost:kMaxNumberOfCachedMeasurements];
+  }
+  return sMeasurementCache;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The key for a measurement of the given text in the shared measurement cache.
+ */
+static NSString* NITextMeasurementKey(NSString* kind, NSString* text, UIFont* font,
+                                      CGFloat width, UILineBreakMode lineBreakMode) {
+  return [NSString stringWithFormat:@"%@|%@|%f|%f|%d|%@",
+          kind, font.fontName, font.pointSize, width, lineBreakMode, text];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static BOOL NIIsUnreservedURLCharacter(unsigned char character) {
+  // RFC 3986 section 2.3.
+  return ((character >= 'a' && character <= 'z')
+          || (character >= 'A' && character <= 'Z')
+          || (character >= '0' && character <= '9')
+          || '-' == character || '.' == character || '_' == character || '~' == character);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static int NIHexDigitValue(UniChar character) {
+  if (character >= '0' && character <= '9') {
+    return character - '0';
+
+  } else if (character >= 'a' && character <= 'f') {
+    return character - 'a' + 10;
+
+  } else if (character >= 'A' && character <= 'F') {
+    return character - 'A' + 10;
+  }
+  return -1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Create a string from a component of a query, replacing its percent escapes.
+ *
+ * Matches stringByReplacingPercentEscapesUsingEncoding:, including returning nil if an escape
+ * is malformed or doesn't decode in the given encoding.
+ *
+ * @returns A string that the caller must release.
+ */
+static NSString* NICreateStringFromQueryComponent(const UniChar* characters, NSUInteger length,
+                                                  NSStringEncoding encoding) {
+  BOOL hasEscapes = NO;
+  BOOL isASCII = YES;
+  for (NSUInteger ix = 0; ix < length; ++ix) {
+    if ('%' == characters[ix]) {
+      hasEscapes = YES;
+
+    } else if (characters[ix] > 0x7F) {
+      isASCII = NO;
+    }
+  }
+
+  if (!hasEscapes) {
+    return [[NSString alloc] initWithCharacters:characters length:length];
+  }
+
+  BOOL isASCIICompatibleEncoding = (NSUTF8StringEncoding == encoding
+                                    || NSASCIIStringEncoding == encoding
+                                    || NSISOLatin1StringEncoding == encoding);
+  if (!isASCII || !isASCIICompatibleEncoding) {
+    // Rare enough to not be worth decoding by hand.
+    NSString* component = [[NSString alloc] initWithCharacters:characters length:length];
+    NSString* decoded = [[component stringByReplacingPercentEscapesUsingEncoding:encoding] retain];
+    [component release];
+    return decoded;
+  }
+
+  // Decoding can only shrink the component.
+  char stackBytes[NI_QUERY_STACK_BUFFER_LENGTH];
+  char* bytes = (length <= sizeof(stackBytes)) ? stackBytes : malloc(length);
+
+  NSUInteger numberOfBytes = 0;
+  BOOL isValid = YES;
+  for (NSUInteger ix = 0; ix < length && isValid; ++ix) {
+    if ('%' == characters[ix]) {
+      int high = (ix + 2 < length) ? NIHexDigitValue(characters[ix + 1]) : -1;
+      int low = (ix + 2 < length) ? NIHexDigitValue(characters[ix + 2]) : -1;
+      isValid = (high >= 0 && low >= 0);
+      bytes[numberOfBytes++] = (char)((high << 4) | low);
+      ix += 2;
+
+    } else {
+      bytes[numberOfBytes++] = (char)characters[ix];
+    }
+  }
+
+  NSString* decoded = nil;
+  if (isValid) {
+    decoded = [[NSString alloc] initWithBytes:bytes length:numberOfBytes encoding:encoding];
+  }
+
+  if (bytes != stackBytes) {
+    free(bytes);
+  }
+
+  return decoded;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Percent-encode the UTF-8 bytes of a query component into the output.
+ *
+ * @param output  The buffer to write to, or NULL to only calculate the length.
+ * @returns The number of characters written, or the most that could be written if output is
+ *          NULL.
+ */
+static NSUInteger NIAppendQueryComponent(NSString* component, UniChar* output) {
+  if (NULL == output) {
+    return [component lengthOfBytesUsingEncoding:NSUTF8StringEncoding] * 3;
+  }
+
+  static const char kHexDigits[] = "0123456789ABCDEF";
+
+  NSUInteger numberOfCharacters = 0;
+  unsigned char bytes[NI_QUERY_STACK_BUFFER_LENGTH];
+  NSRange remainingRange = NSMakeRange(0, [component length]);
+  while (remainingRange.length > 0) {
+    NSUInteger numberOfBytes = 0;
+    if (![component getBytes: bytes
+                   maxLength: sizeof(bytes)
+                  usedLength: &numberOfBytes
+                    encoding: NSUTF8StringEncoding
+                     options: 0
+                       range: remainingRange
+              remainingRange: &remainingRange]) {
+      break;
+    }
+
+    for (NSUInteger ix = 0; ix < numberOfBytes; ++ix) {
+      if (NIIsUnreservedURLCharacter(bytes[ix])) {
+        output[numberOfCharacters++] = bytes[ix];
+
+      } else {
+        output[numberOfCharacters++] = '%';
+        output[numberOfCharacters++] = kHexDigits[bytes[ix] >> 4];
+        output[numberOfCharacters++] = kHexDigits[bytes[ix] & 0x0F];
+      }
+    }
+  }
+
+  return numberOfCharacters;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Write the given query parameters into the output as key=value pairs joined with '&'.
+ *
+ * Values may be strings, NSNull for keys without a value, arrays of either for repeated keys,
+ * or any other object, whose description is used.
+ *
+ * @param output  The buffer to write to, or NULL to only calculate the length.
+ * @returns The number of characters written, or the most that could be written if output is
+ *          NULL.
+ */
+static NSUInteger NIAppendQueryDictionary(NSDictionary* query, UniChar* output) {
+  NSUInteger numberOfCharacters = 0;
+  BOOL isFirstPair = YES;
+
+  for (id key in [query keyEnumerator]) {
+    NSString* keyString = [key isKindOfClass:[NSString class]] ? key : [key description];
+
+    id value = [query objectForKey:key];
+    NSArray* values = [value isKindOfClass:[NSArray class]] ? value : nil;
+    NSUInteger numberOfValues = (nil != values) ? [values count] : 1;
+
+    for (NSUInteger ixValue = 0; ixValue < numberOfValues; ++ixValue) {
+      id pairValue = (nil != values) ? [values objectAtIndex:ixValue] : value;
+
+      if (!isFirstPair) {
+        if (NULL != output) {
+          output[numberOfCharacters] = '&';
+        }
+        ++numberOfCharacters;
+      }
+      isFirstPair = NO;
+
+      numberOfCharacters += NIAppendQueryComponent(keyString,
+                                                   output ? output + numberOfCharacters : NULL);
+
+      if (![pairValue isKindOfClass:[NSNull class]]) {
+        NSString* valueString = ([pairValue isKindOfClass:[NSString class]]
+                                 ? pairValue
+                                 : [pairValue description]);
+        if (NULL != output) {
+          output[numberOfCharacters] = '=';
+        }
+        ++numberOfCharacters;
+        numberOfCharacters += NIAppendQueryComponent(valueString,
+                                                     output ? output + numberOfCharacters : NULL);
+      }
+    }
+  }
+
+  return numberOfCharacters;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Whether the character is in the whitespaceAndNewlineCharacterSet.
+ */
+static BOOL NIIsWhitespaceOrNewline(UniChar character) {
+  if (character < 0x80) {
+    return (' ' == character || (character >= '\t' && character <= '\r'));
+  }
+
+  return CFCharacterSetIsCharacterMember(
+           CFCharacterSetGetPredefined(kCFCharacterSetWhitespaceAndNewline), character);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The pieces of a version string that versionStringCompare: compares.
+ */
+typedef struct {
+  NSUInteger  mainLength;         // The number of characters before the first "a".
+  NSUInteger  numberOfComponents; // One more than the number of "a"s.
+  int         alpha;              // The intValue of the text between the first and second "a".
+  BOOL        isMainASCII;
+} NIVersionStringParts;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Split a version string into the parts that would result from separating it by "a".
+ *
+ * The alpha part is converted the way intValue does: leading whitespace is skipped, an optional
+ * sign and the following digits are read, and the value saturates at INT_MAX or INT_MIN.
+ */
+static NIVersionStringParts NIGetVersionStringParts(NSString* string,
+                                                    CFStringInlineBuffer* buffer) {
+  NIVersionStringParts parts = { 0, 1, 0, YES };
+
+  NSUInteger length = [string length];
+  CFStringInitInlineBuffer((CFStringRef)string, buffer, CFRangeMake(0, length));
+
+  NSUInteger ix = 0;
+  for (; ix < length; ++ix) {
+    UniChar character = CFStringGetCharacterFromInlineBuffer(buffer, ix);
+    if ('a' == character) {
+      break;
+    }
+    if (character >= 0x80) {
+      parts.isMainASCII = NO;
+    }
+  }
+  parts.mainLength = ix;
+
+  BOOL isReadingAlpha = YES;
+  BOOL hasDigits = NO;
+  BOOL isNegative = NO;
+  long long alpha = 0;
+
+  for (; ix < length; ++ix) {
+    UniChar character = CFStringGetCharacterFromInlineBuffer(buffer, ix);
+    if ('a' == character) {
+      // Only the second component, the text after the first "a", is converted.
+      isReadingAlpha = (1 == parts.numberOfComponents);
+      ++parts.numberOfComponents;
+      continue;
+    }
+
+    if (!isReadingAlpha) {
+      continue;
+    }
+
+    if (character >= '0' && character <= '9') {
+      hasDigits = YES;
+      if (alpha <= INT_MAX) {
+        alpha = alpha * 10 + (character - '0');
+      }
+
+    } else if (!hasDigits && ('-' == character || '+' == character)) {
+      isNegative = ('-' == character);
+      hasDigits = YES;  // Nothing other than digits may follow a sign.
+
+    } else if (!hasDigits && NIIsWhitespaceOrNewline(character)) {
+      // Leading whitespace is skipped.
+
+    } else {
+      isReadingAlpha = NO;
+    }
+  }
+
+  if (isNegative) {
+    alpha = -alpha;
+  }
+  parts.alpha = (int)MAX(MIN(alpha, (long long)INT_MAX), (long long)INT_MIN);
+
+  return parts;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Compare the text before the first "a" of each version string.
+ */
+static NSComparisonResult NICompareVersionStringMains(NSString* one,
+                                                      const NIVersionStringParts* oneParts,
+                                                      CFStringInlineBuffer* oneBuffer,
+                                                      NSString* two,
+                                                      const NIVersionStringParts* twoParts,
+                                                      CFStringInlineBuffer* twoBuffer) {
+  if (!oneParts->isMainASCII || !twoParts->isMainASCII) {
+    // Non-ASCII versions need compare:'s handling of composed characters.
+    return [[one substringToIndex:oneParts->mainLength]
+            compare:[two substringToIndex:twoParts->mainLength]];
+  }
+
+  NSUInteger commonLength = MIN(oneParts->mainLength, twoParts->mainLength);
+  for (NSUInteger ix = 0; ix < commonLength; ++ix) {
+    UniChar oneCharacter = CFStringGetCharacterFromInlineBuffer(oneBuffer, ix);
+    UniChar twoCharacter = CFStringGetCharacterFromInlineBuffer(twoBuffer, ix);
+    if (oneCharacter != twoCharacter) {
+      return (oneCharacter < twoCharacter) ? NSOrderedAscending : NSOrderedDescending;
+    }
+  }
+
+  if (oneParts->mainLength == twoParts->mainLength) {
+    return NSOrderedSame;
+  }
+  return (oneParts->mainLength < twoParts->mainLength) ? NSOrderedAscending : NSOrderedDescending;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NSInteger NIVersionStringCompare(id one, id two, void* context) {
+  return [one versionStringCompare:two];
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -34,10 +408,12 @@ NI_FIX_CATEGORY_BUG(NSStringNimbusCore)
  * @brief Determines if the string contains only whitespace and newlines.
  */
 - (BOOL)isWhitespaceAndNewlines {
-  NSCharacterSet* whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
-  for (NSInteger i = 0; i < self.length; ++i) {
-    unichar c = [self characterAtIndex:i];
-    if (![whitespace characterIsMember:c]) {
+  NSUInteger length = [self length];
+  CFStringInlineBuffer buffer;
+  CFStringInitInlineBuffer((CFStringRef)self, &buffer, CFRangeMake(0, length));
+
+  for (NSUInteger ix = 0; ix < length; ++ix) {
+    if (!NIIsWhitespaceOrNewline(CFStringGetCharacterFromInlineBuffer(&buffer, ix))) {
       return NO;
     }
   }
@@ -60,6 +436,62 @@ NI_FIX_CATEGORY_BUG(NSStringNimbusCore)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Calculates the size of a single line of this text, caching the result.
+ *
+ * Returns the same value as sizeWithFont:forWidth:lineBreakMode:. Measurements are stored in
+ * a cache that is shared by every caller in the process and keyed by the text, the font's name
+ * and size, the width, and the line break mode. Repeatedly measuring the same text, as happens
+ * when views are laid out during rotations and scrolling, only measures the text once.
+ *
+ * Must only be called from the main thread.
+ */
+- (CGSize)cachedSizeWithFont: (UIFont*)font
+                    forWidth: (CGFloat)width
+               lineBreakMode: (UILineBreakMode)lineBreakMode {
+  NIMemoryCache* cache = NITextMeasurementCache();
+  NSString* key = NITextMeasurementKey(kSingleLineMeasurement, self, font, width, lineBreakMode);
+
+  NSValue* cachedSize = [cache objectForKey:key];
+  if (nil != cachedSize) {
+    return [cachedSize CGSizeValue];
+  }
+
+  CGSize size = [self sizeWithFont:font forWidth:width lineBreakMode:lineBreakMode];
+  [cache setObject:[NSValue valueWithCGSize:size] forKey:key cost:1];
+  return size;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Calculates the height of this text given the font, max width, and line break mode,
+ *        caching the result.
+ *
+ * Returns the same value as heightWithFont:constrainedToWidth:lineBreakMode:, using the shared
+ * measurement cache described in cachedSizeWithFont:forWidth:lineBreakMode:.
+ *
+ * Must only be called from the main thread.
+ */
+- (CGFloat)cachedHeightWithFont: (UIFont*)font
+             constrainedToWidth: (CGFloat)width
+                  lineBreakMode: (UILineBreakMode)lineBreakMode {
+  NIMemoryCache* cache = NITextMeasurementCache();
+  NSString* key = NITextMeasurementKey(kConstrainedMeasurement, self, font, width,
+                                       lineBreakMode);
+
+  NSNumber* cachedHeight = [cache objectForKey:key];
+  if (nil != cachedHeight) {
+    return [cachedHeight floatValue];
+  }
+
+  CGFloat height = [self heightWithFont:font constrainedToWidth:width lineBreakMode:lineBreakMode];
+  [cache setObject:[NSNumber numberWithFloat:height] forKey:key cost:1];
+  return height;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Parses a URL query string into a dictionary where the values are arrays.
@@ -70,59 +502,121 @@ NI_FIX_CATEGORY_BUG(NSStringNimbusCore)
  * The value for each key will be an NSArray which may be empty if the key is simply present
  * in the query. Otherwise each object in the array with be an NSString corresponding to a value
  * in the query for that parameter.
+ *
+ * Pairs may be separated by '&' or ';'. Pairs with more than one '=', or with percent escapes
+ * that can't be decoded in the given encoding, are skipped.
  */
 - (NSDictionary*)queryContentsUsingEncoding:(NSStringEncoding)encoding {
-  NSCharacterSet* delimiterSet = [NSCharacterSet characterSetWithCharactersInString:@"&;"];
+  NSUInteger length = [self length];
   NSMutableDictionary* pairs = [NSMutableDictionary dictionary];
-  NSScanner* scanner = [[[NSScanner alloc] initWithString:self] autorelease];
-  while (![scanner isAtEnd]) {
-    NSString* pairString = nil;
-    [scanner scanUpToCharactersFromSet:delimiterSet intoString:&pairString];
-    [scanner scanCharactersFromSet:delimiterSet intoString:NULL];
-    NSArray* kvPair = [pairString componentsSeparatedByString:@"="];
-    if (kvPair.count == 1 || kvPair.count == 2) {
-      NSString* key = [[kvPair objectAtIndex:0]
-                       stringByReplacingPercentEscapesUsingEncoding:encoding];
-      NSMutableArray* values = [pairs objectForKey:key];
-      if (nil == values) {
-        values = [NSMutableArray array];
-        [pairs setObject:values forKey:key];
+
+  // Walk the characters directly rather than creating a string for every pair.
+  UniChar stackCharacters[NI_QUERY_STACK_BUFFER_LENGTH];
+  UniChar* ownedCharacters = NULL;
+  const UniChar* characters = CFStringGetCharactersPtr((CFStringRef)self);
+  if (NULL == characters) {
+    if (length <= NI_QUERY_STACK_BUFFER_LENGTH) {
+      characters = stackCharacters;
+
+    } else {
+      ownedCharacters = malloc(sizeof(UniChar) * length);
+      characters = ownedCharacters;
+    }
+    CFStringGetCharacters((CFStringRef)self, CFRangeMake(0, length), (UniChar *)characters);
+  }
+
+  NSCharacterSet* whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+  NSUInteger pairStart = 0;
+  NSUInteger equalsIndex = 0;
+  NSUInteger numberOfEquals = 0;
+
+  // The end of the string is treated as one last delimiter.
+  for (NSUInteger ix = 0; ix <= length; ++ix) {
+    UniChar character = (ix < length) ? characters[ix] : '&';
+
+    if (ix == pairStart && ix < length && [whitespace characterIsMember:character]) {
+      // Whitespace at the start of a pair is skipped, as NSScanner does by default.
+      ++pairStart;
+
+    } else if ('=' == character) {
+      if (0 == numberOfEquals) {
+        equalsIndex = ix;
       }
-      if (kvPair.count == 1) {
-        [values addObject:[NSNull null]];
+      ++numberOfEquals;
+
+    } else if ('&' == character || ';' == character) {
+      // Pairs with more than one '=' are ambiguous and ignored.
+      if (ix > pairStart && numberOfEquals <= 1) {
+        NSUInteger keyEnd = (0 == numberOfEquals) ? ix : equalsIndex;
+        NSString* key = NICreateStringFromQueryComponent(characters + pairStart,
+                                                         keyEnd - pairStart, encoding);
+        id value = nil;
+        if (0 == numberOfEquals) {
+          value = [[NSNull null] retain];
+
+        } else {
+          value = NICreateStringFromQueryComponent(characters + equalsIndex + 1,
+                                                   ix - equalsIndex - 1, encoding);
+        }
+
+        if (nil != key && nil != value) {
+          NSMutableArray* values = [pairs objectForKey:key];
+          if (nil == values) {
+            values = [[NSMutableArray alloc] initWithObjects:value, nil];
+            [pairs setObject:values forKey:key];
+            [values release];
+
+          } else {
+            [values addObject:value];
+          }
+        }
 
-      } else if (kvPair.count == 2) {
-        NSString* value = [[kvPair objectAtIndex:1]
-                           stringByReplacingPercentEscapesUsingEncoding:encoding];
-        [values addObject:value];
+        [key release];
+        [value release];
       }
+
+      pairStart = ix + 1;
+      numberOfEquals = 0;
     }
   }
-  return [NSDictionary dictionaryWithDictionary:pairs];
+
+  if (NULL != ownedCharacters) {
+    free(ownedCharacters);
+  }
+
+  return pairs;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Parses a URL, adds query parameters to its query, and re-encodes it as a new URL.
+ *
+ * Keys and values are percent-encoded as UTF-8, leaving only the unreserved characters of
+ * RFC 3986 as they are. A value may also be an NSNull to add the key without a value, or an
+ * array to add the key once for each of its objects.
  */
 - (NSString*)stringByAddingQueryDictionary:(NSDictionary*)query {
-  NSMutableArray* pairs = [NSMutableArray array];
-  for (NSString* key in [query keyEnumerator]) {
-    NSString* value = [query objectForKey:key];
-    value = [value stringByReplacingOccurrencesOfString:@"?" withString:@"%3F"];
-    value = [value stringByReplacingOccurrencesOfString:@"=" withString:@"%3D"];
-    NSString* pair = [NSString stringWithFormat:@"%@=%@", key, value];
-    [pairs addObject:pair];
+  NSUInteger length = [self length];
+  NSUInteger maxLength = length + 1 + NIAppendQueryDictionary(query, NULL);
+
+  UniChar* characters = malloc(sizeof(UniChar) * maxLength);
+  if (NULL == characters) {
+    return nil;
   }
 
-  NSString* params = [pairs componentsJoinedByString:@"&"];
-  if ([self rangeOfString:@"?"].location == NSNotFound) {
-    return [self stringByAppendingFormat:@"?%@", params];
+  [self getCharacters:characters range:NSMakeRange(0, length)];
+  NSUInteger numberOfCharacters = length;
 
-  } else {
-    return [self stringByAppendingFormat:@"&%@", params];
-  }
+  BOOL hasQuery = ([self rangeOfString:@"?"].location != NSNotFound);
+  characters[numberOfCharacters++] = hasQuery ? '&' : '?';
+
+  numberOfCharacters += NIAppendQueryDictionary(query, characters + numberOfCharacters);
+
+  // The string takes ownership of the buffer rather than copying it.
+  return [[[NSString alloc] initWithCharactersNoCopy: characters
+                                              length: numberOfCharacters
+                                        freeWhenDone: YES] autorelease];
 }
 
 
@@ -164,37 +658,39 @@ NI_FIX_CATEGORY_BUG(NSStringNimbusCore)
  * @endhtmlonly
  */
 - (NSComparisonResult)versionStringCompare:(NSString *)other {
-  NSArray *oneComponents = [self componentsSeparatedByString:@"a"];
-  NSArray *twoComponents = [other componentsSeparatedByString:@"a"];
-
-  // The parts before the "a"
-  NSString *oneMain = [oneComponents objectAtIndex:0];
-  NSString *twoMain = [twoComponents objectAtIndex:0];
+  // The characters are read through inline buffers, so comparing versions never allocates
+  // unless they contain non-ASCII characters.
+  CFStringInlineBuffer oneBuffer;
+  CFStringInlineBuffer twoBuffer;
+  NIVersionStringParts oneParts = NIGetVersionStringParts(self, &oneBuffer);
+  NIVersionStringParts twoParts = NIGetVersionStringParts(other, &twoBuffer);
 
   // If main parts are different, return that result, regardless of alpha part
-  NSComparisonResult mainDiff;
-  if ((mainDiff = [oneMain compare:twoMain]) != NSOrderedSame) {
+  NSComparisonResult mainDiff = NICompareVersionStringMains(self, &oneParts, &oneBuffer,
+                                                            other, &twoParts, &twoBuffer);
+  if (mainDiff != NSOrderedSame) {
     return mainDiff;
   }
 
   // At this point the main parts are the same; just deal with alpha stuff
   // If one has an alpha part and the other doesn't, the one without is newer
-  if ([oneComponents count] < [twoComponents count]) {
+  if (oneParts.numberOfComponents < twoParts.numberOfComponents) {
     return NSOrderedDescending;
 
-  } else if ([oneComponents count] > [twoComponents count]) {
+  } else if (oneParts.numberOfComponents > twoParts.numberOfComponents) {
     return NSOrderedAscending;
 
-  } else if ([oneComponents count] == 1) {
+  } else if (oneParts.numberOfComponents == 1) {
     // Neither has an alpha part, and we know the main parts are the same
     return NSOrderedSame;
   }
 
   // At this point the main parts are the same and both have alpha parts. Compare the alpha parts
   // numerically. If it's not a valid number (including empty string) it's treated as zero.
-  NSNumber *oneAlpha = [NSNumber numberWithInt:[[oneComponents objectAtIndex:1] intValue]];
-  NSNumber *twoAlpha = [NSNumber numberWithInt:[[twoComponents objectAtIndex:1] intValue]];
-  return [oneAlpha compare:twoAlpha];
+  if (oneParts.alpha == twoParts.alpha) {
+    return NSOrderedSame;
+  }
+  return (oneParts.alpha < twoParts.alpha) ? NSOrderedAscending : NSOrderedDescending;
 }
 
 
@@ -205,7 +701,11 @@ NI_FIX_CATEGORY_BUG(NSStringNimbusCore)
  * @returns md5 hash of this string.
  */
 - (NSString*)md5Hash {
-  return [[self dataUsingEncoding:NSUTF8StringEncoding] md5Hash];
+  NIHasher* hasher = [[NIHasher alloc] initWithAlgorithm:NIHashAlgorithmMD5];
+  [hasher updateWithString:self];
+  NSString* hash = [hasher finishHexDigest];
+  [hasher release];
+  return hash;
 }
 
 
@@ -216,7 +716,11 @@ NI_FIX_CATEGORY_BUG(NSStringNimbusCore)
  * @returns SHA1 hash of this string.
  */
 - (NSString*)sha1Hash {
-  return [[self dataUsingEncoding:NSUTF8StringEncoding] sha1Hash];
+  NIHasher* hasher = [[NIHasher alloc] initWithAlgorithm:NIHashAlgorithmSHA1];
+  [hasher updateWithString:self];
+  NSString* hash = [hasher finishHexDigest];
+  [hasher release];
+  return hash;
 }
 
 @end
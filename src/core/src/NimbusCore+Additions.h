@@ -40,6 +40,12 @@
 
 @property (nonatomic, readonly) NSString* sha1Hash;
 
+@property (nonatomic, readonly) NSData* md5Digest;
+
+@property (nonatomic, readonly) NSData* sha1Digest;
+
+@property (nonatomic, readonly) NSString* hexString;
+
 @end
 
 
@@ -60,6 +66,14 @@
        constrainedToWidth: (CGFloat)width
             lineBreakMode: (UILineBreakMode)lineBreakMode;
 
+- (CGSize)cachedSizeWithFont: (UIFont*)font
+                    forWidth: (CGFloat)width
+               lineBreakMode: (UILineBreakMode)lineBreakMode;
+
+- (CGFloat)cachedHeightWithFont: (UIFont*)font
+             constrainedToWidth: (CGFloat)width
+                  lineBreakMode: (UILineBreakMode)lineBreakMode;
+
 
 #pragma mark URL queries
 
@@ -81,4 +95,12 @@
 
 @end
 
+/**
+ * @brief Compares two version strings with versionStringCompare:.
+ *
+ * For sorting large arrays of versions with sortUsingFunction:context: or
+ * sortedArrayUsingFunction:context:. The context is unused.
+ */
+NSInteger NIVersionStringCompare(id one, id two, void* context);
+
 /**@}*/
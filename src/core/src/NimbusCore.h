@@ -128,12 +128,35 @@
  * NID* method's log level. See below for log levels.
  *
  * The default maximum log level is NILOGLEVEL_WARNING.
+ *
+ * <h2>Log Sinks</h2>
+ *
+ * Every log message is handed to the current log sink, which can be replaced with
+ * NISetLogSink. The default sink is an NIBufferedLogSink that writes to the console with NSLog.
+ * Logging a message only formats the text and adds it to a lock-free buffer; the message's
+ * prefix is formatted and written on a background thread. The buffer is flushed before an
+ * assertion breaks in the debugger and, on a best-effort basis, when the app crashes. Call
+ * NIFlushLog to write everything logged so far.
+ *
+ * <h2>Module Log Levels</h2>
+ *
+ * Define NI_LOG_MODULE as a C string before Nimbus is imported, or in a target's
+ * "Preprocessor Macros" build setting, to log everything in those files under a module name.
+ * Each module's maximum log level can then be set with NISetMaxLogLevelForModule. Modules
+ * without a level of their own, and logs without a module, use NIMaxLogLevel.
+ *
+ * @code
+ * // Only log errors from the launcher, no matter how verbose the rest of the app is.
+ * NISetMaxLogLevelForModule(NILOGLEVEL_ERROR, "launcher");
+ * @endcode
  */
 
 #define NILOGLEVEL_INFO     5
 #define NILOGLEVEL_WARNING  3
 #define NILOGLEVEL_ERROR    1
 
+@protocol NILogSink;
+
 /**
  * @brief The maximum log level to output for Nimbus debug logs.
  *
@@ -143,6 +166,60 @@
  */
 extern NSInteger NIMaxLogLevel;
 
+/**
+ * @brief The module that logs in the current file are written under.
+ *
+ * Defaults to NULL, which means that the file's logs don't belong to any module.
+ */
+#ifndef NI_LOG_MODULE
+#define NI_LOG_MODULE NULL
+#endif
+
+/**
+ * @brief Set the maximum log level for the logs of a single module.
+ *
+ * This overrides NIMaxLogLevel for the given module. Up to 32 modules may be given levels.
+ */
+void NISetMaxLogLevelForModule(NSInteger maxLogLevel, const char* module);
+
+/**
+ * @brief The maximum log level for the given module.
+ *
+ * @returns The module's own level if one has been set, NIMaxLogLevel otherwise.
+ */
+NSInteger NIMaxLogLevelForModule(const char* module);
+
+/**
+ * @brief Format a message and hand it to the current log sink.
+ *
+ * This is called by the logging macros and writes the message regardless of log levels.
+ *
+ * @param level     The level of the message, or 0 for messages logged with NIDPRINT.
+ * @param module    The module that the message was logged from. May be NULL.
+ * @param function  The function that the message was logged from. Must be a string that lives
+ *                  for the lifetime of the app, such as __PRETTY_FUNCTION__.
+ */
+void NILogMessage(NSInteger level, const char* module, const char* function, NSInteger line,
+                  NSString* format, ...);
+
+/**
+ * @brief Replace the log sink that every log message is written to.
+ *
+ * The previous sink is flushed before it is released. Pass nil to restore the default sink.
+ * The sink should be set before anything is logged from a background thread.
+ */
+void NISetLogSink(id<NILogSink> sink);
+
+/**
+ * @brief The log sink that log messages are currently written to.
+ */
+id<NILogSink> NICurrentLogSink(void);
+
+/**
+ * @brief Write every message logged so far before returning.
+ */
+void NIFlushLog(void);
+
 /**
  * @brief Only writes to the log when DEBUG is defined.
  *
@@ -150,7 +227,8 @@ extern NSInteger NIMaxLogLevel;
  * of the other logging methods in Nimbus' debugging library.
  */
 #ifdef DEBUG
-#define NIDPRINT(xx, ...)  NSLog(@"%s(%d): " xx, __PRETTY_FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define NIDPRINT(xx, ...)  NILogMessage(0, NI_LOG_MODULE, __PRETTY_FUNCTION__, __LINE__, \
+                                        xx, ##__VA_ARGS__)
 #else
 #define NIDPRINT(xx, ...)  ((void)0)
 #endif // #ifdef DEBUG
@@ -175,7 +253,7 @@ int NIIsInDebugger();
 // We leave the __asm__ in this macro so that when a break occurs, we don't have to step out of
 // a "breakInDebugger" function.
 #define NIDASSERT(xx) { if (!(xx)) { NIDPRINT(@"NIDASSERT failed: %s", #xx); \
-if (NIIsInDebugger()) { __asm__("int $3\n" : : ); }; } \
+NIFlushLog(); if (NIIsInDebugger()) { __asm__("int $3\n" : : ); }; } \
 } ((void)0)
 #else
 #define NIDASSERT(xx) { if (!(xx)) { NIDPRINT(@"NIDASSERT failed: %s", #xx); } } ((void)0)
@@ -192,6 +270,19 @@ if (NIIsInDebugger()) { __asm__("int $3\n" : : ); }; } \
 #define NIDCONDITIONLOG(condition, xx, ...) ((void)0)
 #endif // #ifdef DEBUG
 
+/**
+ * @brief Write to the log with the given level if the current module's level allows it.
+ *
+ * The message's arguments are only evaluated if it is going to be written.
+ */
+#ifdef DEBUG
+#define NIDLEVELLOG(level, xx, ...) { if ((level) <= NIMaxLogLevelForModule(NI_LOG_MODULE)) { \
+NILogMessage((level), NI_LOG_MODULE, __PRETTY_FUNCTION__, __LINE__, xx, ##__VA_ARGS__); } \
+} ((void)0)
+#else
+#define NIDLEVELLOG(level, xx, ...) ((void)0)
+#endif // #ifdef DEBUG
+
 
 #pragma mark Level-Based Loggers
 
@@ -201,20 +292,19 @@ if (NIIsInDebugger()) { __asm__("int $3\n" : : ); }; } \
  */
 
 /**
- * @brief Only writes to the log if NIMaxLogLevel >= NILOGLEVEL_ERROR.
+ * @brief Only writes to the log if the module's maximum log level >= NILOGLEVEL_ERROR.
  */
-#define NIDERROR(xx, ...)  NIDCONDITIONLOG((NILOGLEVEL_ERROR <= NIMaxLogLevel), xx, ##__VA_ARGS__)
+#define NIDERROR(xx, ...)  NIDLEVELLOG(NILOGLEVEL_ERROR, xx, ##__VA_ARGS__)
 
 /**
- * @brief Only writes to the log if NIMaxLogLevel >= NILOGLEVEL_WARNING.
+ * @brief Only writes to the log if the module's maximum log level >= NILOGLEVEL_WARNING.
  */
-#define NIDWARNING(xx, ...)  NIDCONDITIONLOG((NILOGLEVEL_WARNING <= NIMaxLogLevel), \
-                                             xx, ##__VA_ARGS__)
+#define NIDWARNING(xx, ...)  NIDLEVELLOG(NILOGLEVEL_WARNING, xx, ##__VA_ARGS__)
 
 /**
- * @brief Only writes to the log if NIMaxLogLevel >= NILOGLEVEL_INFO.
+ * @brief Only writes to the log if the module's maximum log level >= NILOGLEVEL_INFO.
  */
-#define NIDINFO(xx, ...)  NIDCONDITIONLOG((NILOGLEVEL_INFO <= NIMaxLogLevel), xx, ##__VA_ARGS__)
+#define NIDINFO(xx, ...)  NIDLEVELLOG(NILOGLEVEL_INFO, xx, ##__VA_ARGS__)
 
 /**@}*/// End of Level-Based Loggers
 
@@ -224,6 +314,148 @@ if (NIIsInDebugger()) { __asm__("int $3\n" : : ); }; } \
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+#pragma mark -
+#pragma mark Tracing
+
+/**
+ * @brief For finding out where time goes in any build, including release builds.
+ * @defgroup Tracing Tracing
+ * @{
+ *
+ * Unlike the debugging tools, tracing is compiled into every build and is switched on at
+ * run-time by setting NITracingEnabled. While tracing is disabled each tracing macro costs a
+ * single branch on a global variable and its arguments are not evaluated.
+ *
+ * @code
+ * NI_TRACE_BEGIN("NILauncherView reloadData");
+ * ...
+ * NI_TRACE_END("NILauncherView reloadData");
+ * @endcode
+ *
+ * Records an interval on the current thread. Intervals may be nested.
+ *
+ * @code
+ * NI_TRACE_COUNTER("NILauncherView loaded buttons", numberOfButtons);
+ * @endcode
+ *
+ * Records the current value of a counter.
+ *
+ * @code
+ * NI_TRACE_MARKER("NINetworkImageLoader cache hit", 10);
+ * @endcode
+ *
+ * Records a point in time, sampling only every tenth call from this line of code. Sampling
+ * keeps markers in very hot code from crowding every other event out of the trace.
+ *
+ * Names must be string literals or otherwise live for the lifetime of the app; only the
+ * pointer is stored. Events are recorded into a fixed-size ring buffer with a lock-free
+ * increment, so tracing is safe from any thread and never allocates. Once the buffer is full
+ * the oldest events are overwritten.
+ *
+ * The trace is written with NITraceWriteToFile in the Trace Event Format, which can be opened
+ * in Chrome's about:tracing timeline viewer.
+ */
+
+/**
+ * @brief The types of events recorded in a trace.
+ */
+typedef enum {
+  NITraceEventTypeBegin,
+  NITraceEventTypeEnd,
+  NITraceEventTypeCounter,
+  NITraceEventTypeMarker,
+} NITraceEventType;
+
+/**
+ * @brief An event recorded in a trace.
+ */
+typedef struct {
+  NITraceEventType  type;
+  const char*       name;
+  uint64_t          timestamp;  // In mach_absolute_time units.
+  uint32_t          thread;     // The mach port of the thread that recorded the event.
+  int64_t           value;      // Only used by counters.
+} NITraceEvent;
+
+/**
+ * @brief The maximum number of events kept in the trace buffer.
+ */
+#define NI_TRACE_BUFFER_CAPACITY 16384
+
+/**
+ * @brief Whether or not tracing macros record events.
+ *
+ * This value may be changed at run-time if you so desire.
+ *
+ * The default value is NO.
+ */
+extern BOOL NITracingEnabled;
+
+/**
+ * @brief Record an event in the trace buffer, regardless of NITracingEnabled.
+ *
+ * Use the NI_TRACE macros instead, which skip this call entirely when tracing is disabled.
+ */
+void NITraceRecordEvent(NITraceEventType type, const char* name, int64_t value);
+
+/**
+ * @brief Copy the recorded events, oldest first, into the given buffer.
+ *
+ * @param events     A buffer of at least maxCount events.
+ * @param maxCount   The maximum number of events to copy. The most recent events are copied.
+ * @returns The number of events copied.
+ */
+NSUInteger NITraceCopyEvents(NITraceEvent* events, NSUInteger maxCount);
+
+/**
+ * @brief Discard every recorded event.
+ */
+void NITraceReset(void);
+
+/**
+ * @brief Convert a trace event's timestamp to seconds since the first event in the buffer.
+ */
+NSTimeInterval NITraceTimeIntervalFromTimestamp(uint64_t timestamp, uint64_t startTimestamp);
+
+/**
+ * @brief Write the recorded events to a file in the Trace Event Format.
+ *
+ * @returns YES if the file was written.
+ */
+BOOL NITraceWriteToFile(NSString* path, NSError** error);
+
+/**
+ * @brief Begin an interval on the current thread.
+ */
+#define NI_TRACE_BEGIN(name) { if (NITracingEnabled) { \
+NITraceRecordEvent(NITraceEventTypeBegin, (name), 0); } } ((void)0)
+
+/**
+ * @brief End the most recent interval with the same name on the current thread.
+ */
+#define NI_TRACE_END(name) { if (NITracingEnabled) { \
+NITraceRecordEvent(NITraceEventTypeEnd, (name), 0); } } ((void)0)
+
+/**
+ * @brief Record the value of a counter.
+ */
+#define NI_TRACE_COUNTER(name, value) { if (NITracingEnabled) { \
+NITraceRecordEvent(NITraceEventTypeCounter, (name), (int64_t)(value)); } } ((void)0)
+
+/**
+ * @brief Record a point in time once out of every sampleInterval calls from this line.
+ */
+#define NI_TRACE_MARKER(name, sampleInterval) { if (NITracingEnabled) { \
+static NSUInteger __niTraceMarkerCount = 0; \
+if (0 == (__niTraceMarkerCount++ % (sampleInterval))) { \
+NITraceRecordEvent(NITraceEventTypeMarker, (name), 0); } } } ((void)0)
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**@}*/// End of Tracing //////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
 #pragma mark -
 #pragma mark Non-Retaining Collections
 
@@ -238,6 +470,11 @@ if (NIIsInDebugger()) { __asm__("int $3\n" : : ); }; } \
  * The danger primarily lies in the fact that by all appearances the collection should still
  * operate like a regular collection, so this might lead to a lot of developer error if the
  * developer assumes that the collection does, in fact, retain the object.
+ *
+ * The collections created here keep pointing to objects after they've been deallocated. When
+ * that can happen, use NIZeroingWeakArray or NIZeroingWeakSet from NIZeroingWeakCollections.h
+ * instead, which drop their objects as they are deallocated. For hot registries keyed by object
+ * identity, NIPointerSet from NIPointerSet.h avoids the per-operation CF callbacks altogether.
  */
 
 /**
@@ -422,6 +659,20 @@ UIInterfaceOrientation NIInterfaceOrientation();
  * @brief For creating standard system paths.
  * @defgroup Paths Paths
  * @{
+ *
+ * The documents and caches directories are looked up once, so every method here is safe to
+ * call from any thread.
+ *
+ * When building many paths, such as when looking up thousands of cache files, the C string
+ * variants write the path into a buffer without creating any objects at all.
+ *
+ * @code
+ * char path[PATH_MAX];
+ * if (NIGetPathForCachesResource(path, sizeof(path), "images/3d2a0c.png")) {
+ *   int fileDescriptor = open(path, O_RDONLY);
+ *   ...
+ * }
+ * @endcode
  */
 
 /**
@@ -441,6 +692,53 @@ NSString* NIPathForBundleResource(NSBundle* bundle, NSString* relativePath);
  */
 NSString* NIPathForDocumentsResource(NSString* relativePath);
 
+/**
+ * @brief Create a path with the caches directory and the relative path appended.
+ *
+ * Unlike the documents directory, the caches directory is not backed up and may be purged by
+ * the system, so it is the place for data that can be downloaded again.
+ *
+ * @returns The caches path concatenated with the given relative path.
+ */
+NSString* NIPathForCachesResource(NSString* relativePath);
+
+/**
+ * @brief Write the path of a resource in the documents directory into a buffer.
+ *
+ * @param buffer        Receives the path as a NUL-terminated C string in the file system's
+ *                      representation. PATH_MAX bytes is always enough.
+ * @param bufferSize    The size of the buffer in bytes.
+ * @param relativePath  The path to append, in the file system's representation. May be NULL.
+ *
+ * @returns NO if the path does not fit in the buffer.
+ */
+BOOL NIGetPathForDocumentsResource(char* buffer, size_t bufferSize, const char* relativePath);
+
+/**
+ * @brief Write the path of a resource in the caches directory into a buffer.
+ *
+ * @see NIGetPathForDocumentsResource
+ *
+ * @returns NO if the path does not fit in the buffer.
+ */
+BOOL NIGetPathForCachesResource(char* buffer, size_t bufferSize, const char* relativePath);
+
+/**
+ * @brief Create a file URL with the documents directory and the relative path appended.
+ *
+ * The URL is created directly from the path's bytes without creating a path string first.
+ *
+ * @returns The file URL, or nil if the path is longer than PATH_MAX.
+ */
+NSURL* NIURLForDocumentsResource(NSString* relativePath);
+
+/**
+ * @brief Create a file URL with the caches directory and the relative path appended.
+ *
+ * @returns The file URL, or nil if the path is longer than PATH_MAX.
+ */
+NSURL* NIURLForCachesResource(NSString* relativePath);
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /**@}*/// End of Paths ////////////////////////////////////////////////////////////////////////////
@@ -555,6 +853,8 @@ NSString* NIPathForDocumentsResource(NSString* relativePath);
 /**
  * @brief Checks whether the device the app is currently running on is an iPad or not.
  *
+ * The result is determined once and is safe to fetch from any thread.
+ *
  * @returns YES if the device is an iPad.
  */
 BOOL NIIsPad();
@@ -574,7 +874,8 @@ BOOL NIDeviceOSVersionIsAtLeast(double versionNumber);
 /**
  * @brief Safely fetch the UIPopoverController class if it is available.
  *
- * The class is cached to avoid repeated lookups.
+ * The class is cached to avoid repeated lookups. It is looked up once, so this is safe to call
+ * from any thread.
  *
  * Uses NSClassFromString to fetch the popover controller class.
  *
@@ -590,4 +891,58 @@ Class NIUIPopoverControllerClass();
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+#pragma mark -
+#pragma mark Images
+
+/**
+ * @brief For loading images that are ready to be displayed.
+ * @defgroup Images Images
+ * @{
+ *
+ * UIImage defers decompressing an image until it is first drawn, which happens on the main
+ * thread. Decompressing a number of images at once, such as when a page of icons is first shown,
+ * can cause the UI to stutter.
+ *
+ * The following methods decompress the image into a bitmap up front. They are safe to call
+ * from any thread, so the cost can be moved off of the main thread entirely.
+ */
+
+/**
+ * @brief Create a copy of the given image that has been decompressed into a bitmap.
+ *
+ * @returns The decompressed image, or nil if the image could not be decoded.
+ */
+UIImage* NIDecodedImage(UIImage* image);
+
+/**
+ * @brief Create a decompressed image from PNG or JPEG data.
+ *
+ * When called on the main thread, other image formats are read with UIImage and then
+ * decompressed. UIImage is not safe to use from other threads before iOS 4, so on other
+ * threads only PNG and JPEG data can be decoded.
+ *
+ * @param data   The encoded image data.
+ * @param scale  The scale of the resulting image. Ignored on versions of iOS that don't
+ *               support image scales.
+ *
+ * @returns The decompressed image, or nil if the data could not be decoded.
+ */
+UIImage* NIDecodedImageWithData(NSData* data, CGFloat scale);
+
+/**
+ * @brief Create a decompressed image from the contents of the file at the given path.
+ *
+ * Files whose names end in @2x are given a scale of 2. On high resolution screens the @2x
+ * version of the file is used if there is one, as with UIImage's imageWithContentsOfFile:.
+ *
+ * @returns The decompressed image, or nil if the file could not be read or decoded.
+ */
+UIImage* NIDecodedImageWithContentsOfFile(NSString* path);
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**@}*/// End of Images ///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
 /**@}*/
@@ -95,6 +95,15 @@
 
   STAssertTrue(![@"a" isWhitespaceAndNewlines], @"Text should not be whitespace.");
   STAssertTrue(![@" \r\n\ta\r\n " isWhitespaceAndNewlines], @"Text should not be whitespace.");
+
+  // Long enough to be read through more than one fill of the inline buffer.
+  NSMutableString* longWhitespace = [NSMutableString string];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    [longWhitespace appendFormat:@" \t%C", (unichar)0x3000];
+  }
+  STAssertTrue([longWhitespace isWhitespaceAndNewlines], @"Long whitespace should be whitespace.");
+  [longWhitespace appendString:@"a"];
+  STAssertTrue(![longWhitespace isWhitespaceAndNewlines], @"Trailing text should be found.");
 }
 
 
@@ -170,6 +179,15 @@
 	STAssertTrue([[query objectForKey:@"q"] isEqual:qArr], @"Query: %@", query);
 	STAssertTrue([[query objectForKey:@"hl"] isEqual:[NSArray arrayWithObject:@"en"]],
                @"Query: %@", query);
+
+	query = [@" q=three20& hl=en&\n g& " queryContentsUsingEncoding:NSUTF8StringEncoding];
+	STAssertTrue([query count] == 3, @"Query: %@", query);
+	STAssertTrue([[query objectForKey:@"q"] isEqual:[NSArray arrayWithObject:@"three20"]],
+               @"Query: %@", query);
+	STAssertTrue([[query objectForKey:@"hl"] isEqual:[NSArray arrayWithObject:@"en"]],
+               @"Query: %@", query);
+	STAssertTrue([[query objectForKey:@"g"] isEqual:[NSArray arrayWithObject:[NSNull null]]],
+               @"Query: %@", query);
 }
 
 
@@ -202,6 +220,69 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testNSString_stringByAddingQueryDictionaryEncoding {
+  NSString* baseUrl = @"http://google.com/search";
+
+  NSDictionary* query = [NSDictionary dictionaryWithObject:@"a b&c=d?é~" forKey:@"q"];
+  STAssertEqualObjects([baseUrl stringByAddingQueryDictionary:query],
+                       @"http://google.com/search?q=a%20b%26c%3Dd%3F%C3%A9~",
+                       @"Reserved and non-ASCII characters should be percent-encoded.");
+
+  STAssertEqualObjects([@"http://google.com/search?hl=en" stringByAddingQueryDictionary:query],
+                       @"http://google.com/search?hl=en&q=a%20b%26c%3Dd%3F%C3%A9~",
+                       @"Parameters should be added to an existing query.");
+
+  query = [NSDictionary dictionaryWithObject:[NSArray arrayWithObjects:
+                                              @"1", [NSNull null], [NSNumber numberWithInt:3], nil]
+                                      forKey:@"n"];
+  STAssertEqualObjects([baseUrl stringByAddingQueryDictionary:query],
+                       @"http://google.com/search?n=1&n&n=3",
+                       @"Arrays should repeat the key and NSNull should leave out the value.");
+
+  // Building and parsing should round-trip.
+  query = [NSDictionary dictionaryWithObject:@"three20 & nimbus" forKey:@"q"];
+  NSString* url = [baseUrl stringByAddingQueryDictionary:query];
+  NSString* queryString = [url substringFromIndex:[url rangeOfString:@"?"].location + 1];
+  STAssertEqualObjects([[queryString queryContentsUsingEncoding:NSUTF8StringEncoding]
+                        objectForKey:@"q"],
+                       [NSArray arrayWithObject:@"three20 & nimbus"],
+                       @"The value should survive a round trip.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testNSString_queryContentsUsingEncodingEscapes {
+  NSDictionary* query = [@"q=caf%C3%A9;hl=en%2Dus&%71=x" queryContentsUsingEncoding:
+                         NSUTF8StringEncoding];
+  STAssertEqualObjects([query objectForKey:@"q"], ([NSArray arrayWithObjects:@"café", @"x", nil]),
+                       @"Escaped keys and values should be decoded.");
+  STAssertEqualObjects([query objectForKey:@"hl"], [NSArray arrayWithObject:@"en-us"],
+                       @"';' should separate pairs.");
+
+  query = [@"q=100%&hl=en" queryContentsUsingEncoding:NSUTF8StringEncoding];
+  STAssertNil([query objectForKey:@"q"], @"Malformed escapes should be skipped. %@", query);
+  STAssertEqualObjects([query objectForKey:@"hl"], [NSArray arrayWithObject:@"en"],
+                       @"Pairs after a malformed escape should still be parsed.");
+
+  query = [@"q=日本%20語" queryContentsUsingEncoding:NSUTF8StringEncoding];
+  STAssertEqualObjects([query objectForKey:@"q"], [NSArray arrayWithObject:@"日本 語"],
+                       @"Unescaped non-ASCII characters should be kept.");
+
+  // Long enough to not fit in the parser's stack buffers.
+  NSMutableString* longValue = [NSMutableString string];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    [longValue appendString:@"%41bc"];
+  }
+  query = [[NSString stringWithFormat:@"hl=en&q=%@", longValue]
+           queryContentsUsingEncoding:NSUTF8StringEncoding];
+  STAssertEquals([[[query objectForKey:@"q"] lastObject] length], (NSUInteger)300,
+                 @"Long values should be decoded.");
+  STAssertTrue([[[query objectForKey:@"q"] lastObject] hasPrefix:@"AbcAbc"],
+               @"Long values should be decoded.");
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)testNSString_versionStringCompare {
   STAssertTrue([@"3.0"   versionStringCompare:@"3.0"]    == NSOrderedSame, @"same version");
@@ -214,6 +295,66 @@
   STAssertTrue([@"3.0a"  versionStringCompare:@"3.0a1"]  == NSOrderedAscending, @"empty alpha");
   STAssertTrue([@"3.02"  versionStringCompare:@"3.03"]   == NSOrderedAscending, @"point diff");
   STAssertTrue([@"3.0.2" versionStringCompare:@"3.0.3"]  == NSOrderedAscending, @"point diff");
+
+  // The alpha parts are compared the way intValue reads them.
+  STAssertTrue([@"3.0a 7" versionStringCompare:@"3.0a7"] == NSOrderedSame, @"alpha whitespace");
+  STAssertTrue([@"3.0a-1" versionStringCompare:@"3.0a"]  == NSOrderedAscending, @"negative alpha");
+  STAssertTrue([@"3.0a2b" versionStringCompare:@"3.0a2"] == NSOrderedSame, @"alpha suffix");
+  STAssertTrue([@"3.0a1a9" versionStringCompare:@"3.0a1"] == NSOrderedAscending,
+               @"more alpha parts");
+  STAssertTrue([@"3.0a99999999999" versionStringCompare:@"3.0a2147483647"] == NSOrderedSame,
+               @"saturated alpha");
+  STAssertTrue([@"3.0" versionStringCompare:@"3.0.1"] == NSOrderedAscending, @"shorter main");
+  STAssertTrue([@"3.é" versionStringCompare:@"3.é"] == NSOrderedSame, @"non-ASCII main");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testVersionStringCompareFunction {
+  NSArray* versions = [NSArray arrayWithObjects:
+                       @"3.1", @"3.0a19", @"2.5", @"3.0", @"3.0a2", @"3.0a", nil];
+  NSArray* sorted = [versions sortedArrayUsingFunction:NIVersionStringCompare context:NULL];
+  NSArray* expected = [NSArray arrayWithObjects:
+                       @"2.5", @"3.0a", @"3.0a2", @"3.0a19", @"3.0", @"3.1", nil];
+  STAssertEqualObjects(sorted, expected, @"Versions should be sorted oldest first.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testNSString_cachedSizeWithFont {
+  UIFont* font = [UIFont systemFontOfSize:12];
+  NSString* text = @"Nimbus launcher button";
+
+  CGSize size = [text sizeWithFont:font forWidth:60 lineBreakMode:UILineBreakModeTailTruncation];
+  for (NSInteger ix = 0; ix < 2; ++ix) {
+    // The second pass reads from the cache.
+    CGSize cachedSize = [text cachedSizeWithFont: font
+                                        forWidth: 60
+                                   lineBreakMode: UILineBreakModeTailTruncation];
+    STAssertTrue(CGSizeEqualToSize(size, cachedSize), @"Cached sizes should match.");
+  }
+
+  CGSize widerSize = [text cachedSizeWithFont: font
+                                     forWidth: 500
+                                lineBreakMode: UILineBreakModeTailTruncation];
+  STAssertTrue(widerSize.width > size.width, @"Each width should be measured separately.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testNSString_cachedHeightWithFont {
+  UIFont* font = [UIFont systemFontOfSize:12];
+  NSString* text = @"A long string of text that will need to wrap onto several lines.";
+
+  CGFloat height = [text heightWithFont: font
+                     constrainedToWidth: 50
+                          lineBreakMode: UILineBreakModeWordWrap];
+  for (NSInteger ix = 0; ix < 2; ++ix) {
+    CGFloat cachedHeight = [text cachedHeightWithFont: font
+                                   constrainedToWidth: 50
+                                        lineBreakMode: UILineBreakModeWordWrap];
+    STAssertEquals(height, cachedHeight, @"Cached heights should match.");
+  }
 }
 
 
@@ -41,6 +41,104 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Tracing
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testTracingDisabled {
+  NITraceReset();
+  NITracingEnabled = NO;
+
+  NSInteger numberOfEvaluations = 0;
+  NI_TRACE_BEGIN("disabled");
+  NI_TRACE_COUNTER("disabled", ++numberOfEvaluations);
+  NI_TRACE_END("disabled");
+
+  NITraceEvent event;
+  STAssertEquals(NITraceCopyEvents(&event, 1), (NSUInteger)0,
+                 @"Nothing should be recorded while tracing is disabled.");
+  STAssertEquals(numberOfEvaluations, (NSInteger)0,
+                 @"Arguments should not be evaluated while tracing is disabled.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testTracingEvents {
+  NITraceReset();
+  NITracingEnabled = YES;
+
+  NI_TRACE_BEGIN("interval");
+  NI_TRACE_COUNTER("counter", 42);
+  NI_TRACE_END("interval");
+  for (NSInteger ix = 0; ix < 10; ++ix) {
+    NI_TRACE_MARKER("marker", 5);
+  }
+
+  NITracingEnabled = NO;
+
+  NITraceEvent events[8];
+  NSUInteger count = NITraceCopyEvents(events, 8);
+  STAssertEquals(count, (NSUInteger)5, @"Every fifth marker should have been sampled.");
+  STAssertEquals(events[0].type, NITraceEventTypeBegin, @"Events should be copied in order.");
+  STAssertEquals(events[1].type, NITraceEventTypeCounter, @"Events should be copied in order.");
+  STAssertEquals(events[1].value, (int64_t)42, @"The counter's value should be recorded.");
+  STAssertEquals(events[2].type, NITraceEventTypeEnd, @"Events should be copied in order.");
+  STAssertEquals(events[3].type, NITraceEventTypeMarker, @"Events should be copied in order.");
+  STAssertTrue(0 == strcmp(events[0].name, "interval"), @"The name should be recorded.");
+  STAssertTrue(events[2].timestamp >= events[0].timestamp, @"Timestamps should increase.");
+
+  STAssertEquals(NITraceCopyEvents(events, 2), (NSUInteger)2,
+                 @"No more than the requested number of events should be copied.");
+  STAssertEquals(events[0].type, NITraceEventTypeMarker,
+                 @"The most recent events should be copied when asked for fewer.");
+
+  NITraceReset();
+  STAssertEquals(NITraceCopyEvents(events, 8), (NSUInteger)0, @"Reset should discard events.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testTracingRingBuffer {
+  NITraceReset();
+  for (NSInteger ix = 0; ix < NI_TRACE_BUFFER_CAPACITY + 10; ++ix) {
+    NITraceRecordEvent(NITraceEventTypeCounter, "counter", ix);
+  }
+
+  NITraceEvent event;
+  STAssertEquals(NITraceCopyEvents(&event, 1), (NSUInteger)1, @"One event should be copied.");
+  STAssertEquals(event.value, (int64_t)(NI_TRACE_BUFFER_CAPACITY + 9),
+                 @"The newest event should survive the buffer wrapping around.");
+
+  NITraceReset();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testTraceWriteToFile {
+  NITraceReset();
+  NITraceRecordEvent(NITraceEventTypeBegin, "\"quoted\"", 0);
+  NITraceRecordEvent(NITraceEventTypeEnd, "\"quoted\"", 0);
+
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NICoreTests.trace"];
+  STAssertTrue(NITraceWriteToFile(path, nil), @"The trace should have been written.");
+
+  NSString* trace = [NSString stringWithContentsOfFile: path
+                                              encoding: NSUTF8StringEncoding
+                                                 error: nil];
+  STAssertTrue([trace hasPrefix:@"{\"traceEvents\":["], @"The trace should be a trace object.");
+  STAssertTrue([trace rangeOfString:@"\"name\":\"\\\"quoted\\\"\""].length > 0,
+               @"Names should be escaped.");
+  STAssertTrue([trace rangeOfString:@"\"ph\":\"E\""].length > 0,
+               @"End events should be written.");
+
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+  NITraceReset();
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -191,4 +289,122 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Paths
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testPathBuffers {
+  char path[PATH_MAX];
+
+  STAssertTrue(NIGetPathForCachesResource(path, sizeof(path), "images/file.png"),
+               @"The path should fit.");
+  STAssertEqualObjects([NSString stringWithUTF8String:path],
+                       NIPathForCachesResource(@"images/file.png"),
+                       @"The C string path should match the NSString path.");
+
+  STAssertTrue(NIGetPathForDocumentsResource(path, sizeof(path), "/file.png"),
+               @"The path should fit.");
+  STAssertEqualObjects([NSString stringWithUTF8String:path],
+                       NIPathForDocumentsResource(@"file.png"),
+                       @"Leading slashes should not be doubled.");
+
+  STAssertTrue(NIGetPathForDocumentsResource(path, sizeof(path), NULL), @"The path should fit.");
+  STAssertEqualObjects([NSString stringWithUTF8String:path], NIPathForDocumentsResource(@""),
+                       @"No relative path should be the directory itself.");
+
+  STAssertFalse(NIGetPathForCachesResource(path, 4, "file.png"),
+                @"A buffer that is too small should be rejected.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testPathURLs {
+  NSURL* url = NIURLForCachesResource(@"images/file.png");
+  STAssertTrue([url isFileURL], @"The URL should be a file URL.");
+  STAssertEqualObjects([url path], NIPathForCachesResource(@"images/file.png"),
+                       @"The URL should point to the resource.");
+
+  url = NIURLForDocumentsResource(nil);
+  STAssertEqualObjects([url path], NIPathForDocumentsResource(@""),
+                       @"No relative path should be the directory itself.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Images
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSData *)pngDataWithSize:(CGSize)size {
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(NULL, size.width, size.height, 8, 0, colorSpace,
+                                               kCGImageAlphaPremultipliedLast);
+  CGColorSpaceRelease(colorSpace);
+  CGContextSetRGBFillColor(context, 1, 0, 0, 1);
+  CGContextFillRect(context, CGRectMake(0, 0, size.width, size.height));
+  CGImageRef imageRef = CGBitmapContextCreateImage(context);
+  CGContextRelease(context);
+
+  UIImage* image = [UIImage imageWithCGImage:imageRef];
+  CGImageRelease(imageRef);
+
+  return UIImagePNGRepresentation(image);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testDecodedImageWithData {
+  NSData* data = [self pngDataWithSize:CGSizeMake(16, 8)];
+
+  UIImage* image = NIDecodedImageWithData(data, 1);
+  STAssertNotNil(image, @"The PNG should have been decoded.");
+  STAssertEquals(image.size, CGSizeMake(16, 8), @"The decoded image should keep its size.");
+  STAssertEquals(CGImageGetWidth(image.CGImage), (size_t)16,
+                 @"The decoded image should be backed by a bitmap of the same width.");
+
+  UIImage* jpegImage = NIDecodedImageWithData(UIImageJPEGRepresentation(image, 1), 1);
+  STAssertNotNil(jpegImage, @"The JPEG should have been decoded.");
+  STAssertEquals(jpegImage.size, CGSizeMake(16, 8), @"The decoded JPEG should keep its size.");
+
+  STAssertNil(NIDecodedImageWithData(nil, 1), @"nil data should not produce an image.");
+  STAssertNil(NIDecodedImageWithData([@"not an image" dataUsingEncoding:NSUTF8StringEncoding], 1),
+              @"Invalid data should not produce an image.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testDecodedImageWithContentsOfFile {
+  NSData* data = [self pngDataWithSize:CGSizeMake(16, 8)];
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NICoreTests@2x.png"];
+  [data writeToFile:path atomically:YES];
+
+  UIImage* image = NIDecodedImageWithContentsOfFile(path);
+  STAssertNotNil(image, @"The image file should have been decoded.");
+  if ([image respondsToSelector:@selector(scale)]) {
+    STAssertEquals(image.scale, (CGFloat)2, @"@2x files should be given a scale of 2.");
+    STAssertEquals(image.size, CGSizeMake(8, 4), @"The size should account for the scale.");
+  }
+
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+  STAssertNil(NIDecodedImageWithContentsOfFile(path), @"Missing files should return nil.");
+  STAssertNil(NIDecodedImageWithContentsOfFile(nil), @"A nil path should return nil.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testDecodedImage {
+  UIImage* image = [UIImage imageWithData:[self pngDataWithSize:CGSizeMake(4, 4)]];
+  UIImage* decodedImage = NIDecodedImage(image);
+  STAssertNotNil(decodedImage, @"The image should have been decoded.");
+  STAssertEquals(decodedImage.size, image.size, @"The decoded image should keep its size.");
+  STAssertNil(NIDecodedImage(nil), @"A nil image should return nil.");
+}
+
+
 @end
@@ -0,0 +1,145 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "NimbusCore/NIHashing.h"
+#import "NimbusCore/NimbusCore+Additions.h"
+
+@interface NIHashingTests : SenTestCase {
+}
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIHashingTests
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testHexStringFromBytes {
+  const unsigned char bytes[] = { 0x00, 0x0f, 0x10, 0xab, 0xff };
+  STAssertEqualObjects(NIHexStringFromBytes(bytes, sizeof(bytes)), @"000f10abff",
+                       @"Each byte should become two lowercase digits.");
+  STAssertEqualObjects(NIHexStringFromBytes(bytes, 0), @"", @"No bytes should be empty.");
+
+  NSData* data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+  STAssertEqualObjects([data hexString], @"000f10abff", @"The data should be hex encoded.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testIncrementalHashing {
+  NIHasher* hasher = [NIHasher hasherWithAlgorithm:NIHashAlgorithmMD5];
+  [hasher updateWithBytes:"nim" length:3];
+  [hasher updateWithData:[NSData dataWithBytes:"bus" length:3]];
+  STAssertEqualObjects([hasher finishHexDigest], @"0e78d66f33c484a3c3b36d69bd3114cf",
+                       @"Hashing in pieces should match hashing all at once.");
+
+  hasher = [NIHasher hasherWithAlgorithm:NIHashAlgorithmSHA1];
+  [hasher updateWithString:@"nimbus"];
+  STAssertEqualObjects([hasher finishHexDigest], @"c1b42d95fd18ad8a56d4fd7bbb4105952620d857",
+                       @"SHA1 hashes don't match.");
+
+  hasher = [NIHasher hasherWithAlgorithm:NIHashAlgorithmSHA256];
+  [hasher updateWithString:@"abc"];
+  STAssertEqualObjects([hasher finishHexDigest],
+                       @"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+                       @"SHA256 hashes don't match.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testStringHashing {
+  // Long enough, and with enough multi-byte characters, to need several passes through the
+  // hasher's encoding buffer.
+  NSMutableString* string = [NSMutableString string];
+  for (NSInteger ix = 0; ix < 500; ++ix) {
+    [string appendFormat:@"%d café 日本 ", ix];
+  }
+
+  NSData* data = [string dataUsingEncoding:NSUTF8StringEncoding];
+  STAssertEqualObjects([string md5Hash], [data md5Hash],
+                       @"The string should hash its UTF-8 encoding.");
+  STAssertEqualObjects([string sha1Hash], [data sha1Hash],
+                       @"The string should hash its UTF-8 encoding.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testRawDigests {
+  NSData* data = [NSData dataWithBytes:"nimbus" length:6];
+
+  STAssertEquals([[data md5Digest] length], (NSUInteger)CC_MD5_DIGEST_LENGTH,
+                 @"The MD5 digest should be raw bytes.");
+  STAssertEqualObjects([[data md5Digest] hexString], [data md5Hash],
+                       @"The raw and hex MD5 digests should match.");
+  STAssertEqualObjects([[data sha1Digest] hexString], [data sha1Hash],
+                       @"The raw and hex SHA1 digests should match.");
+
+  unsigned char digest[NI_MAX_DIGEST_LENGTH];
+  NIHasher* hasher = [NIHasher hasherWithAlgorithm:NIHashAlgorithmMD5];
+  [hasher updateWithData:data];
+  [hasher finishWithDigest:digest];
+  STAssertEqualObjects(NIHexStringFromBytes(digest, hasher.digestLength), [data md5Hash],
+                       @"The digest should be written into the buffer.");
+
+  STAssertEqualObjects([hasher finishDigest], [data md5Digest],
+                       @"Finishing again should return the same digest.");
+  STAssertEqualObjects([hasher finishHexDigest], [data md5Hash],
+                       @"Finishing again should return the same digest.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testHashingFiles {
+  NSMutableData* data = [NSMutableData dataWithLength:200 * 1024];
+  unsigned char* bytes = [data mutableBytes];
+  for (NSUInteger ix = 0; ix < [data length]; ++ix) {
+    bytes[ix] = (unsigned char)(ix * 31);
+  }
+
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"NIHashingTests.bin"];
+  STAssertTrue([data writeToFile:path atomically:YES], @"The test file should be written.");
+
+  NSError* error = nil;
+  STAssertEqualObjects([NIHasher hexDigestOfFileAtPath: path
+                                             algorithm: NIHashAlgorithmSHA1
+                                                 error: &error],
+                       [data sha1Hash],
+                       @"Hashing the file should match hashing its contents.");
+  STAssertEqualObjects([NIHasher digestOfFileAtPath: path
+                                          algorithm: NIHashAlgorithmMD5
+                                              error: &error],
+                       [data md5Digest],
+                       @"Hashing the file should match hashing its contents.");
+  STAssertNil(error, @"There should be no error.");
+
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+  STAssertNil([NIHasher digestOfFileAtPath: path
+                                 algorithm: NIHashAlgorithmMD5
+                                     error: &error],
+              @"A missing file should have no digest.");
+  STAssertEquals([error code], (NSInteger)ENOENT, @"The error should say the file is missing.");
+}
+
+
+@end
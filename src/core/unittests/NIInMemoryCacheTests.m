@@ -0,0 +1,141 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "NimbusCore/NIInMemoryCache.h"
+
+@interface NIInMemoryCacheTests : SenTestCase {
+}
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIInMemoryCacheTests
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testStoringAndRemovingObjects {
+  NIMemoryCache* cache = [[[NIMemoryCache alloc] init] autorelease];
+
+  [cache setObject:@"one" forKey:@"1" cost:10];
+  [cache setObject:@"two" forKey:@"2" cost:20];
+  STAssertEquals(cache.count, (NSUInteger)2, @"Both objects should be stored.");
+  STAssertEquals(cache.totalCost, (NSUInteger)30, @"The costs should be summed.");
+  STAssertEqualObjects([cache objectForKey:@"1"], @"one", @"The stored object should be found.");
+
+  [cache setObject:@"uno" forKey:@"1" cost:5];
+  STAssertEqualObjects([cache objectForKey:@"1"], @"uno", @"The object should be replaced.");
+  STAssertEquals(cache.totalCost, (NSUInteger)25, @"The replaced object's cost should be dropped.");
+
+  [cache removeObjectForKey:@"2"];
+  STAssertNil([cache objectForKey:@"2"], @"The object should have been removed.");
+  STAssertEquals(cache.totalCost, (NSUInteger)5, @"The removed object's cost should be dropped.");
+
+  [cache removeAllObjects];
+  STAssertEquals(cache.count, (NSUInteger)0, @"The cache should be empty.");
+  STAssertEquals(cache.totalCost, (NSUInteger)0, @"An empty cache should have no cost.");
+  STAssertEquals(cache.numberOfEvictions, (NSUInteger)0,
+                 @"Explicit removals should not count as evictions.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testLeastRecentlyUsedEviction {
+  NIMemoryCache* cache = [[[NIMemoryCache alloc] initWithMaxTotalCost:30] autorelease];
+
+  [cache setObject:@"one" forKey:@"1" cost:10];
+  [cache setObject:@"two" forKey:@"2" cost:10];
+  [cache setObject:@"three" forKey:@"3" cost:10];
+
+  // Touch the oldest object so that "2" becomes the least recently used.
+  STAssertNotNil([cache objectForKey:@"1"], @"The object should still be cached.");
+
+  [cache setObject:@"four" forKey:@"4" cost:10];
+  STAssertNil([cache objectForKey:@"2"], @"The least recently used object should be evicted.");
+  STAssertNotNil([cache objectForKey:@"1"], @"Recently used objects should be kept.");
+  STAssertNotNil([cache objectForKey:@"3"], @"Recently used objects should be kept.");
+  STAssertNotNil([cache objectForKey:@"4"], @"The new object should be kept.");
+  STAssertEquals(cache.numberOfEvictions, (NSUInteger)1, @"One object should have been evicted.");
+
+  cache.maxTotalCost = 10;
+  STAssertEquals(cache.count, (NSUInteger)1, @"Lowering the limit should evict immediately.");
+  STAssertNotNil([cache objectForKey:@"4"], @"The most recently used object should be kept.");
+
+  [cache setObject:@"huge" forKey:@"5" cost:100];
+  STAssertNil([cache objectForKey:@"5"], @"Objects larger than the limit should not be kept.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testStatistics {
+  NIMemoryCache* cache = [[[NIMemoryCache alloc] init] autorelease];
+
+  [cache setObject:@"one" forKey:@"1" cost:1];
+  [cache objectForKey:@"1"];
+  [cache objectForKey:@"1"];
+  [cache objectForKey:@"2"];
+  STAssertEquals(cache.numberOfHits, (NSUInteger)2, @"Both lookups of \"1\" should be hits.");
+  STAssertEquals(cache.numberOfMisses, (NSUInteger)1, @"The lookup of \"2\" should be a miss.");
+
+  [cache resetStatistics];
+  STAssertEquals(cache.numberOfHits, (NSUInteger)0, @"Hits should be reset.");
+  STAssertEquals(cache.numberOfMisses, (NSUInteger)0, @"Misses should be reset.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testMemoryWarning {
+  NIMemoryCache* cache = [[[NIMemoryCache alloc] init] autorelease];
+  [cache setObject:@"one" forKey:@"1" cost:1];
+  [cache setObject:@"two" forKey:@"2" cost:1];
+
+  [[NSNotificationCenter defaultCenter]
+   postNotificationName: UIApplicationDidReceiveMemoryWarningNotification
+                 object: nil];
+
+  STAssertEquals(cache.count, (NSUInteger)0, @"A memory warning should empty the cache.");
+  STAssertEquals(cache.numberOfEvictions, (NSUInteger)2,
+                 @"Objects removed by a memory warning should count as evictions.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testImageCost {
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(NULL, 10, 10, 8, 40, colorSpace,
+                                               kCGImageAlphaPremultipliedLast);
+  CGColorSpaceRelease(colorSpace);
+  CGImageRef imageRef = CGBitmapContextCreateImage(context);
+  CGContextRelease(context);
+  UIImage* image = [UIImage imageWithCGImage:imageRef];
+  CGImageRelease(imageRef);
+
+  STAssertEquals([NIImageMemoryCache costForImage:image], (NSUInteger)400,
+                 @"A 10x10 RGBA image uses 400 bytes.");
+
+  NIImageMemoryCache* cache = [[[NIImageMemoryCache alloc] init] autorelease];
+  [cache storeImage:image forKey:@"image"];
+  STAssertEquals(cache.totalCost, (NSUInteger)400, @"Images should be stored at their cost.");
+}
+
+
+@end
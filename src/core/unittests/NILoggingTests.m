@@ -0,0 +1,197 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "NimbusCore/NILogging.h"
+
+@interface NILoggingTests : SenTestCase {
+}
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Remembers every message written to it.
+ */
+@interface NILoggingTestsSink : NSObject <NILogSink> {
+@private
+  NSMutableArray* _messages;
+  NSInteger       _lastLevel;
+  const char*     _lastModule;
+}
+
+@property (nonatomic, readonly, retain) NSArray* messages;
+@property (nonatomic, readonly, assign) NSInteger lastLevel;
+@property (nonatomic, readonly, assign) const char* lastModule;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILoggingTestsSink
+
+@synthesize lastLevel = _lastLevel;
+@synthesize lastModule = _lastModule;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_messages);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _messages = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)messages {
+  @synchronized(self) {
+    return [[_messages copy] autorelease];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)writeLogRecord:(const NILogRecord *)record {
+  @synchronized(self) {
+    [_messages addObject:record->message];
+    _lastLevel = record->level;
+    _lastModule = record->module;
+  }
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILoggingTests
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testModuleLogLevels {
+  NSInteger previousMaxLogLevel = NIMaxLogLevel;
+  NIMaxLogLevel = NILOGLEVEL_WARNING;
+
+  STAssertEquals(NIMaxLogLevelForModule(NULL), (NSInteger)NILOGLEVEL_WARNING,
+                 @"Logs without a module should use the global level.");
+  STAssertEquals(NIMaxLogLevelForModule("NILoggingTests unset"), (NSInteger)NILOGLEVEL_WARNING,
+                 @"Modules without a level should use the global level.");
+
+  NISetMaxLogLevelForModule(NILOGLEVEL_INFO, "NILoggingTests");
+  STAssertEquals(NIMaxLogLevelForModule("NILoggingTests"), (NSInteger)NILOGLEVEL_INFO,
+                 @"The module's own level should be used.");
+
+  NIMaxLogLevel = NILOGLEVEL_ERROR;
+  STAssertEquals(NIMaxLogLevelForModule("NILoggingTests"), (NSInteger)NILOGLEVEL_INFO,
+                 @"The module's level should not follow the global level.");
+  STAssertEquals(NIMaxLogLevelForModule("NILoggingTests unset"), (NSInteger)NILOGLEVEL_ERROR,
+                 @"Modules without a level should follow the global level.");
+
+  NISetMaxLogLevelForModule(NILOGLEVEL_ERROR, "NILoggingTests");
+  STAssertEquals(NIMaxLogLevelForModule("NILoggingTests"), (NSInteger)NILOGLEVEL_ERROR,
+                 @"Setting a module's level again should replace it.");
+
+  NIMaxLogLevel = previousMaxLogLevel;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testLogMessageWritesToCurrentSink {
+  NILoggingTestsSink* sink = [[[NILoggingTestsSink alloc] init] autorelease];
+  NISetLogSink(sink);
+  STAssertEquals((id)NICurrentLogSink(), (id)sink, @"The sink should have been replaced.");
+
+  NILogMessage(NILOGLEVEL_INFO, "NILoggingTests", __PRETTY_FUNCTION__, __LINE__,
+               @"%d apples", 5);
+
+  NISetLogSink(nil);
+  STAssertTrue(NICurrentLogSink() != sink, @"The default sink should have been restored.");
+
+  STAssertEqualObjects(sink.messages, [NSArray arrayWithObject:@"5 apples"],
+                       @"The message should be formatted.");
+  STAssertEquals(sink.lastLevel, (NSInteger)NILOGLEVEL_INFO, @"The level should be passed on.");
+  STAssertTrue(0 == strcmp(sink.lastModule, "NILoggingTests"), @"The module should be passed on.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testBufferedSinkKeepsOrder {
+  NILoggingTestsSink* destination = [[[NILoggingTestsSink alloc] init] autorelease];
+  NIBufferedLogSink* sink = [[NIBufferedLogSink alloc] initWithDestination: destination
+                                                                  capacity: 4];
+
+  // Far more records than the buffer can hold, so the logging thread has to drain it too.
+  NSMutableArray* expectedMessages = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    NSString* message = [NSString stringWithFormat:@"%d", ix];
+    [expectedMessages addObject:message];
+
+    NILogRecord record;
+    memset(&record, 0, sizeof(record));
+    record.message = message;
+    [sink writeLogRecord:&record];
+  }
+
+  [sink flush];
+  STAssertEqualObjects(destination.messages, expectedMessages,
+                       @"Every record should be written once and in order.");
+
+  [sink release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testBufferedSinkWritesInBackground {
+  NILoggingTestsSink* destination = [[[NILoggingTestsSink alloc] init] autorelease];
+  NIBufferedLogSink* sink = [[NIBufferedLogSink alloc] initWithDestination:destination];
+
+  NILogRecord record;
+  memset(&record, 0, sizeof(record));
+  record.message = @"background";
+  [sink writeLogRecord:&record];
+
+  NSDate* timeout = [NSDate dateWithTimeIntervalSinceNow:2];
+  while ([destination.messages count] == 0 && [timeout timeIntervalSinceNow] > 0) {
+    [NSThread sleepForTimeInterval:0.01];
+  }
+
+  STAssertEqualObjects(destination.messages, [NSArray arrayWithObject:@"background"],
+                       @"The record should be written without being flushed.");
+
+  [sink release];
+}
+
+
+@end
@@ -0,0 +1,160 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "NimbusCore/NIPointerSet.h"
+
+@interface NIPointerSetTests : SenTestCase {
+}
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIPointerSetTests
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testAddingAndRemovingPointers {
+  NIPointerSet* set = [NIPointerSet pointerSet];
+  int first, second;
+
+  [set addPointer:&first];
+  [set addPointer:&first];
+  STAssertEquals(set.count, (NSUInteger)1, @"A pointer should only be added once.");
+  STAssertTrue([set containsPointer:&first], @"The pointer should be in the set.");
+  STAssertFalse([set containsPointer:&second], @"The pointer was never added.");
+  STAssertFalse([set containsPointer:NULL], @"NULL is never in the set.");
+
+  [set removePointer:&second];
+  STAssertEquals(set.count, (NSUInteger)1, @"Removing a missing pointer should do nothing.");
+
+  [set removePointer:&first];
+  STAssertEquals(set.count, (NSUInteger)0, @"The pointer should have been removed.");
+  STAssertFalse([set containsPointer:&first], @"The pointer should have been removed.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testValues {
+  NIPointerSet* set = [NIPointerSet pointerSet];
+  int first, second;
+
+  [set addPointer:&first withValue:5];
+  [set addPointer:&second];
+
+  NSInteger value = -1;
+  STAssertTrue([set getValue:&value forPointer:&first], @"The pointer should be in the set.");
+  STAssertEquals(value, (NSInteger)5, @"The value should have been stored.");
+  STAssertTrue([set getValue:&value forPointer:&second], @"The pointer should be in the set.");
+  STAssertEquals(value, (NSInteger)0, @"Pointers added without a value should have zero.");
+
+  [set addPointer:&first withValue:7];
+  [set addPointer:&first];
+  STAssertTrue([set getValue:&value forPointer:&first], @"The pointer should be in the set.");
+  STAssertEquals(value, (NSInteger)7, @"Only an explicit value should replace the old one.");
+  STAssertEquals(set.count, (NSUInteger)2, @"Replacing a value shouldn't add a pointer.");
+
+  [set removePointer:&first];
+  value = -1;
+  STAssertFalse([set getValue:&value forPointer:&first], @"The pointer should have been removed.");
+  STAssertEquals(value, (NSInteger)-1, @"The value should be left alone when not found.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testGrowingAndReusingDeletedSlots {
+  NIPointerSet* set = [[[NIPointerSet alloc] initWithCapacity:2] autorelease];
+  char pointers[1000];
+
+  for (NSInteger ix = 0; ix < 1000; ++ix) {
+    [set addPointer:&pointers[ix] withValue:ix];
+  }
+  STAssertEquals(set.count, (NSUInteger)1000, @"Every pointer should have been added.");
+
+  // Repeatedly removing and adding pointers fills the table with deleted slots.
+  for (NSInteger ixRound = 0; ixRound < 10; ++ixRound) {
+    for (NSInteger ix = 0; ix < 1000; ix += 2) {
+      [set removePointer:&pointers[ix]];
+    }
+    for (NSInteger ix = 0; ix < 1000; ix += 2) {
+      [set addPointer:&pointers[ix] withValue:ix];
+    }
+  }
+
+  STAssertEquals(set.count, (NSUInteger)1000, @"Every pointer should still be in the set.");
+  for (NSInteger ix = 0; ix < 1000; ++ix) {
+    NSInteger value = -1;
+    STAssertTrue([set getValue:&value forPointer:&pointers[ix]], @"Pointer %d is missing.", ix);
+    STAssertEquals(value, ix, @"Pointer %d has the wrong value.", ix);
+  }
+
+  [set removeAllPointers];
+  STAssertEquals(set.count, (NSUInteger)0, @"Every pointer should have been removed.");
+  STAssertFalse([set containsPointer:&pointers[0]], @"Every pointer should have been removed.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testEnumeration {
+  NIPointerSet* set = [NIPointerSet pointerSet];
+  NSMutableArray* objects = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    NSNumber* number = [NSNumber numberWithInt:ix];
+    [objects addObject:number];
+    [set addPointer:number];
+  }
+
+  NSMutableSet* enumeratedObjects = [NSMutableSet set];
+  for (id object in set) {
+    [enumeratedObjects addObject:object];
+  }
+  STAssertEqualObjects(enumeratedObjects, [NSSet setWithArray:objects],
+                       @"Every pointer should be enumerated once.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testRemovingDuringEnumeration {
+  NIPointerSet* set = [NIPointerSet pointerSet];
+  NSMutableArray* objects = [NSMutableArray array];
+  for (NSInteger ix = 0; ix < 100; ++ix) {
+    NSNumber* number = [NSNumber numberWithInt:ix];
+    [objects addObject:number];
+    [set addPointer:number];
+  }
+
+  NSInteger numberOfObjects = 0;
+  for (id object in set) {
+    for (id otherObject in objects) {
+      [set removePointer:otherObject];
+    }
+    if (nil != object) {
+      ++numberOfObjects;
+    }
+  }
+
+  STAssertEquals(numberOfObjects, (NSInteger)1, @"Removed pointers should be enumerated as nil.");
+  STAssertEquals(set.count, (NSUInteger)0, @"Every pointer should have been removed.");
+}
+
+
+@end
@@ -0,0 +1,206 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// See: http://bit.ly/hS5nNh for unit test macros.
+
+#import <SenTestingKit/SenTestingKit.h>
+
+#import "NimbusCore/NIZeroingWeakCollections.h"
+
+@interface NIZeroingWeakCollectionsTests : SenTestCase {
+}
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NIZeroingWeakCollectionsTests
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testArrayDoesNotRetain {
+  NIZeroingWeakArray* array = [NIZeroingWeakArray array];
+  id object = [[NSObject alloc] init];
+  NSUInteger initialRetainCount = [object retainCount];
+
+  [array addObject:object];
+  STAssertEquals([object retainCount], initialRetainCount, @"The array shouldn't retain.");
+  STAssertTrue([array containsObject:object], @"The object should be in the array.");
+
+  [array removeObject:object];
+  STAssertFalse([array containsObject:object], @"The object should have been removed.");
+  STAssertEquals([array count], (NSUInteger)0, @"The array should be empty.");
+
+  [object release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testArrayKeepsOrderAndDuplicates {
+  NIZeroingWeakArray* array = [NIZeroingWeakArray array];
+  NSArray* objects = [NSArray arrayWithObjects:
+                      [[[NSObject alloc] init] autorelease],
+                      [[[NSObject alloc] init] autorelease],
+                      [[[NSObject alloc] init] autorelease],
+                      nil];
+
+  for (id object in objects) {
+    [array addObject:object];
+  }
+  [array addObject:[objects objectAtIndex:0]];
+
+  NSArray* expected = [objects arrayByAddingObject:[objects objectAtIndex:0]];
+  STAssertEqualObjects([array allObjects], expected, @"The objects should be in order.");
+
+  NSMutableArray* enumerated = [NSMutableArray array];
+  for (id object in array) {
+    [enumerated addObject:object];
+  }
+  STAssertEqualObjects(enumerated, expected, @"The objects should be enumerated in order.");
+
+  [array removeObject:[objects objectAtIndex:0]];
+  STAssertEqualObjects([array allObjects], [objects subarrayWithRange:NSMakeRange(1, 2)],
+                       @"Every occurrence should have been removed.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testArrayDropsDeallocatedObjects {
+  if (!NIIsZeroingWeakReferenceSupported()) {
+    return;
+  }
+
+  NIZeroingWeakArray* array = [NIZeroingWeakArray array];
+  id survivor = [[[NSObject alloc] init] autorelease];
+  id object = [[NSObject alloc] init];
+
+  [array addObject:object];
+  [array addObject:survivor];
+  [array addObject:object];
+  STAssertEquals([array count], (NSUInteger)3, @"Every object should have been added.");
+
+  [object release];
+  STAssertEquals([array count], (NSUInteger)1, @"The deallocated object should be gone.");
+  STAssertEqualObjects([array allObjects], [NSArray arrayWithObject:survivor],
+                       @"Only the surviving object should be left.");
+
+  NSInteger numberOfObjects = 0;
+  for (id enumeratedObject in array) {
+    STAssertEquals(enumeratedObject, survivor, @"Dead objects should be skipped.");
+    ++numberOfObjects;
+  }
+  STAssertEquals(numberOfObjects, (NSInteger)1, @"Only the surviving object should be left.");
+
+  // Mutating the array compacts it.
+  id newObject = [[[NSObject alloc] init] autorelease];
+  [array addObject:newObject];
+  STAssertEqualObjects([array allObjects], [NSArray arrayWithObjects:survivor, newObject, nil],
+                       @"The new object should follow the survivor.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testArrayDeallocationDuringEnumeration {
+  if (!NIIsZeroingWeakReferenceSupported()) {
+    return;
+  }
+
+  NIZeroingWeakArray* array = [NIZeroingWeakArray array];
+  id first = [[[NSObject alloc] init] autorelease];
+  id second = [[NSObject alloc] init];
+  [array addObject:first];
+  [array addObject:second];
+
+  NSInteger numberOfObjects = 0;
+  for (id object in array) {
+    if (object == first) {
+      [second release];
+    }
+    if (nil != object) {
+      ++numberOfObjects;
+    }
+  }
+
+  STAssertEquals(numberOfObjects, (NSInteger)1, @"The dead object should be enumerated as nil.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testArrayDeallocatedBeforeItsObjects {
+  NIZeroingWeakArray* array = [[NIZeroingWeakArray alloc] init];
+  id object = [[NSObject alloc] init];
+  [array addObject:object];
+
+  // Neither of these should message the other once it is gone.
+  [array release];
+  [object release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testSet {
+  NIZeroingWeakSet* set = [NIZeroingWeakSet set];
+  id survivor = [[[NSObject alloc] init] autorelease];
+  id object = [[NSObject alloc] init];
+  NSUInteger initialRetainCount = [object retainCount];
+
+  [set addObject:object];
+  [set addObject:object];
+  [set addObject:survivor];
+  STAssertEquals([object retainCount], initialRetainCount, @"The set shouldn't retain.");
+  STAssertEquals([set count], (NSUInteger)2, @"Objects should only be added once.");
+  STAssertTrue([set containsObject:object], @"The object should be in the set.");
+
+  if (NIIsZeroingWeakReferenceSupported()) {
+    [object release];
+    STAssertEquals([set count], (NSUInteger)1, @"The deallocated object should be gone.");
+
+  } else {
+    [set removeObject:object];
+    [object release];
+  }
+
+  STAssertEqualObjects([set allObjects], [NSArray arrayWithObject:survivor],
+                       @"Only the surviving object should be left.");
+
+  [set removeAllObjects];
+  STAssertEquals([set count], (NSUInteger)0, @"The set should be empty.");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)testObjectInSeveralCollections {
+  if (!NIIsZeroingWeakReferenceSupported()) {
+    return;
+  }
+
+  NIZeroingWeakSet* set = [NIZeroingWeakSet set];
+  NIZeroingWeakArray* array = [NIZeroingWeakArray array];
+  id object = [[NSObject alloc] init];
+  [set addObject:object];
+  [array addObject:object];
+
+  // Removing the object from one collection shouldn't stop the other from watching it.
+  [set removeObject:object];
+  [object release];
+
+  STAssertEquals([array count], (NSUInteger)0, @"The array should still have been told.");
+}
+
+
+@end
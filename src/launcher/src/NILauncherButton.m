@@ -18,19 +18,123 @@
 
 #import "NILauncherViewController.h"
 
+#import <QuartzCore/QuartzCore.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NimbusCore+Additions.h"
+#import "NimbusCore/NIInMemoryCache.h"
+#else
+#import "NimbusCore+Additions.h"
+#import "NIInMemoryCache.h"
+#endif
+
 // The padding around the entire button on the top, left, bottom, and right sides.
 static const CGFloat kDefaultPadding = 5;
 
 // The amount of space between the bottom of the image and the top of the text.
 static const CGFloat kSpacing = 5;
 
+// Badges
+static const CGFloat kBadgeFontSize = 13;
+static const CGFloat kBadgeBorderWidth = 2;
+static const CGFloat kBadgeVerticalPadding = 1;
+static const CGFloat kBadgeHorizontalPadding = 5;
+static const NSUInteger kBadgeImageCacheMaxTotalCost = 256 * 1024;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIAddPillToContext(CGContextRef context, CGRect rect) {
+  CGFloat radius = rect.size.height / 2;
+  CGContextBeginPath(context);
+  CGContextAddArc(context, CGRectGetMinX(rect) + radius, CGRectGetMidY(rect), radius,
+                  M_PI / 2, 3 * M_PI / 2, NO);
+  CGContextAddArc(context, CGRectGetMaxX(rect) - radius, CGRectGetMidY(rect), radius,
+                  3 * M_PI / 2, M_PI / 2, NO);
+  CGContextClosePath(context);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The image of a badge showing the given text.
+ *
+ * Each distinct badge value is only drawn once; the images are kept in a cache shared by every
+ * launcher button. Must be called on the main thread.
+ */
+static UIImage* NILauncherBadgeImage(NSString* badgeValue) {
+  static NIImageMemoryCache* sBadgeImageCache = nil;
+  if (nil == sBadgeImageCache) {
+    sBadgeImageCache = [[NIImageMemoryCache alloc] initWithMaxTotalCost:
+                        kBadgeImageCacheMaxTotalCost];
+  }
+
+  UIImage* image = [sBadgeImageCache objectForKey:badgeValue];
+  if (nil != image) {
+    return image;
+  }
+
+  UIFont* font = [UIFont boldSystemFontOfSize:kBadgeFontSize];
+  CGSize textSize = [badgeValue sizeWithFont:font];
+  textSize = CGSizeMake(ceilf(textSize.width), ceilf(textSize.height));
+
+  CGFloat height = textSize.height + 2 * (kBadgeVerticalPadding + kBadgeBorderWidth);
+  CGFloat width = MAX(height, textSize.width + 2 * (kBadgeHorizontalPadding + kBadgeBorderWidth));
+  CGSize size = CGSizeMake(width, height);
+
+  // Weak-linked; only available from iOS 4.0.
+  if (NULL != UIGraphicsBeginImageContextWithOptions) {
+    UIGraphicsBeginImageContextWithOptions(size, NO, 0);
+
+  } else {
+    UIGraphicsBeginImageContext(size);
+  }
+
+  CGContextRef context = UIGraphicsGetCurrentContext();
+  CGRect bounds = CGRectMake(0, 0, size.width, size.height);
+
+  [[UIColor whiteColor] setFill];
+  NIAddPillToContext(context, bounds);
+  CGContextFillPath(context);
+
+  [[UIColor colorWithRed:0.85f green:0.1f blue:0.1f alpha:1] setFill];
+  NIAddPillToContext(context, CGRectInset(bounds, kBadgeBorderWidth, kBadgeBorderWidth));
+  CGContextFillPath(context);
+
+  [[UIColor whiteColor] set];
+  [badgeValue drawAtPoint: CGPointMake(floorf((width - textSize.width) / 2),
+                                       floorf((height - textSize.height) / 2))
+                 withFont: font];
+
+  image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+
+  [sBadgeImageCache storeImage:image forKey:badgeValue];
+  return image;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 @implementation NILauncherButton
 
-@synthesize padding = _padding;
+@synthesize reuseIdentifier = _reuseIdentifier;
+@synthesize drawsContentFlattened = _drawsContentFlattened;
+@synthesize badgeValue = _badgeValue;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_reuseIdentifier);
+  NI_RELEASE_SAFELY(_measuredTitle);
+  NI_RELEASE_SAFELY(_measuredTitleFont);
+  NI_RELEASE_SAFELY(_flattenedContents);
+  NI_RELEASE_SAFELY(_badgeValue);
+  NI_RELEASE_SAFELY(_badgeImage);
+  NI_RELEASE_SAFELY(_badgeLayer);
+
+  [super dealloc];
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -48,24 +152,331 @@ static const CGFloat kSpacing = 5;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The size of the title label's text, measuring it only if it has changed.
+ */
+- (CGSize)titleLabelSizeForWidth:(CGFloat)titleLabelWidth {
+  NSString* title = self.titleLabel.text;
+  UIFont* font = self.titleLabel.font;
+  UILineBreakMode lineBreakMode = self.titleLabel.lineBreakMode;
+
+  BOOL isTitleUnchanged = (_measuredTitle == title
+                           || (nil != title && [_measuredTitle isEqualToString:title]));
+  if (isTitleUnchanged
+      && _measuredTitleFont == font
+      && _measuredTitleWidth == titleLabelWidth
+      && _measuredTitleLineBreakMode == lineBreakMode) {
+    return _titleLabelSize;
+  }
+
+  [_measuredTitle release];
+  _measuredTitle = [title copy];
+  [_measuredTitleFont release];
+  _measuredTitleFont = [font retain];
+  _measuredTitleWidth = titleLabelWidth;
+  _measuredTitleLineBreakMode = lineBreakMode;
+
+  // Buttons with the same title share measurements through the Core measurement cache, so a
+  // reused or newly created button rarely has to measure its text.
+  _titleLabelSize = [title cachedSizeWithFont: font
+                                     forWidth: titleLabelWidth
+                                lineBreakMode: lineBreakMode];
+  return _titleLabelSize;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Calculate the frames of the title and image within the button's bounds.
+ */
+- (void)getTitleFrame:(CGRect *)pTitleFrame imageFrame:(CGRect *)pImageFrame {
+  CGFloat titleLabelWidth = (self.bounds.size.width - _padding.left - _padding.right);
+
+  CGSize titleLabelSize = [self titleLabelSizeForWidth:titleLabelWidth];
+
+  *pTitleFrame = CGRectMake(_padding.left,
+                            self.bounds.size.height - titleLabelSize.height - _padding.bottom,
+                            titleLabelWidth, titleLabelSize.height);
+
+  *pImageFrame = CGRectMake(_padding.left, _padding.top,
+                            titleLabelWidth,
+                            pTitleFrame->origin.y - kSpacing);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)layoutSubviews {
   [super layoutSubviews];
 
-  CGFloat titleLabelWidth = (self.frame.size.width - _padding.left - _padding.right);
+  CGRect titleFrame = CGRectZero;
+  CGRect imageFrame = CGRectZero;
+  [self getTitleFrame:&titleFrame imageFrame:&imageFrame];
+
+  self.titleLabel.frame = titleFrame;
+  self.imageView.frame = imageFrame;
+
+  // UIButton shows and hides its subviews as the title and image change, so we hide them again
+  // after every layout.
+  self.titleLabel.hidden = _drawsContentFlattened;
+  self.imageView.hidden = _drawsContentFlattened;
+
+  if (_drawsContentFlattened
+      && (_needsFlattenedRender
+          || nil == _flattenedContents
+          || !CGSizeEqualToSize(_flattenedContents.size, self.bounds.size))) {
+    [self renderFlattenedContents];
+  }
+
+  [self updateBadgeLayer];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Badge
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The badge's frame, in the top right corner of the button.
+ */
+- (CGRect)badgeFrame {
+  CGSize size = _badgeImage.size;
+  return CGRectMake(floorf(self.bounds.size.width - size.width), 0, size.width, size.height);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Show the badge image in the badge layer, unless it is drawn into the flattened bitmap.
+ *
+ * The layer is created the first time the button shows a badge and kept for reuse.
+ */
+- (void)updateBadgeLayer {
+  if (nil == _badgeImage || _drawsContentFlattened) {
+    _badgeLayer.hidden = YES;
+    return;
+  }
+
+  // Badges appear and move immediately rather than fading with an implicit animation.
+  [CATransaction begin];
+  [CATransaction setDisableActions:YES];
 
-  CGSize titleLabelSize = [self.titleLabel.text sizeWithFont: self.titleLabel.font
-                                                    forWidth: titleLabelWidth
-                                               lineBreakMode: self.titleLabel.lineBreakMode];
+  if (nil == _badgeLayer) {
+    _badgeLayer = [[CALayer alloc] init];
+    // Keeps the badge above the image view and title label, which are created lazily.
+    _badgeLayer.zPosition = 1;
+    [self.layer addSublayer:_badgeLayer];
+  }
+
+  if ([_badgeLayer respondsToSelector:@selector(setContentsScale:)]
+      && [_badgeImage respondsToSelector:@selector(scale)]) {
+    _badgeLayer.contentsScale = _badgeImage.scale;
+  }
+  _badgeLayer.contents = (id)_badgeImage.CGImage;
+  _badgeLayer.frame = [self badgeFrame];
+  _badgeLayer.hidden = NO;
+
+  [CATransaction commit];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setBadgeValue:(NSString *)badgeValue {
+  if (_badgeValue == badgeValue || [_badgeValue isEqualToString:badgeValue]) {
+    return;
+  }
 
-  self.titleLabel.frame = CGRectMake(_padding.left,
-                                     self.frame.size.height
-                                     - titleLabelSize.height - _padding.bottom,
-                                     titleLabelWidth, titleLabelSize.height);
+  [_badgeValue release];
+  _badgeValue = [badgeValue copy];
 
-  self.imageView.frame = CGRectMake(_padding.left, _padding.top,
-                                    titleLabelWidth,
-                                    self.titleLabel.frame.origin.y - kSpacing);
+  [_badgeImage release];
+  _badgeImage = (([_badgeValue length] > 0)
+                 ? [NILauncherBadgeImage(_badgeValue) retain]
+                 : nil);
+
+  if (_drawsContentFlattened) {
+    [self setNeedsDisplayIfFlattened];
+
+  } else {
+    [self updateBadgeLayer];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Flattened Drawing
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Draw the image and title into a bitmap and make it the contents of the layer.
+ */
+- (void)renderFlattenedContents {
+  _needsFlattenedRender = NO;
+
+  CGSize size = self.bounds.size;
+  if (size.width <= 0 || size.height <= 0) {
+    NI_RELEASE_SAFELY(_flattenedContents);
+    self.layer.contents = nil;
+    return;
+  }
+
+  // Weak-linked; only available from iOS 4.0.
+  if (NULL != UIGraphicsBeginImageContextWithOptions) {
+    UIGraphicsBeginImageContextWithOptions(size, NO, 0);
+
+  } else {
+    UIGraphicsBeginImageContext(size);
+  }
+
+  CGRect titleFrame = CGRectZero;
+  CGRect imageFrame = CGRectZero;
+  [self getTitleFrame:&titleFrame imageFrame:&imageFrame];
+
+  CGContextRef context = UIGraphicsGetCurrentContext();
+
+  UIImage* image = self.currentImage;
+  if (nil != image && imageFrame.size.width > 0 && imageFrame.size.height > 0) {
+    // Match the image view by centering the image and only ever scaling it down to fit.
+    CGFloat scale = MIN(1, MIN(imageFrame.size.width / image.size.width,
+                               imageFrame.size.height / image.size.height));
+    CGSize imageSize = CGSizeMake(floorf(image.size.width * scale),
+                                  floorf(image.size.height * scale));
+    CGRect imageRect = CGRectMake(floorf(CGRectGetMidX(imageFrame) - imageSize.width / 2),
+                                  floorf(CGRectGetMidY(imageFrame) - imageSize.height / 2),
+                                  imageSize.width, imageSize.height);
+    [image drawInRect:imageRect];
+
+    if (self.highlighted && self.adjustsImageWhenHighlighted) {
+      // Darken only the image's opaque pixels, like UIButton does.
+      CGContextSaveGState(context);
+      CGContextSetBlendMode(context, kCGBlendModeSourceAtop);
+      CGContextSetFillColorWithColor(context, [UIColor colorWithWhite:0 alpha:0.5].CGColor);
+      CGContextFillRect(context, imageRect);
+      CGContextRestoreGState(context);
+    }
+  }
+
+  NSString* title = self.currentTitle;
+  if (nil != title) {
+    [self.currentTitleColor set];
+    [title drawInRect: titleFrame
+             withFont: self.titleLabel.font
+        lineBreakMode: self.titleLabel.lineBreakMode
+            alignment: self.titleLabel.textAlignment];
+  }
+
+  [_badgeImage drawInRect:[self badgeFrame]];
+
+  [_flattenedContents release];
+  _flattenedContents = [UIGraphicsGetImageFromCurrentImageContext() retain];
+  UIGraphicsEndImageContext();
+
+  if ([self.layer respondsToSelector:@selector(setContentsScale:)]
+      && [_flattenedContents respondsToSelector:@selector(scale)]) {
+    self.layer.contentsScale = _flattenedContents.scale;
+  }
+  self.layer.contents = (id)_flattenedContents.CGImage;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setDrawsContentFlattened:(BOOL)drawsContentFlattened {
+  if (_drawsContentFlattened == drawsContentFlattened) {
+    return;
+  }
+  _drawsContentFlattened = drawsContentFlattened;
+
+  if (_drawsContentFlattened) {
+    _needsFlattenedRender = YES;
+
+  } else {
+    NI_RELEASE_SAFELY(_flattenedContents);
+    self.layer.contents = nil;
+  }
+
+  // Moves the badge between the badge layer and the flattened bitmap.
+  [self setNeedsLayout];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Discard the flattened bitmap if the button is drawing its own content.
+ *
+ * The bitmap is drawn again during the next layout pass, so several changes in a row only
+ * cause a single redraw.
+ */
+- (void)setNeedsDisplayIfFlattened {
+  if (_drawsContentFlattened) {
+    _needsFlattenedRender = YES;
+    [self setNeedsLayout];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setTitle:(NSString *)title forState:(UIControlState)state {
+  [super setTitle:title forState:state];
+  [self setNeedsDisplayIfFlattened];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setTitleColor:(UIColor *)color forState:(UIControlState)state {
+  [super setTitleColor:color forState:state];
+  [self setNeedsDisplayIfFlattened];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setImage:(UIImage *)image forState:(UIControlState)state {
+  [super setImage:image forState:state];
+  [self setNeedsDisplayIfFlattened];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setHighlighted:(BOOL)highlighted {
+  BOOL didChange = (self.highlighted != highlighted);
+  [super setHighlighted:highlighted];
+  if (didChange) {
+    [self setNeedsDisplayIfFlattened];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setSelected:(BOOL)selected {
+  BOOL didChange = (self.selected != selected);
+  [super setSelected:selected];
+  if (didChange) {
+    [self setNeedsDisplayIfFlattened];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setPadding:(UIEdgeInsets)padding {
+  _padding = padding;
+
+  [self setNeedsLayout];
+  [self setNeedsDisplayIfFlattened];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)prepareForReuse {
+  [self setTitle:nil forState:UIControlStateNormal];
+  [self setImage:nil forState:UIControlStateNormal];
+  self.highlighted = NO;
+  self.selected = NO;
+  self.badgeValue = nil;
 }
 
 
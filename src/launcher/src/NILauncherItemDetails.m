@@ -26,12 +26,16 @@
 
 @synthesize title     = _title;
 @synthesize imagePath = _imagePath;
+@synthesize imageURL  = _imageURL;
+@synthesize badgeValue = _badgeValue;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
   NI_RELEASE_SAFELY(_title);
   NI_RELEASE_SAFELY(_imagePath);
+  NI_RELEASE_SAFELY(_imageURL);
+  NI_RELEASE_SAFELY(_badgeValue);
 
   [super dealloc];
 }
@@ -55,11 +59,23 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (id)itemDetailsWithTitle:(NSString *)title imageURL:(NSString *)imageURL {
+  NILauncherItemDetails* item = [[[NILauncherItemDetails alloc] initWithTitle: title
+                                                                    imagePath: nil]
+                                 autorelease];
+  item.imageURL = imageURL;
+  return item;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (id)initWithCoder:(NSCoder *)decoder {
   if ((self = [self initWithTitle:nil imagePath:nil])) {
     self.title = [decoder decodeObjectForKey:@"title"];
     self.imagePath = [decoder decodeObjectForKey:@"imagePath"];
+    self.imageURL = [decoder decodeObjectForKey:@"imageURL"];
+    self.badgeValue = [decoder decodeObjectForKey:@"badgeValue"];
   }
   return self;
 }
@@ -69,6 +85,42 @@
 - (void)encodeWithCoder:(NSCoder *)encoder {
   [encoder encodeObject:self.title forKey:@"title"];
   [encoder encodeObject:self.imagePath forKey:@"imagePath"];
+  [encoder encodeObject:self.imageURL forKey:@"imageURL"];
+  [encoder encodeObject:self.badgeValue forKey:@"badgeValue"];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)isEqualToItemDetailsIgnoringBadge:(NILauncherItemDetails *)other {
+  return ((_title == other.title || [_title isEqualToString:other.title])
+          && (_imagePath == other.imagePath || [_imagePath isEqualToString:other.imagePath])
+          && (_imageURL == other.imageURL || [_imageURL isEqualToString:other.imageURL]));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Two item details are equal if they would produce identical launcher buttons.
+ *
+ * This allows NILauncherViewController to find the items that changed when its pages are set.
+ */
+- (BOOL)isEqual:(id)object {
+  if (self == object) {
+    return YES;
+  }
+  if (![object isKindOfClass:[NILauncherItemDetails class]]) {
+    return NO;
+  }
+
+  NILauncherItemDetails* other = object;
+  return ([self isEqualToItemDetailsIgnoringBadge:other]
+          && (_badgeValue == other.badgeValue || [_badgeValue isEqualToString:other.badgeValue]));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)hash {
+  return [_title hash] ^ [_imagePath hash];
 }
 
 
@@ -0,0 +1,133 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ * @brief Everything that a launcher's page layout is calculated from.
+ *
+ * @ingroup Launcher-User-Interface
+ *
+ * Once these values have been read from the launcher view and its data source, calculating the
+ * layout is pure arithmetic.
+ */
+typedef struct {
+  CGSize        pageSize;         // The size of the launcher's scroll view.
+  UIEdgeInsets  padding;
+  CGSize        buttonDimensions;
+  NSInteger     numberOfRows;     // May be NILauncherViewDynamic.
+  NSInteger     numberOfColumns;  // May be NILauncherViewDynamic.
+} NILauncherLayoutParameters;
+
+/**
+ * @brief The grid that the buttons on every page are arranged in.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+typedef struct {
+  CGSize    buttonDimensions;
+  NSInteger numberOfRows;
+  NSInteger numberOfColumns;
+  CGFloat   buttonHorizontalSpacing;
+  CGFloat   buttonVerticalSpacing;
+} NILauncherLayoutMetrics;
+
+/**
+ * @brief Whether two sets of layout parameters produce the same layout.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+BOOL NILauncherLayoutParametersEqualToParameters(NILauncherLayoutParameters parameters,
+                                                 NILauncherLayoutParameters otherParameters);
+
+/**
+ * @brief Calculate the button grid for the given parameters.
+ *
+ * @ingroup Launcher-User-Interface
+ *
+ * Dynamic numbers of rows and columns are resolved to as many buttons as fit on the page.
+ * This function is thread-safe.
+ */
+NILauncherLayoutMetrics NILauncherLayoutMetricsMake(NILauncherLayoutParameters parameters);
+
+/**
+ * @brief The precomputed frames of a launcher's pages and buttons.
+ *
+ * @ingroup Launcher-User-Interface
+ *
+ * Every page shares the same grid, so a layout stores the frames of the buttons on a single
+ * page, relative to the page, in a plain C array. Laying out a page is then a matter of
+ * assigning each button the frame at its index.
+ *
+ * Layouts are immutable and can be created on any thread, which lets NILauncherView calculate
+ * the layout for another size, such as the other orientation, before it is needed.
+ */
+@interface NILauncherLayout : NSObject {
+@private
+  NILauncherLayoutParameters  _parameters;
+  NILauncherLayoutMetrics     _metrics;
+
+  CGRect*                     _buttonFrames;
+  NSInteger                   _numberOfButtonFrames;
+}
+
+/**
+ * @brief Designated initializer.
+ *
+ * @param numberOfButtonFrames  The number of button frames to calculate up front. Frames for
+ *                              buttons beyond this are calculated when they are requested.
+ */
+- (id)initWithParameters: (NILauncherLayoutParameters)parameters
+    numberOfButtonFrames: (NSInteger)numberOfButtonFrames;
+
+@property (nonatomic, readonly, assign) NILauncherLayoutParameters parameters;
+@property (nonatomic, readonly, assign) NILauncherLayoutMetrics metrics;
+
+/**
+ * @brief The precomputed button frames, relative to their page.
+ */
+@property (nonatomic, readonly, assign) const CGRect* buttonFrames;
+
+/**
+ * @brief The number of frames in buttonFrames.
+ */
+@property (nonatomic, readonly, assign) NSInteger numberOfButtonFrames;
+
+/**
+ * @brief The frame of the button at the given index on a page, relative to the page.
+ */
+- (CGRect)frameForButtonAtIndex:(NSInteger)index;
+
+/**
+ * @brief The index of the grid slot nearest to the given point on a page.
+ *
+ * Each slot extends halfway into the spacing around its button, and points outside of the grid
+ * belong to the nearest column. The index may be beyond the number of buttons on the page.
+ */
+- (NSInteger)indexOfButtonNearestToPoint:(CGPoint)point;
+
+/**
+ * @brief The frame of the given page's scroll view within the launcher's scroll view.
+ */
+- (CGRect)frameForPage:(NSInteger)page;
+
+/**
+ * @brief The content size of a page with the given number of buttons.
+ */
+- (CGSize)contentSizeForPageWithNumberOfButtons:(NSInteger)numberOfButtons;
+
+@end
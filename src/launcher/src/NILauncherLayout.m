@@ -0,0 +1,175 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NILauncherLayout.h"
+
+#import "NILauncherView.h"
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+BOOL NILauncherLayoutParametersEqualToParameters(NILauncherLayoutParameters parameters,
+                                                 NILauncherLayoutParameters otherParameters) {
+  return (CGSizeEqualToSize(parameters.pageSize, otherParameters.pageSize)
+          && UIEdgeInsetsEqualToEdgeInsets(parameters.padding, otherParameters.padding)
+          && CGSizeEqualToSize(parameters.buttonDimensions, otherParameters.buttonDimensions)
+          && parameters.numberOfRows == otherParameters.numberOfRows
+          && parameters.numberOfColumns == otherParameters.numberOfColumns);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+NILauncherLayoutMetrics NILauncherLayoutMetricsMake(NILauncherLayoutParameters parameters) {
+  CGFloat pageWidth = (parameters.pageSize.width
+                       - parameters.padding.left - parameters.padding.right);
+  CGFloat pageHeight = (parameters.pageSize.height
+                        - parameters.padding.top - parameters.padding.bottom);
+
+  CGSize buttonDimensions = parameters.buttonDimensions;
+  NSInteger numberOfColumns = parameters.numberOfColumns;
+  NSInteger numberOfRows = parameters.numberOfRows;
+
+  if (NILauncherViewDynamic == numberOfColumns) {
+    numberOfColumns = floorf(pageWidth / buttonDimensions.width);
+  }
+  if (NILauncherViewDynamic == numberOfRows) {
+    numberOfRows = floorf(pageHeight / buttonDimensions.height);
+  }
+  NIDASSERT(numberOfRows > 0);
+  NIDASSERT(numberOfColumns > 0);
+  numberOfRows = MAX(1, numberOfRows);
+  numberOfColumns = MAX(1, numberOfColumns);
+
+  CGFloat totalButtonWidth = numberOfColumns * buttonDimensions.width;
+  CGFloat buttonHorizontalSpacing = 0;
+  if (numberOfColumns > 1) {
+    buttonHorizontalSpacing = floorf((pageWidth - totalButtonWidth) / (numberOfColumns - 1));
+  }
+  CGFloat totalButtonHeight = numberOfRows * buttonDimensions.height;
+  CGFloat buttonVerticalSpacing = 0;
+  if (numberOfRows > 1) {
+    buttonVerticalSpacing = floorf((pageHeight - totalButtonHeight) / (numberOfRows - 1));
+  }
+
+  NILauncherLayoutMetrics metrics;
+  metrics.buttonDimensions = buttonDimensions;
+  metrics.numberOfRows = numberOfRows;
+  metrics.numberOfColumns = numberOfColumns;
+  metrics.buttonHorizontalSpacing = buttonHorizontalSpacing;
+  metrics.buttonVerticalSpacing = buttonVerticalSpacing;
+  return metrics;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static CGRect NILauncherLayoutFrameForButton(NILauncherLayoutParameters parameters,
+                                             NILauncherLayoutMetrics metrics,
+                                             NSInteger index) {
+  NSInteger col = index % metrics.numberOfColumns;
+  NSInteger row = index / metrics.numberOfColumns;
+
+  return CGRectMake(parameters.padding.left + col * metrics.buttonDimensions.width
+                    + (col * metrics.buttonHorizontalSpacing),
+                    parameters.padding.top + row * metrics.buttonDimensions.height
+                    + (row * metrics.buttonVerticalSpacing),
+                    metrics.buttonDimensions.width, metrics.buttonDimensions.height);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILauncherLayout
+
+@synthesize parameters = _parameters;
+@synthesize metrics = _metrics;
+@synthesize buttonFrames = _buttonFrames;
+@synthesize numberOfButtonFrames = _numberOfButtonFrames;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  free(_buttonFrames);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithParameters: (NILauncherLayoutParameters)parameters
+    numberOfButtonFrames: (NSInteger)numberOfButtonFrames {
+  if ((self = [super init])) {
+    _parameters = parameters;
+    _metrics = NILauncherLayoutMetricsMake(parameters);
+
+    if (numberOfButtonFrames > 0) {
+      _buttonFrames = malloc(numberOfButtonFrames * sizeof(CGRect));
+    }
+    if (NULL != _buttonFrames) {
+      _numberOfButtonFrames = numberOfButtonFrames;
+      for (NSInteger ixButton = 0; ixButton < numberOfButtonFrames; ++ixButton) {
+        _buttonFrames[ixButton] = NILauncherLayoutFrameForButton(_parameters, _metrics, ixButton);
+      }
+    }
+  }
+
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGRect)frameForButtonAtIndex:(NSInteger)index {
+  if (index >= 0 && index < _numberOfButtonFrames) {
+    return _buttonFrames[index];
+  }
+  return NILauncherLayoutFrameForButton(_parameters, _metrics, index);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)indexOfButtonNearestToPoint:(CGPoint)point {
+  CGFloat columnWidth = _metrics.buttonDimensions.width + _metrics.buttonHorizontalSpacing;
+  CGFloat rowHeight = _metrics.buttonDimensions.height + _metrics.buttonVerticalSpacing;
+
+  NSInteger col = (NSInteger)floorf((point.x - _parameters.padding.left
+                                     + _metrics.buttonHorizontalSpacing / 2) / columnWidth);
+  NSInteger row = (NSInteger)floorf((point.y - _parameters.padding.top
+                                     + _metrics.buttonVerticalSpacing / 2) / rowHeight);
+  col = MAX(0, MIN(_metrics.numberOfColumns - 1, col));
+  row = MAX(0, row);
+
+  return row * _metrics.numberOfColumns + col;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGRect)frameForPage:(NSInteger)page {
+  return CGRectMake(page * _parameters.pageSize.width, 0,
+                    _parameters.pageSize.width, _parameters.pageSize.height);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (CGSize)contentSizeForPageWithNumberOfButtons:(NSInteger)numberOfButtons {
+  // The last button is always in the bottom row.
+  CGFloat pageBottom = 0;
+  if (numberOfButtons > 0) {
+    pageBottom = CGRectGetMaxY([self frameForButtonAtIndex:numberOfButtons - 1]);
+  }
+  return CGSizeMake(_parameters.pageSize.width, pageBottom + _parameters.padding.bottom);
+}
+
+
+@end
@@ -0,0 +1,211 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusLauncher/NILauncherViewController.h"
+#else
+#import "NILauncherViewController.h"
+#endif
+
+/**
+ * @brief The error domain for errors reported by NILauncherPagesArchive.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+extern NSString* const NILauncherPagesArchiveErrorDomain;
+
+/**
+ * @brief The error codes reported in NILauncherPagesArchiveErrorDomain.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+typedef enum {
+  NILauncherPagesArchiveErrorInvalidFormat = 1,  // The data is not a launcher pages archive.
+  NILauncherPagesArchiveErrorUnsupportedVersion, // The archive was written by a newer version.
+} NILauncherPagesArchiveError;
+
+/**
+ * @brief The version of the archive format written by NILauncherPagesArchive.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+extern const NSUInteger NILauncherPagesArchiveCurrentVersion;
+
+/**
+ * @brief The key of an item's title in the dictionaries given to dataWithPageDictionaries:.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+extern NSString* const NILauncherPagesArchiveTitleKey;
+
+/**
+ * @brief The key of an item's image path in the dictionaries given to dataWithPageDictionaries:.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+extern NSString* const NILauncherPagesArchiveImagePathKey;
+
+/**
+ * @brief The key of an item's image URL in the dictionaries given to dataWithPageDictionaries:.
+ *
+ * @ingroup Launcher-User-Interface
+ */
+extern NSString* const NILauncherPagesArchiveImageURLKey;
+
+/**
+ * @brief A compact binary archive of launcher pages that is read lazily.
+ *
+ * @ingroup Launcher-User-Interface
+ *
+ * Restoring pages that were archived with NSKeyedArchiver allocates every item up front, which
+ * becomes noticeable with thousands of items. This archive instead stores a small header, a
+ * table of pages, a fixed-size record for each item, and a table of the UTF-8 strings that
+ * the records refer to. Identical strings are only stored once.
+ *
+ * When read from a file the archive is memory-mapped, so opening it only touches the header.
+ * NILauncherItemDetails objects are created the first time they are requested and kept for
+ * later requests. A launcher that only shows a few pages at a time will only ever materialize
+ * the items on those pages. Archives are NILauncherItemSource objects and may be given
+ * directly to NILauncherViewController::itemSource.
+ *
+ * Each distinct string is only created once per archive, so items that share a title or image
+ * path share the same string object.
+ *
+ * Archives can also be built in one pass from parsed data, such as the result of a JSON
+ * parser, with initWithPageDictionaries:. The records are written straight into a single
+ * buffer and no items are created until they are requested.
+ *
+ * All values are stored in little-endian byte order. The header's version number is increased
+ * whenever the layout changes; archives with a newer version than
+ * NILauncherPagesArchiveCurrentVersion are rejected.
+ */
+@interface NILauncherPagesArchive : NSObject <NILauncherItemSource> {
+@private
+  NSData*         _data;
+  NSUInteger      _numberOfPages;
+  NSUInteger      _numberOfItems;
+  const void*     _pageRecords;
+  const void*     _itemRecords;
+  const char*     _strings;
+  NSUInteger      _stringsLength;
+
+  // Materialized items, created as they are requested.
+  NSMutableDictionary* _items; // NSDictionary< NSNumber(item index), NILauncherItemDetails * >
+
+  // Strings created from the string table, keyed by their offset and length in the table.
+  CFMutableDictionaryRef _internedStrings;
+}
+
+/**
+ * @brief Encode pages of NILauncherItemDetails in the archive format.
+ *
+ * @param pages  An array of arrays of NILauncherItemDetails.
+ */
++ (NSData *)dataWithPages:(NSArray *)pages;
+
+/**
+ * @brief Encode pages of item dictionaries in the archive format.
+ *
+ * No NILauncherItemDetails objects are created. Each dictionary may contain a string for
+ * NILauncherPagesArchiveTitleKey, NILauncherPagesArchiveImagePathKey and
+ * NILauncherPagesArchiveImageURLKey. Missing keys and values that aren't strings, such as
+ * NSNull, are stored as nil.
+ *
+ * @param pages  An array of arrays of NSDictionary.
+ */
++ (NSData *)dataWithPageDictionaries:(NSArray *)pages;
+
+/**
+ * @brief Write pages of NILauncherItemDetails to a file in the archive format.
+ *
+ * The file is written atomically.
+ *
+ * @param pages  An array of arrays of NILauncherItemDetails.
+ * @param path   The path of the file to write.
+ * @param error  If the file can't be written, upon return contains the reason.
+ * @returns YES if the file was written.
+ */
++ (BOOL)writePages:(NSArray *)pages toFile:(NSString *)path error:(NSError **)error;
+
+/**
+ * @brief Open an archive backed by the given data.
+ *
+ * The archive's header and tables are validated, but no items are created.
+ *
+ * @param data   The archive's data. The data is retained, not copied.
+ * @param error  If the data is not a valid archive, upon return contains the reason.
+ * @returns nil if the data is not a valid archive.
+ */
+- (id)initWithData:(NSData *)data error:(NSError **)error;
+
+/**
+ * @brief Open an archive stored in a file by memory-mapping it.
+ *
+ * @param path   The path of the archive file.
+ * @param error  If the file can't be read or is not a valid archive, upon return contains
+ *               the reason.
+ * @returns nil if the file could not be opened.
+ */
+- (id)initWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+/**
+ * @brief Build an archive in memory from pages of item dictionaries.
+ *
+ * This is the fastest way to turn a large parsed data set into an item source.
+ *
+ * @param pages  An array of arrays of NSDictionary in the format described by
+ *               dataWithPageDictionaries:.
+ */
+- (id)initWithPageDictionaries:(NSArray *)pages;
+
+/**
+ * @brief The number of pages in the archive.
+ */
+@property (nonatomic, readonly, assign) NSInteger numberOfPages;
+
+/**
+ * @brief The number of items on the given page.
+ */
+- (NSInteger)numberOfItemsInPage:(NSInteger)page;
+
+/**
+ * @brief The item at the given index of the given page, created if it hasn't been yet.
+ */
+- (NILauncherItemDetails *)itemDetailsForPage:(NSInteger)page atIndex:(NSInteger)index;
+
+/**
+ * @brief The items on the given page as an array of NILauncherItemDetails.
+ */
+- (NSArray *)itemsForPage:(NSInteger)page;
+
+/**
+ * @brief Every page of the archive as an array of arrays of NILauncherItemDetails.
+ *
+ * This creates every item in the archive and should be avoided for large archives.
+ */
+- (NSArray *)pages;
+
+/**
+ * @brief Release the items and strings that have been created from the archive.
+ *
+ * They will be created again from the archive's data the next time they are requested.
+ * This is called automatically when the app receives a memory warning.
+ */
+- (void)reduceMemoryUsage;
+
+@end
@@ -0,0 +1,522 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NILauncherPagesArchive.h"
+
+#import "NILauncherViewController.h"
+
+NSString* const NILauncherPagesArchiveErrorDomain = @"NILauncherPagesArchiveErrorDomain";
+NSString* const NILauncherPagesArchiveTitleKey = @"title";
+NSString* const NILauncherPagesArchiveImagePathKey = @"imagePath";
+NSString* const NILauncherPagesArchiveImageURLKey = @"imageURL";
+const NSUInteger NILauncherPagesArchiveCurrentVersion = 1;
+
+// "NILP" when read as bytes.
+static const uint32_t kArchiveMagic = 0x504C494E;
+
+// Marks a nil string.
+static const uint32_t kNilStringOffset = 0xFFFFFFFF;
+
+/**
+ * The archive layout, in order:
+ *
+ *   Header
+ *   Page records     (numberOfPages)
+ *   Item records     (numberOfItems, ordered by page)
+ *   String table     (stringsLength bytes of UTF-8 without terminators)
+ *
+ * Every field is a little-endian uint32_t so that each record is naturally aligned.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numberOfPages;
+  uint32_t numberOfItems;
+  uint32_t stringsLength;
+} NILauncherPagesArchiveHeader;
+
+typedef struct {
+  uint32_t firstItem;
+  uint32_t numberOfItems;
+} NILauncherPagesArchivePage;
+
+typedef struct {
+  uint32_t offset; // Into the string table, or kNilStringOffset.
+  uint32_t length;
+} NILauncherPagesArchiveString;
+
+typedef struct {
+  NILauncherPagesArchiveString title;
+  NILauncherPagesArchiveString imagePath;
+  NILauncherPagesArchiveString imageURL;
+} NILauncherPagesArchiveItem;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIStoreUInt32(uint32_t** cursor, uint32_t value) {
+  **cursor = CFSwapInt32HostToLittle(value);
+  ++*cursor;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Store a string reference, adding the string to the string table if it's new.
+ *
+ * @param stringReferences  The offset and length of every string in the table, packed into
+ *                          the high and low 32 bits of an NSNumber and keyed by the string.
+ */
+static void NIStoreString(uint32_t** cursor, NSMutableData* strings,
+                          NSMutableDictionary* stringReferences, id string) {
+  if (![string isKindOfClass:[NSString class]]) {
+    NIStoreUInt32(cursor, kNilStringOffset);
+    NIStoreUInt32(cursor, 0);
+    return;
+  }
+
+  uint32_t offset = 0;
+  uint32_t length = 0;
+  unsigned long long packedReference = 0;
+  NSNumber* reference = [stringReferences objectForKey:string];
+  if (nil != reference) {
+    packedReference = [reference unsignedLongLongValue];
+    offset = (uint32_t)(packedReference >> 32);
+    length = (uint32_t)packedReference;
+
+  } else {
+    // The string is encoded directly into the end of the string table.
+    NSUInteger maxLength = [string maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    NSUInteger usedLength = 0;
+    offset = [strings length];
+    [strings increaseLengthBy:maxLength];
+    [string getBytes: (char *)[strings mutableBytes] + offset
+           maxLength: maxLength
+          usedLength: &usedLength
+            encoding: NSUTF8StringEncoding
+             options: 0
+               range: NSMakeRange(0, [string length])
+      remainingRange: NULL];
+    [strings setLength:offset + usedLength];
+    length = usedLength;
+
+    packedReference = ((unsigned long long)offset << 32) | length;
+    [stringReferences setObject: [NSNumber numberWithUnsignedLongLong:packedReference]
+                         forKey: string];
+  }
+
+  NIStoreUInt32(cursor, offset);
+  NIStoreUInt32(cursor, length);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Copies the strings of an item, which may be of any type, for NILauncherPagesArchiveData.
+ */
+typedef void (*NILauncherPagesArchiveGetStrings)(id item, id* title, id* imagePath, id* imageURL);
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIGetItemDetailsStrings(id item, id* title, id* imagePath, id* imageURL) {
+  NILauncherItemDetails* itemDetails = item;
+  *title = itemDetails.title;
+  *imagePath = itemDetails.imagePath;
+  *imageURL = itemDetails.imageURL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void NIGetDictionaryStrings(id item, id* title, id* imagePath, id* imageURL) {
+  NSDictionary* dictionary = item;
+  *title = [dictionary objectForKey:NILauncherPagesArchiveTitleKey];
+  *imagePath = [dictionary objectForKey:NILauncherPagesArchiveImagePathKey];
+  *imageURL = [dictionary objectForKey:NILauncherPagesArchiveImageURLKey];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Encode pages of items in the archive format.
+ *
+ * The header and records are written into a single buffer that is sized up front, followed by
+ * the string table, so the only allocations made per item are for strings seen for the first
+ * time.
+ */
+static NSData* NILauncherPagesArchiveData(NSArray* pages,
+                                          NILauncherPagesArchiveGetStrings getStrings) {
+  NSUInteger numberOfItems = 0;
+  for (NSArray* page in pages) {
+    numberOfItems += [page count];
+  }
+
+  NSUInteger recordsLength = (sizeof(NILauncherPagesArchiveHeader)
+                              + [pages count] * sizeof(NILauncherPagesArchivePage)
+                              + numberOfItems * sizeof(NILauncherPagesArchiveItem));
+  NSMutableData* data = [NSMutableData dataWithLength:recordsLength];
+  NSMutableData* strings = [NSMutableData data];
+  NSMutableDictionary* stringReferences = [NSMutableDictionary dictionary];
+
+  uint32_t* cursor = [data mutableBytes];
+  NIStoreUInt32(&cursor, kArchiveMagic);
+  NIStoreUInt32(&cursor, NILauncherPagesArchiveCurrentVersion);
+  NIStoreUInt32(&cursor, [pages count]);
+  NIStoreUInt32(&cursor, numberOfItems);
+  uint32_t* stringsLength = cursor;
+  NIStoreUInt32(&cursor, 0);
+
+  uint32_t firstItem = 0;
+  for (NSArray* page in pages) {
+    NIStoreUInt32(&cursor, firstItem);
+    NIStoreUInt32(&cursor, [page count]);
+    firstItem += [page count];
+  }
+
+  for (NSArray* page in pages) {
+    for (id item in page) {
+      id title = nil;
+      id imagePath = nil;
+      id imageURL = nil;
+      getStrings(item, &title, &imagePath, &imageURL);
+
+      NIStoreString(&cursor, strings, stringReferences, title);
+      NIStoreString(&cursor, strings, stringReferences, imagePath);
+      NIStoreString(&cursor, strings, stringReferences, imageURL);
+    }
+  }
+  NIDASSERT((uint8_t *)cursor == (uint8_t *)[data mutableBytes] + recordsLength);
+
+  *stringsLength = CFSwapInt32HostToLittle([strings length]);
+  [data appendData:strings];
+
+  return data;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Compares string references in the archive by their offset and length.
+ *
+ * Two references may share an offset but not a length, such as a string and a prefix of it.
+ */
+static Boolean NIStringReferencesAreEqual(const void* first, const void* second) {
+  const NILauncherPagesArchiveString* firstReference = first;
+  const NILauncherPagesArchiveString* secondReference = second;
+  return (firstReference->offset == secondReference->offset
+          && firstReference->length == secondReference->length);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static CFHashCode NIStringReferenceHash(const void* value) {
+  const NILauncherPagesArchiveString* reference = value;
+  return (CFHashCode)reference->offset * 31 + reference->length;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static NSError* NIArchiveError(NILauncherPagesArchiveError code, NSString* description) {
+  return [NSError errorWithDomain: NILauncherPagesArchiveErrorDomain
+                             code: code
+                         userInfo: [NSDictionary dictionaryWithObject: description
+                                                               forKey: NSLocalizedDescriptionKey]];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILauncherPagesArchive
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+  NI_RELEASE_SAFELY(_data);
+  NI_RELEASE_SAFELY(_items);
+  if (NULL != _internedStrings) {
+    CFRelease(_internedStrings);
+    _internedStrings = NULL;
+  }
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSData *)dataWithPages:(NSArray *)pages {
+  return NILauncherPagesArchiveData(pages, NIGetItemDetailsStrings);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSData *)dataWithPageDictionaries:(NSArray *)pages {
+  return NILauncherPagesArchiveData(pages, NIGetDictionaryStrings);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (BOOL)writePages:(NSArray *)pages toFile:(NSString *)path error:(NSError **)error {
+  return [[self dataWithPages:pages] writeToFile: path
+                                         options: NSAtomicWrite
+                                           error: error];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithData:(NSData *)data error:(NSError **)error {
+  if ((self = [super init])) {
+    NSError* validationError = nil;
+    const uint8_t* bytes = [data bytes];
+    NSUInteger length = [data length];
+
+    if (length < sizeof(NILauncherPagesArchiveHeader)) {
+      validationError = NIArchiveError(NILauncherPagesArchiveErrorInvalidFormat,
+                                       @"The archive is too short to contain a header.");
+
+    } else {
+      const NILauncherPagesArchiveHeader* header = (const NILauncherPagesArchiveHeader *)bytes;
+      uint32_t version = CFSwapInt32LittleToHost(header->version);
+      _numberOfPages = CFSwapInt32LittleToHost(header->numberOfPages);
+      _numberOfItems = CFSwapInt32LittleToHost(header->numberOfItems);
+      _stringsLength = CFSwapInt32LittleToHost(header->stringsLength);
+
+      // Computed in 64 bits so that a corrupt header can't overflow the length check.
+      unsigned long long expectedLength =
+      (sizeof(NILauncherPagesArchiveHeader)
+       + (unsigned long long)_numberOfPages * sizeof(NILauncherPagesArchivePage)
+       + (unsigned long long)_numberOfItems * sizeof(NILauncherPagesArchiveItem)
+       + _stringsLength);
+
+      if (CFSwapInt32LittleToHost(header->magic) != kArchiveMagic) {
+        validationError = NIArchiveError(NILauncherPagesArchiveErrorInvalidFormat,
+                                         @"The data is not a launcher pages archive.");
+
+      } else if (version == 0 || version > NILauncherPagesArchiveCurrentVersion) {
+        validationError = NIArchiveError(NILauncherPagesArchiveErrorUnsupportedVersion,
+                                         @"The archive version is not supported.");
+
+      } else if ((unsigned long long)length < expectedLength) {
+        validationError = NIArchiveError(NILauncherPagesArchiveErrorInvalidFormat,
+                                         @"The archive is truncated.");
+
+      } else {
+        _pageRecords = bytes + sizeof(NILauncherPagesArchiveHeader);
+        _itemRecords = ((const uint8_t *)_pageRecords
+                        + _numberOfPages * sizeof(NILauncherPagesArchivePage));
+        _strings = ((const char *)_itemRecords
+                    + _numberOfItems * sizeof(NILauncherPagesArchiveItem));
+
+        // Make sure every page refers only to items that exist so that lookups don't need to.
+        const NILauncherPagesArchivePage* pageRecords = _pageRecords;
+        for (NSUInteger ixPage = 0; ixPage < _numberOfPages; ++ixPage) {
+          unsigned long long lastItem =
+          ((unsigned long long)CFSwapInt32LittleToHost(pageRecords[ixPage].firstItem)
+           + CFSwapInt32LittleToHost(pageRecords[ixPage].numberOfItems));
+          if (lastItem > _numberOfItems) {
+            validationError = NIArchiveError(NILauncherPagesArchiveErrorInvalidFormat,
+                                             @"The archive's page table is corrupt.");
+            break;
+          }
+        }
+      }
+    }
+
+    if (nil != validationError) {
+      if (nil != error) {
+        *error = validationError;
+      }
+      [self release];
+      return nil;
+    }
+
+    _data = [data retain];
+    _items = [[NSMutableDictionary alloc] init];
+
+    // Keyed by the string references in the item records, which live as long as the data.
+    CFDictionaryKeyCallBacks keyCallBacks;
+    memset(&keyCallBacks, 0, sizeof(keyCallBacks));
+    keyCallBacks.equal = &NIStringReferencesAreEqual;
+    keyCallBacks.hash = &NIStringReferenceHash;
+    _internedStrings = CFDictionaryCreateMutable(NULL, 0, &keyCallBacks,
+                                                 &kCFTypeDictionaryValueCallBacks);
+
+    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+    [nc addObserver: self
+           selector: @selector(didReceiveMemoryWarning:)
+               name: UIApplicationDidReceiveMemoryWarningNotification
+             object: nil];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithPageDictionaries:(NSArray *)pages {
+  // Freshly encoded data is always valid.
+  return [self initWithData:[[self class] dataWithPageDictionaries:pages] error:nil];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithContentsOfFile:(NSString *)path error:(NSError **)error {
+  // NSMappedRead maps the file into memory rather than reading it, so only the pages of the
+  // file that we touch are ever loaded from disk.
+  NSData* data = [[[NSData alloc] initWithContentsOfFile: path
+                                                 options: NSMappedRead
+                                                   error: error] autorelease];
+  if (nil == data) {
+    [self release];
+    return nil;
+  }
+  return [self initWithData:data error:error];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)numberOfPages {
+  return _numberOfPages;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The record for the given page, or NULL if the page is out of bounds.
+ */
+- (const NILauncherPagesArchivePage *)recordForPage:(NSInteger)page {
+  if (page < 0 || page >= (NSInteger)_numberOfPages) {
+    return NULL;
+  }
+  return (const NILauncherPagesArchivePage *)_pageRecords + page;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)numberOfItemsInPage:(NSInteger)page {
+  const NILauncherPagesArchivePage* pageRecord = [self recordForPage:page];
+  NIDASSERT(NULL != pageRecord);
+  if (NULL == pageRecord) {
+    return 0;
+  }
+  return CFSwapInt32LittleToHost(pageRecord->numberOfItems);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The string from the string table, or nil if the reference is nil or corrupt.
+ *
+ * Each string in the table is only created once, so items that share a string share the
+ * same object.
+ */
+- (NSString *)stringForReference:(const NILauncherPagesArchiveString *)reference {
+  uint32_t offset = CFSwapInt32LittleToHost(reference->offset);
+  uint32_t length = CFSwapInt32LittleToHost(reference->length);
+  if (kNilStringOffset == offset
+      || (unsigned long long)offset + length > _stringsLength) {
+    return nil;
+  }
+
+  // An empty string shares its offset with the string that follows it in the table.
+  if (0 == length) {
+    return @"";
+  }
+
+  NSString* string = (NSString *)CFDictionaryGetValue(_internedStrings, reference);
+  if (nil == string) {
+    string = [[NSString alloc] initWithBytes: _strings + offset
+                                      length: length
+                                    encoding: NSUTF8StringEncoding];
+    if (nil == string) {
+      return nil;
+    }
+    CFDictionarySetValue(_internedStrings, reference, string);
+    [string release];
+  }
+  return string;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NILauncherItemDetails *)itemDetailsForPage:(NSInteger)page atIndex:(NSInteger)index {
+  const NILauncherPagesArchivePage* pageRecord = [self recordForPage:page];
+  NSInteger numberOfItems = ((NULL != pageRecord)
+                             ? CFSwapInt32LittleToHost(pageRecord->numberOfItems)
+                             : 0);
+  NIDASSERT(index >= 0 && index < numberOfItems);
+  if (index < 0 || index >= numberOfItems) {
+    return nil;
+  }
+
+  NSUInteger ixItem = CFSwapInt32LittleToHost(pageRecord->firstItem) + index;
+  NSNumber* key = [NSNumber numberWithUnsignedInteger:ixItem];
+  NILauncherItemDetails* item = [_items objectForKey:key];
+  if (nil == item) {
+    const NILauncherPagesArchiveItem* record =
+    (const NILauncherPagesArchiveItem *)_itemRecords + ixItem;
+
+    NSString* title = [self stringForReference:&record->title];
+    NSString* imagePath = [self stringForReference:&record->imagePath];
+    item = [NILauncherItemDetails itemDetailsWithTitle:title imagePath:imagePath];
+    item.imageURL = [self stringForReference:&record->imageURL];
+    [_items setObject:item forKey:key];
+  }
+  return item;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)itemsForPage:(NSInteger)page {
+  NSInteger numberOfItems = [self numberOfItemsInPage:page];
+  NSMutableArray* items = [NSMutableArray arrayWithCapacity:numberOfItems];
+  for (NSInteger ixItem = 0; ixItem < numberOfItems; ++ixItem) {
+    [items addObject:[self itemDetailsForPage:page atIndex:ixItem]];
+  }
+  return items;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)pages {
+  NSMutableArray* pages = [NSMutableArray arrayWithCapacity:_numberOfPages];
+  for (NSInteger ixPage = 0; ixPage < (NSInteger)_numberOfPages; ++ixPage) {
+    [pages addObject:[self itemsForPage:ixPage]];
+  }
+  return pages;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryUsage {
+  // Every item and string can be created again from the archive's data.
+  [_items removeAllObjects];
+  CFDictionaryRemoveAllValues(_internedStrings);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Notifications
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+  [self reduceMemoryUsage];
+}
+
+
+@end
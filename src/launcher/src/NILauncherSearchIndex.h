@@ -0,0 +1,101 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NIPointerSet.h"
+#else
+#import "NIPointerSet.h"
+#endif
+
+@class NILauncherItemDetails;
+struct NILauncherSearchIndexEntry;
+
+/**
+ * @brief An index of launcher item titles for type-to-filter searches.
+ *
+ * @ingroup Launcher-User-Interface
+ *
+ * Titles are normalized by folding case, diacritics, and character widths and are split into
+ * words at every character that isn't a letter or digit. An item matches a search if every
+ * word of the search text is the start of one of the words in the item's title, so "caf"
+ * and "CAFÉ" both match "Café Menu".
+ *
+ * Every prefix of up to three characters of each title word maps to the set of items whose
+ * titles contain it. A search only checks the items under the rarest prefix of its words
+ * rather than every title. A search whose text extends the text of the previous search, as it
+ * does while the user types, only checks the previous search's matches.
+ *
+ * Items are added and removed one at a time, so the index can be kept up to date as pages
+ * change without being rebuilt. Items are identified by pointer and retained by the index.
+ * An item that is added more than once stays in the index until it has been removed as many
+ * times.
+ */
+@interface NILauncherSearchIndex : NSObject {
+@private
+  // Item slots are reused once their items have been removed.
+  struct NILauncherSearchIndexEntry* _entries;
+  NSUInteger            _numberOfSlots;
+  NSUInteger            _slotCapacity;
+  NSMutableIndexSet*    _freeSlots;
+  NIPointerSet*         _itemSlots;
+
+  NSMutableDictionary*  _prefixSlots; // NSDictionary< NSString(prefix), NSMutableIndexSet >
+
+  // The most recent search's normalized text and matching slots. Forgotten whenever the
+  // index changes.
+  NSString*             _lastSearchText;
+  NSIndexSet*           _lastMatchingSlots;
+}
+
+/**
+ * @brief Fold the case, diacritics, and widths of a string's characters for searching.
+ */
++ (NSString *)normalizedSearchString:(NSString *)string;
+
+/**
+ * @brief The number of distinct items in the index.
+ */
+@property (nonatomic, readonly, assign) NSUInteger count;
+
+/**
+ * @brief Index an item by its title.
+ */
+- (void)addItem:(NILauncherItemDetails *)item;
+
+/**
+ * @brief Remove an item that was added to the index.
+ */
+- (void)removeItem:(NILauncherItemDetails *)item;
+
+/**
+ * @brief Remove every item from the index.
+ */
+- (void)removeAllItems;
+
+/**
+ * @brief The items whose titles match the given search text.
+ *
+ * The result is a pointer set so that a launcher's items can be tested for membership in
+ * constant time while they are arranged in page order.
+ *
+ * @returns An empty set if the search text has no words.
+ */
+- (NIPointerSet *)itemsMatchingSearchText:(NSString *)searchText;
+
+@end
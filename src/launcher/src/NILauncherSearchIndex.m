@@ -0,0 +1,308 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#import "NILauncherSearchIndex.h"
+
+#import "NILauncherViewController.h"
+
+// Title words are indexed by each of their prefixes up to this length.
+static const NSUInteger kMaxIndexedPrefixLength = 3;
+
+static const NSUInteger kMinimumSlotCapacity = 16;
+
+struct NILauncherSearchIndexEntry {
+  NILauncherItemDetails*  item;   // Retained. nil if the slot is free.
+  NSArray*                words;  // Retained. The normalized words of the item's title.
+  NSUInteger              numberOfAdditions;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Split a normalized string into its words.
+ */
+static NSArray* NISearchWordsInString(NSString* normalizedString) {
+  static NSCharacterSet* sSeparators = nil;
+  if (nil == sSeparators) {
+    sSeparators = [[[NSCharacterSet alphanumericCharacterSet] invertedSet] retain];
+  }
+
+  NSArray* components = [normalizedString componentsSeparatedByCharactersInSet:sSeparators];
+  NSMutableArray* words = [NSMutableArray arrayWithCapacity:[components count]];
+  for (NSString* component in components) {
+    if ([component length] > 0) {
+      [words addObject:component];
+    }
+  }
+  return words;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Whether every search word starts one of the title words.
+ */
+static BOOL NISearchWordsMatchTitleWords(NSArray* searchWords, NSArray* titleWords) {
+  for (NSString* searchWord in searchWords) {
+    BOOL isFound = NO;
+    for (NSString* titleWord in titleWords) {
+      if ([titleWord hasPrefix:searchWord]) {
+        isFound = YES;
+        break;
+      }
+    }
+    if (!isFound) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILauncherSearchIndex
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [self removeAllItems];
+  free(_entries);
+  NI_RELEASE_SAFELY(_freeSlots);
+  NI_RELEASE_SAFELY(_itemSlots);
+  NI_RELEASE_SAFELY(_prefixSlots);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  if ((self = [super init])) {
+    _freeSlots = [[NSMutableIndexSet alloc] init];
+    _itemSlots = [[NIPointerSet alloc] init];
+    _prefixSlots = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NSString *)normalizedSearchString:(NSString *)string {
+  if (nil == string) {
+    return nil;
+  }
+
+  NSMutableString* normalizedString = [[string mutableCopy] autorelease];
+  CFStringFold((CFMutableStringRef)normalizedString,
+               (kCFCompareCaseInsensitive
+                | kCFCompareDiacriticInsensitive
+                | kCFCompareWidthInsensitive),
+               NULL);
+  return normalizedString;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSUInteger)count {
+  return [_itemSlots count];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)forgetLastSearch {
+  NI_RELEASE_SAFELY(_lastSearchText);
+  NI_RELEASE_SAFELY(_lastMatchingSlots);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief A free slot, growing the entries if there isn't one.
+ *
+ * @returns NSNotFound if the entries couldn't be grown.
+ */
+- (NSUInteger)takeFreeSlot {
+  NSUInteger slot = [_freeSlots firstIndex];
+  if (NSNotFound != slot) {
+    [_freeSlots removeIndex:slot];
+    return slot;
+  }
+
+  if (_numberOfSlots == _slotCapacity) {
+    NSUInteger capacity = MAX(kMinimumSlotCapacity, _slotCapacity * 2);
+    struct NILauncherSearchIndexEntry* entries =
+    realloc(_entries, capacity * sizeof(struct NILauncherSearchIndexEntry));
+    if (NULL == entries) {
+      return NSNotFound;
+    }
+    _entries = entries;
+    _slotCapacity = capacity;
+  }
+
+  return _numberOfSlots++;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)addItem:(NILauncherItemDetails *)item {
+  if (nil == item) {
+    return;
+  }
+
+  NSInteger existingSlot = 0;
+  if ([_itemSlots getValue:&existingSlot forPointer:item]) {
+    _entries[existingSlot].numberOfAdditions++;
+    return;
+  }
+
+  NSUInteger slot = [self takeFreeSlot];
+  if (NSNotFound == slot) {
+    return;
+  }
+
+  [self forgetLastSearch];
+
+  NSArray* words = NISearchWordsInString([[self class] normalizedSearchString:item.title]);
+  _entries[slot].item = [item retain];
+  _entries[slot].words = [words retain];
+  _entries[slot].numberOfAdditions = 1;
+  [_itemSlots addPointer:item withValue:slot];
+
+  for (NSString* word in words) {
+    NSUInteger maxPrefixLength = MIN(kMaxIndexedPrefixLength, [word length]);
+    for (NSUInteger prefixLength = 1; prefixLength <= maxPrefixLength; ++prefixLength) {
+      NSString* prefix = [word substringToIndex:prefixLength];
+      NSMutableIndexSet* slots = [_prefixSlots objectForKey:prefix];
+      if (nil == slots) {
+        slots = [[NSMutableIndexSet alloc] init];
+        [_prefixSlots setObject:slots forKey:prefix];
+        [slots release];
+      }
+      [slots addIndex:slot];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Remove a slot's item from the prefix sets and release it.
+ */
+- (void)clearSlot:(NSUInteger)slot {
+  for (NSString* word in _entries[slot].words) {
+    NSUInteger maxPrefixLength = MIN(kMaxIndexedPrefixLength, [word length]);
+    for (NSUInteger prefixLength = 1; prefixLength <= maxPrefixLength; ++prefixLength) {
+      NSString* prefix = [word substringToIndex:prefixLength];
+      NSMutableIndexSet* slots = [_prefixSlots objectForKey:prefix];
+      [slots removeIndex:slot];
+      if ([slots count] == 0) {
+        [_prefixSlots removeObjectForKey:prefix];
+      }
+    }
+  }
+
+  NI_RELEASE_SAFELY(_entries[slot].item);
+  NI_RELEASE_SAFELY(_entries[slot].words);
+  _entries[slot].numberOfAdditions = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeItem:(NILauncherItemDetails *)item {
+  NSInteger slot = 0;
+  if (nil == item || ![_itemSlots getValue:&slot forPointer:item]) {
+    return;
+  }
+
+  if (--_entries[slot].numberOfAdditions > 0) {
+    return;
+  }
+
+  [self forgetLastSearch];
+
+  [_itemSlots removePointer:item];
+  [self clearSlot:slot];
+  [_freeSlots addIndex:slot];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllItems {
+  [self forgetLastSearch];
+
+  for (NSUInteger slot = 0; slot < _numberOfSlots; ++slot) {
+    NI_RELEASE_SAFELY(_entries[slot].item);
+    NI_RELEASE_SAFELY(_entries[slot].words);
+  }
+  _numberOfSlots = 0;
+  [_freeSlots removeAllIndexes];
+  [_itemSlots removeAllPointers];
+  [_prefixSlots removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIPointerSet *)itemsMatchingSearchText:(NSString *)searchText {
+  NSString* normalizedText = [[self class] normalizedSearchString:searchText];
+  NSArray* searchWords = NISearchWordsInString(normalizedText);
+  if ([searchWords count] == 0) {
+    return [NIPointerSet pointerSet];
+  }
+
+  // The items under the rarest prefix are the only ones that can match.
+  NSIndexSet* candidateSlots = nil;
+  for (NSString* word in searchWords) {
+    NSString* prefix = [word substringToIndex:MIN(kMaxIndexedPrefixLength, [word length])];
+    NSIndexSet* slots = [_prefixSlots objectForKey:prefix];
+    if (nil == slots) {
+      candidateSlots = [NSIndexSet indexSet];
+      break;
+    }
+    if (nil == candidateSlots || [slots count] < [candidateSlots count]) {
+      candidateSlots = slots;
+    }
+  }
+
+  // Adding characters to a search can only remove matches.
+  if (nil != _lastSearchText && [normalizedText hasPrefix:_lastSearchText]
+      && [_lastMatchingSlots count] < [candidateSlots count]) {
+    candidateSlots = _lastMatchingSlots;
+  }
+
+  NSMutableIndexSet* matchingSlots = [NSMutableIndexSet indexSet];
+  NIPointerSet* matchingItems = [NIPointerSet pointerSet];
+  NSUInteger slot = [candidateSlots firstIndex];
+  while (NSNotFound != slot) {
+    if (NISearchWordsMatchTitleWords(searchWords, _entries[slot].words)) {
+      [matchingSlots addIndex:slot];
+      [matchingItems addPointer:_entries[slot].item];
+    }
+    slot = [candidateSlots indexGreaterThanIndex:slot];
+  }
+
+  [_lastSearchText release];
+  _lastSearchText = [normalizedText copy];
+  [_lastMatchingSlots release];
+  _lastMatchingSlots = [matchingSlots copy];
+
+  return matchingItems;
+}
+
+
+@end
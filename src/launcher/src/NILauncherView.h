@@ -19,8 +19,17 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NIPointerSet.h"
+#else
+#import "NIPointerSet.h"
+#endif
+
+@class NILauncherLayout;
+@class NILauncherLayoutOperation;
 @protocol NILauncherDelegate;
 @protocol NILauncherDataSource;
+@protocol NILauncherPrefetchingDataSource;
 
 /**
  * @brief Calculate the given field dynamically given the view and button dimensions.
@@ -31,10 +40,8 @@ extern const NSInteger NILauncherViewDynamic;
  * @brief A launcher view that simulates iOS' home screen launcher functionality.
  * @ingroup Launcher-User-Interface
  *
- * @todo Implement tap-and-hold editing for the launcher button ordering. The Three20
- * implementation can likely be learned from to implement this, though it's possible that
- * I could improve on it by writing it from scratch. Care needs to be taken with the fact
- * that launcher pages can scroll vertically now as well.
+ * Touching and holding a button puts the launcher in editing mode, in which the buttons can be
+ * dragged to new positions on any page. See the Editing methods below for details.
  */
 @interface NILauncherView : UIView <
   UIScrollViewDelegate
@@ -46,15 +53,84 @@ extern const NSInteger NILauncherViewDynamic;
 
   // Presentation Information
   NSInteger       _maxNumberOfButtonsPerPage;
+  NSInteger       _numberOfAdjacentPagesToLoad;
+  NSInteger       _maxNumberOfResidentPages;
+  NSInteger       _numberOfPagesToPrefetch;
+
+  // Set by a memory warning to load fewer neighbouring pages until the loading window is
+  // configured again.
+  BOOL            _isLimitedByMemoryWarning;
 
   // Display Information
   UIEdgeInsets    _padding;
 
+  // Cached Layout Information
+  // The layout is only recalculated when the scroll view's size or the padding changes.
+  BOOL                _isLayoutValid;
+  CGSize              _laidOutViewSize;
+  NILauncherLayout*   _layout;
+
+  // A layout calculated ahead of time on the layout queue, used instead of calculating a new
+  // layout if its parameters match.
+  NILauncherLayout*   _precomputedLayout;
+  NSOperationQueue*   _layoutQueue;
+  NILauncherLayoutOperation* _layoutOperation;
+
+  // Loaded pages, other than the current page, that are laid out in idle run loop passes after
+  // the layout metrics change.
+  NSMutableIndexSet*  _pagesNeedingDeferredLayout;
+  BOOL                _isDeferredLayoutScheduled;
+
   // Cached Data Source Information
   NSInteger       _numberOfPages;
-
-  NSMutableArray* _pagesOfButtons;      // NSArray< NSArray< UIButton *> >
-  NSMutableArray* _pagesOfScrollViews;  // NSArray< UIScrollView *>
+  BOOL            _dataSourceProvidesButtonDimensions;
+  BOOL            _dataSourceProvidesNumberOfRows;
+  BOOL            _dataSourceProvidesNumberOfColumns;
+  BOOL            _dataSourcePrefetches;
+
+  // Pages that have not been loaded are represented by NSNull.
+  NSMutableArray* _pagesOfButtons;      // NSArray< NSArray< UIButton *> | NSNull >
+  NSMutableArray* _pagesOfScrollViews;  // NSArray< UIScrollView * | NSNull >
+
+  // The location of every loaded button, used to resolve taps without searching the pages.
+  // Each button maps to its page and index packed into a single integer.
+  NIPointerSet*   _buttonIndexPaths;
+
+  // Buttons that have been removed from unloaded pages, keyed by reuse identifier.
+  NSMutableDictionary* _reusableButtons; // NSDictionary< NSString *, NSMutableArray< UIButton *> >
+
+  // Incremental Updates
+  NSInteger           _updateDepth;
+  NSMutableIndexSet*  _pagesNeedingLayout;
+
+  // Editing
+  // The dragged button is kept at its current slot in _pagesOfButtons while it follows the
+  // touch, so only the buttons between its old and new slots are moved.
+  BOOL                _isEditing;
+  NSTimer*            _longPressTimer;
+  UIButton*           _pressedButton;
+  UIButton*           _draggingButton;
+  NSInteger           _dragOriginPage;
+  NSInteger           _dragOriginIndex;
+  NSInteger           _dragPage;
+  NSInteger           _dragIndex;
+  CGPoint             _dragTouchPoint;    // In the launcher view's coordinates.
+  CGPoint             _dragTouchOffset;   // From the touch to the dragged button's center.
+  NSTimer*            _editingPageTimer;
+  NSInteger           _editingPageDirection;
+
+  // Filtering
+  // The data source index paths of the buttons shown while filtering, packed into pages.
+  NSArray*            _filteredIndexPaths;
+  NSInteger           _numberOfButtonsPerFilteredPage;
+  NSInteger           _pageBeforeFiltering;
+
+  // Prefetching
+  NSInteger           _firstLoadedPage;
+  NSInteger           _lastLoadedPage;
+  CGFloat             _lastContentOffsetX;
+  NSTimeInterval      _lastScrollTime;
+  NSMutableIndexSet*  _prefetchedPages;
 
   // Protocols
   id<NILauncherDelegate>    _delegate;
@@ -68,12 +144,55 @@ extern const NSInteger NILauncherViewDynamic;
  */
 @property (nonatomic, readwrite, assign) NSInteger maxNumberOfButtonsPerPage;
 
+/**
+ * @brief The number of pages on either side of the visible pages that are kept loaded.
+ *
+ * Pages outside of this window are not requested from the data source and have no views in
+ * the view hierarchy. As the user scrolls, pages are loaded and unloaded so that only the
+ * visible pages and their neighbours are materialized. This keeps the cost of reloadData
+ * proportional to the window instead of the total number of pages.
+ *
+ * A value of 1, for example, keeps at most three pages loaded when scrolling has settled.
+ *
+ * By default this value is NSIntegerMax, meaning every page is loaded.
+ */
+@property (nonatomic, readwrite, assign) NSInteger numberOfAdjacentPagesToLoad;
+
+/**
+ * @brief The maximum number of pages that are kept loaded at once.
+ *
+ * The window of loaded pages determined by numberOfAdjacentPagesToLoad is trimmed to this many
+ * pages, keeping the visible pages and as many of their neighbours on each side as fit. This
+ * bounds the number of buttons, and therefore images, that the launcher holds regardless of the
+ * total number of pages. The visible pages are always loaded, even if there are more of them
+ * than the budget allows while scrolling between two pages.
+ *
+ * Must be at least 1. By default this value is NSIntegerMax, meaning that only
+ * numberOfAdjacentPagesToLoad limits the number of loaded pages.
+ */
+@property (nonatomic, readwrite, assign) NSInteger maxNumberOfResidentPages;
+
+/**
+ * @brief The number of pages beyond the loaded pages that the data source is asked to prefetch.
+ *
+ * Only used if the data source implements NILauncherPrefetchingDataSource. While the user
+ * scrolls, the pages just past the loaded pages in the direction of the scroll are handed to
+ * the data source so that it can begin preparing their items and images before the pages are
+ * loaded. Faster scrolls prefetch up to twice as many pages. Pages that fall out of the
+ * prefetch window before they are loaded are cancelled.
+ *
+ * By default this value is 2.
+ */
+@property (nonatomic, readwrite, assign) NSInteger numberOfPagesToPrefetch;
+
 /**
  * @brief The amount of padding on each side of the launcher view pages.
  *
  * The bottom padding is considered above the page control.
  *
  * Default values are 10 pixels of padding on all sides.
+ *
+ * Changing the padding lays out the loaded pages again.
  */
 @property (nonatomic, readwrite, assign) UIEdgeInsets padding;
 
@@ -84,6 +203,9 @@ extern const NSInteger NILauncherViewDynamic;
 
 /**
  * @brief The launcher view populates its pages with information from the data source.
+ *
+ * If the data source also implements NILauncherPrefetchingDataSource it is told which pages are
+ * about to be loaded while the user scrolls.
  */
 @property (nonatomic, readwrite, assign) id<NILauncherDataSource> dataSource;
 
@@ -93,16 +215,204 @@ extern const NSInteger NILauncherViewDynamic;
  * This will release all of the launcher's buttons and call all necessary data source methods
  * again.
  *
- * Unlike the UITableView's reloadData, this is not a cheap method to call.
+ * Unlike the UITableView's reloadData, this is not a cheap method to call unless
+ * numberOfAdjacentPagesToLoad limits the number of pages that are loaded.
+ *
+ * The button dimensions and the number of rows and columns are only requested from the data
+ * source when the launcher's size changes or when this method is called. Call this method
+ * if the data source's answers change for any other reason.
+ *
+ * The current page is kept if it still exists, and the current page is scrolled so that the
+ * row that was at the top of the page remains at the top.
  */
 - (void)reloadData;
 
+/**
+ * @brief Returns a reusable button object located by its identifier.
+ *
+ * Much like UITableView's dequeueReusableCellWithIdentifier:, you should call this method from
+ * your data source's launcherView:buttonForPage:atIndex: implementation before allocating a new
+ * button.
+ *
+ * Buttons are added to the reuse queue when their page is unloaded, either because it has
+ * scrolled outside of the window of loaded pages or because the launcher is being reloaded.
+ * Only buttons that implement the NILauncherReusableButton protocol and have a non-nil
+ * reuseIdentifier are queued for reuse.
+ *
+ * @param identifier  The reuse identifier of the button to dequeue.
+ * @returns A button with the given identifier, or nil if there are no buttons in the queue.
+ */
+- (UIButton *)dequeueReusableButtonWithIdentifier:(NSString *)identifier;
+
+/**
+ * @brief The loaded button at the given page and index.
+ *
+ * Use this to update a button that is already displayed, such as its badge, without asking the
+ * data source for it again.
+ *
+ * @returns nil if the button's page isn't loaded or the index is beyond the loaded buttons.
+ */
+- (UIButton *)buttonForPage:(NSInteger)page atIndex:(NSInteger)index;
+
+/**
+ * @brief The index of the page that is currently displayed.
+ */
+- (NSInteger)currentPage;
+
+/**
+ * @brief Scroll to the given page, as though the user had tapped the page control.
+ *
+ * @param page      The page to show. Clamped to the number of pages.
+ * @param animated  YES to animate the scroll.
+ */
+- (void)setCurrentPage:(NSInteger)page animated:(BOOL)animated;
+
+/**
+ * @brief Release every page that isn't visible and empty the reuse queue.
+ *
+ * Prefetching is cancelled, and from then on at most one page on either side of the visible
+ * pages is loaded until numberOfAdjacentPagesToLoad or maxNumberOfResidentPages is set again.
+ * Released pages are requested from the data source again as they are scrolled back into
+ * view. Pages that are needed by a button being dragged are kept.
+ *
+ * Called automatically when the application receives a memory warning.
+ */
+- (void)reduceMemoryUsage;
+
+
+/**
+ * @name Incremental Updates
+ * The following methods update individual buttons without reloading the entire launcher.
+ *
+ * Index paths are created with NSIndexPath's indexPathForRow:inSection:, where the section is
+ * the page and the row is the button's index within that page.
+ *
+ * The data source must reflect the change before any of these methods are called. Only pages
+ * that are currently loaded request new buttons from the data source and are laid out again;
+ * unloaded pages will pick up the changes when they are next loaded.
+ * @{
+ */
+#pragma mark Incremental Updates
+
+/**
+ * @brief Begin a series of method calls that insert, delete, move, or reload buttons.
+ *
+ * Pages touched by the updates are only laid out once the matching endUpdates is called.
+ * Calls to beginUpdates and endUpdates may be nested.
+ *
+ * Unlike UITableView, updates within a begin/end block are applied in the order that they are
+ * made, so the index paths given to each call must reflect the updates made before it.
+ */
+- (void)beginUpdates;
+
+/**
+ * @brief Conclude a series of method calls that insert, delete, move, or reload buttons.
+ *
+ * The number of pages is re-queried from the data source and every touched page is laid out.
+ */
+- (void)endUpdates;
+
+/**
+ * @brief Insert buttons at the locations identified by the given index paths.
+ *
+ * Index paths refer to the positions of the buttons after they have been inserted.
+ */
+- (void)insertButtonsAtIndexPaths:(NSArray *)indexPaths;
+
+/**
+ * @brief Delete the buttons at the locations identified by the given index paths.
+ *
+ * Index paths refer to the positions of the buttons before any of them are deleted.
+ */
+- (void)deleteButtonsAtIndexPaths:(NSArray *)indexPaths;
+
+/**
+ * @brief Move the button at the given index path to a new location.
+ *
+ * The button object is preserved if both pages are loaded.
+ */
+- (void)moveButtonAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath;
+
+/**
+ * @brief Replace the buttons at the given index paths with new buttons from the data source.
+ *
+ * The replaced buttons are placed in the reuse queue before the data source is asked for new
+ * ones, so a data source that dequeues buttons will often receive the same button back.
+ */
+- (void)reloadButtonsAtIndexPaths:(NSArray *)indexPaths;
+
+/**@}*/
+
+
+/**
+ * @name Editing
+ * The following methods control the launcher's editing mode, in which buttons can be dragged
+ * to new positions.
+ *
+ * Editing begins when the user touches and holds a button, provided the delegate implements
+ * launcherView:didMoveButton:fromPage:atIndex:toPage:atIndex: and doesn't refuse with
+ * launcherViewShouldBeginEditing:. While editing, touching a button picks it up immediately
+ * and taps are not reported to the delegate.
+ *
+ * As a button is dragged, only the buttons between its old and new positions are moved out of
+ * its way. Holding the button near the left or right edge of the launcher scrolls to the
+ * neighbouring page, where it may be dropped in any page that has room for it. Pages aren't
+ * unloaded while a button is being dragged, so the pages touched by the drag are the only ones
+ * that disagree with the data source until the button is dropped.
+ *
+ * Incremental updates and reloads should not be made while a button is being dragged; a reload
+ * drops the button without reporting its move.
+ * @{
+ */
+#pragma mark Editing
+
+/**
+ * @brief Whether the launcher is in editing mode.
+ *
+ * Ending editing drops any button that is being dragged. The delegate is told when editing
+ * begins and ends, whether by the user or by setting this property.
+ */
+@property (nonatomic, readwrite, assign, getter=isEditing) BOOL editing;
+
+/**@}*/
+
+
+/**
+ * @name Filtering
+ * The following methods show a subset of the data source's buttons, such as the results of a
+ * search.
+ * @{
+ */
+#pragma mark Filtering
+
+/**
+ * @brief The data source index paths of the only buttons to show, in the order to show them.
+ *
+ * The buttons are packed into as few pages as possible, filling each page's grid before
+ * starting the next, and the launcher scrolls to the first page. Buttons are requested from
+ * the data source at their original index paths, and taps are reported to the delegate with
+ * them too. Setting nil shows every button again and returns to the page that was shown
+ * before filtering began.
+ *
+ * Setting new index paths only loads the buttons on the visible pages and their neighbours,
+ * most of which come from the reuse queue, so the filter can be updated on every keystroke.
+ *
+ * While filtering, editing is ended and can't begin, the prefetching data source is not asked
+ * to prefetch, and launcherView:didUnloadPage: is not sent. Make incremental updates by setting
+ * new filtered index paths rather than with the incremental update methods. Defaults to nil.
+ */
+@property (nonatomic, readwrite, copy) NSArray* filteredIndexPaths;
+
+/**@}*/
+
 /**
  * @brief Lays out the subviews for this launcher view.
  *
  * If you subclass this view and implement setFrame, you should either replicate the
  * functionality found within or call [super setFrame:].
  *
+ * Nothing is laid out again if only the origin of the frame changes.
+ *
  * @note Subviews are laid out in this method instead of layoutSubviews due to the fact that the
  * scroll view offset and content size are modified within this method. If we modify these values
  * in layoutSubviews then we will end up breaking the scroll view because whenever the user drags
@@ -110,6 +420,55 @@ extern const NSInteger NILauncherViewDynamic;
  */
 - (void)setFrame:(CGRect)frame;
 
+/**
+ * @brief Calculate the layout for the given frame on a background thread.
+ *
+ * Call this before the launcher is given a new size, for example with the frame it will have
+ * in the other orientation once the view has appeared. When the frame is later set and the
+ * layout parameters still match, the precomputed button frames are assigned directly rather
+ * than being calculated on the main thread during the rotation.
+ *
+ * The data source is asked for its button dimensions now. The number of rows and columns
+ * must be the values that the data source will return once the launcher has the given frame,
+ * or NILauncherViewDynamic if the data source doesn't provide them.
+ *
+ * The layout that is replaced by a new size is kept as well, so rotating back is also cheap.
+ * A precomputed layout that doesn't match is simply ignored.
+ */
+- (void)precomputeLayoutForFrame: (CGRect)frame
+                    numberOfRows: (NSInteger)numberOfRows
+                 numberOfColumns: (NSInteger)numberOfColumns;
+
+@end
+
+
+/**
+ * @brief A button that can be reused by the launcher view once its page has been unloaded.
+ * @ingroup Launcher-Protocols
+ *
+ * Buttons that implement this protocol are placed in the launcher view's reuse queue and may
+ * be retrieved with NILauncherView::dequeueReusableButtonWithIdentifier:.
+ */
+@protocol NILauncherReusableButton <NSObject>
+
+@required
+
+/**
+ * @brief The identifier used to dequeue this button for reuse.
+ *
+ * If this is nil the button will not be reused.
+ */
+- (NSString *)reuseIdentifier;
+
+@optional
+
+/**
+ * @brief Called when the button is placed in the reuse queue.
+ *
+ * Use this method to reset any state that should not carry over to the button's next use.
+ */
+- (void)prepareForReuse;
+
 @end
 
 
@@ -129,6 +488,48 @@ extern const NSInteger NILauncherViewDynamic;
               onPage: (NSInteger)page
              atIndex: (NSInteger)index;
 
+/**
+ * @brief Called after a page's buttons have been removed from the launcher view.
+ *
+ * Pages are unloaded when they scroll outside of the window of loaded pages and when the
+ * launcher is reloaded. Any data kept only to populate the page's buttons may be released.
+ */
+- (void)launcherView:(NILauncherView *)launcher didUnloadPage:(NSInteger)page;
+
+/**
+ * @brief Asked before the user's touch and hold puts the launcher in editing mode.
+ *
+ * Return NO to keep the launcher from being edited, for example when its pages can't be
+ * rearranged. Not called when the editing property is set directly.
+ */
+- (BOOL)launcherViewShouldBeginEditing:(NILauncherView *)launcher;
+
+/**
+ * @brief Called after the launcher enters editing mode.
+ */
+- (void)launcherViewDidBeginEditing:(NILauncherView *)launcher;
+
+/**
+ * @brief Called after the launcher leaves editing mode.
+ */
+- (void)launcherViewDidEndEditing:(NILauncherView *)launcher;
+
+/**
+ * @brief Called when the user drops a button at a new position.
+ *
+ * The launcher view has already moved the button, so the data source must be updated to match
+ * without telling the launcher view about the change. The index on the new page is the
+ * button's index after it has been removed from its old position.
+ *
+ * The user can only begin editing if the delegate implements this method.
+ */
+- (void)launcherView: (NILauncherView *)launcher
+       didMoveButton: (UIButton *)button
+            fromPage: (NSInteger)fromPage
+             atIndex: (NSInteger)fromIndex
+              toPage: (NSInteger)toPage
+             atIndex: (NSInteger)toIndex;
+
 @end
 
 
@@ -183,3 +584,35 @@ extern const NSInteger NILauncherViewDynamic;
                    atIndex: (NSInteger)index;
 
 @end
+
+
+/**
+ * @brief A launcher data source that prepares pages before they are loaded.
+ * @ingroup Launcher-Protocols
+ *
+ * The launcher view only asks its data source for buttons once a page comes within
+ * numberOfAdjacentPagesToLoad of the visible page. A fast swipe can outrun any work started at
+ * that point, such as loading images, which leaves blank buttons on screen. Data sources that
+ * implement this protocol are told which pages are likely to be loaded next, based on the
+ * direction and speed of the scroll, so that the work can be started early.
+ *
+ * Pages are never both loaded and prefetching; a prefetched page that gets loaded is simply
+ * requested from the data source as usual and is not cancelled.
+ */
+@protocol NILauncherPrefetchingDataSource <NILauncherDataSource>
+
+@required
+
+/**
+ * @brief Begin preparing the items on the given pages.
+ */
+- (void)launcherView:(NILauncherView *)launcherView prefetchItemsForPages:(NSIndexSet *)pages;
+
+/**
+ * @brief The given pages are no longer expected to be loaded soon.
+ *
+ * Cancel any work begun in launcherView:prefetchItemsForPages: for these pages.
+ */
+- (void)launcherView:(NILauncherView *)launcherView cancelPrefetchingForPages:(NSIndexSet *)pages;
+
+@end
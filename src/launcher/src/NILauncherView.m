@@ -18,17 +18,153 @@
 
 #import "NILauncherView.h"
 
+#import "NILauncherLayout.h"
+
 const NSInteger NILauncherViewDynamic = -1;
 
 static const CGFloat kDefaultButtonDimensions = 80;
 static const CGFloat kDefaultPadding          = 10;
 static const NSTimeInterval kAnimateToPageDuration = 0.2;
+static const NSInteger kDefaultNumberOfPagesToPrefetch = 2;
+
+// The number of neighbouring pages on each side that are loaded after a memory warning.
+static const NSInteger kNumberOfAdjacentPagesToLoadAfterMemoryWarning = 1;
+
+// The number of offscreen pages laid out in each idle run loop pass after the layout changes.
+static const NSInteger kNumberOfDeferredPagesToLayOutPerPass = 2;
+
+// Scroll events further apart than this are not used to estimate the scroll velocity.
+static const NSTimeInterval kMaxScrollVelocitySampleInterval = 0.5;
+
+// The number of low bits of a packed button index path that hold the button's index.
+static const NSInteger kButtonIndexBits = 16;
+
+// Editing
+static const NSTimeInterval kLongPressDuration = 0.5;
+static const CGFloat kLongPressAllowableMovement = 10;
+static const NSTimeInterval kEditingAnimationDuration = 0.2;
+static const CGFloat kDraggingButtonScale = 1.2;
+static const CGFloat kDraggingButtonAlpha = 0.8;
+// Holding a dragged button this close to the left or right edge scrolls to the next page.
+static const CGFloat kEditingPageEdgeWidth = 20;
+static const NSTimeInterval kEditingPageDelay = 0.6;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static NSInteger NIPackButtonIndexPath(NSInteger page, NSInteger index) {
+  NIDASSERT(index >= 0 && index < (1 << kButtonIndexBits));
+  return (page << kButtonIndexBits) | index;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 @interface NILauncherView()
 
 - (void)layoutPages;
+- (void)layoutLoadedPage:(NSInteger)ixPage;
+- (UIScrollView *)scrollViewForPage:(NSInteger)page;
+- (void)layoutPage:(NSInteger)ixPage;
+- (void)layoutLoadedPagesStartingWithPage:(NSInteger)firstPage;
+- (NSInteger)anchorItemForPage:(NSInteger)page;
+- (void)scrollPage:(NSInteger)page toAnchorItem:(NSInteger)anchorItem;
+- (void)updateLoadedPages;
+- (void)enqueueReusableButton:(UIButton *)button;
+- (void)layoutOperationDidFinish:(NILauncherLayoutOperation *)operation;
+- (void)cancelLongPress;
+- (NSInteger)numberOfButtonsPerFilteredPage;
+- (void)updateDraggingButtonSlot;
+- (void)dropDraggingButtonAndReportMove:(BOOL)reportMove;
+- (void)moveDraggingButtonToPage:(NSInteger)ixPage index:(NSInteger)ixItem;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Calculates a launcher layout on a background thread.
+ *
+ * The result is handed back to the launcher view on the main thread.
+ */
+@interface NILauncherLayoutOperation : NSOperation {
+@private
+  NILauncherLayoutParameters  _parameters;
+  NSInteger                   _numberOfButtonFrames;
+  NILauncherLayout*           _layout;
+  NILauncherView*             _launcherView;
+}
+
+- (id)initWithParameters: (NILauncherLayoutParameters)parameters
+    numberOfButtonFrames: (NSInteger)numberOfButtonFrames;
+
+// The calculated layout. Only valid once the operation has finished.
+@property (nonatomic, readonly, retain) NILauncherLayout* layout;
+
+// Only accessed from the main thread. Set to nil before cancelling the operation.
+@property (nonatomic, readwrite, assign) NILauncherView* launcherView;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILauncherLayoutOperation
+
+@synthesize layout        = _layout;
+@synthesize launcherView  = _launcherView;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_layout);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithParameters: (NILauncherLayoutParameters)parameters
+    numberOfButtonFrames: (NSInteger)numberOfButtonFrames {
+  if ((self = [super init])) {
+    _parameters = parameters;
+    _numberOfButtonFrames = numberOfButtonFrames;
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didFinishLayout {
+  if (![self isCancelled]) {
+    [_launcherView layoutOperationDidFinish:self];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)main {
+  NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+  NI_TRACE_BEGIN("NILauncherLayoutOperation");
+
+  if (![self isCancelled]) {
+    _layout = [[NILauncherLayout alloc] initWithParameters: _parameters
+                                      numberOfButtonFrames: _numberOfButtonFrames];
+
+    if (![self isCancelled]) {
+      [self performSelectorOnMainThread: @selector(didFinishLayout)
+                             withObject: nil
+                          waitUntilDone: NO];
+    }
+  }
+
+  NI_TRACE_END("NILauncherLayoutOperation");
+
+  [pool release];
+}
+
 
 @end
 
@@ -39,8 +175,12 @@ static const NSTimeInterval kAnimateToPageDuration = 0.2;
 @implementation NILauncherView
 
 @synthesize maxNumberOfButtonsPerPage = _maxNumberOfButtonsPerPage;
+@synthesize numberOfAdjacentPagesToLoad = _numberOfAdjacentPagesToLoad;
+@synthesize maxNumberOfResidentPages = _maxNumberOfResidentPages;
+@synthesize numberOfPagesToPrefetch = _numberOfPagesToPrefetch;
 
 @synthesize padding = _padding;
+@synthesize editing = _isEditing;
 
 @synthesize delegate    = _delegate;
 @synthesize dataSource  = _dataSource;
@@ -48,10 +188,25 @@ static const NSTimeInterval kAnimateToPageDuration = 0.2;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+
   NI_RELEASE_SAFELY(_pager);
   NI_RELEASE_SAFELY(_scrollView);
   NI_RELEASE_SAFELY(_pagesOfButtons);
   NI_RELEASE_SAFELY(_pagesOfScrollViews);
+  NI_RELEASE_SAFELY(_buttonIndexPaths);
+  NI_RELEASE_SAFELY(_reusableButtons);
+  NI_RELEASE_SAFELY(_pagesNeedingLayout);
+  NI_RELEASE_SAFELY(_pagesNeedingDeferredLayout);
+  NI_RELEASE_SAFELY(_prefetchedPages);
+  _layoutOperation.launcherView = nil;
+  [_layoutOperation cancel];
+  NI_RELEASE_SAFELY(_layoutOperation);
+  NI_RELEASE_SAFELY(_layoutQueue);
+  NI_RELEASE_SAFELY(_layout);
+  NI_RELEASE_SAFELY(_precomputedLayout);
+  NI_RELEASE_SAFELY(_draggingButton);
+  NI_RELEASE_SAFELY(_filteredIndexPaths);
 
   [super dealloc];
 }
@@ -61,6 +216,15 @@ static const NSTimeInterval kAnimateToPageDuration = 0.2;
 - (id)initWithFrame:(CGRect)frame {
   if ((self = [super initWithFrame:frame])) {
     _maxNumberOfButtonsPerPage = NSIntegerMax;
+    _numberOfAdjacentPagesToLoad = NSIntegerMax;
+    _maxNumberOfResidentPages = NSIntegerMax;
+    _buttonIndexPaths = [[NIPointerSet alloc] init];
+    _reusableButtons = [[NSMutableDictionary alloc] init];
+    _pagesNeedingLayout = [[NSMutableIndexSet alloc] init];
+    _pagesNeedingDeferredLayout = [[NSMutableIndexSet alloc] init];
+    _numberOfPagesToPrefetch = kDefaultNumberOfPagesToPrefetch;
+    _prefetchedPages = [[NSMutableIndexSet alloc] init];
+    _lastLoadedPage = -1;
     _padding = UIEdgeInsetsMake(kDefaultPadding, kDefaultPadding,
                                 kDefaultPadding, kDefaultPadding);
 
@@ -100,6 +264,12 @@ static const NSTimeInterval kAnimateToPageDuration = 0.2;
      forControlEvents: UIControlEventValueChanged];
 
     [self addSubview:_pager];
+
+    NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+    [nc addObserver: self
+           selector: @selector(didReceiveMemoryWarning:)
+               name: UIApplicationDidReceiveMemoryWarningNotification
+             object: nil];
   }
   return self;
 }
@@ -124,6 +294,27 @@ static const NSTimeInterval kAnimateToPageDuration = 0.2;
 - (void)setFrame:(CGRect)frame {
   [super setFrame:frame];
 
+  // UIView calls setFrame: from initWithFrame: before our subviews exist. Nothing gets laid out
+  // then, so the size must not be recorded as laid out either.
+  if (nil == _scrollView) {
+    return;
+  }
+
+  if (CGSizeEqualToSize(_laidOutViewSize, frame.size)) {
+    // Only the origin has changed, so none of our subviews need to move.
+    return;
+  }
+  _laidOutViewSize = frame.size;
+
+  // The grid is about to change under the dragged button.
+  if (nil != _draggingButton) {
+    [self dropDraggingButtonAndReportMove:YES];
+  }
+
+  // The layout hasn't been replaced yet, so this is the row at the top of the page before the
+  // size changed.
+  NSInteger anchorItem = [self anchorItemForPage:_pager.currentPage];
+
   // Lay out the pager first. The remaining space is used for the launcher scroll view.
   [_pager sizeToFit];
   _pager.frame = CGRectMake(0, self.frame.size.height - _pager.frame.size.height,
@@ -148,14 +339,44 @@ static const NSTimeInterval kAnimateToPageDuration = 0.2;
                                           * _pager.currentPage,
                                           0);
 
-  // The dimensions of the scroll view may have changed, so lay out all of the pages.
+  // The dimensions of the scroll view may have changed, so lay out all of the pages. Only the
+  // current page is laid out now; the rest follow once the run loop is idle.
   [self layoutPages];
+  [self scrollPage:_pager.currentPage toAnchorItem:anchorItem];
+
+  // A different number of filtered buttons fits on each page now.
+  if (nil != _filteredIndexPaths
+      && [self numberOfButtonsPerFilteredPage] != _numberOfButtonsPerFilteredPage) {
+    [self reloadData];
+  }
 
   // Example: When switching from a 3x4 grid of 12 items to a 5x2 grid of 10, there will be
   // leftover items and the page will be too tall to fit everything as a result. We flash
   // the scroll indicators when this happens to indicate to the user that some buttons have been
   // hidden.
-  [[_pagesOfScrollViews objectAtIndex:_pager.currentPage] flashScrollIndicators];
+  [[self scrollViewForPage:_pager.currentPage] flashScrollIndicators];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Returns YES if the given page's buttons and scroll view have been loaded.
+ */
+- (BOOL)isPageLoaded:(NSInteger)page {
+  return (page >= 0 && page < [_pagesOfButtons count]
+          && [NSNull null] != [_pagesOfButtons objectAtIndex:page]);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The scroll view for the given page, or nil if the page has not been loaded.
+ */
+- (UIScrollView *)scrollViewForPage:(NSInteger)page {
+  if (![self isPageLoaded:page]) {
+    return nil;
+  }
+  return [_pagesOfScrollViews objectAtIndex:page];
 }
 
 
@@ -171,316 +392,1884 @@ static const NSTimeInterval kAnimateToPageDuration = 0.2;
   if (_pager.currentPage != pageIndex) {
     _pager.currentPage = pageIndex;
 
-    [[_pagesOfScrollViews objectAtIndex:pageIndex] flashScrollIndicators];
+    [[self scrollViewForPage:pageIndex] flashScrollIndicators];
   }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)calculateLayoutForFrame: (CGRect)frame
-               buttonDimensions: (CGSize *)pButtonDimensions
-                   numberOfRows: (NSInteger *)pNumberOfRows
-                numberOfColumns: (NSInteger *)pNumberOfColumns
-        buttonHorizontalSpacing: (CGFloat *)pButtonHorizontalSpacing
-          buttonVerticalSpacing: (CGFloat *)pButtonVerticalSpacing {
-  NIDASSERT(nil != pButtonDimensions);
-  NIDASSERT(nil != pNumberOfRows);
-  NIDASSERT(nil != pNumberOfColumns);
-  NIDASSERT(nil != pButtonHorizontalSpacing);
-  NIDASSERT(nil != pButtonVerticalSpacing);
-  if (nil == pButtonDimensions
-      || nil == pNumberOfRows
-      || nil == pNumberOfColumns
-      || nil == pButtonHorizontalSpacing
-      || nil == pButtonVerticalSpacing) {
-    return;
-  }
-  CGFloat pageWidth = frame.size.width - _padding.left - _padding.right;
-  CGFloat pageHeight = frame.size.height - _padding.top - _padding.bottom;
-
-  CGSize buttonDimensions = CGSizeMake(kDefaultButtonDimensions, kDefaultButtonDimensions);
-  if ([self.dataSource respondsToSelector:@selector(buttonDimensionsInLauncherView:)]) {
+/**
+ * @brief The parameters for laying out pages of the given size with the given grid.
+ *
+ * Asks the data source for its button dimensions, so this must be called on the main thread.
+ */
+- (NILauncherLayoutParameters)layoutParametersForPageSize: (CGSize)pageSize
+                                             numberOfRows: (NSInteger)numberOfRows
+                                          numberOfColumns: (NSInteger)numberOfColumns {
+  NILauncherLayoutParameters parameters;
+  parameters.pageSize = pageSize;
+  parameters.padding = _padding;
+  parameters.buttonDimensions = CGSizeMake(kDefaultButtonDimensions, kDefaultButtonDimensions);
+  parameters.numberOfRows = numberOfRows;
+  parameters.numberOfColumns = numberOfColumns;
+
+  if (_dataSourceProvidesButtonDimensions) {
     CGSize dataSourceButtonDimensions = [self.dataSource buttonDimensionsInLauncherView:self];
 
     NIDASSERT(dataSourceButtonDimensions.width > 0 && dataSourceButtonDimensions.height > 0);
     if (dataSourceButtonDimensions.width > 0 && dataSourceButtonDimensions.height > 0) {
-      buttonDimensions = dataSourceButtonDimensions;
+      parameters.buttonDimensions = dataSourceButtonDimensions;
     }
   }
 
+  return parameters;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The parameters for laying out pages of the given size as the data source has them now.
+ */
+- (NILauncherLayoutParameters)layoutParametersForPageSize:(CGSize)pageSize {
   NSInteger numberOfColumns = NILauncherViewDynamic;
   NSInteger numberOfRows = NILauncherViewDynamic;
 
-  if ([self.dataSource respondsToSelector:@selector(numberOfColumnsPerPageInLauncherView:)]) {
+  if (_dataSourceProvidesNumberOfColumns) {
     numberOfColumns = [self.dataSource numberOfColumnsPerPageInLauncherView:self];
   }
-  if ([self.dataSource respondsToSelector:@selector(numberOfRowsPerPageInLauncherView:)]) {
+  if (_dataSourceProvidesNumberOfRows) {
     numberOfRows = [self.dataSource numberOfRowsPerPageInLauncherView:self];
   }
 
-  if (NILauncherViewDynamic == numberOfColumns) {
-    numberOfColumns = floorf(pageWidth / buttonDimensions.width);
+  return [self layoutParametersForPageSize: pageSize
+                              numberOfRows: numberOfRows
+                           numberOfColumns: numberOfColumns];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The number of buttons on the fullest loaded page.
+ *
+ * Layouts calculate this many button frames up front.
+ */
+- (NSInteger)maxNumberOfButtonsOnLoadedPages {
+  NSInteger maxNumberOfButtons = 0;
+  for (id page in _pagesOfButtons) {
+    if ([NSNull null] != page) {
+      maxNumberOfButtons = MAX(maxNumberOfButtons, (NSInteger)[page count]);
+    }
   }
-  if (NILauncherViewDynamic == numberOfRows) {
-    numberOfRows = floorf(pageHeight / buttonDimensions.height);
+  return maxNumberOfButtons;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Replace the layout if the scroll view's size has changed or the layout was invalidated.
+ *
+ * A precomputed layout with matching parameters is used as is. Otherwise the layout is
+ * calculated now. The layout being replaced becomes the precomputed layout, so returning to
+ * the previous size doesn't need a new layout either.
+ *
+ * @returns YES if the layout was replaced, in which case every loaded page needs to be laid out
+ *          again.
+ */
+- (BOOL)updateLayoutMetricsIfNeeded {
+  CGSize frameSize = _scrollView.frame.size;
+  if (_isLayoutValid && CGSizeEqualToSize(frameSize, _layout.parameters.pageSize)) {
+    return NO;
   }
-  NIDASSERT(numberOfRows > 0);
-  NIDASSERT(numberOfColumns > 0);
-  numberOfRows = MAX(1, numberOfRows);
-  numberOfColumns = MAX(1, numberOfColumns);
 
-  CGFloat totalButtonWidth = numberOfColumns * buttonDimensions.width;
-  CGFloat buttonHorizontalSpacing = 0;
-  if (numberOfColumns > 1) {
-    buttonHorizontalSpacing = floorf((pageWidth - totalButtonWidth) / (numberOfColumns - 1));
+  NILauncherLayoutParameters parameters = [self layoutParametersForPageSize:frameSize];
+  _isLayoutValid = YES;
+
+  if (nil != _layout
+      && NILauncherLayoutParametersEqualToParameters(parameters, _layout.parameters)) {
+    // The layout was invalidated, but the data source's answers haven't changed.
+    return YES;
   }
-  CGFloat totalButtonHeight = numberOfRows * buttonDimensions.height;
-  CGFloat buttonVerticalSpacing = 0;
-  if (numberOfRows > 1) {
-    buttonVerticalSpacing = floorf((pageHeight - totalButtonHeight) / (numberOfRows - 1));
+
+  NILauncherLayout* layout = nil;
+  if (nil != _precomputedLayout
+      && NILauncherLayoutParametersEqualToParameters(parameters, _precomputedLayout.parameters)) {
+    layout = [_precomputedLayout retain];
+
+  } else {
+    layout = [[NILauncherLayout alloc] initWithParameters: parameters
+                                     numberOfButtonFrames: [self maxNumberOfButtonsOnLoadedPages]];
   }
 
-  *pButtonDimensions = buttonDimensions;
-  *pNumberOfRows = numberOfRows;
-  *pNumberOfColumns = numberOfColumns;
-  *pButtonHorizontalSpacing = buttonHorizontalSpacing;
-  *pButtonVerticalSpacing = buttonVerticalSpacing;
+  [_precomputedLayout release];
+  _precomputedLayout = _layout;
+  _layout = layout;
+
+  NIDASSERT(_layout.metrics.numberOfRows > 0);
+  NIDASSERT(_layout.metrics.numberOfColumns > 0);
+
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Force the layout to be recalculated the next time a page is laid out.
+ */
+- (void)invalidateLayout {
+  _isLayoutValid = NO;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Lay out every loaded page if the layout metrics have changed.
+ */
 - (void)layoutPages {
   if (nil == _scrollView || CGRectIsEmpty(_scrollView.frame)) {
     // Bail out early; the scroll view hasn't been laid out yet.
     return;
   }
 
-  CGSize buttonDimensions = CGSizeZero;
-  NSInteger numberOfRows = 0;
-  NSInteger numberOfColumns = 0;
-  CGFloat buttonHorizontalSpacing = 0;
-  CGFloat buttonVerticalSpacing = 0;
-  [self calculateLayoutForFrame: _scrollView.frame
-               buttonDimensions: &buttonDimensions
-                   numberOfRows: &numberOfRows
-                numberOfColumns: &numberOfColumns
-        buttonHorizontalSpacing: &buttonHorizontalSpacing
-          buttonVerticalSpacing: &buttonVerticalSpacing];
-
-  NIDASSERT(numberOfRows > 0);
-  NIDASSERT(numberOfColumns > 0);
+  NI_TRACE_BEGIN("NILauncherView layoutPages");
 
-  CGFloat pageWidth = _scrollView.frame.size.width;
+  if ([self updateLayoutMetricsIfNeeded]) {
+    [self layoutLoadedPagesStartingWithPage:_pager.currentPage];
+  }
 
-  for (NSInteger ixPage = 0; ixPage < [_pagesOfButtons count]; ++ixPage) {
-    CGFloat pageOffset = ixPage * pageWidth;
+  NI_TRACE_END("NILauncherView layoutPages");
+}
 
-    NSArray* page = [_pagesOfButtons objectAtIndex:ixPage];
 
-    CGFloat pageBottom = 0;
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Move a loaded page's scroll view into place without laying out its buttons.
+ */
+- (void)positionLoadedPage:(NSInteger)ixPage {
+  UIScrollView* pageScrollView = [_pagesOfScrollViews objectAtIndex:ixPage];
+  pageScrollView.frame = [_layout frameForPage:ixPage];
+}
 
-    for (NSInteger ixItem = 0; ixItem < [page count]; ++ixItem) {
-      NSInteger col = ixItem % numberOfColumns;
-      NSInteger row = ixItem / numberOfColumns;
 
-      UIButton* button = [page objectAtIndex:ixItem];
-      button.frame = CGRectMake(_padding.left + col * buttonDimensions.width
-                                + (col * buttonHorizontalSpacing),
-                                _padding.top + row * buttonDimensions.height
-                                + (row * buttonVerticalSpacing),
-                                buttonDimensions.width, buttonDimensions.height);
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Lay out the given page now and every other loaded page in later run loop passes.
+ *
+ * Relaying out every page at once would hold up the rotation animation on launchers with many
+ * pages. The other pages' scroll views are moved into place immediately so that they don't
+ * overlap the given page while their buttons wait to be laid out.
+ */
+- (void)layoutLoadedPagesStartingWithPage:(NSInteger)firstPage {
+  [_pagesNeedingDeferredLayout removeAllIndexes];
 
-      pageBottom = MAX(pageBottom, CGRectGetMaxY(button.frame));
+  for (NSInteger ixPage = 0; ixPage < [_pagesOfButtons count]; ++ixPage) {
+    if ([self isPageLoaded:ixPage] && ixPage != firstPage) {
+      [self positionLoadedPage:ixPage];
+      [_pagesNeedingDeferredLayout addIndex:ixPage];
     }
+  }
+
+  if ([self isPageLoaded:firstPage]) {
+    [self layoutLoadedPage:firstPage];
+  }
 
-    UIScrollView* pageScrollView = [_pagesOfScrollViews objectAtIndex:ixPage];
-    pageScrollView.frame = CGRectMake(pageOffset, 0, pageWidth, _scrollView.frame.size.height);
-    pageScrollView.contentSize = CGSizeMake(pageWidth, pageBottom + _padding.bottom);
+  if ([_pagesNeedingDeferredLayout count] > 0 && !_isDeferredLayoutScheduled) {
+    _isDeferredLayoutScheduled = YES;
+
+    // Only run in the default mode so that scrolling, which runs in the tracking mode, isn't
+    // interrupted.
+    [self performSelector: @selector(layoutDeferredPages)
+               withObject: nil
+               afterDelay: 0
+                  inModes: [NSArray arrayWithObject:NSDefaultRunLoopMode]];
   }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////
-#pragma mark -
-#pragma mark UIScrollViewDelegate
+/**
+ * @brief Lay out a few of the pages waiting for layout, nearest to the current page first.
+ */
+- (void)layoutDeferredPages {
+  _isDeferredLayoutScheduled = NO;
 
+  NI_TRACE_BEGIN("NILauncherView layoutDeferredPages");
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)scrollViewDidEndDragging:(UIScrollView *)scrollView willDecelerate:(BOOL)decelerate {
-  if (!decelerate) {
-    [self updatePageIndex];
-  } // otherwise we update the page index when the scroll finishes decelerating.
-}
+  NSInteger currentPage = _pager.currentPage;
+  for (NSInteger ixPass = 0;
+       ixPass < kNumberOfDeferredPagesToLayOutPerPass && [_pagesNeedingDeferredLayout count] > 0;
+       ++ixPass) {
+    NSUInteger before = [_pagesNeedingDeferredLayout indexLessThanOrEqualToIndex:currentPage];
+    NSUInteger after = [_pagesNeedingDeferredLayout indexGreaterThanOrEqualToIndex:currentPage];
 
+    NSInteger ixPage = 0;
+    if (NSNotFound == before) {
+      ixPage = after;
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView {
-  [self updatePageIndex];
-}
+    } else if (NSNotFound == after) {
+      ixPage = before;
 
+    } else {
+      ixPage = (currentPage - before <= after - currentPage) ? before : after;
+    }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////
-#pragma mark -
-#pragma mark UIPageControl Change Notifications
+    [self layoutLoadedPage:ixPage];
+  }
 
+  NI_TRACE_END("NILauncherView layoutDeferredPages");
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)flashCurrentPageScrollIndicators {
-  [[_pagesOfScrollViews objectAtIndex:_pager.currentPage] flashScrollIndicators];
+  if ([_pagesNeedingDeferredLayout count] > 0) {
+    _isDeferredLayoutScheduled = YES;
+    [self performSelector: @selector(layoutDeferredPages)
+               withObject: nil
+               afterDelay: 0
+                  inModes: [NSArray arrayWithObject:NSDefaultRunLoopMode]];
+  }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)pageChanged:(UIPageControl*)pager {
-  [UIView beginAnimations:nil context:nil];
-  [UIView setAnimationDuration:kAnimateToPageDuration];
-  [UIView setAnimationCurve:UIViewAnimationCurveEaseOut];
-  [UIView setAnimationBeginsFromCurrentState:YES];
-  [UIView setAnimationDelegate:self];
-  [UIView setAnimationDidStopSelector:@selector(flashCurrentPageScrollIndicators)];
+/**
+ * @brief Lay out the buttons and scroll view of a single loaded page using the cached layout.
+ *
+ * The frames have already been calculated, so this only assigns them.
+ */
+- (void)layoutLoadedPage:(NSInteger)ixPage {
+  [_pagesNeedingDeferredLayout removeIndex:ixPage];
 
-  _scrollView.contentOffset = CGPointMake([self pageWidthForLauncherFrame:self.frame]
-                                          * _pager.currentPage,
-                                          _scrollView.contentOffset.y);
+  NSArray* page = [_pagesOfButtons objectAtIndex:ixPage];
+  NSInteger numberOfButtons = [page count];
 
-  [UIView commitAnimations];
+  const CGRect* buttonFrames = _layout.buttonFrames;
+  NSInteger numberOfButtonFrames = MIN(numberOfButtons, _layout.numberOfButtonFrames);
 
-  // Once we've handled the page change notification, notify the pager that it's ok to update
-  // the page display.
-  [_pager updateCurrentPageDisplay];
+  NSInteger ixItem = 0;
+  for (; ixItem < numberOfButtonFrames; ++ixItem) {
+    [[page objectAtIndex:ixItem] setFrame:buttonFrames[ixItem]];
+  }
+
+  // This page has more buttons than any page did when the layout was calculated.
+  for (; ixItem < numberOfButtons; ++ixItem) {
+    [[page objectAtIndex:ixItem] setFrame:[_layout frameForButtonAtIndex:ixItem]];
+  }
+
+  UIScrollView* pageScrollView = [_pagesOfScrollViews objectAtIndex:ixPage];
+  pageScrollView.frame = [_layout frameForPage:ixPage];
+  pageScrollView.contentSize = [_layout contentSizeForPageWithNumberOfButtons:numberOfButtons];
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////
-#pragma mark -
-#pragma mark Actions
+/**
+ * @brief Lay out a single loaded page, updating the layout metrics first if needed.
+ */
+- (void)layoutPage:(NSInteger)ixPage {
+  if (nil == _scrollView || CGRectIsEmpty(_scrollView.frame)) {
+    // The page will be laid out when the scroll view's frame is set.
+    return;
+  }
+
+  if ([self updateLayoutMetricsIfNeeded]) {
+    // The metrics changed, so this page's neighbours are out of date too.
+    [self layoutLoadedPagesStartingWithPage:ixPage];
+
+  } else {
+    [self layoutLoadedPage:ixPage];
+  }
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * @brief Find a button in the pages and retrieve its page and index.
+ * @brief The index of the first button in the topmost visible row of a loaded page.
  *
- * @param[in] searchButton  The button you are looking for.
- * @param[out] pPage        The resulting page, if found.
- * @param[out] pIndex       The resulting index, if found.
- * @returns YES if the button was found. NO otherwise.
+ * Uses the cached layout, so it must be called before it is replaced in order to find the row
+ * that the user was looking at before a change in layout.
  */
-- (BOOL)pageAndIndexOfButton: (UIButton *)searchButton
-                        page: (NSInteger *)pPage
-                       index: (NSInteger *)pIndex {
-  NIDASSERT(nil != pPage);
-  NIDASSERT(nil != pIndex);
-  if (nil == pPage
-      || nil == pIndex) {
-    return NO;
+- (NSInteger)anchorItemForPage:(NSInteger)page {
+  UIScrollView* pageScrollView = [self scrollViewForPage:page];
+  if (nil == pageScrollView || !_isLayoutValid) {
+    return 0;
   }
 
-  for (NSInteger ixPage = 0; ixPage < [_pagesOfButtons count]; ++ixPage) {
-    NSArray* page = [_pagesOfButtons objectAtIndex:ixPage];
-    for (NSInteger ixButton = 0; ixButton < [page count]; ++ixButton) {
-      UIButton* button = [page objectAtIndex:ixButton];
-      if (button == searchButton) {
-        *pPage = ixPage;
-        *pIndex = ixButton;
-        return YES;
-      }
-    }
+  NILauncherLayoutMetrics metrics = _layout.metrics;
+  CGFloat rowHeight = metrics.buttonDimensions.height + metrics.buttonVerticalSpacing;
+  CGFloat offset = pageScrollView.contentOffset.y - _layout.parameters.padding.top;
+  if (rowHeight <= 0 || offset <= 0) {
+    return 0;
   }
 
-  return NO;
+  return (NSInteger)floorf(offset / rowHeight) * metrics.numberOfColumns;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)didTapButton:(UIButton *)tappedButton {
-  NSInteger page = -1;
-  NSInteger index = 0;
-  if ([self pageAndIndexOfButton:tappedButton
-                            page:&page
-                           index:&index]) {
-
-    if ([self.delegate respondsToSelector:
-         @selector(launcherView:didSelectButton:onPage:atIndex:)]) {
-      [self.delegate launcherView: self
-                  didSelectButton: tappedButton
-                           onPage: page
-                          atIndex: index];
-    }
+/**
+ * @brief Scroll a loaded page vertically so that the row containing the given button is at
+ *        the top.
+ */
+- (void)scrollPage:(NSInteger)page toAnchorItem:(NSInteger)anchorItem {
+  UIScrollView* pageScrollView = [self scrollViewForPage:page];
+  if (nil == pageScrollView || !_isLayoutValid) {
+    return;
+  }
 
-  } else {
-    // How exactly did we tap a button that wasn't a part of the launcher view?
-    NIDASSERT(NO);
+  NILauncherLayoutMetrics metrics = _layout.metrics;
+  NSInteger row = anchorItem / metrics.numberOfColumns;
+  CGFloat offset = 0;
+  if (row > 0) {
+    offset = (_layout.parameters.padding.top
+              + row * (metrics.buttonDimensions.height + metrics.buttonVerticalSpacing));
   }
+
+  CGFloat maxOffset = MAX(0, pageScrollView.contentSize.height
+                             - pageScrollView.frame.size.height);
+  pageScrollView.contentOffset = CGPointMake(0, MIN(offset, maxOffset));
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
-#pragma mark Public Methods
+#pragma mark Data Source Mapping
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (void)reloadData {
-  _numberOfPages = [self.dataSource numberOfPagesInLauncherView:self];
+/**
+ * @brief The number of filtered buttons that fill a page's grid.
+ */
+- (NSInteger)numberOfButtonsPerFilteredPage {
+  NSInteger numberOfButtons = _maxNumberOfButtonsPerPage;
+  if (nil != _scrollView && !CGRectIsEmpty(_scrollView.frame)) {
+    if ([self updateLayoutMetricsIfNeeded]) {
+      [self layoutLoadedPagesStartingWithPage:_pager.currentPage];
+    }
+    NILauncherLayoutMetrics metrics = _layout.metrics;
+    numberOfButtons = MIN(numberOfButtons, metrics.numberOfRows * metrics.numberOfColumns);
+  }
+  return MAX(1, numberOfButtons);
+}
 
-  _pager.numberOfPages = _numberOfPages;
 
-  // FEATURE: Remember the current page?
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The index path that the data source knows the given displayed button by.
+ */
+- (NSIndexPath *)dataSourceIndexPathForPage:(NSInteger)page atIndex:(NSInteger)index {
+  if (nil == _filteredIndexPaths) {
+    return [NSIndexPath indexPathForRow:index inSection:page];
+  }
+  return [_filteredIndexPaths objectAtIndex:page * _numberOfButtonsPerFilteredPage + index];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)numberOfPagesFromDataSource {
+  if (nil == _filteredIndexPaths) {
+    return [self.dataSource numberOfPagesInLauncherView:self];
+  }
+
+  NSInteger numberOfButtons = [_filteredIndexPaths count];
+  return ((numberOfButtons > 0)
+          ? 1 + (numberOfButtons - 1) / _numberOfButtonsPerFilteredPage
+          : 0);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)numberOfButtonsFromDataSourceInPage:(NSInteger)page {
+  if (nil == _filteredIndexPaths) {
+    return [self.dataSource launcherView:self numberOfButtonsInPage:page];
+  }
+
+  // Pages only come after the first one if every page before them is full.
+  NSInteger firstButton = page * _numberOfButtonsPerFilteredPage;
+  return MAX(0, MIN(_numberOfButtonsPerFilteredPage,
+                    (NSInteger)[_filteredIndexPaths count] - firstButton));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Page Loading
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Fetch a button from the data source and register for its tap and editing events.
+ */
+- (UIButton *)buttonFromDataSourceForPage:(NSInteger)page atIndex:(NSInteger)index {
+  NSIndexPath* indexPath = [self dataSourceIndexPathForPage:page atIndex:index];
+
+  NI_TRACE_BEGIN("NILauncherView button creation");
+  UIButton* button = [self.dataSource launcherView: self
+                                     buttonForPage: indexPath.section
+                                           atIndex: indexPath.row];
+  NI_TRACE_END("NILauncherView button creation");
+  [button     addTarget: self
+                 action: @selector(didTapButton:)
+       forControlEvents: UIControlEventTouchUpInside];
+  [button     addTarget: self
+                 action: @selector(buttonDidTouchDown:withEvent:)
+       forControlEvents: UIControlEventTouchDown];
+  [button     addTarget: self
+                 action: @selector(buttonDidDrag:withEvent:)
+       forControlEvents: UIControlEventTouchDragInside | UIControlEventTouchDragOutside];
+  [button     addTarget: self
+                 action: @selector(buttonDidEndTouch:)
+       forControlEvents: (UIControlEventTouchUpInside | UIControlEventTouchUpOutside
+                          | UIControlEventTouchCancel)];
+  return button;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Record the current location of every button on a loaded page.
+ *
+ * Must be called whenever buttons are added to, removed from, or moved within a page.
+ */
+- (void)indexButtonsOnPage:(NSInteger)ixPage {
+  NSArray* page = [_pagesOfButtons objectAtIndex:ixPage];
+  for (NSInteger ixItem = 0; ixItem < [page count]; ++ixItem) {
+    [_buttonIndexPaths addPointer: [page objectAtIndex:ixItem]
+                        withValue: NIPackButtonIndexPath(ixPage, ixItem)];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Remove a button from the view hierarchy and place it in the reuse queue.
+ */
+- (void)discardButton:(UIButton *)button {
+  [_buttonIndexPaths removePointer:button];
+  if (_pressedButton == button) {
+    [self cancelLongPress];
+  }
+  // Removes every action that was added in buttonFromDataSourceForPage:atIndex:.
+  [button removeTarget: self
+                action: NULL
+      forControlEvents: UIControlEventAllEvents];
+  [button removeFromSuperview];
+  [self enqueueReusableButton:button];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Query the data source for the given page's buttons and add them to the view hierarchy.
+ *
+ * Each page of buttons lives within a scroll view that will scroll vertically if there are too
+ * many buttons for the page.
+ */
+- (void)loadPage:(NSInteger)ixPage {
+  if ([self isPageLoaded:ixPage]) {
+    return;
+  }
+
+  NSInteger numberOfItems = MIN(_maxNumberOfButtonsPerPage,
+                                [self numberOfButtonsFromDataSourceInPage:ixPage]);
+
+  NSMutableArray* page = [[[NSMutableArray alloc] initWithCapacity:numberOfItems]
+                          autorelease];
+
+  UIScrollView* pageScrollView = [[[UIScrollView alloc] init] autorelease];
+  pageScrollView.indicatorStyle = UIScrollViewIndicatorStyleWhite;
+
+  for (NSInteger ixItem = 0 ; ixItem < numberOfItems; ++ixItem) {
+    UIButton* item = [self buttonFromDataSourceForPage:ixPage atIndex:ixItem];
+    [page addObject:item];
+    [pageScrollView addSubview:item];
+  }
+
+  [_scrollView addSubview:pageScrollView];
+
+  [_pagesOfScrollViews replaceObjectAtIndex:ixPage withObject:pageScrollView];
+  [_pagesOfButtons replaceObjectAtIndex:ixPage withObject:page];
+  [self indexButtonsOnPage:ixPage];
+
+  [self layoutPage:ixPage];
+
+  NI_TRACE_COUNTER("NILauncherView loaded buttons", [_buttonIndexPaths count]);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Add a button that is no longer displayed to the reuse queue, if it supports reuse.
+ */
+- (void)enqueueReusableButton:(UIButton *)button {
+  if (![button respondsToSelector:@selector(reuseIdentifier)]) {
+    return;
+  }
+
+  NSString* identifier = [(id<NILauncherReusableButton>)button reuseIdentifier];
+  if (nil == identifier) {
+    return;
+  }
+
+  NSMutableArray* queue = [_reusableButtons objectForKey:identifier];
+  if (nil == queue) {
+    queue = [[[NSMutableArray alloc] init] autorelease];
+    [_reusableButtons setObject:queue forKey:identifier];
+  }
+
+  if ([button respondsToSelector:@selector(prepareForReuse)]) {
+    [(id<NILauncherReusableButton>)button prepareForReuse];
+  }
+
+  [queue addObject:button];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Remove the given page's buttons from the view hierarchy and queue them for reuse.
+ */
+- (void)unloadPage:(NSInteger)ixPage {
+  if (![self isPageLoaded:ixPage]) {
+    return;
+  }
+
+  for (UIButton* button in [_pagesOfButtons objectAtIndex:ixPage]) {
+    [self discardButton:button];
+  }
+  [[_pagesOfScrollViews objectAtIndex:ixPage] removeFromSuperview];
+
+  [_pagesOfButtons replaceObjectAtIndex:ixPage withObject:[NSNull null]];
+  [_pagesOfScrollViews replaceObjectAtIndex:ixPage withObject:[NSNull null]];
+  [_pagesNeedingDeferredLayout removeIndex:ixPage];
+
+  // Filtered pages don't correspond to the data source's pages.
+  if (nil == _filteredIndexPaths
+      && [self.delegate respondsToSelector:@selector(launcherView:didUnloadPage:)]) {
+    [self.delegate launcherView:self didUnloadPage:ixPage];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The pages that are at least partially visible, based on the scroll view's content
+ *        offset.
+ *
+ * Must only be called when there is at least one page.
+ */
+- (NSRange)visiblePages {
+  NSInteger firstVisiblePage = _pager.currentPage;
+  NSInteger lastVisiblePage = _pager.currentPage;
+  CGFloat pageWidth = _scrollView.frame.size.width;
+  if (pageWidth > 0) {
+    firstVisiblePage = floorf(_scrollView.contentOffset.x / pageWidth);
+    lastVisiblePage = floorf((_scrollView.contentOffset.x + pageWidth - 1) / pageWidth);
+  }
+  firstVisiblePage = MAX(0, MIN(_numberOfPages - 1, firstVisiblePage));
+  lastVisiblePage = MAX(firstVisiblePage, MIN(_numberOfPages - 1, lastVisiblePage));
+
+  return NSMakeRange(firstVisiblePage, lastVisiblePage - firstVisiblePage + 1);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Load the visible pages and their neighbours and unload every other page.
+ *
+ * The window of loaded pages is determined by the scroll view's content offset,
+ * numberOfAdjacentPagesToLoad and maxNumberOfResidentPages.
+ */
+- (void)updateLoadedPages {
+  if (_numberOfPages <= 0) {
+    _firstLoadedPage = 0;
+    _lastLoadedPage = -1;
+    return;
+  }
+
+  NSRange visiblePages = [self visiblePages];
+  NSInteger firstVisiblePage = visiblePages.location;
+  NSInteger lastVisiblePage = NSMaxRange(visiblePages) - 1;
+
+  NSInteger numberOfAdjacentPagesToLoad = _numberOfAdjacentPagesToLoad;
+  if (_isLimitedByMemoryWarning) {
+    numberOfAdjacentPagesToLoad = MIN(numberOfAdjacentPagesToLoad,
+                                      kNumberOfAdjacentPagesToLoadAfterMemoryWarning);
+  }
+
+  // Written to avoid overflowing when numberOfAdjacentPagesToLoad is NSIntegerMax.
+  NSInteger firstPageToLoad = ((numberOfAdjacentPagesToLoad >= firstVisiblePage)
+                               ? 0
+                               : firstVisiblePage - numberOfAdjacentPagesToLoad);
+  NSInteger lastPageToLoad = ((numberOfAdjacentPagesToLoad
+                               >= _numberOfPages - 1 - lastVisiblePage)
+                              ? _numberOfPages - 1
+                              : lastVisiblePage + numberOfAdjacentPagesToLoad);
+
+  // Trim the window to the resident page budget, splitting the neighbouring pages that fit
+  // evenly between both sides unless one side has fewer.
+  if (lastPageToLoad - firstPageToLoad + 1 > _maxNumberOfResidentPages) {
+    NSInteger numberOfAdjacentPages = MAX(0, _maxNumberOfResidentPages
+                                          - (NSInteger)visiblePages.length);
+    NSInteger numberOfPagesBefore = MIN(firstVisiblePage - firstPageToLoad,
+                                        numberOfAdjacentPages / 2);
+    NSInteger numberOfPagesAfter = MIN(lastPageToLoad - lastVisiblePage,
+                                       numberOfAdjacentPages - numberOfPagesBefore);
+    numberOfPagesBefore = MIN(firstVisiblePage - firstPageToLoad,
+                              numberOfAdjacentPages - numberOfPagesAfter);
+
+    firstPageToLoad = firstVisiblePage - numberOfPagesBefore;
+    lastPageToLoad = lastVisiblePage + numberOfPagesAfter;
+  }
+
+  // The pages that a dragged button has passed through no longer match the data source, so
+  // they are kept until the button has been dropped.
+  for (NSInteger ixPage = 0; ixPage < _numberOfPages && nil == _draggingButton; ++ixPage) {
+    if (ixPage < firstPageToLoad || ixPage > lastPageToLoad) {
+      [self unloadPage:ixPage];
+    }
+  }
+
+  // Load the visible pages before their neighbours. Visible pages that are still waiting for
+  // their deferred layout can't wait any longer.
+  for (NSInteger ixPage = firstVisiblePage; ixPage <= lastVisiblePage; ++ixPage) {
+    [self loadPage:ixPage];
+    if ([_pagesNeedingDeferredLayout containsIndex:ixPage]) {
+      [self layoutLoadedPage:ixPage];
+    }
+  }
+  for (NSInteger ixPage = firstPageToLoad; ixPage <= lastPageToLoad; ++ixPage) {
+    [self loadPage:ixPage];
+  }
+
+  _firstLoadedPage = firstPageToLoad;
+  _lastLoadedPage = lastPageToLoad;
+
+  // Prefetched pages that have now been loaded are no longer prefetching.
+  [_prefetchedPages removeIndexesInRange:NSMakeRange(firstPageToLoad,
+                                                     lastPageToLoad - firstPageToLoad + 1)];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Prefetching
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Tell the data source that none of the prefetched pages are needed anymore.
+ */
+- (void)cancelAllPrefetching {
+  if (_dataSourcePrefetches && [_prefetchedPages count] > 0) {
+    [(id<NILauncherPrefetchingDataSource>)self.dataSource launcherView: self
+                                             cancelPrefetchingForPages: _prefetchedPages];
+  }
+  [_prefetchedPages removeAllIndexes];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Prefetch the pages past the loaded pages in the direction of the scroll.
+ *
+ * @param scrollDelta     The horizontal distance scrolled since the last update. Its sign is
+ *                        the direction of the scroll.
+ * @param pagesPerSecond  The estimated speed of the scroll.
+ */
+- (void)updatePrefetchedPagesWithScrollDelta: (CGFloat)scrollDelta
+                              pagesPerSecond: (CGFloat)pagesPerSecond {
+  if (!_dataSourcePrefetches || _numberOfPagesToPrefetch <= 0 || scrollDelta == 0
+      || nil != _filteredIndexPaths) {
+    return;
+  }
+
+  // Scrolling faster than a page a second means that the loaded pages will be outrun sooner,
+  // so look further ahead.
+  NSInteger numberOfPagesToPrefetch = _numberOfPagesToPrefetch;
+  if (pagesPerSecond > 1) {
+    numberOfPagesToPrefetch = MIN(_numberOfPagesToPrefetch * 2,
+                                  _numberOfPagesToPrefetch + (NSInteger)floorf(pagesPerSecond));
+  }
+
+  NSInteger firstPage = 0;
+  NSInteger lastPage = -1;
+  if (scrollDelta > 0) {
+    firstPage = _lastLoadedPage + 1;
+    lastPage = MIN(_numberOfPages - 1, _lastLoadedPage + numberOfPagesToPrefetch);
+
+  } else {
+    firstPage = MAX(0, _firstLoadedPage - numberOfPagesToPrefetch);
+    lastPage = _firstLoadedPage - 1;
+  }
+
+  NSMutableIndexSet* pagesToPrefetch = [NSMutableIndexSet indexSet];
+  if (firstPage <= lastPage) {
+    [pagesToPrefetch addIndexesInRange:NSMakeRange(firstPage, lastPage - firstPage + 1)];
+  }
+
+  NSMutableIndexSet* cancelledPages = [[_prefetchedPages mutableCopy] autorelease];
+  [cancelledPages removeIndexes:pagesToPrefetch];
+
+  NSMutableIndexSet* newPages = [[pagesToPrefetch mutableCopy] autorelease];
+  [newPages removeIndexes:_prefetchedPages];
+
+  [_prefetchedPages removeAllIndexes];
+  [_prefetchedPages addIndexes:pagesToPrefetch];
+
+  id<NILauncherPrefetchingDataSource> dataSource =
+  (id<NILauncherPrefetchingDataSource>)self.dataSource;
+  if ([cancelledPages count] > 0) {
+    [dataSource launcherView:self cancelPrefetchingForPages:cancelledPages];
+  }
+  if ([newPages count] > 0) {
+    [dataSource launcherView:self prefetchItemsForPages:newPages];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark UIScrollViewDelegate
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView {
+  [self updateLoadedPages];
+
+  if (!_scrollView.dragging && !_scrollView.decelerating) {
+    // The content offset was changed programmatically, e.g. by a rotation or reload, which
+    // doesn't say anything about where the user is headed.
+    _lastContentOffsetX = _scrollView.contentOffset.x;
+    _lastScrollTime = 0;
+    return;
+  }
+
+  CGFloat contentOffsetX = _scrollView.contentOffset.x;
+  CGFloat scrollDelta = contentOffsetX - _lastContentOffsetX;
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+  NSTimeInterval elapsed = now - _lastScrollTime;
+
+  CGFloat pageWidth = _scrollView.frame.size.width;
+  CGFloat pagesPerSecond = 0;
+  if (elapsed > 0 && elapsed < kMaxScrollVelocitySampleInterval && pageWidth > 0) {
+    pagesPerSecond = fabsf(scrollDelta) / pageWidth / elapsed;
+  }
+
+  _lastContentOffsetX = contentOffsetX;
+  _lastScrollTime = now;
+
+  [self updatePrefetchedPagesWithScrollDelta:scrollDelta pagesPerSecond:pagesPerSecond];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)scrollViewDidEndDragging:(UIScrollView *)scrollView willDecelerate:(BOOL)decelerate {
+  if (!decelerate) {
+    [self updatePageIndex];
+  } // otherwise we update the page index when the scroll finishes decelerating.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView {
+  [self updatePageIndex];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)scrollViewDidEndScrollingAnimation:(UIScrollView *)scrollView {
+  if (nil != _draggingButton) {
+    // The finger hasn't moved, but there is a new page under it.
+    [self updateDraggingButtonSlot];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark UIPageControl Change Notifications
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)flashCurrentPageScrollIndicators {
+  [[self scrollViewForPage:_pager.currentPage] flashScrollIndicators];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)pageChanged:(UIPageControl*)pager {
+  [UIView beginAnimations:nil context:nil];
+  [UIView setAnimationDuration:kAnimateToPageDuration];
+  [UIView setAnimationCurve:UIViewAnimationCurveEaseOut];
+  [UIView setAnimationBeginsFromCurrentState:YES];
+  [UIView setAnimationDelegate:self];
+  [UIView setAnimationDidStopSelector:@selector(flashCurrentPageScrollIndicators)];
+
+  _scrollView.contentOffset = CGPointMake([self pageWidthForLauncherFrame:self.frame]
+                                          * _pager.currentPage,
+                                          _scrollView.contentOffset.y);
+
+  [UIView commitAnimations];
+
+  // Once we've handled the page change notification, notify the pager that it's ok to update
+  // the page display.
+  [_pager updateCurrentPageDisplay];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Actions
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Find a button in the pages and retrieve its page and index.
+ *
+ * Runs in constant time. Buttons are indexed as their pages are loaded and updated, so the
+ * result is only accurate outside of a beginUpdates/endUpdates block.
+ *
+ * @param[in] searchButton  The button you are looking for.
+ * @param[out] pPage        The resulting page, if found.
+ * @param[out] pIndex       The resulting index, if found.
+ * @returns YES if the button was found. NO otherwise.
+ */
+- (BOOL)pageAndIndexOfButton: (UIButton *)searchButton
+                        page: (NSInteger *)pPage
+                       index: (NSInteger *)pIndex {
+  NIDASSERT(nil != pPage);
+  NIDASSERT(nil != pIndex);
+  if (nil == pPage
+      || nil == pIndex) {
+    return NO;
+  }
+
+  NSInteger packedIndexPath = 0;
+  if (![_buttonIndexPaths getValue:&packedIndexPath forPointer:searchButton]) {
+    return NO;
+  }
+
+  *pPage = packedIndexPath >> kButtonIndexBits;
+  *pIndex = packedIndexPath & ((1 << kButtonIndexBits) - 1);
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didTapButton:(UIButton *)tappedButton {
+  if (_isEditing) {
+    // Touches pick buttons up while editing rather than selecting them.
+    return;
+  }
+
+  NSInteger page = -1;
+  NSInteger index = 0;
+  if ([self pageAndIndexOfButton:tappedButton
+                            page:&page
+                           index:&index]) {
+
+    if ([self.delegate respondsToSelector:
+         @selector(launcherView:didSelectButton:onPage:atIndex:)]) {
+      NSIndexPath* indexPath = [self dataSourceIndexPathForPage:page atIndex:index];
+      [self.delegate launcherView: self
+                  didSelectButton: tappedButton
+                           onPage: indexPath.section
+                          atIndex: indexPath.row];
+    }
+
+  } else {
+    // How exactly did we tap a button that wasn't a part of the launcher view?
+    NIDASSERT(NO);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Public Methods
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reloadData {
+  NI_TRACE_BEGIN("NILauncherView reloadData");
+
+  // Remember where the user was before the layout metrics are thrown away.
+  NSInteger previousPage = _pager.currentPage;
+  NSInteger anchorItem = [self anchorItemForPage:previousPage];
+
+  // The data source may give different answers for the layout metrics now.
+  [self invalidateLayout];
+
+  // The button's move would refer to pages that are about to be replaced.
+  if (nil != _draggingButton) {
+    [self dropDraggingButtonAndReportMove:NO];
+  }
+
+  // The pages being prefetched may not exist anymore.
+  [self cancelAllPrefetching];
+
+  if (nil != _filteredIndexPaths) {
+    _numberOfButtonsPerFilteredPage = [self numberOfButtonsPerFilteredPage];
+  }
+  _numberOfPages = [self numberOfPagesFromDataSource];
+
+  _pager.numberOfPages = _numberOfPages;
+  _pager.currentPage = MAX(0, MIN(previousPage, _numberOfPages - 1));
 
   _scrollView.contentSize = CGSizeMake(_scrollView.frame.size.width * _numberOfPages,
                                        _scrollView.frame.size.height);
 
-  // Remove the views from the view hierarchy before we clobber the collections.
-  for (NSArray* page in _pagesOfButtons) {
-    for (UIButton* button in page) {
-      [button removeFromSuperview];
+  // Remove the views from the view hierarchy before we clobber the collections.
+  for (NSInteger ixPage = 0; ixPage < [_pagesOfButtons count]; ++ixPage) {
+    [self unloadPage:ixPage];
+  }
+
+  NI_RELEASE_SAFELY(_pagesOfButtons);
+  NI_RELEASE_SAFELY(_pagesOfScrollViews);
+  [_buttonIndexPaths removeAllPointers];
+  [_pagesNeedingLayout removeAllIndexes];
+
+  // Every page starts out unloaded. Only the pages within the loading window are then
+  // requested from the data source.
+  _pagesOfButtons = [[NSMutableArray alloc] initWithCapacity:_numberOfPages];
+  _pagesOfScrollViews = [[NSMutableArray alloc] initWithCapacity:_numberOfPages];
+  for (NSInteger ixPage = 0; ixPage < _numberOfPages; ++ixPage) {
+    [_pagesOfButtons addObject:[NSNull null]];
+    [_pagesOfScrollViews addObject:[NSNull null]];
+  }
+
+  // Setting the offset would normally load the pages, but not if it hasn't changed.
+  _scrollView.contentOffset = CGPointMake(_scrollView.frame.size.width * _pager.currentPage, 0);
+  [self updateLoadedPages];
+
+  if (_pager.currentPage == previousPage) {
+    [self scrollPage:previousPage toAnchorItem:anchorItem];
+  }
+
+  NI_TRACE_END("NILauncherView reloadData");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (UIButton *)dequeueReusableButtonWithIdentifier:(NSString *)identifier {
+  NSMutableArray* queue = [_reusableButtons objectForKey:identifier];
+  if ([queue count] == 0) {
+    return nil;
+  }
+
+  UIButton* button = [[[queue lastObject] retain] autorelease];
+  [queue removeLastObject];
+  return button;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (UIButton *)buttonForPage:(NSInteger)page atIndex:(NSInteger)index {
+  if (![self isPageLoaded:page]) {
+    return nil;
+  }
+
+  NSArray* buttons = [_pagesOfButtons objectAtIndex:page];
+  return ((index >= 0 && index < (NSInteger)[buttons count])
+          ? [buttons objectAtIndex:index]
+          : nil);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)currentPage {
+  return _pager.currentPage;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setCurrentPage:(NSInteger)page animated:(BOOL)animated {
+  _pager.currentPage = MAX(0, MIN(page, _numberOfPages - 1));
+  [_pager updateCurrentPageDisplay];
+
+  [_scrollView setContentOffset: CGPointMake(_scrollView.frame.size.width * _pager.currentPage, 0)
+                       animated: animated];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reduceMemoryUsage {
+  NI_TRACE_BEGIN("NILauncherView reduceMemoryUsage");
+
+  _isLimitedByMemoryWarning = YES;
+
+  // The prefetched pages would only be loaded again.
+  [self cancelAllPrefetching];
+
+  // The pages that a dragged button has passed through no longer match the data source.
+  if (_numberOfPages > 0 && nil == _draggingButton) {
+    NSRange visiblePages = [self visiblePages];
+    for (NSInteger ixPage = 0; ixPage < [_pagesOfButtons count]; ++ixPage) {
+      if (!NSLocationInRange(ixPage, visiblePages)) {
+        [self unloadPage:ixPage];
+      }
+    }
+    _firstLoadedPage = visiblePages.location;
+    _lastLoadedPage = NSMaxRange(visiblePages) - 1;
+  }
+
+  // Emptied last because unloading the pages queues their buttons for reuse.
+  [_reusableButtons removeAllObjects];
+
+  NI_TRACE_COUNTER("NILauncherView loaded buttons", [_buttonIndexPaths count]);
+  NI_TRACE_END("NILauncherView reduceMemoryUsage");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Notifications
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+  [self reduceMemoryUsage];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Layout Precomputation
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelLayoutPrecomputation {
+  _layoutOperation.launcherView = nil;
+  [_layoutOperation cancel];
+  NI_RELEASE_SAFELY(_layoutOperation);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)precomputeLayoutForFrame: (CGRect)frame
+                    numberOfRows: (NSInteger)numberOfRows
+                 numberOfColumns: (NSInteger)numberOfColumns {
+  // Mirrors the size that setFrame: gives the scroll view.
+  CGFloat pagerHeight = [_pager sizeThatFits:frame.size].height;
+  CGSize pageSize = CGSizeMake([self pageWidthForLauncherFrame:frame],
+                               frame.size.height - pagerHeight);
+  if (pageSize.width <= 0 || pageSize.height <= 0) {
+    return;
+  }
+
+  // Only the data source calls have to happen on the main thread.
+  NILauncherLayoutParameters parameters = [self layoutParametersForPageSize: pageSize
+                                                               numberOfRows: numberOfRows
+                                                            numberOfColumns: numberOfColumns];
+
+  [self cancelLayoutPrecomputation];
+
+  if (nil == _layoutQueue) {
+    _layoutQueue = [[NSOperationQueue alloc] init];
+    [_layoutQueue setMaxConcurrentOperationCount:1];
+  }
+
+  NSInteger numberOfButtonFrames = [self maxNumberOfButtonsOnLoadedPages];
+  _layoutOperation = [[NILauncherLayoutOperation alloc] initWithParameters: parameters
+                                                      numberOfButtonFrames: numberOfButtonFrames];
+  _layoutOperation.launcherView = self;
+  [_layoutQueue addOperation:_layoutOperation];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)layoutOperationDidFinish:(NILauncherLayoutOperation *)operation {
+  NIDASSERT(operation == _layoutOperation);
+  if (operation != _layoutOperation) {
+    return;
+  }
+
+  [_precomputedLayout release];
+  _precomputedLayout = [operation.layout retain];
+
+  NI_RELEASE_SAFELY(_layoutOperation);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Incremental Updates
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Re-query the number of pages and grow or shrink the page collections to match.
+ */
+- (void)updateNumberOfPages {
+  NSInteger numberOfPages = [self numberOfPagesFromDataSource];
+  if (numberOfPages == _numberOfPages) {
+    return;
+  }
+
+  if (numberOfPages < _numberOfPages) {
+    for (NSInteger ixPage = numberOfPages; ixPage < _numberOfPages; ++ixPage) {
+      [self unloadPage:ixPage];
+    }
+    NSRange removedPages = NSMakeRange(numberOfPages, _numberOfPages - numberOfPages);
+    [_pagesOfButtons removeObjectsInRange:removedPages];
+    [_pagesOfScrollViews removeObjectsInRange:removedPages];
+    [_pagesNeedingLayout removeIndexesInRange:removedPages];
+    [_pagesNeedingDeferredLayout removeIndexesInRange:removedPages];
+
+  } else {
+    for (NSInteger ixPage = _numberOfPages; ixPage < numberOfPages; ++ixPage) {
+      [_pagesOfButtons addObject:[NSNull null]];
+      [_pagesOfScrollViews addObject:[NSNull null]];
+    }
+  }
+
+  _numberOfPages = numberOfPages;
+  _pager.numberOfPages = _numberOfPages;
+
+  CGFloat pageWidth = _scrollView.frame.size.width;
+  _scrollView.contentSize = CGSizeMake(pageWidth * _numberOfPages,
+                                       _scrollView.frame.size.height);
+
+  // If the page we were looking at has been removed, move to the new last page.
+  if (_pager.currentPage >= _numberOfPages) {
+    _pager.currentPage = MAX(0, _numberOfPages - 1);
+    _scrollView.contentOffset = CGPointMake(pageWidth * _pager.currentPage, 0);
+  }
+
+  [self updateLoadedPages];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Make a loaded page's button count match the data source.
+ *
+ * Deleting a button from a page that is limited by maxNumberOfButtonsPerPage may bring a new
+ * button into view, and inserting one may push a button off of the page.
+ */
+- (void)reconcileButtonCountForPage:(NSInteger)ixPage {
+  NSMutableArray* page = [_pagesOfButtons objectAtIndex:ixPage];
+  NSInteger numberOfItems = MIN(_maxNumberOfButtonsPerPage,
+                                [self numberOfButtonsFromDataSourceInPage:ixPage]);
+
+  while ((NSInteger)[page count] > numberOfItems) {
+    [self discardButton:[page lastObject]];
+    [page removeLastObject];
+  }
+
+  UIScrollView* pageScrollView = [_pagesOfScrollViews objectAtIndex:ixPage];
+  while ((NSInteger)[page count] < numberOfItems) {
+    UIButton* button = [self buttonFromDataSourceForPage:ixPage atIndex:[page count]];
+    [page addObject:button];
+    [pageScrollView addSubview:button];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Put the dragged button back where it was picked up before the pages are updated.
+ *
+ * The updates describe the data source, which hasn't been told about the drag, and may remove
+ * the pages or the button that the drag refers to.
+ */
+- (void)cancelDraggingButtonForUpdates {
+  if (nil == _draggingButton) {
+    return;
+  }
+
+  [self moveDraggingButtonToPage:_dragOriginPage index:_dragOriginIndex];
+  [self dropDraggingButtonAndReportMove:NO];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Lay out every page touched by an update, unless we are within a begin/end block.
+ */
+- (void)flushUpdatesIfNeeded {
+  if (_updateDepth > 0) {
+    return;
+  }
+
+  [self updateNumberOfPages];
+
+  NSUInteger ixPage = [_pagesNeedingLayout firstIndex];
+  while (NSNotFound != ixPage) {
+    if ([self isPageLoaded:ixPage]) {
+      [self reconcileButtonCountForPage:ixPage];
+      [self indexButtonsOnPage:ixPage];
+      [self layoutPage:ixPage];
+    }
+    ixPage = [_pagesNeedingLayout indexGreaterThanIndex:ixPage];
+  }
+  [_pagesNeedingLayout removeAllIndexes];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Insert a button from the data source into a loaded page.
+ */
+- (void)insertButtonAtIndexPath:(NSIndexPath *)indexPath {
+  NSInteger ixPage = indexPath.section;
+  NSInteger ixItem = indexPath.row;
+  if (![self isPageLoaded:ixPage]) {
+    return;
+  }
+
+  NSMutableArray* page = [_pagesOfButtons objectAtIndex:ixPage];
+  NIDASSERT(ixItem >= 0 && ixItem <= [page count]);
+  if (ixItem < 0 || ixItem > [page count] || ixItem >= _maxNumberOfButtonsPerPage) {
+    // The button won't be visible on this page.
+    return;
+  }
+
+  UIButton* button = [self buttonFromDataSourceForPage:ixPage atIndex:ixItem];
+  [page insertObject:button atIndex:ixItem];
+  [[_pagesOfScrollViews objectAtIndex:ixPage] addSubview:button];
+
+  [_pagesNeedingLayout addIndex:ixPage];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Remove a button from a loaded page and place it in the reuse queue.
+ */
+- (void)deleteButtonAtIndexPath:(NSIndexPath *)indexPath {
+  NSInteger ixPage = indexPath.section;
+  NSInteger ixItem = indexPath.row;
+  if (![self isPageLoaded:ixPage]) {
+    return;
+  }
+
+  NSMutableArray* page = [_pagesOfButtons objectAtIndex:ixPage];
+  if (ixItem < 0 || ixItem >= [page count]) {
+    // Buttons beyond maxNumberOfButtonsPerPage are never loaded.
+    return;
+  }
+
+  // The drag is cancelled before any update is made, so the button can't still be in use.
+  UIButton* button = [page objectAtIndex:ixItem];
+  NIDASSERT(button != _draggingButton);
+  [self discardButton:button];
+  [page removeObjectAtIndex:ixItem];
+
+  [_pagesNeedingLayout addIndex:ixPage];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)beginUpdates {
+  [self cancelDraggingButtonForUpdates];
+  ++_updateDepth;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)endUpdates {
+  NIDASSERT(_updateDepth > 0);
+  if (_updateDepth > 0) {
+    --_updateDepth;
+  }
+
+  [self flushUpdatesIfNeeded];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)insertButtonsAtIndexPaths:(NSArray *)indexPaths {
+  [self cancelDraggingButtonForUpdates];
+
+  // Insert in ascending order so that each index path refers to the final position.
+  for (NSIndexPath* indexPath in [indexPaths sortedArrayUsingSelector:@selector(compare:)]) {
+    [self insertButtonAtIndexPath:indexPath];
+  }
+
+  [self flushUpdatesIfNeeded];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)deleteButtonsAtIndexPaths:(NSArray *)indexPaths {
+  [self cancelDraggingButtonForUpdates];
+
+  // Delete in descending order so that each index path refers to the original position.
+  NSArray* sortedIndexPaths = [indexPaths sortedArrayUsingSelector:@selector(compare:)];
+  for (NSIndexPath* indexPath in [sortedIndexPaths reverseObjectEnumerator]) {
+    [self deleteButtonAtIndexPath:indexPath];
+  }
+
+  [self flushUpdatesIfNeeded];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)moveButtonAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath {
+  [self cancelDraggingButtonForUpdates];
+
+  NSInteger ixFromPage = indexPath.section;
+  NSInteger ixFromItem = indexPath.row;
+  NSInteger ixToPage = newIndexPath.section;
+  NSInteger ixToItem = newIndexPath.row;
+
+  NSMutableArray* fromPage = ([self isPageLoaded:ixFromPage]
+                              ? [_pagesOfButtons objectAtIndex:ixFromPage]
+                              : nil);
+  NSMutableArray* toPage = ([self isPageLoaded:ixToPage]
+                            ? [_pagesOfButtons objectAtIndex:ixToPage]
+                            : nil);
+  BOOL canMoveButton = (nil != fromPage && nil != toPage
+                        && ixFromItem >= 0 && ixFromItem < [fromPage count]);
+
+  if (canMoveButton) {
+    UIButton* button = [[[fromPage objectAtIndex:ixFromItem] retain] autorelease];
+    [fromPage removeObjectAtIndex:ixFromItem];
+    [_pagesNeedingLayout addIndex:ixFromPage];
+
+    if (ixToItem >= 0 && ixToItem <= [toPage count] && ixToItem < _maxNumberOfButtonsPerPage) {
+      [toPage insertObject:button atIndex:ixToItem];
+      if (ixFromPage != ixToPage) {
+        [[_pagesOfScrollViews objectAtIndex:ixToPage] addSubview:button];
+      }
+
+    } else {
+      [self discardButton:button];
     }
+    [_pagesNeedingLayout addIndex:ixToPage];
+
+  } else {
+    // At most one of the pages is loaded, so there is no button to carry across.
+    [self deleteButtonAtIndexPath:indexPath];
+    [self insertButtonAtIndexPath:newIndexPath];
   }
-  for (UIScrollView* scrollView in _pagesOfScrollViews) {
-    [scrollView removeFromSuperview];
+
+  [self flushUpdatesIfNeeded];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reloadButtonsAtIndexPaths:(NSArray *)indexPaths {
+  [self cancelDraggingButtonForUpdates];
+
+  for (NSIndexPath* indexPath in indexPaths) {
+    NSInteger ixPage = indexPath.section;
+    NSInteger ixItem = indexPath.row;
+    if (![self isPageLoaded:ixPage]) {
+      continue;
+    }
+
+    NSMutableArray* page = [_pagesOfButtons objectAtIndex:ixPage];
+    if (ixItem < 0 || ixItem >= [page count]) {
+      continue;
+    }
+
+    UIButton* oldButton = [[[page objectAtIndex:ixItem] retain] autorelease];
+    CGRect frame = oldButton.frame;
+    [self discardButton:oldButton];
+
+    UIButton* button = [self buttonFromDataSourceForPage:ixPage atIndex:ixItem];
+    [page replaceObjectAtIndex:ixItem withObject:button];
+    [_buttonIndexPaths addPointer: button
+                        withValue: NIPackButtonIndexPath(ixPage, ixItem)];
+
+    // The button occupies the same slot, so the page doesn't need to be laid out again.
+    button.frame = frame;
+    [[_pagesOfScrollViews objectAtIndex:ixPage] addSubview:button];
   }
 
-  NI_RELEASE_SAFELY(_pagesOfButtons);
-  NI_RELEASE_SAFELY(_pagesOfScrollViews);
+  [self flushUpdatesIfNeeded];
+}
 
-  // We query the data source for all of the button views. Each page of buttons lives within
-  // a scroll view that will scroll vertically if there are too many buttons for the page.
 
-  _pagesOfButtons = [[NSMutableArray alloc] initWithCapacity:_numberOfPages];
-  _pagesOfScrollViews = [[NSMutableArray alloc] initWithCapacity:_numberOfPages];
-  for (NSInteger ixPage = 0; ixPage < _numberOfPages; ++ixPage) {
-    NSInteger numberOfItems = MIN(_maxNumberOfButtonsPerPage,
-                                  [self.dataSource launcherView: self
-                                          numberOfButtonsInPage: ixPage]);
-
-    NSMutableArray* page = [[[NSMutableArray alloc] initWithCapacity:numberOfItems]
-                            autorelease];
-
-    UIScrollView* pageScrollView = [[[UIScrollView alloc] init] autorelease];
-    pageScrollView.indicatorStyle = UIScrollViewIndicatorStyleWhite;
-
-    for (NSInteger ixItem = 0 ; ixItem < numberOfItems; ++ixItem) {
-      UIButton* item = [self.dataSource launcherView: self
-                                       buttonForPage: ixPage
-                                             atIndex: ixItem];
-      [item       addTarget: self
-                     action: @selector(didTapButton:)
-           forControlEvents: UIControlEventTouchUpInside];
-      [page addObject:item];
-      [pageScrollView addSubview:item];
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Editing
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Schedule a timer that also fires while the user's finger is down.
+ */
+- (NSTimer *)scheduledTimerWithTimeInterval: (NSTimeInterval)interval
+                                   selector: (SEL)selector
+                                    repeats: (BOOL)repeats {
+  NSTimer* timer = [NSTimer timerWithTimeInterval: interval
+                                           target: self
+                                         selector: selector
+                                         userInfo: nil
+                                          repeats: repeats];
+  [[NSRunLoop currentRunLoop] addTimer:timer forMode:NSRunLoopCommonModes];
+  return timer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelLongPress {
+  [_longPressTimer invalidate];
+  _longPressTimer = nil;
+  _pressedButton = nil;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)stopEditingPageTimer {
+  [_editingPageTimer invalidate];
+  _editingPageTimer = nil;
+  _editingPageDirection = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Move a range of a loaded page's buttons into their slots and record their locations.
+ *
+ * The dragged button is left to follow the touch. The buttons are animated if this is called
+ * within an animation block.
+ */
+- (void)layoutButtonsOnPage:(NSInteger)ixPage inRange:(NSRange)range {
+  NSArray* page = [_pagesOfButtons objectAtIndex:ixPage];
+  for (NSUInteger ixItem = range.location; ixItem < NSMaxRange(range); ++ixItem) {
+    UIButton* button = [page objectAtIndex:ixItem];
+    if (button != _draggingButton) {
+      button.frame = [_layout frameForButtonAtIndex:ixItem];
     }
+    [_buttonIndexPaths addPointer: button
+                        withValue: NIPackButtonIndexPath(ixPage, ixItem)];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)updateContentSizeOfPage:(NSInteger)ixPage {
+  NSInteger numberOfButtons = [[_pagesOfButtons objectAtIndex:ixPage] count];
+  UIScrollView* pageScrollView = [_pagesOfScrollViews objectAtIndex:ixPage];
+  pageScrollView.contentSize = [_layout contentSizeForPageWithNumberOfButtons:numberOfButtons];
+}
 
-    [_scrollView addSubview:pageScrollView];
 
-    [_pagesOfScrollViews addObject:pageScrollView];
-    [_pagesOfButtons addObject:page];
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Move the dragged button's slot and animate the buttons between its old and new slots.
+ *
+ * Every other button keeps its frame.
+ */
+- (void)moveDraggingButtonToPage:(NSInteger)ixPage index:(NSInteger)ixItem {
+  if (ixPage == _dragPage && ixItem == _dragIndex) {
+    return;
   }
 
-  [self layoutPages];
+  NSMutableArray* fromPage = [_pagesOfButtons objectAtIndex:_dragPage];
+  NSMutableArray* toPage = [_pagesOfButtons objectAtIndex:ixPage];
+  [fromPage removeObjectAtIndex:_dragIndex];
+  [toPage insertObject:_draggingButton atIndex:ixItem];
+
+  [UIView beginAnimations:nil context:nil];
+  [UIView setAnimationDuration:kEditingAnimationDuration];
+  [UIView setAnimationBeginsFromCurrentState:YES];
+
+  if (ixPage == _dragPage) {
+    NSInteger firstItem = MIN(ixItem, _dragIndex);
+    NSInteger lastItem = MAX(ixItem, _dragIndex);
+    [self layoutButtonsOnPage:ixPage inRange:NSMakeRange(firstItem, lastItem - firstItem + 1)];
+
+  } else {
+    // The buttons after the old slot close the gap and those after the new slot make room.
+    [self layoutButtonsOnPage: _dragPage
+                      inRange: NSMakeRange(_dragIndex, [fromPage count] - _dragIndex)];
+    [self layoutButtonsOnPage: ixPage
+                      inRange: NSMakeRange(ixItem, [toPage count] - ixItem)];
+  }
+
+  [UIView commitAnimations];
+
+  if (ixPage != _dragPage) {
+    [self updateContentSizeOfPage:_dragPage];
+    [self updateContentSizeOfPage:ixPage];
+  }
+
+  _dragPage = ixPage;
+  _dragIndex = ixItem;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Move the dragged button to the slot under the touch on the current page.
+ */
+- (void)updateDraggingButtonSlot {
+  NSInteger ixPage = _pager.currentPage;
+  UIScrollView* pageScrollView = [self scrollViewForPage:ixPage];
+  if (nil == pageScrollView || !_isLayoutValid) {
+    return;
+  }
+
+  CGPoint point = [self convertPoint:_dragTouchPoint toView:pageScrollView];
+  NSInteger ixItem = [_layout indexOfButtonNearestToPoint:point];
+  NSInteger numberOfButtons = [[_pagesOfButtons objectAtIndex:ixPage] count];
+
+  if (ixPage == _dragPage) {
+    ixItem = MIN(ixItem, numberOfButtons - 1);
+
+  } else if (numberOfButtons < _maxNumberOfButtonsPerPage) {
+    ixItem = MIN(ixItem, numberOfButtons);
+
+  } else {
+    // There is no room for another button on this page.
+    return;
+  }
+
+  [self moveDraggingButtonToPage:ixPage index:ixItem];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Lift a button out of its page so that it can follow the touch to any page.
+ */
+- (void)beginDraggingButton:(UIButton *)button {
+  NSInteger ixPage = 0;
+  NSInteger ixItem = 0;
+  if (nil != _filteredIndexPaths
+      || ![self pageAndIndexOfButton:button page:&ixPage index:&ixItem]) {
+    // Moves between filtered pages can't be expressed in the data source's pages.
+    return;
+  }
+
+  _draggingButton = [button retain];
+  _dragOriginPage = _dragPage = ixPage;
+  _dragOriginIndex = _dragIndex = ixItem;
+
+  UIScrollView* pageScrollView = [_pagesOfScrollViews objectAtIndex:ixPage];
+  button.center = [pageScrollView convertPoint:button.center toView:self];
+  [self addSubview:button];
+  _dragTouchOffset = CGPointMake(button.center.x - _dragTouchPoint.x,
+                                 button.center.y - _dragTouchPoint.y);
+
+  // Otherwise the scroll views would take over the touch as soon as it moves.
+  _scrollView.scrollEnabled = NO;
+  pageScrollView.scrollEnabled = NO;
+
+  [UIView beginAnimations:nil context:nil];
+  [UIView setAnimationDuration:kEditingAnimationDuration];
+  button.transform = CGAffineTransformMakeScale(kDraggingButtonScale, kDraggingButtonScale);
+  button.alpha = kDraggingButtonAlpha;
+  [UIView commitAnimations];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Settle the dragged button into its slot and tell the delegate where it moved.
+ */
+- (void)dropDraggingButtonAndReportMove:(BOOL)reportMove {
+  [self stopEditingPageTimer];
+
+  UIButton* button = [_draggingButton autorelease];
+  _draggingButton = nil;
+
+  _scrollView.scrollEnabled = YES;
+  [[_pagesOfScrollViews objectAtIndex:_dragOriginPage] setScrollEnabled:YES];
+
+  UIScrollView* pageScrollView = [_pagesOfScrollViews objectAtIndex:_dragPage];
+  button.center = [self convertPoint:button.center toView:pageScrollView];
+  [pageScrollView addSubview:button];
+
+  CGRect frame = [_layout frameForButtonAtIndex:_dragIndex];
+  [UIView beginAnimations:nil context:nil];
+  [UIView setAnimationDuration:kEditingAnimationDuration];
+  button.transform = CGAffineTransformIdentity;
+  button.alpha = 1;
+  button.center = CGPointMake(CGRectGetMidX(frame), CGRectGetMidY(frame));
+  [UIView commitAnimations];
+
+  BOOL didMove = (_dragPage != _dragOriginPage || _dragIndex != _dragOriginIndex);
+  if (reportMove && didMove
+      && [self.delegate respondsToSelector:
+          @selector(launcherView:didMoveButton:fromPage:atIndex:toPage:atIndex:)]) {
+    [self.delegate launcherView: self
+                  didMoveButton: button
+                       fromPage: _dragOriginPage
+                        atIndex: _dragOriginIndex
+                         toPage: _dragPage
+                        atIndex: _dragIndex];
+
+    if (_dragPage != _dragOriginPage) {
+      // A button that didn't fit within maxNumberOfButtonsPerPage may fit on the old page now.
+      NSInteger numberOfButtons = [[_pagesOfButtons objectAtIndex:_dragOriginPage] count];
+      [self reconcileButtonCountForPage:_dragOriginPage];
+      NSInteger numberOfAddedButtons = ([[_pagesOfButtons objectAtIndex:_dragOriginPage] count]
+                                        - numberOfButtons);
+      if (numberOfAddedButtons > 0) {
+        [self layoutButtonsOnPage: _dragOriginPage
+                          inRange: NSMakeRange(numberOfButtons, numberOfAddedButtons)];
+        [self updateContentSizeOfPage:_dragOriginPage];
+      }
+    }
+  }
+
+  // The pages that were kept loaded for the drag may be unloaded now.
+  [self updateLoadedPages];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Page in the direction of the edge that the dragged button is being held against.
+ */
+- (void)updateEditingPageTimer {
+  NSInteger direction = 0;
+  if (_dragTouchPoint.x < kEditingPageEdgeWidth) {
+    direction = -1;
+
+  } else if (_dragTouchPoint.x > self.bounds.size.width - kEditingPageEdgeWidth) {
+    direction = 1;
+  }
+
+  if (direction != _editingPageDirection) {
+    [self stopEditingPageTimer];
+
+    if (0 != direction) {
+      _editingPageDirection = direction;
+      _editingPageTimer = [self scheduledTimerWithTimeInterval: kEditingPageDelay
+                                                      selector: @selector(editingPageTimerDidFire:)
+                                                       repeats: YES];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)editingPageTimerDidFire:(NSTimer *)timer {
+  NSInteger page = _pager.currentPage + _editingPageDirection;
+  if (page >= 0 && page < _numberOfPages) {
+    // The dragged button is moved onto the new page once the scroll animation ends.
+    [self setCurrentPage:page animated:YES];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)longPressTimerDidFire:(NSTimer *)timer {
+  UIButton* button = _pressedButton;
+  // Timers that don't repeat are invalidated once they fire.
+  _longPressTimer = nil;
+  _pressedButton = nil;
+
+  if ([self.delegate respondsToSelector:@selector(launcherViewShouldBeginEditing:)]
+      && ![self.delegate launcherViewShouldBeginEditing:self]) {
+    return;
+  }
+
+  self.editing = YES;
+  [self beginDraggingButton:button];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)buttonDidTouchDown:(UIButton *)button withEvent:(UIEvent *)event {
+  if (nil != _draggingButton) {
+    // Only one button can be dragged at a time.
+    return;
+  }
+
+  _dragTouchPoint = [[[event touchesForView:button] anyObject] locationInView:self];
+
+  if (_isEditing) {
+    [self beginDraggingButton:button];
+
+  } else if (nil == _filteredIndexPaths
+             && [self.delegate respondsToSelector:
+                 @selector(launcherView:didMoveButton:fromPage:atIndex:toPage:atIndex:)]) {
+    [self cancelLongPress];
+    _pressedButton = button;
+    _longPressTimer = [self scheduledTimerWithTimeInterval: kLongPressDuration
+                                                  selector: @selector(longPressTimerDidFire:)
+                                                   repeats: NO];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)buttonDidDrag:(UIButton *)button withEvent:(UIEvent *)event {
+  CGPoint point = [[[event touchesForView:button] anyObject] locationInView:self];
+
+  if (button == _pressedButton) {
+    // A touch that wanders is the start of a scroll rather than a long press.
+    if (fabsf(point.x - _dragTouchPoint.x) > kLongPressAllowableMovement
+        || fabsf(point.y - _dragTouchPoint.y) > kLongPressAllowableMovement) {
+      [self cancelLongPress];
+    }
+    return;
+  }
+
+  if (button != _draggingButton) {
+    return;
+  }
+
+  _dragTouchPoint = point;
+  button.center = CGPointMake(point.x + _dragTouchOffset.x, point.y + _dragTouchOffset.y);
+
+  [self updateDraggingButtonSlot];
+  [self updateEditingPageTimer];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)buttonDidEndTouch:(UIButton *)button {
+  if (button == _pressedButton) {
+    [self cancelLongPress];
+
+  } else if (button == _draggingButton) {
+    [self dropDraggingButtonAndReportMove:YES];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setEditing:(BOOL)editing {
+  if (_isEditing == editing) {
+    return;
+  }
+
+  [self cancelLongPress];
+  if (!editing && nil != _draggingButton) {
+    [self dropDraggingButtonAndReportMove:YES];
+  }
+
+  _isEditing = editing;
+
+  if (_isEditing) {
+    if ([self.delegate respondsToSelector:@selector(launcherViewDidBeginEditing:)]) {
+      [self.delegate launcherViewDidBeginEditing:self];
+    }
+
+  } else if ([self.delegate respondsToSelector:@selector(launcherViewDidEndEditing:)]) {
+    [self.delegate launcherViewDidEndEditing:self];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Filtering
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSArray *)filteredIndexPaths {
+  return _filteredIndexPaths;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setFilteredIndexPaths:(NSArray *)filteredIndexPaths {
+  if (_filteredIndexPaths == filteredIndexPaths
+      || [_filteredIndexPaths isEqualToArray:filteredIndexPaths]) {
+    return;
+  }
+
+  self.editing = NO;
+
+  // The loaded pages have to be unloaded as the kind of page that they were loaded as.
+  for (NSInteger ixPage = 0; ixPage < [_pagesOfButtons count]; ++ixPage) {
+    [self unloadPage:ixPage];
+  }
+
+  BOOL wasFiltering = (nil != _filteredIndexPaths);
+  [_filteredIndexPaths release];
+  _filteredIndexPaths = [filteredIndexPaths copy];
+
+  if (nil != _filteredIndexPaths) {
+    if (!wasFiltering) {
+      _pageBeforeFiltering = _pager.currentPage;
+    }
+    // Every new set of results starts from the first page.
+    _pager.currentPage = 0;
+    [self reloadData];
+
+  } else {
+    [self reloadData];
+    [self setCurrentPage:_pageBeforeFiltering animated:NO];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Properties
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setDataSource:(id<NILauncherDataSource>)dataSource {
+  [self cancelAllPrefetching];
+
+  _dataSource = dataSource;
+
+  // The layout methods are called every time the layout metrics are recalculated, so we only
+  // ask the data source which of them it implements once.
+  _dataSourceProvidesButtonDimensions =
+  [_dataSource respondsToSelector:@selector(buttonDimensionsInLauncherView:)];
+  _dataSourceProvidesNumberOfRows =
+  [_dataSource respondsToSelector:@selector(numberOfRowsPerPageInLauncherView:)];
+  _dataSourceProvidesNumberOfColumns =
+  [_dataSource respondsToSelector:@selector(numberOfColumnsPerPageInLauncherView:)];
+  _dataSourcePrefetches =
+  [_dataSource conformsToProtocol:@protocol(NILauncherPrefetchingDataSource)];
+
+  [self invalidateLayout];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setPadding:(UIEdgeInsets)padding {
+  if (!UIEdgeInsetsEqualToEdgeInsets(_padding, padding)) {
+    _padding = padding;
+
+    [self invalidateLayout];
+    [self layoutPages];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setNumberOfPagesToPrefetch:(NSInteger)numberOfPagesToPrefetch {
+  NIDASSERT(numberOfPagesToPrefetch >= 0);
+  _numberOfPagesToPrefetch = MAX(0, numberOfPagesToPrefetch);
+
+  if (0 == _numberOfPagesToPrefetch) {
+    [self cancelAllPrefetching];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setNumberOfAdjacentPagesToLoad:(NSInteger)numberOfAdjacentPagesToLoad {
+  NIDASSERT(numberOfAdjacentPagesToLoad >= 0);
+  _numberOfAdjacentPagesToLoad = MAX(0, numberOfAdjacentPagesToLoad);
+  _isLimitedByMemoryWarning = NO;
+
+  [self updateLoadedPages];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setMaxNumberOfResidentPages:(NSInteger)maxNumberOfResidentPages {
+  NIDASSERT(maxNumberOfResidentPages >= 1);
+  _maxNumberOfResidentPages = MAX(1, maxNumberOfResidentPages);
+  _isLimitedByMemoryWarning = NO;
+
+  [self updateLoadedPages];
 }
 
 
@@ -23,6 +23,12 @@
 #import "NILauncherView.h"
 #endif
 
+@class CALayer;
+@class NIImageMemoryCache;
+@class NILauncherSearchIndex;
+@protocol NILauncherItemSource;
+@protocol NILauncherItemSourceDelegate;
+
 /**
  * @brief A view controller that displays a launcher view and implements its protocols.
  *
@@ -61,21 +67,55 @@
  * functionality by default in this controller.
  *
  *
- * @image html NILauncherViewControllerExample1.png "Example of an NILauncherViewController as seen in the BasicLauncher demo application."
+ * Buttons can be rearranged by touching and holding one of them. While the launcher is being
+ * edited, a Done button replaces the navigation item's right bar button item. Moved buttons
+ * are applied to the pages directly, so the launcher view isn't reloaded. The launcher can't be
+ * edited while its items come from an itemSource.
+ *
+ * Launcher pages can be stored and loaded with NILauncherPagesArchive, which can also be used
+ * directly as the itemSource.
  *
  *
- * @todo Implement a reusable means of storing and loading launcher state information. This can
- * probably be easily accomplished using simple keyed archiving because NILauncherItemDetails
- * implements the NSCoding protocol.
+ * @image html NILauncherViewControllerExample1.png "Example of an NILauncherViewController as seen in the BasicLauncher demo application."
  */
 @interface NILauncherViewController : UIViewController <
   NILauncherDelegate,
-  NILauncherDataSource
+  NILauncherPrefetchingDataSource
 > {
 @private
   NILauncherView* _launcherView;
 
-  NSMutableArray* _pages; // Array< Array<NILauncherItemDetails *> >
+  NSArray* _pages; // Array< Array<NILauncherItemDetails *> >
+
+  // Item Source
+  // Only the pages that are loaded in the launcher view are kept.
+  id<NILauncherItemSource>  _itemSource;
+  NSMutableDictionary*      _itemSourcePages; // Dictionary< NSNumber(page), Array<Items> >
+  NSMutableIndexSet*        _pendingItemSourcePages;
+
+  // Image Loading
+  UIImage*              _placeholderImage;
+  NIImageMemoryCache*   _imageMemoryCache;
+  NSOperationQueue*     _imageLoadingQueue;
+  NSMutableDictionary*  _imageLoadingOperations; // Dictionary< NSValue(UIButton *), NSOperation >
+  NSMutableDictionary*  _networkImageButtons;  // Dictionary< NSString(URL), Array<UIButton *> >
+
+  // Prefetching
+  // Pages are removed from the prefetched pages once the launcher view loads them.
+  NSMutableIndexSet*    _prefetchedPages;
+  NSMutableDictionary*  _prefetchImageOperations; // Dictionary< NSString(path), NSOperation >
+  NSMutableDictionary*  _prefetchedImagePaths; // Dictionary< NSNumber(page), Array<NSString *> >
+  NSMutableDictionary*  _prefetchedImageURLs;  // Dictionary< NSNumber(page), Array<NSString *> >
+
+  // Editing
+  // Restored once editing ends.
+  UIBarButtonItem*      _nonEditingRightBarButtonItem;
+
+  // Searching
+  // The index is built the first time the launcher is searched and then kept up to date as
+  // the pages change.
+  NSString*               _searchText;
+  NILauncherSearchIndex*  _searchIndex;
 }
 
 /**
@@ -98,9 +138,93 @@
  *       the contents of the pages after they have been stored in this view controller.
  *       If you need to modify the pages after assigning them here, you should assign
  *       a new set of pages.
+ *
+ * Assigning a new set of pages only updates the buttons for the items that have changed.
+ * Items are compared using isEqual:. Assigning pages removes the itemSource.
+ *
+ * Reading this property does not copy the pages. If an itemSource is being used, the pages are
+ * gathered from it with NILauncherItemSource::itemsForPage:, which may be expensive, or nil is
+ * returned if the item source only loads its items asynchronously.
  */
 @property (nonatomic, readwrite, copy) NSArray* pages;
 
+/**
+ * @brief A source of items that are fetched a page at a time as they are displayed.
+ *
+ * Use an item source instead of assigning pages when the launcher has too many items to keep
+ * in memory at once. The controller only keeps the items of the pages that are loaded in the
+ * launcher view; set NILauncherView::numberOfAdjacentPagesToLoad to limit how many that is.
+ *
+ * Buttons for items that an asynchronous item source has not yet delivered show no title and
+ * the placeholderImage until they arrive.
+ *
+ * Assigning an item source discards the pages. Defaults to nil.
+ */
+@property (nonatomic, readwrite, retain) id<NILauncherItemSource> itemSource;
+
+/**
+ * @brief Discard every item fetched from the itemSource and reload the launcher view.
+ *
+ * Call this when the item source's contents have changed.
+ */
+- (void)reloadItemSource;
+
+/**
+ * @brief Save the pages to a file using the NILauncherPagesArchive format.
+ *
+ * @returns YES if the file was written.
+ */
+- (BOOL)savePagesToFile:(NSString *)path error:(NSError **)error;
+
+/**
+ * @brief Replace the pages with those stored in a file written by savePagesToFile:error:.
+ *
+ * The archive becomes the controller's itemSource. The file is memory-mapped and items are
+ * only created as the launcher view displays them, so
+ * the cost of restoring the launcher depends on the number of pages shown rather than the
+ * number of items saved. Combine this with NILauncherView::numberOfAdjacentPagesToLoad to keep
+ * the number of loaded pages small.
+ *
+ * @returns NO if the file could not be read, in which case the pages are left unmodified.
+ */
+- (BOOL)loadPagesFromFile:(NSString *)path error:(NSError **)error;
+
+/**
+ * @brief Only show the items whose titles match this text.
+ *
+ * Matching items are shown in page order, packed into as few pages as possible, using
+ * NILauncherView::filteredIndexPaths. For example, "caf me" matches an item titled
+ * "Café Menu"; see NILauncherSearchIndex for the details. Set this from a search field's
+ * change notifications to filter as the user types.
+ *
+ * Assigning new pages while searching updates the results. Searching isn't possible while
+ * the items come from an itemSource. Set nil or an empty string to show every item.
+ */
+@property (nonatomic, readwrite, copy) NSString* searchText;
+
+/**
+ * @brief The image shown on a button while its item's image is being loaded.
+ *
+ * Item images are read from disk and decompressed on a background thread so that showing a new
+ * page of buttons doesn't stall the main thread. If a button is reused before its image has
+ * loaded, the pending load is cancelled.
+ *
+ * Defaults to nil.
+ */
+@property (nonatomic, readwrite, retain) UIImage* placeholderImage;
+
+/**
+ * @brief The in-memory cache of decompressed item images, keyed by image path.
+ *
+ * Buttons whose images are found in this cache are given the image immediately, without
+ * touching the disk. Images are added to the cache once they have been loaded.
+ *
+ * Assign the same cache to several launcher controllers to share images between them.
+ *
+ * By default, each controller creates its own cache that holds up to 4 megabytes of pixels.
+ */
+@property (nonatomic, readwrite, retain) NIImageMemoryCache* imageMemoryCache;
+
 
 /**
  * @name Subclassing
@@ -121,6 +245,17 @@
  */
 - (Class)launcherButtonClass;
 
+/**
+ * @brief The reuse identifier given to buttons created by this controller.
+ *
+ * Buttons are dequeued from the launcher view with this identifier before new ones are
+ * allocated. If the button class implements setReuseIdentifier:, newly created buttons are
+ * assigned this identifier.
+ *
+ * Defaults to the name of launcherButtonClass.
+ */
+- (NSString *)launcherButtonReuseIdentifier;
+
 /**@}*/
 
 @end
@@ -136,9 +271,29 @@
  *
  * @image html NILauncherButtonExample1.png "Example of an NILauncherButton"
  */
-@interface NILauncherButton : UIButton {
+@interface NILauncherButton : UIButton <NILauncherReusableButton> {
 @private
   UIEdgeInsets _padding;
+  NSString*    _reuseIdentifier;
+
+  // The most recent title measurement. The title is only measured again once the title, font,
+  // width, or line break mode changes.
+  CGSize            _titleLabelSize;
+  NSString*         _measuredTitle;
+  UIFont*           _measuredTitleFont;
+  CGFloat           _measuredTitleWidth;
+  UILineBreakMode   _measuredTitleLineBreakMode;
+
+  // Flattened Drawing
+  BOOL      _drawsContentFlattened;
+  BOOL      _needsFlattenedRender;
+  UIImage*  _flattenedContents;
+
+  // Badge
+  // The badge image is shared by every button with the same badge value.
+  NSString* _badgeValue;
+  UIImage*  _badgeImage;
+  CALayer*  _badgeLayer;
 }
 
 /**
@@ -150,6 +305,50 @@
  */
 @property (nonatomic, readwrite, assign) UIEdgeInsets padding;
 
+/**
+ * @brief The identifier used by the launcher view to queue this button for reuse.
+ *
+ * Buttons with a nil reuse identifier are not reused. Defaults to nil.
+ */
+@property (nonatomic, readwrite, copy) NSString* reuseIdentifier;
+
+/**
+ * @brief Whether the image and title are drawn into the button's own backing store.
+ *
+ * By default the button shows its image and title in separate image view and label subviews,
+ * each of which is a layer that must be composited while the launcher scrolls. When this is
+ * enabled the subviews are hidden and the image and title are drawn into a single bitmap that
+ * becomes the contents of the button's layer. The bitmap is only drawn again when the title,
+ * image, title color, padding, size, or highlighted and selected states change.
+ *
+ * Enable this when showing many buttons per page on older hardware.
+ *
+ * Defaults to NO.
+ */
+@property (nonatomic, readwrite, assign) BOOL drawsContentFlattened;
+
+/**
+ * @brief The text shown in a badge at the top right corner of the button.
+ *
+ * Typically a count of unread items. The badge is drawn once per distinct value into an image
+ * that is shared between buttons, so badges don't add any views to the button. When the
+ * content is flattened the badge is drawn into the flattened bitmap; otherwise the shared image
+ * is shown by a single bare layer.
+ *
+ * Changing the badge doesn't lay out the button's image or title again, so it is cheap enough
+ * to update on every loaded button at once.
+ *
+ * Setting a nil or empty value hides the badge. Defaults to nil.
+ */
+@property (nonatomic, readwrite, copy) NSString* badgeValue;
+
+/**
+ * @brief Clears the title, image, and control state of the button.
+ *
+ * Called by the launcher view when this button is placed in the reuse queue.
+ */
+- (void)prepareForReuse;
+
 @end
 
 
@@ -167,6 +366,8 @@
 @private
   NSString* _title;
   NSString* _imagePath;
+  NSString* _imageURL;
+  NSString* _badgeValue;
 }
 
 /**
@@ -179,6 +380,29 @@
  */
 @property (nonatomic, readwrite, copy) NSString* imagePath;
 
+/**
+ * @brief The URL of a launcher image to load from the network.
+ *
+ * When set, NILauncherViewController loads the image using NINetworkImageLoader instead of
+ * from imagePath.
+ */
+@property (nonatomic, readwrite, copy) NSString* imageURL;
+
+/**
+ * @brief The badge shown on the launcher button, see NILauncherButton::badgeValue.
+ *
+ * When new pages are assigned to NILauncherViewController, items that only differ in their
+ * badges update the badges of their buttons in place rather than reloading them.
+ *
+ * Badges usually reflect transient state and are not saved by NILauncherPagesArchive.
+ */
+@property (nonatomic, readwrite, copy) NSString* badgeValue;
+
+/**
+ * @brief Whether the two items would produce identical launcher buttons, apart from the badge.
+ */
+- (BOOL)isEqualToItemDetailsIgnoringBadge:(NILauncherItemDetails *)itemDetails;
+
 /**
  * @brief Convenience method for creating a launcher item details object.
  *
@@ -187,6 +411,14 @@
  */
 + (id)itemDetailsWithTitle:(NSString *)title imagePath:(NSString *)imagePath;
 
+/**
+ * @brief Convenience method for creating a launcher item details object with a network image.
+ *
+ * @param title       The title for the launcher button.
+ * @param imageURL    The URL of the launcher image.
+ */
++ (id)itemDetailsWithTitle:(NSString *)title imageURL:(NSString *)imageURL;
+
 /**
  * @brief The designated initializer.
  *
@@ -196,3 +428,76 @@
 - (id)initWithTitle:(NSString *)title imagePath:(NSString *)imagePath;
 
 @end
+
+
+/**
+ * @brief A source of launcher items that are fetched one page at a time.
+ * @ingroup Launcher-Protocols
+ *
+ * The number of pages and the number of items on each page must be known up front, but the
+ * items themselves are only requested when their page is shown. Implement itemsForPage: to
+ * provide the items immediately, or loadItemsForPage:delegate: to load them in the background.
+ *
+ * NILauncherPagesArchive is an item source.
+ */
+@protocol NILauncherItemSource <NSObject>
+
+@required
+
+/**
+ * @brief The total number of pages.
+ */
+- (NSInteger)numberOfPages;
+
+/**
+ * @brief The number of items on the given page.
+ */
+- (NSInteger)numberOfItemsInPage:(NSInteger)page;
+
+@optional
+
+/**
+ * @brief The NILauncherItemDetails on the given page.
+ *
+ * If implemented, this is used instead of loadItemsForPage:delegate:.
+ */
+- (NSArray *)itemsForPage:(NSInteger)page;
+
+/**
+ * @brief Begin loading the NILauncherItemDetails on the given page.
+ *
+ * Call NILauncherItemSourceDelegate::itemSource:didLoadItems:forPage: on the main thread once the
+ * items have loaded. The delegate may be notified before this method returns. The delegate is
+ * not retained.
+ */
+- (void)loadItemsForPage:(NSInteger)page delegate:(id<NILauncherItemSourceDelegate>)delegate;
+
+/**
+ * @brief The items on the given page are no longer needed by the delegate.
+ *
+ * Called when a page is unloaded before its items have been delivered.
+ */
+- (void)cancelLoadingItemsForPage: (NSInteger)page
+                         delegate: (id<NILauncherItemSourceDelegate>)delegate;
+
+@end
+
+
+/**
+ * @brief Receives the items loaded asynchronously by an NILauncherItemSource.
+ * @ingroup Launcher-Protocols
+ */
+@protocol NILauncherItemSourceDelegate <NSObject>
+
+@required
+
+/**
+ * @brief The items on the given page have been loaded.
+ *
+ * Must be called on the main thread.
+ */
+- (void)itemSource: (id<NILauncherItemSource>)itemSource
+      didLoadItems: (NSArray *)items
+           forPage: (NSInteger)page;
+
+@end
@@ -17,6 +17,142 @@
 #import "NILauncherViewController.h"
 
 #import "NILauncherView.h"
+#import "NILauncherPagesArchive.h"
+#import "NILauncherSearchIndex.h"
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NIInMemoryCache.h"
+#import "NimbusNetworkImage/NINetworkImageLoader.h"
+#else
+#import "NIInMemoryCache.h"
+#import "NINetworkImageLoader.h"
+#endif
+
+static const NSInteger kMaxNumberOfConcurrentImageLoads = 2;
+static const NSUInteger kDefaultImageMemoryCacheMaxTotalCost = 4 * 1024 * 1024;
+
+@class NILauncherImageLoadOperation;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface NILauncherViewController() <
+  NINetworkImageLoaderDelegate,
+  NILauncherItemSourceDelegate
+>
+
+- (void)imageLoadOperation:(NILauncherImageLoadOperation *)operation didLoadImage:(UIImage *)image;
+- (void)prefetchImagesForItems:(NSArray *)items onPage:(NSInteger)page;
+- (void)forgetPrefetchedPage:(NSInteger)page;
+- (void)cancelAllPrefetching;
+- (BOOL)isSearching;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Reads and decompresses a launcher button's image on a background thread.
+ *
+ * The result is handed back to the controller on the main thread.
+ */
+@interface NILauncherImageLoadOperation : NSOperation {
+@private
+  NSString* _imagePath;
+  UIButton* _button;
+  UIImage*  _image;
+  NILauncherViewController* _controller;
+}
+
+// The button may be nil to only load the image into the controller's image memory cache.
+- (id)initWithImagePath:(NSString *)imagePath button:(UIButton *)button;
+
+@property (nonatomic, readonly, copy) NSString* imagePath;
+@property (nonatomic, readonly, retain) UIButton* button;
+
+// The decoded image. Only valid once the operation has finished.
+@property (nonatomic, readonly, retain) UIImage* image;
+
+// Only accessed from the main thread. Set to nil before cancelling the operation.
+@property (nonatomic, readwrite, assign) NILauncherViewController* controller;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NILauncherImageLoadOperation
+
+@synthesize imagePath   = _imagePath;
+@synthesize button      = _button;
+@synthesize image       = _image;
+@synthesize controller  = _controller;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_imagePath);
+  NI_RELEASE_SAFELY(_button);
+  NI_RELEASE_SAFELY(_image);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithImagePath:(NSString *)imagePath button:(UIButton *)button {
+  if ((self = [super init])) {
+    _imagePath = [imagePath copy];
+    _button = [button retain];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didLoadImage:(UIImage *)image {
+  if (![self isCancelled]) {
+    [_controller imageLoadOperation:self didLoadImage:image];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)main {
+  NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+  NI_TRACE_BEGIN("NILauncherImageLoadOperation");
+
+  if (![self isCancelled]) {
+    // A prefetch of the same image that this operation was made to wait on may have already
+    // decoded it.
+    for (NILauncherImageLoadOperation* dependency in [self dependencies]) {
+      if (nil == _image && [dependency.imagePath isEqualToString:_imagePath]) {
+        _image = [dependency.image retain];
+      }
+    }
+
+    if (nil == _image) {
+      _image = [NIDecodedImageWithContentsOfFile(_imagePath) retain];
+    }
+
+    if (![self isCancelled]) {
+      [self performSelectorOnMainThread: @selector(didLoadImage:)
+                             withObject: _image
+                          waitUntilDone: NO];
+    }
+  }
+
+  NI_TRACE_END("NILauncherImageLoadOperation");
+
+  [pool release];
+}
+
+
+@end
+
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -24,13 +160,36 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 @implementation NILauncherViewController
 
-@synthesize launcherView  = _launcherView;
-@synthesize pages         = _pages;
+@synthesize launcherView      = _launcherView;
+@synthesize pages             = _pages;
+@synthesize placeholderImage  = _placeholderImage;
+@synthesize imageMemoryCache  = _imageMemoryCache;
+@synthesize itemSource        = _itemSource;
+@synthesize searchText        = _searchText;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)dealloc {
+  [self cancelAllPrefetching];
+  [self cancelAllImageLoads];
+  [self discardItemSourcePages];
+
   NI_RELEASE_SAFELY(_pages);
+  NI_RELEASE_SAFELY(_itemSource);
+  NI_RELEASE_SAFELY(_itemSourcePages);
+  NI_RELEASE_SAFELY(_pendingItemSourcePages);
+  NI_RELEASE_SAFELY(_placeholderImage);
+  NI_RELEASE_SAFELY(_imageMemoryCache);
+  NI_RELEASE_SAFELY(_imageLoadingQueue);
+  NI_RELEASE_SAFELY(_imageLoadingOperations);
+  NI_RELEASE_SAFELY(_networkImageButtons);
+  NI_RELEASE_SAFELY(_prefetchedPages);
+  NI_RELEASE_SAFELY(_prefetchImageOperations);
+  NI_RELEASE_SAFELY(_prefetchedImagePaths);
+  NI_RELEASE_SAFELY(_prefetchedImageURLs);
+  NI_RELEASE_SAFELY(_nonEditingRightBarButtonItem);
+  NI_RELEASE_SAFELY(_searchText);
+  NI_RELEASE_SAFELY(_searchIndex);
   // _launcherView is retained by self.view and is released in viewDidUnload
 
   [super dealloc];
@@ -53,12 +212,28 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)viewDidUnload {
+  // The buttons are going away along with the launcher view.
+  [self cancelAllPrefetching];
+  [self cancelAllImageLoads];
+  [self discardItemSourcePages];
   _launcherView = nil;
 
   [super viewDidUnload];
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didReceiveMemoryWarning {
+  // The launcher view and the image memory cache free their own memory when they receive the
+  // warning. The search index is rebuilt from the pages the next time a search begins.
+  if (![self isSearching]) {
+    NI_RELEASE_SAFELY(_searchIndex);
+  }
+
+  [super didReceiveMemoryWarning];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (BOOL)shouldAutorotateToInterfaceOrientation:(UIInterfaceOrientation)toInterfaceOrientation {
   // Only allow portrait for the iPhone and iPod touch.
@@ -66,6 +241,376 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Lay out the launcher for the opposite orientation in the background, if it can rotate.
+ *
+ * The bars above the launcher are assumed to take up the same height in both orientations, as
+ * they do on the iPad. If they don't, the launcher view ignores the layout and calculates a new
+ * one when it rotates.
+ */
+- (void)precomputeLauncherLayoutForOppositeOrientation {
+  UIInterfaceOrientation orientation = (UIInterfaceOrientationIsPortrait(self.interfaceOrientation)
+                                        ? UIInterfaceOrientationLandscapeLeft
+                                        : UIInterfaceOrientationPortrait);
+  if (nil == _launcherView || ![self shouldAutorotateToInterfaceOrientation:orientation]) {
+    return;
+  }
+
+  CGSize size = _launcherView.bounds.size;
+  CGSize screenSize = [UIScreen mainScreen].bounds.size;
+  CGFloat screenHeight = (UIInterfaceOrientationIsPortrait(self.interfaceOrientation)
+                          ? screenSize.height : screenSize.width);
+  CGFloat barsHeight = screenHeight - size.height;
+
+  CGSize rotatedScreenSize = (UIInterfaceOrientationIsPortrait(orientation)
+                              ? screenSize : CGSizeMake(screenSize.height, screenSize.width));
+  CGRect frame = CGRectMake(0, 0,
+                            rotatedScreenSize.width, rotatedScreenSize.height - barsHeight);
+
+  [_launcherView precomputeLayoutForFrame: frame
+                             numberOfRows: [self numberOfRowsPerPageForInterfaceOrientation:
+                                            orientation]
+                          numberOfColumns: [self numberOfColumnsPerPageForInterfaceOrientation:
+                                            orientation]];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)viewDidAppear:(BOOL)animated {
+  [super viewDidAppear:animated];
+
+  [self precomputeLauncherLayoutForOppositeOrientation];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didRotateFromInterfaceOrientation:(UIInterfaceOrientation)fromInterfaceOrientation {
+  [super didRotateFromInterfaceOrientation:fromInterfaceOrientation];
+
+  // The launcher view keeps the layout it just replaced, but the bars may have changed height.
+  [self precomputeLauncherLayoutForOppositeOrientation];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Image Loading
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSOperationQueue *)imageLoadingQueue {
+  if (nil == _imageLoadingQueue) {
+    _imageLoadingQueue = [[NSOperationQueue alloc] init];
+    [_imageLoadingQueue setMaxConcurrentOperationCount:kMaxNumberOfConcurrentImageLoads];
+  }
+  return _imageLoadingQueue;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NIImageMemoryCache *)imageMemoryCache {
+  if (nil == _imageMemoryCache) {
+    _imageMemoryCache =
+    [[NIImageMemoryCache alloc] initWithMaxTotalCost:kDefaultImageMemoryCacheMaxTotalCost];
+  }
+  return _imageMemoryCache;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelNetworkImageLoadForButton:(UIButton *)button {
+  // Buttons waiting on the same URL share a single request, so the request is only cancelled
+  // once no buttons need it.
+  for (NSString* url in [_networkImageButtons allKeys]) {
+    NSMutableArray* buttons = [_networkImageButtons objectForKey:url];
+    if ([buttons indexOfObjectIdenticalTo:button] != NSNotFound) {
+      [buttons removeObjectIdenticalTo:button];
+      if ([buttons count] == 0) {
+        [[NINetworkImageLoader globalLoader] cancelRequestForURL:url delegate:self];
+        [_networkImageButtons removeObjectForKey:url];
+      }
+      break;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelImageLoadForButton:(UIButton *)button {
+  [self cancelNetworkImageLoadForButton:button];
+
+  NSValue* key = [NSValue valueWithNonretainedObject:button];
+  NILauncherImageLoadOperation* operation = [_imageLoadingOperations objectForKey:key];
+  if (nil != operation) {
+    operation.controller = nil;
+    [operation cancel];
+    [_imageLoadingOperations removeObjectForKey:key];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelAllImageLoads {
+  for (NILauncherImageLoadOperation* operation in [_imageLoadingOperations objectEnumerator]) {
+    operation.controller = nil;
+    [operation cancel];
+  }
+  [_imageLoadingOperations removeAllObjects];
+
+  for (NSString* url in [_networkImageButtons keyEnumerator]) {
+    [[NINetworkImageLoader globalLoader] cancelRequestForURL:url delegate:self];
+  }
+  [_networkImageButtons removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Show the placeholder image on the button and start loading the real image.
+ *
+ * Any image that is still being loaded for this button is for a previous item, so it is
+ * cancelled first.
+ */
+- (void)loadImageForButton:(UIButton *)button fromPath:(NSString *)imagePath {
+  [self cancelImageLoadForButton:button];
+
+  if (nil == imagePath) {
+    [button setImage:_placeholderImage forState:UIControlStateNormal];
+    return;
+  }
+
+  UIImage* cachedImage = [self.imageMemoryCache objectForKey:imagePath];
+  if (nil != cachedImage) {
+    [button setImage:cachedImage forState:UIControlStateNormal];
+    return;
+  }
+
+  [button setImage:_placeholderImage forState:UIControlStateNormal];
+
+  if (nil == _imageLoadingOperations) {
+    _imageLoadingOperations = [[NSMutableDictionary alloc] init];
+  }
+
+  NILauncherImageLoadOperation* operation =
+  [[NILauncherImageLoadOperation alloc] initWithImagePath: imagePath
+                                                   button: button];
+  operation.controller = self;
+
+  // Rather than decoding the image twice, wait for a prefetch of it to finish.
+  NSOperation* prefetchOperation = [_prefetchImageOperations objectForKey:imagePath];
+  if (nil != prefetchOperation) {
+    [operation addDependency:prefetchOperation];
+  }
+
+  [_imageLoadingOperations setObject: operation
+                              forKey: [NSValue valueWithNonretainedObject:button]];
+  [self.imageLoadingQueue addOperation:operation];
+  [operation release];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)imageLoadOperation:(NILauncherImageLoadOperation *)operation didLoadImage:(UIImage *)image {
+  if (nil == image && nil != operation.imagePath) {
+    // Only PNG and JPEG images can be decoded off of the main thread.
+    image = [UIImage imageWithContentsOfFile:operation.imagePath];
+  }
+
+  UIButton* button = operation.button;
+  if (nil != image) {
+    [self.imageMemoryCache storeImage:image forKey:operation.imagePath];
+    [button setImage:image forState:UIControlStateNormal];
+  }
+
+  if (nil == button) {
+    [_prefetchImageOperations removeObjectForKey:operation.imagePath];
+
+  } else {
+    [_imageLoadingOperations removeObjectForKey:[NSValue valueWithNonretainedObject:button]];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Show the placeholder image on the button and start loading the image from the network.
+ */
+- (void)loadImageForButton:(UIButton *)button fromURL:(NSString *)imageURL {
+  [self cancelImageLoadForButton:button];
+
+  NINetworkImageLoader* loader = [NINetworkImageLoader globalLoader];
+  UIImage* cachedImage = [loader cachedImageForURL:imageURL];
+  if (nil != cachedImage) {
+    [button setImage:cachedImage forState:UIControlStateNormal];
+    return;
+  }
+
+  [button setImage:_placeholderImage forState:UIControlStateNormal];
+
+  if (nil == _networkImageButtons) {
+    _networkImageButtons = [[NSMutableDictionary alloc] init];
+  }
+
+  NSMutableArray* buttons = [_networkImageButtons objectForKey:imageURL];
+  if (nil == buttons) {
+    buttons = [NSMutableArray array];
+    [_networkImageButtons setObject:buttons forKey:imageURL];
+    [buttons addObject:button];
+    [loader requestImageAtURL:imageURL delegate:self];
+
+  } else {
+    [buttons addObject:button];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark NINetworkImageLoaderDelegate
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)networkImageLoader: (NINetworkImageLoader *)loader
+              didLoadImage: (UIImage *)image
+                    forURL: (NSString *)url {
+  for (UIButton* button in [_networkImageButtons objectForKey:url]) {
+    [button setImage:image forState:UIControlStateNormal];
+  }
+  [_networkImageButtons removeObjectForKey:url];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)networkImageLoader: (NINetworkImageLoader *)loader
+  didFailToLoadImageForURL: (NSString *)url
+                     error: (NSError *)error {
+  // The buttons keep showing the placeholder image.
+  [_networkImageButtons removeObjectForKey:url];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Item Source
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Forget the items fetched for the given page and cancel its load if it is pending.
+ */
+- (void)discardItemSourcePage:(NSInteger)page {
+  [_itemSourcePages removeObjectForKey:[NSNumber numberWithInteger:page]];
+
+  if ([_pendingItemSourcePages containsIndex:page]) {
+    [_pendingItemSourcePages removeIndex:page];
+    if ([_itemSource respondsToSelector:@selector(cancelLoadingItemsForPage:delegate:)]) {
+      [_itemSource cancelLoadingItemsForPage:page delegate:self];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Forget every page fetched from the item source and cancel any pending loads.
+ */
+- (void)discardItemSourcePages {
+  if ([_itemSource respondsToSelector:@selector(cancelLoadingItemsForPage:delegate:)]) {
+    NSUInteger ixPage = [_pendingItemSourcePages firstIndex];
+    while (NSNotFound != ixPage) {
+      [_itemSource cancelLoadingItemsForPage:ixPage delegate:self];
+      ixPage = [_pendingItemSourcePages indexGreaterThanIndex:ixPage];
+    }
+  }
+
+  [_pendingItemSourcePages removeAllIndexes];
+  [_itemSourcePages removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief The items on the given page, or nil if they are still being loaded.
+ *
+ * Items from the item source are fetched the first time their page is requested.
+ */
+- (NSArray *)itemsForPage:(NSInteger)page {
+  if (nil == _itemSource) {
+    return [_pages objectAtIndex:page];
+  }
+
+  NSNumber* key = [NSNumber numberWithInteger:page];
+  NSArray* items = [_itemSourcePages objectForKey:key];
+  if (nil != items || [_pendingItemSourcePages containsIndex:page]) {
+    return items;
+  }
+
+  if (nil == _itemSourcePages) {
+    _itemSourcePages = [[NSMutableDictionary alloc] init];
+    _pendingItemSourcePages = [[NSMutableIndexSet alloc] init];
+  }
+
+  if ([_itemSource respondsToSelector:@selector(itemsForPage:)]) {
+    items = [_itemSource itemsForPage:page];
+    if (nil != items) {
+      [_itemSourcePages setObject:items forKey:key];
+    }
+
+  } else if ([_itemSource respondsToSelector:@selector(loadItemsForPage:delegate:)]) {
+    [_pendingItemSourcePages addIndex:page];
+    [_itemSource loadItemsForPage:page delegate:self];
+
+    // The item source may have delivered the items immediately.
+    items = [_itemSourcePages objectForKey:key];
+  }
+
+  return items;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)itemSource: (id<NILauncherItemSource>)itemSource
+      didLoadItems: (NSArray *)items
+           forPage: (NSInteger)page {
+  if (itemSource != _itemSource || ![_pendingItemSourcePages containsIndex:page]) {
+    // The page was unloaded or the item source replaced while the items were loading.
+    return;
+  }
+
+  [_pendingItemSourcePages removeIndex:page];
+  if (nil == items) {
+    return;
+  }
+  [_itemSourcePages setObject:items forKey:[NSNumber numberWithInteger:page]];
+
+  if ([_prefetchedPages containsIndex:page]) {
+    [self prefetchImagesForItems:items onPage:page];
+    return;
+  }
+
+  // Replace the placeholder buttons. This does nothing if the page is still being loaded by
+  // the launcher view, in which case it will pick up the items itself.
+  NSInteger numberOfItems = MIN((NSInteger)[items count],
+                                [_itemSource numberOfItemsInPage:page]);
+  NSMutableArray* indexPaths = [NSMutableArray arrayWithCapacity:numberOfItems];
+  for (NSInteger ixItem = 0; ixItem < numberOfItems; ++ixItem) {
+    [indexPaths addObject:[NSIndexPath indexPathForRow:ixItem inSection:page]];
+  }
+  [_launcherView reloadButtonsAtIndexPaths:indexPaths];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)reloadItemSource {
+  [self discardItemSourcePages];
+  [_launcherView reloadData];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -73,33 +618,51 @@
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (NSInteger)numberOfRowsPerPageInLauncherView:(NILauncherView *)launcherView {
+- (NSInteger)numberOfRowsPerPageForInterfaceOrientation:(UIInterfaceOrientation)orientation {
   // Replace this with NILauncherViewDynamic to allow the launcher view to calculate the number
   // of rows and columns automatically.
   return (NIIsPad()
           ? 4
-          : (UIInterfaceOrientationIsPortrait(NIInterfaceOrientation())
+          : (UIInterfaceOrientationIsPortrait(orientation)
              ? 3 : 2));
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-- (NSInteger)numberOfColumnsPerPageInLauncherView:(NILauncherView *)launcherView {
+- (NSInteger)numberOfColumnsPerPageForInterfaceOrientation:(UIInterfaceOrientation)orientation {
   return (NIIsPad()
           ? 5
-          : (UIInterfaceOrientationIsPortrait(NIInterfaceOrientation())
+          : (UIInterfaceOrientationIsPortrait(orientation)
              ? 3 : 5));
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)numberOfRowsPerPageInLauncherView:(NILauncherView *)launcherView {
+  return [self numberOfRowsPerPageForInterfaceOrientation:NIInterfaceOrientation()];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)numberOfColumnsPerPageInLauncherView:(NILauncherView *)launcherView {
+  return [self numberOfColumnsPerPageForInterfaceOrientation:NIInterfaceOrientation()];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (NSInteger)numberOfPagesInLauncherView:(NILauncherView *)launcherView {
+  if (nil != _itemSource) {
+    return [_itemSource numberOfPages];
+  }
   return [_pages count];
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (NSInteger)launcherView:(NILauncherView *)launcherView numberOfButtonsInPage:(NSInteger)page {
+  if (nil != _itemSource) {
+    return [_itemSource numberOfItemsInPage:page];
+  }
   return [[_pages objectAtIndex:page] count];
 }
 
@@ -108,23 +671,218 @@
 - (UIButton *)launcherView: (NILauncherView *)launcherView
              buttonForPage: (NSInteger)page
                    atIndex: (NSInteger)index {
-  UIButton* button = [[[[self launcherButtonClass] alloc] init] autorelease];
+  NSString* reuseIdentifier = [self launcherButtonReuseIdentifier];
+  UIButton* button = [launcherView dequeueReusableButtonWithIdentifier:reuseIdentifier];
 
-  // launcherButtonClass must return a class that is a subclass of UIButton.
-  NIDASSERT([button isKindOfClass:[UIButton class]]);
-  if (![button isKindOfClass:[UIButton class]]) {
-    return nil;
+  if (nil == button) {
+    button = [[[[self launcherButtonClass] alloc] init] autorelease];
+
+    // launcherButtonClass must return a class that is a subclass of UIButton.
+    NIDASSERT([button isKindOfClass:[UIButton class]]);
+    if (![button isKindOfClass:[UIButton class]]) {
+      return nil;
+    }
+
+    if ([button respondsToSelector:@selector(setReuseIdentifier:)]) {
+      [(NILauncherButton *)button setReuseIdentifier:reuseIdentifier];
+    }
+  }
+
+  if ([_prefetchedPages containsIndex:page]) {
+    // The page is being loaded, so anything still being prefetched for it is needed now.
+    [self forgetPrefetchedPage:page];
   }
 
-  NILauncherItemDetails* item = [[_pages objectAtIndex:page] objectAtIndex:index];
+  // The items will be nil if an asynchronous item source hasn't delivered them yet.
+  NSArray* items = [self itemsForPage:page];
+  NILauncherItemDetails* item = ((index < (NSInteger)[items count])
+                                 ? [items objectAtIndex:index]
+                                 : nil);
   [button setTitle:item.title forState:UIControlStateNormal];
-  [button setImage: [UIImage imageWithContentsOfFile:item.imagePath]
-          forState: UIControlStateNormal];
+  if ([button respondsToSelector:@selector(setBadgeValue:)]) {
+    [(NILauncherButton *)button setBadgeValue:item.badgeValue];
+  }
+  if (nil != item.imageURL) {
+    [self loadImageForButton:button fromURL:item.imageURL];
+
+  } else {
+    [self loadImageForButton:button fromPath:item.imagePath];
+  }
 
   return button;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark NILauncherPrefetchingDataSource
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Start loading the images of the given items that aren't already in memory.
+ *
+ * Path images are decoded into the image memory cache and network images are requested from
+ * the global network image loader, which keeps them in its own cache.
+ */
+- (void)prefetchImagesForItems:(NSArray *)items onPage:(NSInteger)page {
+  NSMutableArray* imagePaths = [NSMutableArray array];
+  NSMutableArray* imageURLs = [NSMutableArray array];
+  NINetworkImageLoader* loader = [NINetworkImageLoader globalLoader];
+
+  for (NILauncherItemDetails* item in items) {
+    if (nil != item.imageURL) {
+      if (nil == [loader cachedImageForURL:item.imageURL]) {
+        [imageURLs addObject:item.imageURL];
+        [loader requestImageAtURL:item.imageURL delegate:self];
+      }
+
+    } else if (nil != item.imagePath
+               && nil == [self.imageMemoryCache objectForKey:item.imagePath]) {
+      [imagePaths addObject:item.imagePath];
+
+      if (nil == [_prefetchImageOperations objectForKey:item.imagePath]) {
+        NILauncherImageLoadOperation* operation =
+        [[NILauncherImageLoadOperation alloc] initWithImagePath: item.imagePath
+                                                         button: nil];
+        operation.controller = self;
+        [_prefetchImageOperations setObject:operation forKey:item.imagePath];
+        [self.imageLoadingQueue addOperation:operation];
+        [operation release];
+      }
+    }
+  }
+
+  NSNumber* key = [NSNumber numberWithInteger:page];
+  if ([imagePaths count] > 0) {
+    [_prefetchedImagePaths setObject:imagePaths forKey:key];
+  }
+  if ([imageURLs count] > 0) {
+    [_prefetchedImageURLs setObject:imageURLs forKey:key];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Stop tracking the given page as prefetched without cancelling any of its work.
+ */
+- (void)forgetPrefetchedPage:(NSInteger)page {
+  NSNumber* key = [NSNumber numberWithInteger:page];
+  [_prefetchedPages removeIndex:page];
+  [_prefetchedImagePaths removeObjectForKey:key];
+  [_prefetchedImageURLs removeObjectForKey:key];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)isImage:(NSString *)image prefetchedInPages:(NSDictionary *)imagesByPage {
+  for (NSArray* images in [imagesByPage objectEnumerator]) {
+    if ([images containsObject:image]) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Cancel the work started for a prefetched page that the launcher view hasn't loaded.
+ *
+ * Images that are shared with other prefetched pages, or that loaded buttons are waiting on,
+ * continue to load.
+ */
+- (void)cancelPrefetchingForPage:(NSInteger)page {
+  if (![_prefetchedPages containsIndex:page]) {
+    return;
+  }
+
+  NSNumber* key = [NSNumber numberWithInteger:page];
+  NSArray* imagePaths = [[[_prefetchedImagePaths objectForKey:key] retain] autorelease];
+  NSArray* imageURLs = [[[_prefetchedImageURLs objectForKey:key] retain] autorelease];
+  [self forgetPrefetchedPage:page];
+
+  for (NSString* imagePath in imagePaths) {
+    if (![self isImage:imagePath prefetchedInPages:_prefetchedImagePaths]) {
+      NILauncherImageLoadOperation* operation = [_prefetchImageOperations objectForKey:imagePath];
+      operation.controller = nil;
+      [operation cancel];
+      [_prefetchImageOperations removeObjectForKey:imagePath];
+    }
+  }
+
+  for (NSString* imageURL in imageURLs) {
+    if (nil == [_networkImageButtons objectForKey:imageURL]
+        && ![self isImage:imageURL prefetchedInPages:_prefetchedImageURLs]) {
+      [[NINetworkImageLoader globalLoader] cancelRequestForURL:imageURL delegate:self];
+    }
+  }
+
+  // The page isn't loaded, so there is no need to keep its items in memory.
+  [self discardItemSourcePage:page];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelAllPrefetching {
+  for (NILauncherImageLoadOperation* operation in [_prefetchImageOperations objectEnumerator]) {
+    operation.controller = nil;
+    [operation cancel];
+  }
+  [_prefetchImageOperations removeAllObjects];
+
+  NINetworkImageLoader* loader = [NINetworkImageLoader globalLoader];
+  for (NSArray* imageURLs in [_prefetchedImageURLs objectEnumerator]) {
+    for (NSString* imageURL in imageURLs) {
+      if (nil == [_networkImageButtons objectForKey:imageURL]) {
+        [loader cancelRequestForURL:imageURL delegate:self];
+      }
+    }
+  }
+  [_prefetchedImageURLs removeAllObjects];
+  [_prefetchedImagePaths removeAllObjects];
+  [_prefetchedPages removeAllIndexes];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)launcherView:(NILauncherView *)launcherView prefetchItemsForPages:(NSIndexSet *)pages {
+  if (nil == _prefetchedPages) {
+    _prefetchedPages = [[NSMutableIndexSet alloc] init];
+    _prefetchImageOperations = [[NSMutableDictionary alloc] init];
+    _prefetchedImagePaths = [[NSMutableDictionary alloc] init];
+    _prefetchedImageURLs = [[NSMutableDictionary alloc] init];
+  }
+
+  NSUInteger ixPage = [pages firstIndex];
+  while (NSNotFound != ixPage) {
+    if (![_prefetchedPages containsIndex:ixPage]) {
+      [_prefetchedPages addIndex:ixPage];
+
+      // Items from an asynchronous item source have their images prefetched once they arrive
+      // in itemSource:didLoadItems:forPage:.
+      NSArray* items = [self itemsForPage:ixPage];
+      if (nil != items) {
+        [self prefetchImagesForItems:items onPage:ixPage];
+      }
+    }
+    ixPage = [pages indexGreaterThanIndex:ixPage];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)launcherView:(NILauncherView *)launcherView cancelPrefetchingForPages:(NSIndexSet *)pages {
+  NSUInteger ixPage = [pages firstIndex];
+  while (NSNotFound != ixPage) {
+    [self cancelPrefetchingForPage:ixPage];
+    ixPage = [pages indexGreaterThanIndex:ixPage];
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -155,6 +913,85 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)launcherView:(NILauncherView *)launcher didUnloadPage:(NSInteger)page {
+  if (nil == _itemSource) {
+    return;
+  }
+
+  // Only the pages that are loaded in the launcher view are kept in memory.
+  [self discardItemSourcePage:page];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)launcherViewShouldBeginEditing:(NILauncherView *)launcher {
+  // Moves can only be applied to pages that we own.
+  return (nil == _itemSource);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)launcherViewDidBeginEditing:(NILauncherView *)launcher {
+  [_nonEditingRightBarButtonItem release];
+  _nonEditingRightBarButtonItem = [self.navigationItem.rightBarButtonItem retain];
+
+  UIBarButtonItem* doneItem =
+  [[[UIBarButtonItem alloc] initWithBarButtonSystemItem: UIBarButtonSystemItemDone
+                                                 target: self
+                                                 action: @selector(didTapDoneEditingButton:)]
+   autorelease];
+  [self.navigationItem setRightBarButtonItem:doneItem animated:YES];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)launcherViewDidEndEditing:(NILauncherView *)launcher {
+  [self.navigationItem setRightBarButtonItem:_nonEditingRightBarButtonItem animated:YES];
+  NI_RELEASE_SAFELY(_nonEditingRightBarButtonItem);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didTapDoneEditingButton:(UIBarButtonItem *)barButtonItem {
+  _launcherView.editing = NO;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)launcherView: (NILauncherView *)launcher
+       didMoveButton: (UIButton *)button
+            fromPage: (NSInteger)fromPage
+             atIndex: (NSInteger)fromIndex
+              toPage: (NSInteger)toPage
+             atIndex: (NSInteger)toIndex {
+  NIDASSERT(nil == _itemSource);
+  if (nil != _itemSource) {
+    return;
+  }
+
+  // Only the two pages involved are copied. The launcher view has already moved the button, so
+  // there is nothing for it to update.
+  NSMutableArray* pages = [[_pages mutableCopy] autorelease];
+  NSMutableArray* fromItems = [[[pages objectAtIndex:fromPage] mutableCopy] autorelease];
+  id item = [[[fromItems objectAtIndex:fromIndex] retain] autorelease];
+  [fromItems removeObjectAtIndex:fromIndex];
+
+  if (fromPage == toPage) {
+    [fromItems insertObject:item atIndex:toIndex];
+
+  } else {
+    NSMutableArray* toItems = [[[pages objectAtIndex:toPage] mutableCopy] autorelease];
+    [toItems insertObject:item atIndex:toIndex];
+    [pages replaceObjectAtIndex:toPage withObject:[NSArray arrayWithArray:toItems]];
+  }
+  [pages replaceObjectAtIndex:fromPage withObject:[NSArray arrayWithArray:fromItems]];
+
+  [_pages release];
+  _pages = [pages copy];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -167,6 +1004,226 @@
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)launcherButtonReuseIdentifier {
+  return NSStringFromClass([self launcherButtonClass]);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Update a button's badge in place if that is the only difference between its items.
+ *
+ * @returns NO if the button has to be reloaded instead.
+ */
+- (BOOL)updateBadgeOfButtonOnPage: (NSInteger)page
+                          atIndex: (NSInteger)index
+                         fromItem: (id)oldItem
+                           toItem: (id)newItem {
+  if (![oldItem isKindOfClass:[NILauncherItemDetails class]]
+      || ![newItem isKindOfClass:[NILauncherItemDetails class]]
+      || ![oldItem isEqualToItemDetailsIgnoringBadge:newItem]) {
+    return NO;
+  }
+
+  UIButton* button = [_launcherView buttonForPage:page atIndex:index];
+  if (nil == button) {
+    // The button will be created with the new badge once it is loaded.
+    return YES;
+  }
+
+  if (![button respondsToSelector:@selector(setBadgeValue:)]) {
+    return NO;
+  }
+
+  [(NILauncherButton *)button setBadgeValue:[newItem badgeValue]];
+  return YES;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Apply the minimal set of launcher view updates that turns oldItems into newItems.
+ *
+ * The items common to the start and end of both pages are left untouched. Of the items that
+ * remain in the middle, those that line up are reloaded and the rest are deleted or inserted.
+ * Items that line up and only differ in their badges update their buttons in place.
+ */
+- (void)updateLauncherViewPage: (NSInteger)page
+                     fromItems: (NSArray *)oldItems
+                       toItems: (NSArray *)newItems {
+  NSInteger oldCount = [oldItems count];
+  NSInteger newCount = [newItems count];
+
+  NSInteger prefixLength = 0;
+  while (prefixLength < oldCount && prefixLength < newCount
+         && [[oldItems objectAtIndex:prefixLength]
+             isEqual:[newItems objectAtIndex:prefixLength]]) {
+    ++prefixLength;
+  }
+
+  NSInteger suffixLength = 0;
+  while (suffixLength < oldCount - prefixLength && suffixLength < newCount - prefixLength
+         && [[oldItems objectAtIndex:oldCount - suffixLength - 1]
+             isEqual:[newItems objectAtIndex:newCount - suffixLength - 1]]) {
+    ++suffixLength;
+  }
+
+  NSInteger oldMiddleLength = oldCount - prefixLength - suffixLength;
+  NSInteger newMiddleLength = newCount - prefixLength - suffixLength;
+  NSInteger reloadLength = MIN(oldMiddleLength, newMiddleLength);
+
+  NSMutableArray* reloadIndexPaths = [NSMutableArray arrayWithCapacity:reloadLength];
+  for (NSInteger ix = prefixLength; ix < prefixLength + reloadLength; ++ix) {
+    if (![self updateBadgeOfButtonOnPage: page
+                                 atIndex: ix
+                                fromItem: [oldItems objectAtIndex:ix]
+                                  toItem: [newItems objectAtIndex:ix]]) {
+      [reloadIndexPaths addObject:[NSIndexPath indexPathForRow:ix inSection:page]];
+    }
+  }
+
+  NSMutableArray* deleteIndexPaths = [NSMutableArray array];
+  for (NSInteger ix = prefixLength + reloadLength; ix < prefixLength + oldMiddleLength; ++ix) {
+    [deleteIndexPaths addObject:[NSIndexPath indexPathForRow:ix inSection:page]];
+  }
+
+  NSMutableArray* insertIndexPaths = [NSMutableArray array];
+  for (NSInteger ix = prefixLength + reloadLength; ix < prefixLength + newMiddleLength; ++ix) {
+    [insertIndexPaths addObject:[NSIndexPath indexPathForRow:ix inSection:page]];
+  }
+
+  // NILauncherView applies updates in order, so the deletions and insertions both refer to the
+  // buttons as they are after the reloads.
+  if ([reloadIndexPaths count] > 0) {
+    [_launcherView reloadButtonsAtIndexPaths:reloadIndexPaths];
+  }
+  if ([deleteIndexPaths count] > 0) {
+    [_launcherView deleteButtonsAtIndexPaths:deleteIndexPaths];
+  }
+  if ([insertIndexPaths count] > 0) {
+    [_launcherView insertButtonsAtIndexPaths:insertIndexPaths];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Update the launcher view with only the buttons that differ between the two sets of pages.
+ *
+ * Pages that were added or removed from the end are picked up by the launcher view when it
+ * re-queries the number of pages at the end of the updates.
+ */
+- (void)updateLauncherViewFromPages:(NSArray *)oldPages toPages:(NSArray *)newPages {
+  NSInteger numberOfCommonPages = MIN([oldPages count], [newPages count]);
+
+  [_launcherView beginUpdates];
+  for (NSInteger ixPage = 0; ixPage < numberOfCommonPages; ++ixPage) {
+    NSArray* oldItems = [oldPages objectAtIndex:ixPage];
+    NSArray* newItems = [newPages objectAtIndex:ixPage];
+    if (oldItems != newItems) {
+      [self updateLauncherViewPage: ixPage
+                         fromItems: oldItems
+                           toItems: newItems];
+    }
+  }
+  [_launcherView endUpdates];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Searching
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)isSearching {
+  return ([_searchText length] > 0 && nil == _itemSource);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Re-index the items of only the pages that differ between the two sets of pages.
+ */
+- (void)updateSearchIndexFromPages:(NSArray *)oldPages toPages:(NSArray *)newPages {
+  NSInteger numberOfPages = MAX([oldPages count], [newPages count]);
+  for (NSInteger ixPage = 0; ixPage < numberOfPages; ++ixPage) {
+    NSArray* oldItems = nil;
+    NSArray* newItems = nil;
+    if (ixPage < (NSInteger)[oldPages count]) {
+      oldItems = [oldPages objectAtIndex:ixPage];
+    }
+    if (ixPage < (NSInteger)[newPages count]) {
+      newItems = [newPages objectAtIndex:ixPage];
+    }
+    if (oldItems == newItems) {
+      continue;
+    }
+
+    // Items that stay on the page are only removed from the index if they are added again.
+    for (NILauncherItemDetails* item in newItems) {
+      [_searchIndex addItem:item];
+    }
+    for (NILauncherItemDetails* item in oldItems) {
+      [_searchIndex removeItem:item];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Show the items that match the search text, or every item if we aren't searching.
+ */
+- (void)updateSearchResults {
+  if (![self isSearching]) {
+    _launcherView.filteredIndexPaths = nil;
+    return;
+  }
+
+  NI_TRACE_BEGIN("NILauncherViewController search");
+
+  if (nil == _searchIndex) {
+    _searchIndex = [[NILauncherSearchIndex alloc] init];
+    [self updateSearchIndexFromPages:nil toPages:_pages];
+  }
+
+  NIPointerSet* matchingItems = [_searchIndex itemsMatchingSearchText:_searchText];
+
+  // Walking the pages keeps the results in the order that the items are shown in normally.
+  NSMutableArray* indexPaths = [NSMutableArray arrayWithCapacity:[matchingItems count]];
+  NSInteger numberOfPages = [_pages count];
+  for (NSInteger ixPage = 0; ixPage < numberOfPages && [matchingItems count] > 0; ++ixPage) {
+    NSArray* items = [_pages objectAtIndex:ixPage];
+    NSInteger numberOfItems = [items count];
+    for (NSInteger ixItem = 0; ixItem < numberOfItems; ++ixItem) {
+      if ([matchingItems containsPointer:[items objectAtIndex:ixItem]]) {
+        [indexPaths addObject:[NSIndexPath indexPathForRow:ixItem inSection:ixPage]];
+      }
+    }
+  }
+
+  _launcherView.filteredIndexPaths = indexPaths;
+
+  NI_TRACE_END("NILauncherViewController search");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setSearchText:(NSString *)searchText {
+  if (_searchText == searchText || [_searchText isEqualToString:searchText]) {
+    return;
+  }
+
+  [_searchText release];
+  _searchText = [searchText copy];
+
+  [self updateSearchResults];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -175,20 +1232,92 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (void)setPages:(NSArray *)pages {
-  if (_pages != pages) {
-    [_pages release];
-    _pages = [pages mutableCopy];
+  if (_pages != pages || nil != _itemSource) {
+    NSArray* oldPages = [_pages autorelease];
+    _pages = [pages copy];
 
-    // If the view hasn't been loaded yet (entirely possible) then this will no-op and the
-    // launcher view will load its data in viewDidLoad.
-    [_launcherView reloadData];
+    // Comparing against the item source's pages could fetch every item, so we reload instead
+    // of updating when replacing an item source.
+    BOOL hadItemSource = (nil != _itemSource);
+    [self discardItemSourcePages];
+    NI_RELEASE_SAFELY(_itemSource);
+
+    if (nil != _searchIndex) {
+      [self updateSearchIndexFromPages:oldPages toPages:_pages];
+    }
+
+    if ([self isSearching]) {
+      // The launcher view is showing the search results rather than the pages.
+      [self updateSearchResults];
+
+    } else if (nil == oldPages || hadItemSource) {
+      // If the view hasn't been loaded yet (entirely possible) then this will no-op and the
+      // launcher view will load its data in viewDidLoad.
+      [_launcherView reloadData];
+
+    } else {
+      [self updateLauncherViewFromPages:oldPages toPages:_pages];
+    }
   }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 - (NSArray *)pages {
-  return [NSArray arrayWithArray:_pages];
+  if (nil == _itemSource) {
+    // The pages are immutable, so there is no need to copy them.
+    return _pages;
+  }
+
+  if (![_itemSource respondsToSelector:@selector(itemsForPage:)]) {
+    return nil;
+  }
+
+  NSInteger numberOfPages = [_itemSource numberOfPages];
+  NSMutableArray* pages = [NSMutableArray arrayWithCapacity:numberOfPages];
+  for (NSInteger ixPage = 0; ixPage < numberOfPages; ++ixPage) {
+    NSArray* items = [_itemSource itemsForPage:ixPage];
+    [pages addObject:(nil != items) ? items : [NSArray array]];
+  }
+  return pages;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setItemSource:(id<NILauncherItemSource>)itemSource {
+  if (_itemSource != itemSource) {
+    [self discardItemSourcePages];
+
+    [_itemSource release];
+    _itemSource = [itemSource retain];
+    NI_RELEASE_SAFELY(_pages);
+    NI_RELEASE_SAFELY(_searchIndex);
+
+    // Item sources can't be searched, so this also shows every item again.
+    _launcherView.filteredIndexPaths = nil;
+    [_launcherView reloadData];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)savePagesToFile:(NSString *)path error:(NSError **)error {
+  return [NILauncherPagesArchive writePages:self.pages toFile:path error:error];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (BOOL)loadPagesFromFile:(NSString *)path error:(NSError **)error {
+  NILauncherPagesArchive* archive = [[NILauncherPagesArchive alloc] initWithContentsOfFile: path
+                                                                                     error: error];
+  if (nil == archive) {
+    return NO;
+  }
+
+  self.itemSource = archive;
+  [archive release];
+
+  return YES;
 }
 
 
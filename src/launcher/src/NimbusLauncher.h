@@ -23,9 +23,8 @@
  * of pages that each contain a set of buttons that the user may tap to access a consistent,
  * focused aspect of the application or operating system. The user may swipe the screen to the
  * left or right or tap the pager control at the bottom of the screen to change pages. A launcher
- * also allows its buttons to be repositioned using a tap and hold gesture (though this has not
- * been implemented yet in Nimbus' launcher, see the <a href="todo.html">todo list</a> for
- * more details).
+ * also allows its buttons to be repositioned using a tap and hold gesture, after which the
+ * buttons can be dragged to new positions on any page.
  *
  * @image html NILauncherViewControllerExample1.png "Example of an NILauncherViewController as seen in the BasicLauncher demo application."
  *
@@ -70,9 +69,15 @@
 #ifdef BASE_PRODUCT_NAME
 #import "NimbusLauncher/NILauncherViewController.h"
 #import "NimbusLauncher/NILauncherView.h"
+#import "NimbusLauncher/NILauncherLayout.h"
+#import "NimbusLauncher/NILauncherPagesArchive.h"
+#import "NimbusLauncher/NILauncherSearchIndex.h"
 #else
 #import "NILauncherViewController.h"
 #import "NILauncherView.h"
+#import "NILauncherLayout.h"
+#import "NILauncherPagesArchive.h"
+#import "NILauncherSearchIndex.h"
 #endif
 
 
@@ -0,0 +1,173 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+@class NIImageMemoryCache;
+@protocol NINetworkImageLoaderDelegate;
+
+/**
+ * @brief The error domain for errors reported by NINetworkImageLoader.
+ *
+ * @ingroup Network-Image-Loading
+ */
+extern NSString* const NINetworkImageErrorDomain;
+
+/**
+ * @brief The error codes reported in NINetworkImageErrorDomain.
+ *
+ * @ingroup Network-Image-Loading
+ */
+typedef enum {
+  NINetworkImageErrorBadResponse = 1,   // The server responded with a non-2xx status code.
+  NINetworkImageErrorInvalidImage,      // The downloaded data could not be decoded as an image.
+} NINetworkImageError;
+
+/**
+ * @brief Downloads, caches, and decodes images from the network.
+ *
+ * @ingroup Network-Image-Loading
+ *
+ * Images are looked for in three places, in order:
+ *
+ * -# The in-memory cache of decompressed images.
+ * -# The on-disk cache of downloaded image data, stored in the caches directory and keyed by
+ *    the md5 hash of the image's URL.
+ * -# The network.
+ *
+ * Everything but the memory cache lookup happens on a background thread, including
+ * decompressing the image. Delegates are always notified on the main thread.
+ *
+ * Requests for a URL that is already being loaded are coalesced into the existing request, so
+ * a screen full of views showing the same image will only download it once. No more than
+ * maxNumberOfConcurrentRequests images are loaded at once.
+ *
+ * This class should only be used from the main thread.
+ */
+@interface NINetworkImageLoader : NSObject {
+@private
+  NSOperationQueue*     _queue;
+  NSMutableDictionary*  _pendingOperations; // NSDictionary< NSString(URL), NSOperation >
+
+  NIImageMemoryCache*   _imageMemoryCache;
+  NSString*             _diskCachePath;
+  NSTimeInterval        _timeoutInterval;
+}
+
+/**
+ * @brief The loader shared by every NINetworkImageView that hasn't been given its own loader.
+ *
+ * Its disk cache is stored in the NimbusNetworkImages folder of the caches directory.
+ */
++ (NINetworkImageLoader *)globalLoader;
+
+/**
+ * @brief Designated initializer.
+ *
+ * @param diskCachePath  The folder in which downloaded image data is stored. It is created
+ *                       if it doesn't exist. If nil, downloaded images are not stored on disk.
+ */
+- (id)initWithDiskCachePath:(NSString *)diskCachePath;
+
+/**
+ * @brief Fetch an image from the in-memory cache without touching the disk or network.
+ *
+ * @returns The decompressed image, or nil if it isn't in the memory cache.
+ */
+- (UIImage *)cachedImageForURL:(NSString *)url;
+
+/**
+ * @brief Load the image at the given URL and notify the delegate when it has loaded.
+ *
+ * If the image is in the memory cache then the delegate is notified before this method returns.
+ *
+ * The delegate is not retained. Delegates must cancel their requests before they are released.
+ */
+- (void)requestImageAtURL:(NSString *)url delegate:(id<NINetworkImageLoaderDelegate>)delegate;
+
+/**
+ * @brief Stop notifying the delegate about the image at the given URL.
+ *
+ * If no other delegates are waiting on the image then the request itself is cancelled.
+ */
+- (void)cancelRequestForURL:(NSString *)url delegate:(id<NINetworkImageLoaderDelegate>)delegate;
+
+/**
+ * @brief Cancel every pending request. No delegates will be notified.
+ */
+- (void)cancelAllRequests;
+
+/**
+ * @brief Delete every downloaded image from the disk cache.
+ */
+- (void)removeAllCachedImagesFromDisk;
+
+/**
+ * @brief The maximum number of images that may be loaded at the same time.
+ *
+ * Defaults to 4.
+ */
+@property (nonatomic, readwrite, assign) NSInteger maxNumberOfConcurrentRequests;
+
+/**
+ * @brief The number of seconds to wait for a download before it fails.
+ *
+ * Defaults to 60.
+ */
+@property (nonatomic, readwrite, assign) NSTimeInterval timeoutInterval;
+
+/**
+ * @brief The in-memory cache of decompressed images.
+ *
+ * By default this holds up to 8 megabytes of pixels.
+ */
+@property (nonatomic, readwrite, retain) NIImageMemoryCache* imageMemoryCache;
+
+/**
+ * @brief The folder in which downloaded image data is stored.
+ */
+@property (nonatomic, readonly, copy) NSString* diskCachePath;
+
+@end
+
+
+/**
+ * @brief Notifications of a network image finishing or failing to load.
+ *
+ * @ingroup Network-Image-Loading
+ */
+@protocol NINetworkImageLoaderDelegate <NSObject>
+
+@required
+
+/**
+ * @brief The image at the given URL has been loaded and decompressed.
+ */
+- (void)networkImageLoader: (NINetworkImageLoader *)loader
+              didLoadImage: (UIImage *)image
+                    forURL: (NSString *)url;
+
+@optional
+
+/**
+ * @brief The image at the given URL could not be loaded.
+ */
+- (void)networkImageLoader: (NINetworkImageLoader *)loader
+  didFailToLoadImageForURL: (NSString *)url
+                     error: (NSError *)error;
+
+@end
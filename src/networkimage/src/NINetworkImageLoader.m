@@ -0,0 +1,437 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NINetworkImageLoader.h"
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusCore/NimbusCore+Additions.h"
+#import "NimbusCore/NIInMemoryCache.h"
+#else
+#import "NimbusCore+Additions.h"
+#import "NIInMemoryCache.h"
+#endif
+
+NSString* const NINetworkImageErrorDomain = @"NINetworkImageErrorDomain";
+
+static const NSInteger kDefaultMaxNumberOfConcurrentRequests = 4;
+static const NSTimeInterval kDefaultTimeoutInterval = 60;
+static const NSUInteger kDefaultImageMemoryCacheMaxTotalCost = 8 * 1024 * 1024;
+
+static NINetworkImageLoader* gGlobalLoader = nil;
+
+@class NINetworkImageOperation;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@interface NINetworkImageLoader()
+
+- (void)operationDidFinish:(NINetworkImageOperation *)operation;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Loads a single image from the disk cache or the network on a background thread.
+ *
+ * The download is performed synchronously within the operation so that it doesn't depend on
+ * the background thread having a run loop. Cancelling the operation while it is downloading
+ * discards the result once the download completes.
+ */
+@interface NINetworkImageOperation : NSOperation {
+@private
+  NSString*       _url;
+  NSString*       _diskCacheFilePath;
+  NSTimeInterval  _timeoutInterval;
+
+  UIImage*        _image;
+  NSError*        _error;
+
+  // Data that couldn't be decoded on the background thread, to be decoded on the main thread.
+  NSData*         _undecodedData;
+  BOOL            _isFromDiskCache;
+
+  // Only accessed from the main thread.
+  NINetworkImageLoader* _loader;
+  NSMutableArray*       _delegates; // Non-retaining
+}
+
+- (id)initWithURL: (NSString *)url
+diskCacheFilePath: (NSString *)diskCacheFilePath
+  timeoutInterval: (NSTimeInterval)timeoutInterval;
+
+@property (nonatomic, readonly, copy)   NSString* url;
+@property (nonatomic, readonly, retain) UIImage*  image;
+@property (nonatomic, readonly, retain) NSError*  error;
+
+@property (nonatomic, readwrite, assign) NINetworkImageLoader* loader;
+@property (nonatomic, readonly, retain)  NSMutableArray*       delegates;
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NINetworkImageOperation
+
+@synthesize url       = _url;
+@synthesize image     = _image;
+@synthesize error     = _error;
+@synthesize loader    = _loader;
+@synthesize delegates = _delegates;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  NI_RELEASE_SAFELY(_url);
+  NI_RELEASE_SAFELY(_diskCacheFilePath);
+  NI_RELEASE_SAFELY(_image);
+  NI_RELEASE_SAFELY(_error);
+  NI_RELEASE_SAFELY(_undecodedData);
+  NI_RELEASE_SAFELY(_delegates);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithURL: (NSString *)url
+diskCacheFilePath: (NSString *)diskCacheFilePath
+  timeoutInterval: (NSTimeInterval)timeoutInterval {
+  if ((self = [super init])) {
+    _url = [url copy];
+    _diskCacheFilePath = [diskCacheFilePath copy];
+    _timeoutInterval = timeoutInterval;
+    _delegates = NICreateNonRetainingArray();
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSData *)downloadData {
+  NSURL* url = [NSURL URLWithString:_url];
+  if (nil == url) {
+    return nil;
+  }
+
+  NSURLRequest* request = [NSURLRequest requestWithURL: url
+                                           cachePolicy: NSURLRequestUseProtocolCachePolicy
+                                       timeoutInterval: _timeoutInterval];
+  NSURLResponse* response = nil;
+  NSError* error = nil;
+  NI_TRACE_BEGIN("NINetworkImageOperation download");
+  NSData* data = [NSURLConnection sendSynchronousRequest: request
+                                       returningResponse: &response
+                                                   error: &error];
+  NI_TRACE_END("NINetworkImageOperation download");
+  if (nil != error) {
+    _error = [error retain];
+    return nil;
+  }
+
+  if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
+    NSInteger statusCode = [(NSHTTPURLResponse *)response statusCode];
+    if (statusCode < 200 || statusCode >= 300) {
+      _error = [[NSError alloc] initWithDomain: NINetworkImageErrorDomain
+                                          code: NINetworkImageErrorBadResponse
+                                      userInfo: nil];
+      return nil;
+    }
+  }
+
+  return data;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Decode the data that the background thread couldn't, now that UIImage may be used.
+ */
+- (void)decodeUndecodedData {
+  _image = [NIDecodedImageWithData(_undecodedData, 1) retain];
+
+  if (nil == _image) {
+    if (_isFromDiskCache) {
+      // The cached file is unusable, so make sure that we download it again next time.
+      [[NSFileManager defaultManager] removeItemAtPath:_diskCacheFilePath error:nil];
+    }
+    _error = [[NSError alloc] initWithDomain: NINetworkImageErrorDomain
+                                        code: NINetworkImageErrorInvalidImage
+                                    userInfo: nil];
+
+  } else if (!_isFromDiskCache && nil != _diskCacheFilePath) {
+    [_undecodedData writeToFile:_diskCacheFilePath atomically:YES];
+  }
+
+  NI_RELEASE_SAFELY(_undecodedData);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)didFinish {
+  if (![self isCancelled]) {
+    if (nil != _undecodedData) {
+      [self decodeUndecodedData];
+    }
+    [_loader operationDidFinish:self];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)main {
+  NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+
+  if (![self isCancelled]) {
+    _isFromDiskCache = YES;
+    NSData* data = (nil == _diskCacheFilePath
+                    ? nil
+                    : [NSData dataWithContentsOfFile:_diskCacheFilePath]);
+    if (nil == data && ![self isCancelled]) {
+      _isFromDiskCache = NO;
+      data = [self downloadData];
+    }
+
+    if (nil != data && ![self isCancelled]) {
+      _image = [NIDecodedImageWithData(data, 1) retain];
+
+      if (nil == _image) {
+        // Only PNG and JPEG images can be decoded off of the main thread. Other formats, such
+        // as GIF, are decoded when the operation finishes.
+        _undecodedData = [data retain];
+
+      } else if (!_isFromDiskCache && nil != _diskCacheFilePath) {
+        [data writeToFile:_diskCacheFilePath atomically:YES];
+      }
+    }
+
+    if (![self isCancelled]) {
+      [self performSelectorOnMainThread: @selector(didFinish)
+                             withObject: nil
+                          waitUntilDone: NO];
+    }
+  }
+
+  [pool release];
+}
+
+
+@end
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NINetworkImageLoader
+
+@synthesize timeoutInterval   = _timeoutInterval;
+@synthesize imageMemoryCache  = _imageMemoryCache;
+@synthesize diskCachePath     = _diskCachePath;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [self cancelAllRequests];
+
+  NI_RELEASE_SAFELY(_queue);
+  NI_RELEASE_SAFELY(_pendingOperations);
+  NI_RELEASE_SAFELY(_imageMemoryCache);
+  NI_RELEASE_SAFELY(_diskCachePath);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithDiskCachePath:(NSString *)diskCachePath {
+  if ((self = [super init])) {
+    _queue = [[NSOperationQueue alloc] init];
+    [_queue setMaxConcurrentOperationCount:kDefaultMaxNumberOfConcurrentRequests];
+
+    _pendingOperations = [[NSMutableDictionary alloc] init];
+    _imageMemoryCache =
+    [[NIImageMemoryCache alloc] initWithMaxTotalCost:kDefaultImageMemoryCacheMaxTotalCost];
+    _timeoutInterval = kDefaultTimeoutInterval;
+
+    _diskCachePath = [diskCachePath copy];
+    if (nil != _diskCachePath) {
+      [[NSFileManager defaultManager] createDirectoryAtPath: _diskCachePath
+                                withIntermediateDirectories: YES
+                                                 attributes: nil
+                                                      error: nil];
+    }
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)init {
+  return [self initWithDiskCachePath:nil];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
++ (NINetworkImageLoader *)globalLoader {
+  if (nil == gGlobalLoader) {
+    NSString* diskCachePath = NIPathForCachesResource(@"NimbusNetworkImages");
+    gGlobalLoader = [[NINetworkImageLoader alloc] initWithDiskCachePath:diskCachePath];
+  }
+  return gGlobalLoader;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSString *)diskCacheFilePathForURL:(NSString *)url {
+  if (nil == _diskCachePath) {
+    return nil;
+  }
+  return [_diskCachePath stringByAppendingPathComponent:[url md5Hash]];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)operationDidFinish:(NINetworkImageOperation *)operation {
+  // Keep the operation alive while we notify the delegates.
+  [[operation retain] autorelease];
+  [_pendingOperations removeObjectForKey:operation.url];
+  operation.loader = nil;
+
+  if (nil != operation.image) {
+    [_imageMemoryCache storeImage:operation.image forKey:operation.url];
+  }
+
+  // Delegates may cancel other requests while being notified.
+  NSArray* delegates = [NSArray arrayWithArray:operation.delegates];
+  for (id<NINetworkImageLoaderDelegate> delegate in delegates) {
+    if (nil != operation.image) {
+      [delegate networkImageLoader: self
+                      didLoadImage: operation.image
+                            forURL: operation.url];
+
+    } else if ([delegate respondsToSelector:
+                @selector(networkImageLoader:didFailToLoadImageForURL:error:)]) {
+      [delegate networkImageLoader: self
+          didFailToLoadImageForURL: operation.url
+                             error: operation.error];
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Public Methods
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (UIImage *)cachedImageForURL:(NSString *)url {
+  if (nil == url) {
+    return nil;
+  }
+  return [_imageMemoryCache objectForKey:url];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)requestImageAtURL:(NSString *)url delegate:(id<NINetworkImageLoaderDelegate>)delegate {
+  NIDASSERT(nil != url);
+  if (nil == url) {
+    return;
+  }
+
+  UIImage* cachedImage = [self cachedImageForURL:url];
+  if (nil != cachedImage) {
+    [delegate networkImageLoader:self didLoadImage:cachedImage forURL:url];
+    return;
+  }
+
+  NINetworkImageOperation* operation = [_pendingOperations objectForKey:url];
+  if (nil == operation) {
+    operation = [[NINetworkImageOperation alloc] initWithURL: url
+                                           diskCacheFilePath: [self diskCacheFilePathForURL:url]
+                                             timeoutInterval: _timeoutInterval];
+    operation.loader = self;
+    [_pendingOperations setObject:operation forKey:url];
+    [_queue addOperation:operation];
+    [operation release];
+  }
+
+  if (nil != delegate && ![operation.delegates containsObject:delegate]) {
+    [operation.delegates addObject:delegate];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelRequestForURL:(NSString *)url delegate:(id<NINetworkImageLoaderDelegate>)delegate {
+  if (nil == url) {
+    return;
+  }
+
+  NINetworkImageOperation* operation = [_pendingOperations objectForKey:url];
+  [operation.delegates removeObjectIdenticalTo:delegate];
+
+  if (nil != operation && [operation.delegates count] == 0) {
+    operation.loader = nil;
+    [operation cancel];
+    [_pendingOperations removeObjectForKey:url];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelAllRequests {
+  for (NINetworkImageOperation* operation in [_pendingOperations objectEnumerator]) {
+    operation.loader = nil;
+    [operation cancel];
+  }
+  [_pendingOperations removeAllObjects];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)removeAllCachedImagesFromDisk {
+  if (nil == _diskCachePath) {
+    return;
+  }
+
+  NSFileManager* fm = [NSFileManager defaultManager];
+  for (NSString* filename in [fm contentsOfDirectoryAtPath:_diskCachePath error:nil]) {
+    [fm removeItemAtPath:[_diskCachePath stringByAppendingPathComponent:filename] error:nil];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NSInteger)maxNumberOfConcurrentRequests {
+  return [_queue maxConcurrentOperationCount];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setMaxNumberOfConcurrentRequests:(NSInteger)maxNumberOfConcurrentRequests {
+  NIDASSERT(maxNumberOfConcurrentRequests > 0);
+  [_queue setMaxConcurrentOperationCount:MAX(1, maxNumberOfConcurrentRequests)];
+}
+
+
+@end
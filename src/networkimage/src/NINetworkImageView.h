@@ -0,0 +1,126 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusNetworkImage/NINetworkImageLoader.h"
+#else
+#import "NINetworkImageLoader.h"
+#endif
+
+@protocol NINetworkImageViewDelegate;
+
+/**
+ * @brief An image view that loads its image from the network.
+ *
+ * @ingroup Network-Image-User-Interface
+ *
+ * The view shows its initial image until the network image has loaded. Loading, caching, and
+ * decompressing the image is handled by an NINetworkImageLoader so that none of this work
+ * happens on the main thread.
+ *
+ * When using network image views in cells or other reusable views, call prepareForReuse before
+ * setting a new path so that the previous request is cancelled.
+ *
+ * @image html NINetworkImageDesign1.png "The design of the network image view."
+ */
+@interface NINetworkImageView : UIImageView <NINetworkImageLoaderDelegate> {
+@private
+  NSString*             _pathToNetworkImage;
+  UIImage*              _initialImage;
+  NINetworkImageLoader* _imageLoader;
+  BOOL                  _isLoading;
+
+  id<NINetworkImageViewDelegate> _delegate;
+}
+
+/**
+ * @brief Designated initializer.
+ *
+ * @param image  The initial image to show while the network image loads. May be nil.
+ */
+- (id)initWithImage:(UIImage *)image;
+
+/**
+ * @brief Start loading the image at the given URL, cancelling any previous request.
+ *
+ * If the image is already in the loader's memory cache then it is shown immediately.
+ * Setting a nil path shows the initial image.
+ */
+- (void)setPathToNetworkImage:(NSString *)pathToNetworkImage;
+
+/**
+ * @brief Cancel any pending request and show the initial image.
+ */
+- (void)prepareForReuse;
+
+/**
+ * @brief The URL of the network image. Use setPathToNetworkImage: to change it.
+ */
+@property (nonatomic, readonly, copy) NSString* pathToNetworkImage;
+
+/**
+ * @brief The image shown while the network image loads, or if it fails to load.
+ */
+@property (nonatomic, readwrite, retain) UIImage* initialImage;
+
+/**
+ * @brief Whether the network image is currently being loaded.
+ */
+@property (nonatomic, readonly, assign) BOOL isLoading;
+
+/**
+ * @brief The loader used to fetch images.
+ *
+ * Defaults to [NINetworkImageLoader globalLoader].
+ */
+@property (nonatomic, readwrite, retain) NINetworkImageLoader* imageLoader;
+
+/**
+ * @brief The delegate notified of changes to the loading state.
+ */
+@property (nonatomic, readwrite, assign) id<NINetworkImageViewDelegate> delegate;
+
+@end
+
+
+/**
+ * @brief Notifications of an NINetworkImageView's loading state.
+ *
+ * @ingroup Network-Image-Protocols
+ */
+@protocol NINetworkImageViewDelegate <NSObject>
+
+@optional
+
+/**
+ * @brief The image view has started loading its image from the disk cache or the network.
+ */
+- (void)networkImageViewDidStartLoad:(NINetworkImageView *)imageView;
+
+/**
+ * @brief The image view has loaded and shown its image.
+ */
+- (void)networkImageView:(NINetworkImageView *)imageView didLoadImage:(UIImage *)image;
+
+/**
+ * @brief The image view's image failed to load. The initial image remains visible.
+ */
+- (void)networkImageView:(NINetworkImageView *)imageView didFailWithError:(NSError *)error;
+
+@end
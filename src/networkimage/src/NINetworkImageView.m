@@ -0,0 +1,166 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "NINetworkImageView.h"
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+@implementation NINetworkImageView
+
+@synthesize pathToNetworkImage  = _pathToNetworkImage;
+@synthesize initialImage        = _initialImage;
+@synthesize imageLoader         = _imageLoader;
+@synthesize isLoading           = _isLoading;
+@synthesize delegate            = _delegate;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)dealloc {
+  [_imageLoader cancelRequestForURL:_pathToNetworkImage delegate:self];
+
+  NI_RELEASE_SAFELY(_pathToNetworkImage);
+  NI_RELEASE_SAFELY(_initialImage);
+  NI_RELEASE_SAFELY(_imageLoader);
+
+  [super dealloc];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithImage:(UIImage *)image {
+  if ((self = [super initWithImage:image])) {
+    _initialImage = [image retain];
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (id)initWithFrame:(CGRect)frame {
+  if ((self = [self initWithImage:nil])) {
+    self.frame = frame;
+  }
+  return self;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (NINetworkImageLoader *)imageLoader {
+  if (nil == _imageLoader) {
+    _imageLoader = [[NINetworkImageLoader globalLoader] retain];
+  }
+  return _imageLoader;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setImageLoader:(NINetworkImageLoader *)imageLoader {
+  if (_imageLoader != imageLoader) {
+    [self prepareForReuse];
+    [_imageLoader release];
+    _imageLoader = [imageLoader retain];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)cancelRequest {
+  if (_isLoading) {
+    [self.imageLoader cancelRequestForURL:_pathToNetworkImage delegate:self];
+    _isLoading = NO;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)prepareForReuse {
+  [self cancelRequest];
+  NI_RELEASE_SAFELY(_pathToNetworkImage);
+  self.image = _initialImage;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)setPathToNetworkImage:(NSString *)pathToNetworkImage {
+  if (_pathToNetworkImage == pathToNetworkImage
+      || [_pathToNetworkImage isEqualToString:pathToNetworkImage]) {
+    return;
+  }
+
+  [self prepareForReuse];
+  if (nil == pathToNetworkImage) {
+    return;
+  }
+
+  _pathToNetworkImage = [pathToNetworkImage copy];
+
+  UIImage* cachedImage = [self.imageLoader cachedImageForURL:_pathToNetworkImage];
+  if (nil != cachedImage) {
+    self.image = cachedImage;
+    return;
+  }
+
+  _isLoading = YES;
+  if ([_delegate respondsToSelector:@selector(networkImageViewDidStartLoad:)]) {
+    [_delegate networkImageViewDidStartLoad:self];
+  }
+
+  [self.imageLoader requestImageAtURL:_pathToNetworkImage delegate:self];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark NINetworkImageLoaderDelegate
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)networkImageLoader: (NINetworkImageLoader *)loader
+              didLoadImage: (UIImage *)image
+                    forURL: (NSString *)url {
+  if (![url isEqualToString:_pathToNetworkImage]) {
+    return;
+  }
+
+  _isLoading = NO;
+  self.image = image;
+
+  if ([_delegate respondsToSelector:@selector(networkImageView:didLoadImage:)]) {
+    [_delegate networkImageView:self didLoadImage:image];
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+- (void)networkImageLoader: (NINetworkImageLoader *)loader
+  didFailToLoadImageForURL: (NSString *)url
+                     error: (NSError *)error {
+  if (![url isEqualToString:_pathToNetworkImage]) {
+    return;
+  }
+
+  _isLoading = NO;
+
+  if ([_delegate respondsToSelector:@selector(networkImageView:didFailWithError:)]) {
+    [_delegate networkImageView:self didFailWithError:error];
+  }
+}
+
+
+@end
@@ -0,0 +1,62 @@
+//
+// Copyright 2011 Jeff Verkoeyen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/**
+ * @brief Nimbus' network image view and the image loading stack behind it.
+ * @defgroup NimbusNetworkImage Nimbus Network Image
+ * @{
+ *
+ * Showing images from the network is one of the most common needs of an iOS application, and
+ * also one of the easiest ways to make scrolling stutter. Nimbus' network images are built so
+ * that downloading, caching, and decompressing the image all happen off of the main thread.
+ * The only work left for the main thread is setting the finished image on the view.
+ *
+ * @image html NINetworkImageDesign1.png "The design of the network image view."
+ */
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+
+/**
+ * @brief The views used to display network images.
+ * @defgroup Network-Image-User-Interface User Interface
+ */
+
+/**
+ * @brief The objects used to download, cache, and decode network images.
+ * @defgroup Network-Image-Loading Loading
+ *
+ * NINetworkImageLoader coalesces requests for the same image and limits the number of images
+ * that are loaded at once. Downloaded images are stored in memory as decompressed bitmaps and
+ * on disk as the original data.
+ */
+
+/**
+ * @brief The delegate protocols used to observe network image loading.
+ * @defgroup Network-Image-Protocols Protocols
+ */
+
+#ifdef BASE_PRODUCT_NAME
+#import "NimbusNetworkImage/NINetworkImageView.h"
+#import "NimbusNetworkImage/NINetworkImageLoader.h"
+#else
+#import "NINetworkImageView.h"
+#import "NINetworkImageLoader.h"
+#endif
+
+
+/**@}*/